@@ -15,6 +15,7 @@
 #include "cJSON.h"
 #include "json_helpers.h"
 #include "json_common.h"
+#include "cbor_common.h"
 #include "json_protocol_names.h"
 
 #include <logging/log.h>
@@ -469,6 +470,27 @@ int cloud_codec_encode_batch_data(
 				size_t accel_buf_count,
 				size_t bat_buf_count)
 {
+	if (IS_ENABLED(CONFIG_CLOUD_CODEC_CBOR)) {
+		return cbor_common_batch_encode(output, gps_buf, sensor_buf, modem_dyn_buf, ui_buf,
+						accel_buf, bat_buf, gps_buf_count,
+						sensor_buf_count, modem_dyn_buf_count,
+						ui_buf_count, accel_buf_count, bat_buf_count);
+	}
+
+	if (IS_ENABLED(CONFIG_CLOUD_CODEC_JSON_WRITER)) {
+		const struct json_common_batch batch[] = {
+			{ JSON_COMMON_MODEM_DYNAMIC, modem_dyn_buf, modem_dyn_buf_count,
+			  DATA_MODEM_DYNAMIC },
+			{ JSON_COMMON_GPS, gps_buf, gps_buf_count, DATA_GPS },
+			{ JSON_COMMON_SENSOR, sensor_buf, sensor_buf_count, DATA_ENVIRONMENTALS },
+			{ JSON_COMMON_UI, ui_buf, ui_buf_count, DATA_BUTTON },
+			{ JSON_COMMON_BATTERY, bat_buf, bat_buf_count, DATA_BATTERY },
+			{ JSON_COMMON_ACCELEROMETER, accel_buf, accel_buf_count, DATA_MOVEMENT },
+		};
+
+		return json_common_batch_encode(output, batch, ARRAY_SIZE(batch));
+	}
+
 	int err;
 	char *buffer;
 	bool object_added = false;
@@ -0,0 +1,588 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr.h>
+#include <date_time.h>
+
+#include "cloud_codec.h"
+#include "cbor_common.h"
+#include "cbor_writer.h"
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(cbor_common, CONFIG_CLOUD_CODEC_LOG_LEVEL);
+
+#define GPS_PVT_VALUES		6
+#define SENSOR_VALUES		2
+#define ACCEL_VALUES		3
+
+struct batch {
+	struct cloud_data_gps *gps_buf;
+	struct cloud_data_sensors *sensor_buf;
+	struct cloud_data_modem_dynamic *modem_dyn_buf;
+	struct cloud_data_ui *ui_buf;
+	struct cloud_data_accelerometer *accel_buf;
+	struct cloud_data_battery *bat_buf;
+	size_t gps_buf_count;
+	size_t sensor_buf_count;
+	size_t modem_dyn_buf_count;
+	size_t ui_buf_count;
+	size_t accel_buf_count;
+	size_t bat_buf_count;
+};
+
+/* Previous entry of an array, that the following entry is encoded relative to. */
+struct delta {
+	int64_t ts;
+	int64_t values[GPS_PVT_VALUES];
+	bool ts_set;
+	bool values_set;
+};
+
+/* The timestamps are converted into a copy, so that the data can be encoded more than once,
+ * as done when computing the length of the output before writing it.
+ */
+static int ts_get(int64_t uptime, int64_t *ts)
+{
+	int err;
+
+	*ts = uptime;
+
+	err = date_time_uptime_to_unix_time_ms(ts);
+	if (err) {
+		LOG_ERR("date_time_uptime_to_unix_time_ms, error: %d", err);
+	}
+
+	return err;
+}
+
+/* Rounded half away from zero, without depending on the math library. */
+static int64_t fixed_point(double value, int32_t scale)
+{
+	double scaled = value * scale;
+
+	return (int64_t)(scaled < 0 ? scaled - 0.5 : scaled + 0.5);
+}
+
+static void ts_write(struct cbor_writer *writer, struct delta *delta, int64_t ts)
+{
+	cbor_writer_int(writer, delta->ts_set ? ts - delta->ts : ts);
+
+	delta->ts = ts;
+	delta->ts_set = true;
+}
+
+static void values_write(struct cbor_writer *writer, struct delta *delta, const int64_t *values,
+			 size_t count)
+{
+	for (size_t i = 0; i < count; i++) {
+		cbor_writer_int(writer, delta->values_set ? values[i] - delta->values[i] : values[i]);
+		delta->values[i] = values[i];
+	}
+
+	delta->values_set = true;
+}
+
+static bool modem_dynamic_has_values(const struct cloud_data_modem_dynamic *data)
+{
+	return data->rsrp_fresh || data->area_code_fresh || data->mccmnc_fresh ||
+	       data->cell_id_fresh || data->ip_address_fresh;
+}
+
+static size_t modem_dynamic_count(struct cloud_data_modem_dynamic *buf, size_t buf_count)
+{
+	size_t count = 0;
+
+	for (size_t i = 0; i < buf_count; i++) {
+		if (!buf[i].queued) {
+			continue;
+		}
+
+		if (!modem_dynamic_has_values(&buf[i])) {
+			buf[i].queued = false;
+			LOG_WRN("No valid dynamic modem data values present, entry unqueued");
+			continue;
+		}
+
+		count++;
+	}
+
+	return count;
+}
+
+static int modem_dynamic_write(struct cbor_writer *writer, struct cloud_data_modem_dynamic *buf,
+			       size_t buf_count, size_t count)
+{
+	struct delta delta = { 0 };
+	int err;
+
+	cbor_writer_array_start(writer, count);
+
+	for (size_t i = 0; i < buf_count; i++) {
+		struct cloud_data_modem_dynamic *data = &buf[i];
+		uint32_t mccmnc = 0;
+		size_t pairs = 1;
+		char *end_ptr;
+		int64_t ts;
+
+		if (!data->queued) {
+			continue;
+		}
+
+		err = ts_get(data->ts, &ts);
+		if (err) {
+			return err;
+		}
+
+		if (data->mccmnc_fresh) {
+			/* Convert mccmnc to unsigned long integer. */
+			errno = 0;
+			mccmnc = strtoul(data->mccmnc, &end_ptr, 10);
+
+			if ((errno == ERANGE) || (*end_ptr != '\0')) {
+				LOG_ERR("MCCMNC string could not be converted.");
+				return -ENOTEMPTY;
+			}
+		}
+
+		pairs += data->rsrp_fresh + data->area_code_fresh + data->mccmnc_fresh +
+			 data->cell_id_fresh + data->ip_address_fresh;
+
+		cbor_writer_map_start(writer, pairs);
+		cbor_writer_uint(writer, CBOR_COMMON_MODEM_TIMESTAMP);
+		ts_write(writer, &delta, ts);
+
+		if (data->rsrp_fresh) {
+			cbor_writer_uint(writer, CBOR_COMMON_MODEM_RSRP);
+			cbor_writer_int(writer, data->rsrp);
+		}
+
+		if (data->area_code_fresh) {
+			cbor_writer_uint(writer, CBOR_COMMON_MODEM_AREA_CODE);
+			cbor_writer_uint(writer, data->area);
+		}
+
+		if (data->mccmnc_fresh) {
+			cbor_writer_uint(writer, CBOR_COMMON_MODEM_MCCMNC);
+			cbor_writer_uint(writer, mccmnc);
+		}
+
+		if (data->cell_id_fresh) {
+			cbor_writer_uint(writer, CBOR_COMMON_MODEM_CELL_ID);
+			cbor_writer_uint(writer, data->cell);
+		}
+
+		if (data->ip_address_fresh) {
+			cbor_writer_uint(writer, CBOR_COMMON_MODEM_IP_ADDRESS);
+			cbor_writer_tstr(writer, data->ip);
+		}
+
+		if (!cbor_writer_is_sizing(writer)) {
+			data->queued = false;
+		}
+	}
+
+	return writer->err;
+}
+
+static size_t gps_count(struct cloud_data_gps *buf, size_t buf_count)
+{
+	size_t count = 0;
+
+	for (size_t i = 0; i < buf_count; i++) {
+		count += buf[i].queued;
+	}
+
+	return count;
+}
+
+static int gps_write(struct cbor_writer *writer, struct cloud_data_gps *buf, size_t buf_count,
+		     size_t count)
+{
+	/* NMEA entries only take part in the timestamp deltas. */
+	struct delta delta = { 0 };
+	int err;
+
+	cbor_writer_array_start(writer, count);
+
+	for (size_t i = 0; i < buf_count; i++) {
+		struct cloud_data_gps *data = &buf[i];
+		int64_t ts;
+
+		if (!data->queued) {
+			continue;
+		}
+
+		err = ts_get(data->gps_ts, &ts);
+		if (err) {
+			return err;
+		}
+
+		switch (data->format) {
+		case CLOUD_CODEC_GPS_FORMAT_PVT: {
+			const int64_t values[GPS_PVT_VALUES] = {
+				fixed_point(data->pvt.longi, CBOR_COMMON_GPS_COORD_SCALE),
+				fixed_point(data->pvt.lat, CBOR_COMMON_GPS_COORD_SCALE),
+				fixed_point(data->pvt.acc, CBOR_COMMON_GPS_METER_SCALE),
+				fixed_point(data->pvt.alt, CBOR_COMMON_GPS_METER_SCALE),
+				fixed_point(data->pvt.spd, CBOR_COMMON_GPS_METER_SCALE),
+				fixed_point(data->pvt.hdg, CBOR_COMMON_GPS_HEADING_SCALE),
+			};
+
+			cbor_writer_array_start(writer, 1 + GPS_PVT_VALUES);
+			ts_write(writer, &delta, ts);
+			values_write(writer, &delta, values, GPS_PVT_VALUES);
+		}
+			break;
+		case CLOUD_CODEC_GPS_FORMAT_NMEA:
+			cbor_writer_array_start(writer, 2);
+			ts_write(writer, &delta, ts);
+			cbor_writer_tstr(writer, data->nmea);
+			break;
+		case CLOUD_CODEC_GPS_FORMAT_INVALID:
+			/* Fall through */
+		default:
+			LOG_WRN("GPS data format not set");
+			return -EINVAL;
+		}
+
+		if (!cbor_writer_is_sizing(writer)) {
+			data->queued = false;
+		}
+	}
+
+	return writer->err;
+}
+
+static size_t sensor_count(struct cloud_data_sensors *buf, size_t buf_count)
+{
+	size_t count = 0;
+
+	for (size_t i = 0; i < buf_count; i++) {
+		count += buf[i].queued;
+	}
+
+	return count;
+}
+
+static int sensor_write(struct cbor_writer *writer, struct cloud_data_sensors *buf,
+			size_t buf_count, size_t count)
+{
+	struct delta delta = { 0 };
+	int err;
+
+	cbor_writer_array_start(writer, count);
+
+	for (size_t i = 0; i < buf_count; i++) {
+		struct cloud_data_sensors *data = &buf[i];
+		int64_t ts;
+
+		if (!data->queued) {
+			continue;
+		}
+
+		err = ts_get(data->env_ts, &ts);
+		if (err) {
+			return err;
+		}
+
+		const int64_t values[SENSOR_VALUES] = {
+			fixed_point(data->temp, CBOR_COMMON_SENSOR_SCALE),
+			fixed_point(data->hum, CBOR_COMMON_SENSOR_SCALE),
+		};
+
+		cbor_writer_array_start(writer, 1 + SENSOR_VALUES);
+		ts_write(writer, &delta, ts);
+		values_write(writer, &delta, values, SENSOR_VALUES);
+
+		if (!cbor_writer_is_sizing(writer)) {
+			data->queued = false;
+		}
+	}
+
+	return writer->err;
+}
+
+static size_t ui_count(struct cloud_data_ui *buf, size_t buf_count)
+{
+	size_t count = 0;
+
+	for (size_t i = 0; i < buf_count; i++) {
+		count += buf[i].queued;
+	}
+
+	return count;
+}
+
+static int ui_write(struct cbor_writer *writer, struct cloud_data_ui *buf, size_t buf_count,
+		    size_t count)
+{
+	struct delta delta = { 0 };
+	int err;
+
+	cbor_writer_array_start(writer, count);
+
+	for (size_t i = 0; i < buf_count; i++) {
+		struct cloud_data_ui *data = &buf[i];
+		int64_t ts;
+
+		if (!data->queued) {
+			continue;
+		}
+
+		err = ts_get(data->btn_ts, &ts);
+		if (err) {
+			return err;
+		}
+
+		cbor_writer_array_start(writer, 2);
+		ts_write(writer, &delta, ts);
+		cbor_writer_int(writer, data->btn);
+
+		if (!cbor_writer_is_sizing(writer)) {
+			data->queued = false;
+		}
+	}
+
+	return writer->err;
+}
+
+static size_t battery_count(struct cloud_data_battery *buf, size_t buf_count)
+{
+	size_t count = 0;
+
+	for (size_t i = 0; i < buf_count; i++) {
+		count += buf[i].queued;
+	}
+
+	return count;
+}
+
+static int battery_write(struct cbor_writer *writer, struct cloud_data_battery *buf,
+			 size_t buf_count, size_t count)
+{
+	struct delta delta = { 0 };
+	int err;
+
+	cbor_writer_array_start(writer, count);
+
+	for (size_t i = 0; i < buf_count; i++) {
+		struct cloud_data_battery *data = &buf[i];
+		int64_t ts;
+
+		if (!data->queued) {
+			continue;
+		}
+
+		err = ts_get(data->bat_ts, &ts);
+		if (err) {
+			return err;
+		}
+
+		cbor_writer_array_start(writer, 2);
+		ts_write(writer, &delta, ts);
+		cbor_writer_int(writer, data->bat);
+
+		if (!cbor_writer_is_sizing(writer)) {
+			data->queued = false;
+		}
+	}
+
+	return writer->err;
+}
+
+static size_t accel_count(struct cloud_data_accelerometer *buf, size_t buf_count)
+{
+	size_t count = 0;
+
+	for (size_t i = 0; i < buf_count; i++) {
+		count += buf[i].queued;
+	}
+
+	return count;
+}
+
+static int accel_write(struct cbor_writer *writer, struct cloud_data_accelerometer *buf,
+		       size_t buf_count, size_t count)
+{
+	struct delta delta = { 0 };
+	int err;
+
+	cbor_writer_array_start(writer, count);
+
+	for (size_t i = 0; i < buf_count; i++) {
+		struct cloud_data_accelerometer *data = &buf[i];
+		int64_t ts;
+
+		if (!data->queued) {
+			continue;
+		}
+
+		err = ts_get(data->ts, &ts);
+		if (err) {
+			return err;
+		}
+
+		cbor_writer_array_start(writer, 1 + ACCEL_VALUES);
+		ts_write(writer, &delta, ts);
+
+		for (size_t j = 0; j < ACCEL_VALUES; j++) {
+			cbor_writer_int(writer,
+					fixed_point(data->values[j], CBOR_COMMON_ACCEL_SCALE));
+		}
+
+		if (!cbor_writer_is_sizing(writer)) {
+			data->queued = false;
+		}
+	}
+
+	return writer->err;
+}
+
+static int batch_write(struct cbor_writer *writer, struct batch *batch)
+{
+	size_t modem_dyn_count = modem_dynamic_count(batch->modem_dyn_buf,
+						     batch->modem_dyn_buf_count);
+	size_t gps_cnt = gps_count(batch->gps_buf, batch->gps_buf_count);
+	size_t sensor_cnt = sensor_count(batch->sensor_buf, batch->sensor_buf_count);
+	size_t ui_cnt = ui_count(batch->ui_buf, batch->ui_buf_count);
+	size_t bat_cnt = battery_count(batch->bat_buf, batch->bat_buf_count);
+	size_t accel_cnt = accel_count(batch->accel_buf, batch->accel_buf_count);
+	size_t arrays = (modem_dyn_count > 0) + (gps_cnt > 0) + (sensor_cnt > 0) +
+			(ui_cnt > 0) + (bat_cnt > 0) + (accel_cnt > 0);
+	int err;
+
+	if (arrays == 0) {
+		LOG_DBG("No data to encode, CBOR output empty...");
+		return -ENODATA;
+	}
+
+	cbor_writer_map_start(writer, 1 + arrays);
+	cbor_writer_uint(writer, CBOR_COMMON_BATCH_VERSION);
+	cbor_writer_uint(writer, CBOR_COMMON_SCHEMA_VERSION);
+
+	if (modem_dyn_count > 0) {
+		cbor_writer_uint(writer, CBOR_COMMON_BATCH_MODEM_DYNAMIC);
+
+		err = modem_dynamic_write(writer, batch->modem_dyn_buf,
+					  batch->modem_dyn_buf_count, modem_dyn_count);
+		if (err) {
+			return err;
+		}
+	}
+
+	if (gps_cnt > 0) {
+		cbor_writer_uint(writer, CBOR_COMMON_BATCH_GPS);
+
+		err = gps_write(writer, batch->gps_buf, batch->gps_buf_count, gps_cnt);
+		if (err) {
+			return err;
+		}
+	}
+
+	if (sensor_cnt > 0) {
+		cbor_writer_uint(writer, CBOR_COMMON_BATCH_SENSOR);
+
+		err = sensor_write(writer, batch->sensor_buf, batch->sensor_buf_count, sensor_cnt);
+		if (err) {
+			return err;
+		}
+	}
+
+	if (ui_cnt > 0) {
+		cbor_writer_uint(writer, CBOR_COMMON_BATCH_UI);
+
+		err = ui_write(writer, batch->ui_buf, batch->ui_buf_count, ui_cnt);
+		if (err) {
+			return err;
+		}
+	}
+
+	if (bat_cnt > 0) {
+		cbor_writer_uint(writer, CBOR_COMMON_BATCH_BATTERY);
+
+		err = battery_write(writer, batch->bat_buf, batch->bat_buf_count, bat_cnt);
+		if (err) {
+			return err;
+		}
+	}
+
+	if (accel_cnt > 0) {
+		cbor_writer_uint(writer, CBOR_COMMON_BATCH_ACCELEROMETER);
+
+		err = accel_write(writer, batch->accel_buf, batch->accel_buf_count, accel_cnt);
+		if (err) {
+			return err;
+		}
+	}
+
+	return cbor_writer_finish(writer);
+}
+
+int cbor_common_batch_encode(struct cloud_codec_data *output,
+			     struct cloud_data_gps *gps_buf,
+			     struct cloud_data_sensors *sensor_buf,
+			     struct cloud_data_modem_dynamic *modem_dyn_buf,
+			     struct cloud_data_ui *ui_buf,
+			     struct cloud_data_accelerometer *accel_buf,
+			     struct cloud_data_battery *bat_buf,
+			     size_t gps_buf_count,
+			     size_t sensor_buf_count,
+			     size_t modem_dyn_buf_count,
+			     size_t ui_buf_count,
+			     size_t accel_buf_count,
+			     size_t bat_buf_count)
+{
+	struct batch batch = {
+		.gps_buf = gps_buf,
+		.sensor_buf = sensor_buf,
+		.modem_dyn_buf = modem_dyn_buf,
+		.ui_buf = ui_buf,
+		.accel_buf = accel_buf,
+		.bat_buf = bat_buf,
+		.gps_buf_count = gps_buf_count,
+		.sensor_buf_count = sensor_buf_count,
+		.modem_dyn_buf_count = modem_dyn_buf_count,
+		.ui_buf_count = ui_buf_count,
+		.accel_buf_count = accel_buf_count,
+		.bat_buf_count = bat_buf_count,
+	};
+	struct cbor_writer writer;
+	uint8_t *buffer;
+	int len;
+	int err;
+
+	/* The length of the output is computed first, so that exactly one buffer is allocated
+	 * for it, and no entry is unqueued if the allocation fails.
+	 */
+	cbor_writer_init(&writer, NULL, 0);
+
+	len = batch_write(&writer, &batch);
+	if (len < 0) {
+		return len;
+	}
+
+	buffer = k_malloc(len);
+	if (buffer == NULL) {
+		LOG_ERR("Failed to allocate memory for CBOR output");
+		return -ENOMEM;
+	}
+
+	cbor_writer_init(&writer, buffer, len);
+
+	err = batch_write(&writer, &batch);
+	if (err != len) {
+		LOG_ERR("Encoded length changed from %d to %d", len, err);
+		k_free(buffer);
+		return (err < 0) ? err : -EIO;
+	}
+
+	LOG_DBG("Encoded batch message of %d bytes", len);
+
+	output->buf = (char *)buffer;
+	output->len = len;
+
+	return 0;
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/**@file
+ * @brief CBOR common library header.
+ */
+
+#ifndef CBOR_COMMON_H__
+#define CBOR_COMMON_H__
+
+/**@file
+ *
+ * @defgroup cbor_common cbor_common
+ * @brief    Module that encodes batch data as CBOR, with the schema in batch.cddl.
+ * @{
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <zephyr.h>
+
+#include "cloud_codec.h"
+
+/** Version of the schema in batch.cddl. */
+#define CBOR_COMMON_SCHEMA_VERSION 1
+
+/** @brief Keys of the batch map. */
+enum cbor_common_batch_key {
+	CBOR_COMMON_BATCH_VERSION,
+	CBOR_COMMON_BATCH_MODEM_DYNAMIC,
+	CBOR_COMMON_BATCH_GPS,
+	CBOR_COMMON_BATCH_SENSOR,
+	CBOR_COMMON_BATCH_UI,
+	CBOR_COMMON_BATCH_BATTERY,
+	CBOR_COMMON_BATCH_ACCELEROMETER,
+};
+
+/** @brief Keys of the dynamic modem data maps. */
+enum cbor_common_modem_dynamic_key {
+	CBOR_COMMON_MODEM_TIMESTAMP,
+	CBOR_COMMON_MODEM_RSRP,
+	CBOR_COMMON_MODEM_AREA_CODE,
+	CBOR_COMMON_MODEM_MCCMNC,
+	CBOR_COMMON_MODEM_CELL_ID,
+	CBOR_COMMON_MODEM_IP_ADDRESS,
+};
+
+/** Number of units per degree of GPS longitude and latitude. */
+#define CBOR_COMMON_GPS_COORD_SCALE 10000000
+/** Number of units per meter of GPS accuracy and altitude, and per meter per second of speed. */
+#define CBOR_COMMON_GPS_METER_SCALE 100
+/** Number of units per degree of GPS heading. */
+#define CBOR_COMMON_GPS_HEADING_SCALE 100
+/** Number of units per degree Celsius and per percent of humidity. */
+#define CBOR_COMMON_SENSOR_SCALE 100
+/** Number of units per meter per second squared of acceleration. */
+#define CBOR_COMMON_ACCEL_SCALE 1000
+
+/**
+ * @brief Encode all queued entries of the passed in buffers as a CBOR map of arrays.
+ *
+ * The output is allocated once, at its exact length, and must be freed with k_free(). Entries
+ * are unqueued when they are encoded.
+ *
+ * @param[out] output Encoded output.
+ * @param[in] gps_buf Pointer to buffer containing GPS data.
+ * @param[in] sensor_buf Pointer to buffer containing environmental sensor data.
+ * @param[in] modem_dyn_buf Pointer to buffer containing dynamic modem data.
+ * @param[in] ui_buf Pointer to buffer containing button data.
+ * @param[in] accel_buf Pointer to buffer containing accelerometer data.
+ * @param[in] bat_buf Pointer to buffer containing battery data.
+ * @param[in] gps_buf_count Length of GPS data buffer.
+ * @param[in] sensor_buf_count Length of sensor data buffer.
+ * @param[in] modem_dyn_buf_count Length of dynamic modem data buffer.
+ * @param[in] ui_buf_count Length of button data buffer.
+ * @param[in] accel_buf_count Length of accelerometer data buffer.
+ * @param[in] bat_buf_count Length of battery data buffer.
+ *
+ * @return 0 on success. -ENODATA if no entry is queued. Otherwise a negative error code is
+ *         returned.
+ */
+int cbor_common_batch_encode(struct cloud_codec_data *output,
+			     struct cloud_data_gps *gps_buf,
+			     struct cloud_data_sensors *sensor_buf,
+			     struct cloud_data_modem_dynamic *modem_dyn_buf,
+			     struct cloud_data_ui *ui_buf,
+			     struct cloud_data_accelerometer *accel_buf,
+			     struct cloud_data_battery *bat_buf,
+			     size_t gps_buf_count,
+			     size_t sensor_buf_count,
+			     size_t modem_dyn_buf_count,
+			     size_t ui_buf_count,
+			     size_t accel_buf_count,
+			     size_t bat_buf_count);
+
+#ifdef __cplusplus
+}
+#endif
+/**
+ * @}
+ */
+#endif /* CBOR_COMMON_H__ */
@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr.h>
+#include <errno.h>
+#include <string.h>
+
+#include "cbor_writer.h"
+
+/* Major types, RFC 8949 section 3.1. */
+#define MAJOR_UINT	0
+#define MAJOR_NINT	1
+#define MAJOR_TSTR	3
+#define MAJOR_ARRAY	4
+#define MAJOR_MAP	5
+
+/* Additional information for arguments that follow the initial byte. */
+#define ARG_1_BYTE	24
+#define ARG_2_BYTES	25
+#define ARG_4_BYTES	26
+#define ARG_8_BYTES	27
+
+static void put(struct cbor_writer *writer, const void *data, size_t len)
+{
+	if (writer->err) {
+		return;
+	}
+
+	if (writer->buf != NULL) {
+		if (writer->len + len > writer->size) {
+			writer->err = -ENOMEM;
+			return;
+		}
+
+		memcpy(writer->buf + writer->len, data, len);
+	}
+
+	writer->len += len;
+}
+
+/* Initial byte and argument, in the shortest form. */
+static int head_put(struct cbor_writer *writer, uint8_t major, uint64_t arg)
+{
+	uint8_t head[9];
+	size_t arg_len;
+
+	if (arg < ARG_1_BYTE) {
+		head[0] = (major << 5) | arg;
+		put(writer, head, 1);
+		return writer->err;
+	} else if (arg <= UINT8_MAX) {
+		head[0] = (major << 5) | ARG_1_BYTE;
+		arg_len = 1;
+	} else if (arg <= UINT16_MAX) {
+		head[0] = (major << 5) | ARG_2_BYTES;
+		arg_len = 2;
+	} else if (arg <= UINT32_MAX) {
+		head[0] = (major << 5) | ARG_4_BYTES;
+		arg_len = 4;
+	} else {
+		head[0] = (major << 5) | ARG_8_BYTES;
+		arg_len = 8;
+	}
+
+	/* Network byte order. */
+	for (size_t i = 0; i < arg_len; i++) {
+		head[arg_len - i] = arg >> (8 * i);
+	}
+
+	put(writer, head, 1 + arg_len);
+
+	return writer->err;
+}
+
+void cbor_writer_init(struct cbor_writer *writer, uint8_t *buf, size_t size)
+{
+	__ASSERT_NO_MSG(writer);
+
+	writer->buf = buf;
+	writer->size = size;
+	writer->len = 0;
+	writer->err = 0;
+}
+
+int cbor_writer_uint(struct cbor_writer *writer, uint64_t value)
+{
+	return head_put(writer, MAJOR_UINT, value);
+}
+
+int cbor_writer_int(struct cbor_writer *writer, int64_t value)
+{
+	if (value >= 0) {
+		return head_put(writer, MAJOR_UINT, value);
+	}
+
+	/* Negative integers are encoded as -1 - n. */
+	return head_put(writer, MAJOR_NINT, -1 - value);
+}
+
+int cbor_writer_tstr(struct cbor_writer *writer, const char *value)
+{
+	size_t len = strlen(value);
+
+	head_put(writer, MAJOR_TSTR, len);
+	put(writer, value, len);
+
+	return writer->err;
+}
+
+int cbor_writer_array_start(struct cbor_writer *writer, size_t count)
+{
+	return head_put(writer, MAJOR_ARRAY, count);
+}
+
+int cbor_writer_map_start(struct cbor_writer *writer, size_t count)
+{
+	return head_put(writer, MAJOR_MAP, count);
+}
+
+int cbor_writer_finish(struct cbor_writer *writer)
+{
+	if (writer->err) {
+		return writer->err;
+	}
+
+	return writer->len;
+}
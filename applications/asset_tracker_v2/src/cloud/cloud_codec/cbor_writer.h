@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/**@file
+ * @brief CBOR writer.
+ */
+
+#ifndef CBOR_WRITER_H__
+#define CBOR_WRITER_H__
+
+/**@file
+ *
+ * @defgroup cbor_writer cbor_writer
+ * @brief    Module that writes CBOR (RFC 8949) data items directly into a buffer.
+ *
+ * Only the data items used by the cloud codecs are supported: integers, text strings, and
+ * arrays and maps of known length. Each item is written in its shortest form. Errors are sticky,
+ * as with the JSON writer.
+ * @{
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <zephyr.h>
+#include <stdbool.h>
+
+/** @brief Writer state. */
+struct cbor_writer {
+	uint8_t *buf;
+	size_t size;
+	/** Length of the output, also counted when nothing is written. */
+	size_t len;
+	int err;
+};
+
+/**
+ * @brief Initialize a writer.
+ *
+ * @param[out] writer Writer.
+ * @param[in] buf Output buffer, or NULL to only compute the length of the output.
+ * @param[in] size Size of the output buffer.
+ */
+void cbor_writer_init(struct cbor_writer *writer, uint8_t *buf, size_t size);
+
+/**
+ * @brief Check if the writer only computes the length of the output.
+ *
+ * @param[in] writer Writer.
+ *
+ * @return true if nothing is written.
+ */
+static inline bool cbor_writer_is_sizing(const struct cbor_writer *writer)
+{
+	return writer->buf == NULL;
+}
+
+/**
+ * @brief Add an unsigned integer.
+ *
+ * @param[in] writer Writer.
+ * @param[in] value Integer.
+ *
+ * @return 0 on success, otherwise a negative error code.
+ */
+int cbor_writer_uint(struct cbor_writer *writer, uint64_t value);
+
+/**
+ * @brief Add a signed integer.
+ *
+ * @param[in] writer Writer.
+ * @param[in] value Integer.
+ *
+ * @return 0 on success, otherwise a negative error code.
+ */
+int cbor_writer_int(struct cbor_writer *writer, int64_t value);
+
+/**
+ * @brief Add a text string.
+ *
+ * @param[in] writer Writer.
+ * @param[in] value Null-terminated UTF-8 string.
+ *
+ * @return 0 on success, otherwise a negative error code.
+ */
+int cbor_writer_tstr(struct cbor_writer *writer, const char *value);
+
+/**
+ * @brief Start an array. It ends after @p count items have been added to it.
+ *
+ * @param[in] writer Writer.
+ * @param[in] count Number of items in the array.
+ *
+ * @return 0 on success, otherwise a negative error code.
+ */
+int cbor_writer_array_start(struct cbor_writer *writer, size_t count);
+
+/**
+ * @brief Start a map. It ends after @p count pairs of key and value have been added to it.
+ *
+ * @param[in] writer Writer.
+ * @param[in] count Number of pairs in the map.
+ *
+ * @return 0 on success, otherwise a negative error code.
+ */
+int cbor_writer_map_start(struct cbor_writer *writer, size_t count);
+
+/**
+ * @brief Finish the output.
+ *
+ * @param[in] writer Writer.
+ *
+ * @return Length of the output on success. -ENOMEM if the output did not fit in the buffer.
+ */
+int cbor_writer_finish(struct cbor_writer *writer);
+
+#ifdef __cplusplus
+}
+#endif
+/**
+ * @}
+ */
+#endif /* CBOR_WRITER_H__ */
@@ -35,7 +35,7 @@ struct cloud_data_battery {
 	/** Battery data timestamp. UNIX milliseconds. */
 	int64_t bat_ts;
 	/** Flag signifying that the data entry is to be encoded. */
-	bool queued : 1;
+	bool queued;
 };
 
 struct cloud_data_gps_pvt {
@@ -78,7 +78,7 @@ struct cloud_data_gps {
 	enum cloud_data_gps_format format;
 
 	/** Flag signifying that the data entry is to be encoded. */
-	bool queued : 1;
+	bool queued;
 };
 
 /** Structure containing boolean variables used to enable/disable inclusion of the corresponding
@@ -126,7 +126,7 @@ struct cloud_data_accelerometer {
 	/** Accelerometer readings. */
 	double values[3];
 	/** Flag signifying that the data entry is to be published. */
-	bool queued : 1;
+	bool queued;
 };
 
 struct cloud_data_sensors {
@@ -137,7 +137,7 @@ struct cloud_data_sensors {
 	/** Humidity level in percentage */
 	double hum;
 	/** Flag signifying that the data entry is to be encoded. */
-	bool queued : 1;
+	bool queued;
 };
 
 struct cloud_data_modem_static {
@@ -161,6 +161,16 @@ struct cloud_data_modem_static {
 	char fw[40];
 	/** Flag signifying that the data entry is to be encoded. */
 	bool queued : 1;
+
+	/** Flags to signify if the corresponding data value is fresh and can be used. The network
+	 *  mode flag covers nw_gps, nw_lte_m and nw_nb_iot.
+	 */
+	bool bnd_fresh	   : 1;
+	bool nw_mode_fresh : 1;
+	bool iccid_fresh   : 1;
+	bool appv_fresh	   : 1;
+	bool brdv_fresh	   : 1;
+	bool fw_fresh	   : 1;
 };
 
 struct cloud_data_modem_dynamic {
@@ -177,14 +187,14 @@ struct cloud_data_modem_dynamic {
 	/* Mobile Country Code*/
 	char mccmnc[7];
 	/** Flag signifying that the data entry is to be encoded. */
-	bool queued : 1;
+	bool queued;
 
 	/** Flags to signify if the corresponding data value is fresh and can be used. */
-	bool area_code_fresh	: 1;
-	bool cell_id_fresh	: 1;
-	bool rsrp_fresh		: 1;
-	bool ip_address_fresh	: 1;
-	bool mccmnc_fresh	: 1;
+	bool area_code_fresh;
+	bool cell_id_fresh;
+	bool rsrp_fresh;
+	bool ip_address_fresh;
+	bool mccmnc_fresh;
 };
 
 struct cloud_data_ui {
@@ -193,7 +203,7 @@ struct cloud_data_ui {
 	/** Button data timestamp. UNIX milliseconds. */
 	int64_t btn_ts;
 	/** Flag signifying that the data entry is to be encoded. */
-	bool queued : 1;
+	bool queued;
 };
 
 struct cloud_codec_data {
@@ -284,39 +294,6 @@ int cloud_codec_encode_batch_data(
 				size_t accel_buf_count,
 				size_t bat_buf_count);
 
-void cloud_codec_populate_sensor_buffer(
-				struct cloud_data_sensors *sensor_buffer,
-				struct cloud_data_sensors *new_sensor_data,
-				int *head_sensor_buf,
-				size_t buffer_count);
-
-void cloud_codec_populate_ui_buffer(struct cloud_data_ui *ui_buffer,
-				    struct cloud_data_ui *new_ui_data,
-				    int *head_ui_buf,
-				    size_t buffer_count);
-
-void cloud_codec_populate_accel_buffer(
-				struct cloud_data_accelerometer *accel_buf,
-				struct cloud_data_accelerometer *new_accel_data,
-				int *head_accel_buf,
-				size_t buffer_count);
-
-void cloud_codec_populate_bat_buffer(struct cloud_data_battery *bat_buffer,
-				     struct cloud_data_battery *new_bat_data,
-				     int *head_bat_buf,
-				     size_t buffer_count);
-
-void cloud_codec_populate_gps_buffer(struct cloud_data_gps *gps_buffer,
-				     struct cloud_data_gps *new_gps_data,
-				     int *head_gps_buf,
-				     size_t buffer_count);
-
-void cloud_codec_populate_modem_dynamic_buffer(
-				struct cloud_data_modem_dynamic *modem_buffer,
-				struct cloud_data_modem_dynamic *new_modem_data,
-				int *head_modem_buf,
-				size_t buffer_count);
-
 static inline void cloud_codec_release_data(struct cloud_codec_data *output)
 {
 	cJSON_FreeString(output->buf);
@@ -4,164 +4,254 @@
  * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
  */
 
-#include <cloud_codec.h>
 #include <zephyr.h>
-#include <cJSON.h>
-#include <cJSON_os.h>
-#include <math.h>
+#include <string.h>
+
+#include "cloud_codec_ringbuffer.h"
 
 #include <logging/log.h>
 LOG_MODULE_REGISTER(cloud_codec_ringbuffer, CONFIG_CLOUD_CODEC_LOG_LEVEL);
 
-void cloud_codec_populate_sensor_buffer(
-				struct cloud_data_sensors *sensor_buffer,
-				struct cloud_data_sensors *new_sensor_data,
-				int *head_sensor_buf,
-				size_t buffer_count)
+static size_t column_size(const struct cloud_codec_ringbuffer_column *column, size_t count)
 {
-	if (!IS_ENABLED(CONFIG_DATA_SENSOR_BUFFER_STORE)) {
-		return;
-	}
+	return DIV_ROUND_UP(count * CLOUD_CODEC_RINGBUFFER_BITS(column->type, column->size), 8);
+}
 
-	if (!new_sensor_data->queued) {
-		return;
+static uint32_t uint_get(const uint8_t *field, size_t size)
+{
+	switch (size) {
+	case sizeof(uint8_t):
+		return *field;
+	case sizeof(uint16_t):
+		return *(const uint16_t *)field;
+	case sizeof(uint32_t):
+		return *(const uint32_t *)field;
+	default:
+		__ASSERT(false, "Unsupported integer size %d", size);
+		return 0;
 	}
+}
 
-	/* Go to start of buffer if end is reached. */
-	*head_sensor_buf += 1;
-	if (*head_sensor_buf == buffer_count) {
-		*head_sensor_buf = 0;
+static void uint_set(uint8_t *field, size_t size, uint32_t value)
+{
+	switch (size) {
+	case sizeof(uint8_t):
+		*field = value;
+		break;
+	case sizeof(uint16_t):
+		*(uint16_t *)field = value;
+		break;
+	case sizeof(uint32_t):
+		*(uint32_t *)field = value;
+		break;
+	default:
+		__ASSERT(false, "Unsupported integer size %d", size);
+		break;
 	}
+}
 
-	sensor_buffer[*head_sensor_buf] = *new_sensor_data;
+/* Rounded half away from zero and saturated, without depending on the math library. */
+static int32_t fixed_point(double value, int32_t scale)
+{
+	double scaled = value * scale;
 
-	LOG_DBG("Entry: %d of %d in sensor buffer filled", *head_sensor_buf,
-		buffer_count - 1);
+	if (scaled >= INT32_MAX) {
+		return INT32_MAX;
+	} else if (scaled <= INT32_MIN) {
+		return INT32_MIN;
+	}
+
+	return (int32_t)(scaled < 0 ? scaled - 0.5 : scaled + 0.5);
 }
 
-void cloud_codec_populate_ui_buffer(struct cloud_data_ui *ui_buffer,
-				   struct cloud_data_ui *new_ui_data,
-				   int *head_ui_buf,
-				   size_t buffer_count)
+static void column_store(const struct cloud_codec_ringbuffer_column *column, size_t slot,
+			 const uint8_t *entry)
 {
-	if (!IS_ENABLED(CONFIG_DATA_UI_BUFFER_STORE)) {
-		return;
+	const uint8_t *field = entry + column->offset;
+
+	switch (column->type) {
+	case CLOUD_CODEC_RINGBUFFER_COPY:
+		memcpy(column->data + slot * column->size, field, column->size);
+		break;
+	case CLOUD_CODEC_RINGBUFFER_U8:
+		column->data[slot] = MIN(uint_get(field, column->size), UINT8_MAX);
+		break;
+	case CLOUD_CODEC_RINGBUFFER_FIXED: {
+		double value;
+		int32_t fixed;
+
+		__ASSERT_NO_MSG(column->size == sizeof(value));
+
+		memcpy(&value, field, sizeof(value));
+		fixed = fixed_point(value, column->scale);
+		memcpy(column->data + slot * sizeof(fixed), &fixed, sizeof(fixed));
 	}
-
-	if (!new_ui_data->queued) {
-		return;
+		break;
+	case CLOUD_CODEC_RINGBUFFER_BOOL:
+		WRITE_BIT(column->data[slot / 8], slot % 8, *(const bool *)field);
+		break;
 	}
+}
 
-	/* Go to start of buffer if end is reached. */
-	*head_ui_buf += 1;
-	if (*head_ui_buf == buffer_count) {
-		*head_ui_buf = 0;
+static void column_load(const struct cloud_codec_ringbuffer_column *column, size_t slot,
+			uint8_t *entry)
+{
+	uint8_t *field = entry + column->offset;
+
+	switch (column->type) {
+	case CLOUD_CODEC_RINGBUFFER_COPY:
+		memcpy(field, column->data + slot * column->size, column->size);
+		break;
+	case CLOUD_CODEC_RINGBUFFER_U8:
+		uint_set(field, column->size, column->data[slot]);
+		break;
+	case CLOUD_CODEC_RINGBUFFER_FIXED: {
+		double value;
+		int32_t fixed;
+
+		memcpy(&fixed, column->data + slot * sizeof(fixed), sizeof(fixed));
+		value = (double)fixed / column->scale;
+		memcpy(field, &value, sizeof(value));
 	}
+		break;
+	case CLOUD_CODEC_RINGBUFFER_BOOL:
+		*(bool *)field = column->data[slot / 8] & BIT(slot % 8);
+		break;
+	}
+}
 
-	ui_buffer[*head_ui_buf] = *new_ui_data;
-
-	LOG_DBG("Entry: %d of %d in UI buffer filled", *head_ui_buf,
-		buffer_count - 1);
+static size_t slot_get(const struct cloud_codec_ringbuffer *ring, size_t index)
+{
+	return (ring->oldest + index) % ring->count;
 }
 
-void cloud_codec_populate_accel_buffer(
-				struct cloud_data_accelerometer *mov_buf,
-				struct cloud_data_accelerometer *new_accel_data,
-				int *head_mov_buf,
-				size_t buffer_count)
+static void entry_store(const struct cloud_codec_ringbuffer *ring, size_t slot,
+			const void *entry)
 {
-	if (!IS_ENABLED(CONFIG_DATA_ACCELEROMETER_BUFFER_STORE)) {
-		return;
+	for (size_t i = 0; i < ring->column_count; i++) {
+		column_store(&ring->columns[i], slot, entry);
 	}
+}
 
-	if (!new_accel_data->queued) {
-		return;
-	}
+static void entry_load(const struct cloud_codec_ringbuffer *ring, size_t slot, int64_t ts,
+		       void *entry)
+{
+	memset(entry, 0, ring->entry_size);
+	memcpy((uint8_t *)entry + ring->ts_offset, &ts, sizeof(ts));
 
-	/* Go to start of buffer if end is reached. */
-	*head_mov_buf += 1;
-	if (*head_mov_buf == buffer_count) {
-		*head_mov_buf = 0;
+	for (size_t i = 0; i < ring->column_count; i++) {
+		column_load(&ring->columns[i], slot, entry);
 	}
+}
 
-	mov_buf[*head_mov_buf] = *new_accel_data;
+static void oldest_drop(struct cloud_codec_ringbuffer *ring)
+{
+	ring->oldest = slot_get(ring, 1);
+	ring->len--;
 
-	LOG_DBG("Entry: %d of %d in movement buffer filled", *head_mov_buf,
-		buffer_count - 1);
+	if (ring->len > 0) {
+		ring->ts_oldest += ring->ts_deltas[ring->oldest];
+	}
 }
 
-void cloud_codec_populate_bat_buffer(struct cloud_data_battery *bat_buffer,
-				     struct cloud_data_battery *new_bat_data,
-				     int *head_bat_buf,
-				     size_t buffer_count)
+void cloud_codec_ringbuffer_put(struct cloud_codec_ringbuffer *ring, const void *entry)
 {
-	if (!IS_ENABLED(CONFIG_DATA_BATTERY_BUFFER_STORE)) {
-		return;
+	int64_t ts;
+	int64_t delta = 0;
+	size_t slot;
+
+	memcpy(&ts, (const uint8_t *)entry + ring->ts_offset, sizeof(ts));
+
+	if (ring->len == ring->count) {
+		oldest_drop(ring);
 	}
 
-	if (!new_bat_data->queued) {
-		return;
+	if (ring->len > 0) {
+		delta = ts - ring->ts_newest;
+
+		if ((delta < INT32_MIN) || (delta > INT32_MAX)) {
+			LOG_WRN("Timestamp too far from the previous entry, %d entries dropped "
+				"from %s", ring->len, ring->name);
+			ring->len = 0;
+			delta = 0;
+		}
 	}
 
-	/* Go to start of buffer if end is reached. */
-	*head_bat_buf += 1;
-	if (*head_bat_buf == buffer_count) {
-		*head_bat_buf = 0;
+	if (ring->len == 0) {
+		ring->oldest = 0;
+		ring->ts_oldest = ts;
 	}
 
-	bat_buffer[*head_bat_buf] = *new_bat_data;
+	slot = slot_get(ring, ring->len);
+	ring->ts_deltas[slot] = delta;
+	ring->ts_newest = ts;
+	ring->len++;
 
-	LOG_DBG("Entry: %d of %d in battery buffer filled", *head_bat_buf,
-		buffer_count - 1);
+	entry_store(ring, slot, entry);
+
+	LOG_DBG("Entry: %d of %d in %s filled", ring->len, ring->count, ring->name);
 }
 
-void cloud_codec_populate_gps_buffer(struct cloud_data_gps *gps_buffer,
-				    struct cloud_data_gps *new_gps_data,
-				    int *head_gps_buf,
-				    size_t buffer_count)
+int cloud_codec_ringbuffer_get(const struct cloud_codec_ringbuffer *ring, size_t index,
+			       void *entry)
 {
-	if (!IS_ENABLED(CONFIG_DATA_GPS_BUFFER_STORE)) {
-		return;
-	}
+	int64_t ts = ring->ts_oldest;
 
-	if (!new_gps_data->queued) {
-		return;
+	if (index >= ring->len) {
+		return -ENOENT;
 	}
 
-	/* Go to start of buffer if end is reached. */
-	*head_gps_buf += 1;
-	if (*head_gps_buf == buffer_count) {
-		*head_gps_buf = 0;
+	for (size_t i = 1; i <= index; i++) {
+		ts += ring->ts_deltas[slot_get(ring, i)];
 	}
 
-	gps_buffer[*head_gps_buf] = *new_gps_data;
+	entry_load(ring, slot_get(ring, index), ts, entry);
 
-	LOG_DBG("Entry: %d of %d in GPS buffer filled", *head_gps_buf,
-		buffer_count - 1);
+	return 0;
 }
 
-void cloud_codec_populate_modem_dynamic_buffer(
-				struct cloud_data_modem_dynamic *modem_buffer,
-				struct cloud_data_modem_dynamic *new_modem_data,
-				int *head_modem_buf,
-				size_t buffer_count)
+int cloud_codec_ringbuffer_set(struct cloud_codec_ringbuffer *ring, size_t index,
+			       const void *entry)
 {
-	if (!IS_ENABLED(CONFIG_DATA_DYNAMIC_MODEM_BUFFER_STORE)) {
-		return;
+	if (index >= ring->len) {
+		return -ENOENT;
 	}
 
-	if (!new_modem_data->queued) {
-		return;
+	entry_store(ring, slot_get(ring, index), entry);
+
+	return 0;
+}
+
+void cloud_codec_ringbuffer_copy(const struct cloud_codec_ringbuffer *ring, void *entries)
+{
+	int64_t ts = ring->ts_oldest;
+
+	for (size_t i = 0; i < ring->len; i++) {
+		size_t slot = slot_get(ring, i);
+
+		if (i > 0) {
+			ts += ring->ts_deltas[slot];
+		}
+
+		entry_load(ring, slot, ts, (uint8_t *)entries + i * ring->entry_size);
 	}
+}
 
-	/* Go to start of buffer if end is reached. */
-	*head_modem_buf += 1;
-	if (*head_modem_buf == buffer_count) {
-		*head_modem_buf = 0;
+void cloud_codec_ringbuffer_update(struct cloud_codec_ringbuffer *ring, const void *entries)
+{
+	for (size_t i = 0; i < ring->len; i++) {
+		entry_store(ring, slot_get(ring, i),
+			    (const uint8_t *)entries + i * ring->entry_size);
 	}
+}
 
-	modem_buffer[*head_modem_buf] = *new_modem_data;
+size_t cloud_codec_ringbuffer_ram_size(const struct cloud_codec_ringbuffer *ring)
+{
+	size_t size = ring->count * sizeof(ring->ts_deltas[0]);
+
+	for (size_t i = 0; i < ring->column_count; i++) {
+		size += column_size(&ring->columns[i], ring->count);
+	}
 
-	LOG_DBG("Entry: %d of %d in dynamic modem buffer filled",
-		*head_modem_buf, buffer_count - 1);
+	return size;
 }
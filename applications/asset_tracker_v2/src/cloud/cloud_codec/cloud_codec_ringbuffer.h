@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/**@file
+ * @brief Cloud codec ringbuffer header.
+ */
+
+#ifndef CLOUD_CODEC_RINGBUFFER_H__
+#define CLOUD_CODEC_RINGBUFFER_H__
+
+/**@file
+ *
+ * @defgroup cloud_codec_ringbuffer cloud_codec_ringbuffer
+ * @brief    Ringbuffer that stores entries of a cloud data type column by column.
+ *
+ * Each field of the entry structure that must be kept is described by a column, which stores the
+ * field of all entries in its own array, in a compact representation. The timestamp of an entry
+ * is stored as the difference from the timestamp of the previous entry. Entries are copied in and
+ * out of the ringbuffer as structures, so that they can be passed to the codecs.
+ * @{
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <zephyr.h>
+#include <stddef.h>
+
+/** @brief Representation of a field in a column. */
+enum cloud_codec_ringbuffer_type {
+	/** Field stored as is. */
+	CLOUD_CODEC_RINGBUFFER_COPY,
+	/** Unsigned integer field stored in one byte. */
+	CLOUD_CODEC_RINGBUFFER_U8,
+	/** Double field stored as a 32-bit fixed-point number, with a decimal scale. */
+	CLOUD_CODEC_RINGBUFFER_FIXED,
+	/** Bool field stored in one bit. */
+	CLOUD_CODEC_RINGBUFFER_BOOL,
+};
+
+/** @brief Column of a ringbuffer. */
+struct cloud_codec_ringbuffer_column {
+	/** Offset of the field in the entry structure. */
+	uint16_t offset;
+	/** Size of the field in the entry structure. */
+	uint16_t size;
+	/** Representation of the field in the column. */
+	enum cloud_codec_ringbuffer_type type;
+	/** Number of units per unit of the field, for fixed-point columns. */
+	int32_t scale;
+	/** Storage of the column. */
+	uint8_t *data;
+};
+
+/** @brief Ringbuffer. Defined with CLOUD_CODEC_RINGBUFFER_DEFINE(). */
+struct cloud_codec_ringbuffer {
+	/** Name used in log messages. */
+	const char *name;
+	const struct cloud_codec_ringbuffer_column *columns;
+	size_t column_count;
+	/** Size of the entry structure. */
+	size_t entry_size;
+	/** Offset of the int64_t timestamp in the entry structure. */
+	size_t ts_offset;
+	/** Timestamp of each entry, relative to the previous entry. */
+	int32_t *ts_deltas;
+	/** Maximum number of entries. */
+	size_t count;
+
+	/** Slot of the oldest entry. */
+	size_t oldest;
+	/** Number of entries. */
+	size_t len;
+	int64_t ts_oldest;
+	int64_t ts_newest;
+};
+
+/** @cond INTERNAL_HIDDEN */
+#define CLOUD_CODEC_RINGBUFFER_BITS(_type, _size)				\
+	(((_type) == CLOUD_CODEC_RINGBUFFER_BOOL) ? 1 :				\
+	 ((_type) == CLOUD_CODEC_RINGBUFFER_U8) ? 8 :				\
+	 ((_type) == CLOUD_CODEC_RINGBUFFER_FIXED) ? 32 : 8 * (_size))
+
+#define CLOUD_CODEC_RINGBUFFER_FIELD_SIZE(_struct, _field) sizeof(((_struct *)0)->_field)
+/** @endcond */
+
+/**
+ * @brief Describe a column and allocate its storage.
+ *
+ * @param _struct Entry structure.
+ * @param _field Field of the entry structure.
+ * @param _type Representation of the field, see @ref cloud_codec_ringbuffer_type.
+ * @param _scale Number of units per unit of the field for fixed-point columns, otherwise 0.
+ * @param _count Maximum number of entries in the ringbuffer.
+ */
+#define CLOUD_CODEC_RINGBUFFER_COLUMN(_struct, _field, _type, _scale, _count)		\
+	{										\
+		.offset = offsetof(_struct, _field),					\
+		.size = CLOUD_CODEC_RINGBUFFER_FIELD_SIZE(_struct, _field),		\
+		.type = (_type),							\
+		.scale = (_scale),							\
+		.data = (uint8_t [DIV_ROUND_UP((_count) * CLOUD_CODEC_RINGBUFFER_BITS(	\
+			_type, CLOUD_CODEC_RINGBUFFER_FIELD_SIZE(_struct, _field)), 8)]){ 0 } \
+	}
+
+/**
+ * @brief Define a ringbuffer.
+ *
+ * @param _name Name of the ringbuffer variable.
+ * @param _struct Entry structure.
+ * @param _ts_field int64_t timestamp field of the entry structure.
+ * @param _count Maximum number of entries.
+ * @param ... Columns, described with CLOUD_CODEC_RINGBUFFER_COLUMN().
+ */
+#define CLOUD_CODEC_RINGBUFFER_DEFINE(_name, _struct, _ts_field, _count, ...)		\
+	BUILD_ASSERT(CLOUD_CODEC_RINGBUFFER_FIELD_SIZE(_struct, _ts_field) ==		\
+		     sizeof(int64_t));							\
+	static const struct cloud_codec_ringbuffer_column _name##_columns[] = {	\
+		__VA_ARGS__								\
+	};										\
+	static int32_t _name##_ts_deltas[_count];					\
+	static struct cloud_codec_ringbuffer _name = {					\
+		.name = STRINGIFY(_name),						\
+		.columns = _name##_columns,						\
+		.column_count = ARRAY_SIZE(_name##_columns),				\
+		.entry_size = sizeof(_struct),						\
+		.ts_offset = offsetof(_struct, _ts_field),				\
+		.ts_deltas = _name##_ts_deltas,						\
+		.count = (_count),							\
+	}
+
+/**
+ * @brief Add an entry, replacing the oldest entry if the ringbuffer is full.
+ *
+ * If the timestamp of the entry is too far from the timestamp of the previous entry to be stored
+ * as a difference, the older entries are dropped.
+ *
+ * @param[in] ring Ringbuffer.
+ * @param[in] entry Entry structure.
+ */
+void cloud_codec_ringbuffer_put(struct cloud_codec_ringbuffer *ring, const void *entry);
+
+/**
+ * @brief Get an entry.
+ *
+ * Fields that are not stored in any column are set to zero.
+ *
+ * @param[in] ring Ringbuffer.
+ * @param[in] index Index of the entry, 0 being the oldest.
+ * @param[out] entry Entry structure.
+ *
+ * @return 0 on success. -ENOENT if there is no entry at @p index.
+ */
+int cloud_codec_ringbuffer_get(const struct cloud_codec_ringbuffer *ring, size_t index,
+			       void *entry);
+
+/**
+ * @brief Update an entry, typically to store that it is no longer queued.
+ *
+ * The timestamp of the entry is left unchanged, as the codecs convert it in place.
+ *
+ * @param[in] ring Ringbuffer.
+ * @param[in] index Index of the entry, 0 being the oldest.
+ * @param[in] entry Entry structure.
+ *
+ * @return 0 on success. -ENOENT if there is no entry at @p index.
+ */
+int cloud_codec_ringbuffer_set(struct cloud_codec_ringbuffer *ring, size_t index,
+			       const void *entry);
+
+/**
+ * @brief Get all entries, oldest first.
+ *
+ * @param[in] ring Ringbuffer.
+ * @param[out] entries Array of cloud_codec_ringbuffer_len() entry structures.
+ */
+void cloud_codec_ringbuffer_copy(const struct cloud_codec_ringbuffer *ring, void *entries);
+
+/**
+ * @brief Update all entries from an array filled by cloud_codec_ringbuffer_copy().
+ *
+ * @param[in] ring Ringbuffer.
+ * @param[in] entries Array of cloud_codec_ringbuffer_len() entry structures.
+ */
+void cloud_codec_ringbuffer_update(struct cloud_codec_ringbuffer *ring, const void *entries);
+
+/**
+ * @brief Get the number of entries.
+ *
+ * @param[in] ring Ringbuffer.
+ *
+ * @return Number of entries.
+ */
+static inline size_t cloud_codec_ringbuffer_len(const struct cloud_codec_ringbuffer *ring)
+{
+	return ring->len;
+}
+
+/**
+ * @brief Get the size of the storage of the ringbuffer, including the timestamps.
+ *
+ * @param[in] ring Ringbuffer.
+ *
+ * @return Size in bytes.
+ */
+size_t cloud_codec_ringbuffer_ram_size(const struct cloud_codec_ringbuffer *ring);
+
+#ifdef __cplusplus
+}
+#endif
+/**
+ * @}
+ */
+#endif /* CLOUD_CODEC_RINGBUFFER_H__ */
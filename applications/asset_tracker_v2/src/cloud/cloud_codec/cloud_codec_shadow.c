@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr.h>
+#include <string.h>
+
+#include "cloud_codec_shadow.h"
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(cloud_codec_shadow, CONFIG_CLOUD_CODEC_LOG_LEVEL);
+
+#define FNV_OFFSET_BASIS 2166136261u
+#define FNV_PRIME	 16777619u
+
+enum modem_static_field {
+	MODEM_STATIC_BAND,
+	MODEM_STATIC_NW_MODE,
+	MODEM_STATIC_ICCID,
+	MODEM_STATIC_FW,
+	MODEM_STATIC_BOARD,
+	MODEM_STATIC_APP_VERSION,
+};
+
+enum config_field {
+	CFG_ACTIVE_MODE,
+	CFG_GPS_TIMEOUT,
+	CFG_ACTIVE_WAIT_TIMEOUT,
+	CFG_MOVEMENT_RESOLUTION,
+	CFG_MOVEMENT_TIMEOUT,
+	CFG_ACCELEROMETER_THRESHOLD,
+	CFG_NOD_LIST,
+};
+
+struct shadow_section {
+	/* Hashes of the fields last acknowledged by the cloud. */
+	uint32_t reported[CLOUD_CODEC_SHADOW_FIELD_MAX];
+	/* Hashes of the fields in the message waiting to be acknowledged. */
+	uint32_t pending[CLOUD_CODEC_SHADOW_FIELD_MAX];
+	/* Bitmasks of the valid entries in the arrays above. */
+	uint8_t reported_valid;
+	uint8_t pending_valid;
+};
+
+BUILD_ASSERT(CLOUD_CODEC_SHADOW_FIELD_MAX <= 8, "Field bitmask too small");
+
+static struct shadow_section sections[CLOUD_CODEC_SHADOW_SECTION_COUNT];
+
+/* Sections are updated from the data module and from the cloud integration layer. */
+static struct k_spinlock lock;
+
+/* 32-bit FNV-1a hash. */
+static uint32_t hash(const void *value, size_t len)
+{
+	const uint8_t *byte = value;
+	uint32_t h = FNV_OFFSET_BASIS;
+
+	for (size_t i = 0; i < len; i++) {
+		h ^= byte[i];
+		h *= FNV_PRIME;
+	}
+
+	return h;
+}
+
+bool cloud_codec_shadow_update(enum cloud_codec_shadow_section section, uint8_t field,
+			       const void *value, size_t len)
+{
+	__ASSERT_NO_MSG(section < CLOUD_CODEC_SHADOW_SECTION_COUNT);
+	__ASSERT_NO_MSG(field < CLOUD_CODEC_SHADOW_FIELD_MAX);
+
+	struct shadow_section *s = &sections[section];
+	uint32_t h = hash(value, len);
+	uint8_t bit = BIT(field);
+	bool changed;
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	s->pending[field] = h;
+	s->pending_valid |= bit;
+	changed = !(s->reported_valid & bit) || (s->reported[field] != h);
+
+	k_spin_unlock(&lock, key);
+
+	return changed;
+}
+
+static bool str_update(enum cloud_codec_shadow_section section, uint8_t field, const char *str)
+{
+	return cloud_codec_shadow_update(section, field, str, strlen(str));
+}
+
+bool cloud_codec_shadow_modem_static_diff(struct cloud_data_modem_static *data)
+{
+	const enum cloud_codec_shadow_section section = CLOUD_CODEC_SHADOW_MODEM_STATIC;
+
+	/* The network mode is encoded as a single string. */
+	const uint16_t nw_mode[] = { data->nw_lte_m, data->nw_nb_iot, data->nw_gps };
+
+	data->bnd_fresh = cloud_codec_shadow_update(section, MODEM_STATIC_BAND,
+						    &data->bnd, sizeof(data->bnd));
+	data->nw_mode_fresh = cloud_codec_shadow_update(section, MODEM_STATIC_NW_MODE,
+							nw_mode, sizeof(nw_mode));
+	data->iccid_fresh = str_update(section, MODEM_STATIC_ICCID, data->iccid);
+	data->fw_fresh = str_update(section, MODEM_STATIC_FW, data->fw);
+	data->brdv_fresh = str_update(section, MODEM_STATIC_BOARD, data->brdv);
+	data->appv_fresh = str_update(section, MODEM_STATIC_APP_VERSION, data->appv);
+
+	return data->bnd_fresh || data->nw_mode_fresh || data->iccid_fresh ||
+	       data->fw_fresh || data->brdv_fresh || data->appv_fresh;
+}
+
+bool cloud_codec_shadow_config_diff(struct cloud_data_cfg *cfg)
+{
+	const enum cloud_codec_shadow_section section = CLOUD_CODEC_SHADOW_CONFIG;
+
+	/* Hash the flags one by one, the structure might contain padding. */
+	const uint8_t nod_list[] = { cfg->no_data.gnss, cfg->no_data.neighbor_cell };
+	const uint8_t active_mode = cfg->active_mode;
+
+	cfg->active_mode_fresh = cloud_codec_shadow_update(section, CFG_ACTIVE_MODE,
+							   &active_mode, sizeof(active_mode));
+	cfg->gps_timeout_fresh = cloud_codec_shadow_update(section, CFG_GPS_TIMEOUT,
+							   &cfg->gps_timeout,
+							   sizeof(cfg->gps_timeout));
+	cfg->active_wait_timeout_fresh =
+		cloud_codec_shadow_update(section, CFG_ACTIVE_WAIT_TIMEOUT,
+					  &cfg->active_wait_timeout,
+					  sizeof(cfg->active_wait_timeout));
+	cfg->movement_resolution_fresh =
+		cloud_codec_shadow_update(section, CFG_MOVEMENT_RESOLUTION,
+					  &cfg->movement_resolution,
+					  sizeof(cfg->movement_resolution));
+	cfg->movement_timeout_fresh =
+		cloud_codec_shadow_update(section, CFG_MOVEMENT_TIMEOUT,
+					  &cfg->movement_timeout,
+					  sizeof(cfg->movement_timeout));
+	cfg->accelerometer_threshold_fresh =
+		cloud_codec_shadow_update(section, CFG_ACCELEROMETER_THRESHOLD,
+					  &cfg->accelerometer_threshold,
+					  sizeof(cfg->accelerometer_threshold));
+	cfg->nod_list_fresh = cloud_codec_shadow_update(section, CFG_NOD_LIST,
+							nod_list, sizeof(nod_list));
+
+	return cfg->active_mode_fresh || cfg->gps_timeout_fresh ||
+	       cfg->active_wait_timeout_fresh || cfg->movement_resolution_fresh ||
+	       cfg->movement_timeout_fresh || cfg->accelerometer_threshold_fresh ||
+	       cfg->nod_list_fresh;
+}
+
+void cloud_codec_shadow_commit(enum cloud_codec_shadow_section section)
+{
+	__ASSERT_NO_MSG(section < CLOUD_CODEC_SHADOW_SECTION_COUNT);
+
+	struct shadow_section *s = &sections[section];
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	for (size_t i = 0; i < CLOUD_CODEC_SHADOW_FIELD_MAX; i++) {
+		if (s->pending_valid & BIT(i)) {
+			s->reported[i] = s->pending[i];
+		}
+	}
+
+	s->reported_valid |= s->pending_valid;
+	s->pending_valid = 0;
+
+	k_spin_unlock(&lock, key);
+}
+
+void cloud_codec_shadow_invalidate(enum cloud_codec_shadow_section section)
+{
+	__ASSERT_NO_MSG(section < CLOUD_CODEC_SHADOW_SECTION_COUNT);
+
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	sections[section].reported_valid = 0;
+	sections[section].pending_valid = 0;
+
+	k_spin_unlock(&lock, key);
+
+	LOG_DBG("Reported state of section %d invalidated", section);
+}
+
+void cloud_codec_shadow_reset(void)
+{
+	for (size_t i = 0; i < CLOUD_CODEC_SHADOW_SECTION_COUNT; i++) {
+		cloud_codec_shadow_invalidate(i);
+	}
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/**@file
+ * @brief Cloud codec shadow cache header.
+ */
+
+#ifndef CLOUD_CODEC_SHADOW_H__
+#define CLOUD_CODEC_SHADOW_H__
+
+/**@file
+ *
+ * @defgroup cloud_codec_shadow cloud_codec_shadow
+ * @brief    Cache of the device state last reported to the cloud shadow.
+ *
+ * The state is divided into sections, each made of up to CLOUD_CODEC_SHADOW_FIELD_MAX fields.
+ * Only a 32-bit hash of each field is kept. A field is reported when its hash differs from the
+ * hash of the value last acknowledged by the cloud, so fields that have not changed are left out
+ * of the shadow update.
+ *
+ * The values passed to cloud_codec_shadow_update() are pending until the message that contains
+ * them is acknowledged with cloud_codec_shadow_commit(). If the message fails to be sent,
+ * cloud_codec_shadow_invalidate() makes the next report of the section complete.
+ * @{
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <zephyr.h>
+#include <stddef.h>
+
+#include "cloud_codec.h"
+
+/** Maximum number of fields in a section. */
+#define CLOUD_CODEC_SHADOW_FIELD_MAX 8
+
+/** @brief Sections of the reported device state. */
+enum cloud_codec_shadow_section {
+	/** Static modem data, part of the data message. */
+	CLOUD_CODEC_SHADOW_MODEM_STATIC,
+	/** Device configuration. */
+	CLOUD_CODEC_SHADOW_CONFIG,
+	/** nRF Cloud service information. */
+	CLOUD_CODEC_SHADOW_SERVICE_INFO,
+
+	CLOUD_CODEC_SHADOW_SECTION_COUNT
+};
+
+/**
+ * @brief Compare a field with the last acknowledged value and make it pending.
+ *
+ * @param[in] section Section of the field.
+ * @param[in] field Index of the field in the section.
+ * @param[in] value Value of the field.
+ * @param[in] len Length of the value.
+ *
+ * @return true if the field has changed and must be reported, otherwise false.
+ */
+bool cloud_codec_shadow_update(enum cloud_codec_shadow_section section, uint8_t field,
+			       const void *value, size_t len);
+
+/**
+ * @brief Set the fresh flags of the static modem data fields that have changed.
+ *
+ * @param[in, out] data Static modem data.
+ *
+ * @return true if any field has changed, otherwise false.
+ */
+bool cloud_codec_shadow_modem_static_diff(struct cloud_data_modem_static *data);
+
+/**
+ * @brief Set the fresh flags of the device configuration fields that have changed.
+ *
+ * @param[in, out] cfg Device configuration.
+ *
+ * @return true if any field has changed, otherwise false.
+ */
+bool cloud_codec_shadow_config_diff(struct cloud_data_cfg *cfg);
+
+/**
+ * @brief Mark the pending fields of a section as acknowledged by the cloud.
+ *
+ * @param[in] section Section.
+ */
+void cloud_codec_shadow_commit(enum cloud_codec_shadow_section section);
+
+/**
+ * @brief Forget the reported state of a section, so that all its fields are reported next time.
+ *
+ * @param[in] section Section.
+ */
+void cloud_codec_shadow_invalidate(enum cloud_codec_shadow_section section);
+
+/** @brief Forget the reported state of all sections, typically when the shadow has been
+ *	   cleared in the cloud.
+ */
+void cloud_codec_shadow_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+/**
+ * @}
+ */
+#endif /* CLOUD_CODEC_SHADOW_H__ */
@@ -62,6 +62,7 @@ int json_common_modem_static_data_add(cJSON *parent,
 {
 	int err;
 	char nw_mode[50] = {0};
+	bool values_added = false;
 
 	static const char lte_string[] = "LTE-M";
 	static const char nbiot_string[] = "NB-IoT";
@@ -95,39 +96,64 @@ int json_common_modem_static_data_add(cJSON *parent,
 		strcat(nw_mode, gps_string);
 	}
 
-	err = json_add_number(modem_val_obj, MODEM_CURRENT_BAND, data->bnd);
-	if (err) {
-		LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
-		goto exit;
+	if (data->bnd_fresh) {
+		err = json_add_number(modem_val_obj, MODEM_CURRENT_BAND, data->bnd);
+		if (err) {
+			LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
+			goto exit;
+		}
+		values_added = true;
 	}
 
-	err = json_add_str(modem_val_obj, MODEM_NETWORK_MODE, nw_mode);
-	if (err) {
-		LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
-		goto exit;
+	if (data->nw_mode_fresh) {
+		err = json_add_str(modem_val_obj, MODEM_NETWORK_MODE, nw_mode);
+		if (err) {
+			LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
+			goto exit;
+		}
+		values_added = true;
 	}
 
-	err = json_add_str(modem_val_obj, MODEM_ICCID, data->iccid);
-	if (err) {
-		LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
-		goto exit;
+	if (data->iccid_fresh) {
+		err = json_add_str(modem_val_obj, MODEM_ICCID, data->iccid);
+		if (err) {
+			LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
+			goto exit;
+		}
+		values_added = true;
 	}
 
-	err = json_add_str(modem_val_obj, MODEM_FIRMWARE_VERSION, data->fw);
-	if (err) {
-		LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
-		goto exit;
+	if (data->fw_fresh) {
+		err = json_add_str(modem_val_obj, MODEM_FIRMWARE_VERSION, data->fw);
+		if (err) {
+			LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
+			goto exit;
+		}
+		values_added = true;
 	}
 
-	err = json_add_str(modem_val_obj, MODEM_BOARD, data->brdv);
-	if (err) {
-		LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
-		goto exit;
+	if (data->brdv_fresh) {
+		err = json_add_str(modem_val_obj, MODEM_BOARD, data->brdv);
+		if (err) {
+			LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
+			goto exit;
+		}
+		values_added = true;
 	}
 
-	err = json_add_str(modem_val_obj, MODEM_APP_VERSION, data->appv);
-	if (err) {
-		LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
+	if (data->appv_fresh) {
+		err = json_add_str(modem_val_obj, MODEM_APP_VERSION, data->appv);
+		if (err) {
+			LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
+			goto exit;
+		}
+		values_added = true;
+	}
+
+	if (!values_added) {
+		err = -ENODATA;
+		data->queued = false;
+		LOG_WRN("No valid static modem data values present, entry unqueued");
 		goto exit;
 	}
 
@@ -1227,3 +1253,491 @@ int json_common_batch_data_add(cJSON *parent, enum json_common_buffer_type type,
 	json_add_obj(parent, object_label, array_obj);
 	return 0;
 }
+
+/* The timestamps are converted into a copy, so that the data can be encoded more than once,
+ * as done when computing the length of the output before writing it.
+ */
+static int writer_ts_get(int64_t uptime, int64_t *ts)
+{
+	int err;
+
+	*ts = uptime;
+
+	err = date_time_uptime_to_unix_time_ms(ts);
+	if (err) {
+		LOG_ERR("date_time_uptime_to_unix_time_ms, error: %d", err);
+	}
+
+	return err;
+}
+
+static int modem_static_data_write(struct json_writer *writer,
+				   struct cloud_data_modem_static *data,
+				   const char *object_label)
+{
+	int err;
+	int64_t ts;
+	char nw_mode[50] = {0};
+
+	if (!data->queued) {
+		return -ENODATA;
+	}
+
+	if (!data->bnd_fresh && !data->nw_mode_fresh && !data->iccid_fresh &&
+	    !data->fw_fresh && !data->brdv_fresh && !data->appv_fresh) {
+		data->queued = false;
+		LOG_WRN("No valid static modem data values present, entry unqueued");
+		return -ENODATA;
+	}
+
+	err = writer_ts_get(data->ts, &ts);
+	if (err) {
+		return err;
+	}
+
+	if (data->nw_lte_m) {
+		strcpy(nw_mode, "LTE-M");
+	} else if (data->nw_nb_iot) {
+		strcpy(nw_mode, "NB-IoT");
+	}
+
+	if (data->nw_gps) {
+		strcat(nw_mode, " GPS");
+	}
+
+	json_writer_object_start(writer, object_label);
+	json_writer_object_start(writer, DATA_VALUE);
+
+	if (data->bnd_fresh) {
+		json_writer_number(writer, MODEM_CURRENT_BAND, data->bnd);
+	}
+
+	if (data->nw_mode_fresh) {
+		json_writer_str(writer, MODEM_NETWORK_MODE, nw_mode);
+	}
+
+	if (data->iccid_fresh) {
+		json_writer_str(writer, MODEM_ICCID, data->iccid);
+	}
+
+	if (data->fw_fresh) {
+		json_writer_str(writer, MODEM_FIRMWARE_VERSION, data->fw);
+	}
+
+	if (data->brdv_fresh) {
+		json_writer_str(writer, MODEM_BOARD, data->brdv);
+	}
+
+	if (data->appv_fresh) {
+		json_writer_str(writer, MODEM_APP_VERSION, data->appv);
+	}
+
+	json_writer_object_end(writer);
+	json_writer_number(writer, DATA_TIMESTAMP, ts);
+
+	err = json_writer_object_end(writer);
+	if (err) {
+		return err;
+	}
+
+	if (!json_writer_is_sizing(writer)) {
+		data->queued = false;
+	}
+
+	return 0;
+}
+
+static int modem_dynamic_data_write(struct json_writer *writer,
+				    struct cloud_data_modem_dynamic *data,
+				    const char *object_label)
+{
+	int err;
+	int64_t ts;
+	uint32_t mccmnc = 0;
+	char *end_ptr;
+
+	if (!data->queued) {
+		return -ENODATA;
+	}
+
+	if (!data->rsrp_fresh && !data->area_code_fresh && !data->mccmnc_fresh &&
+	    !data->cell_id_fresh && !data->ip_address_fresh) {
+		data->queued = false;
+		LOG_WRN("No valid dynamic modem data values present, entry unqueued");
+		return -ENODATA;
+	}
+
+	err = writer_ts_get(data->ts, &ts);
+	if (err) {
+		return err;
+	}
+
+	if (data->mccmnc_fresh) {
+		/* Convert mccmnc to unsigned long integer. */
+		errno = 0;
+		mccmnc = strtoul(data->mccmnc, &end_ptr, 10);
+
+		if ((errno == ERANGE) || (*end_ptr != '\0')) {
+			LOG_ERR("MCCMNC string could not be converted.");
+			return -ENOTEMPTY;
+		}
+	}
+
+	json_writer_object_start(writer, object_label);
+	json_writer_object_start(writer, DATA_VALUE);
+
+	if (data->rsrp_fresh) {
+		json_writer_number(writer, MODEM_RSRP, data->rsrp);
+	}
+
+	if (data->area_code_fresh) {
+		json_writer_number(writer, MODEM_AREA_CODE, data->area);
+	}
+
+	if (data->mccmnc_fresh) {
+		json_writer_number(writer, MODEM_MCCMNC, mccmnc);
+	}
+
+	if (data->cell_id_fresh) {
+		json_writer_number(writer, MODEM_CELL_ID, data->cell);
+	}
+
+	if (data->ip_address_fresh) {
+		json_writer_str(writer, MODEM_IP_ADDRESS, data->ip);
+	}
+
+	json_writer_object_end(writer);
+	json_writer_number(writer, DATA_TIMESTAMP, ts);
+
+	err = json_writer_object_end(writer);
+	if (err) {
+		return err;
+	}
+
+	if (!json_writer_is_sizing(writer)) {
+		data->queued = false;
+	}
+
+	return 0;
+}
+
+static int sensor_data_write(struct json_writer *writer,
+			     struct cloud_data_sensors *data,
+			     const char *object_label)
+{
+	int err;
+	int64_t ts;
+
+	if (!data->queued) {
+		return -ENODATA;
+	}
+
+	err = writer_ts_get(data->env_ts, &ts);
+	if (err) {
+		return err;
+	}
+
+	json_writer_object_start(writer, object_label);
+	json_writer_object_start(writer, DATA_VALUE);
+	json_writer_number(writer, DATA_TEMPERATURE, data->temp);
+	json_writer_number(writer, DATA_HUMID, data->hum);
+	json_writer_object_end(writer);
+	json_writer_number(writer, DATA_TIMESTAMP, ts);
+
+	err = json_writer_object_end(writer);
+	if (err) {
+		return err;
+	}
+
+	if (!json_writer_is_sizing(writer)) {
+		data->queued = false;
+	}
+
+	return 0;
+}
+
+static int gps_data_write(struct json_writer *writer,
+			  struct cloud_data_gps *data,
+			  const char *object_label)
+{
+	int err;
+	int64_t ts;
+
+	if (!data->queued) {
+		return -ENODATA;
+	}
+
+	if (data->format != CLOUD_CODEC_GPS_FORMAT_PVT &&
+	    data->format != CLOUD_CODEC_GPS_FORMAT_NMEA) {
+		LOG_WRN("GPS data format not set");
+		return -EINVAL;
+	}
+
+	err = writer_ts_get(data->gps_ts, &ts);
+	if (err) {
+		return err;
+	}
+
+	json_writer_object_start(writer, object_label);
+
+	if (data->format == CLOUD_CODEC_GPS_FORMAT_PVT) {
+		json_writer_object_start(writer, DATA_VALUE);
+		json_writer_number(writer, DATA_GPS_LONGITUDE, data->pvt.longi);
+		json_writer_number(writer, DATA_GPS_LATITUDE, data->pvt.lat);
+		json_writer_number(writer, DATA_GPS_ACCURACY, data->pvt.acc);
+		json_writer_number(writer, DATA_GPS_ALTITUDE, data->pvt.alt);
+		json_writer_number(writer, DATA_GPS_SPEED, data->pvt.spd);
+		json_writer_number(writer, DATA_GPS_HEADING, data->pvt.hdg);
+		json_writer_object_end(writer);
+	} else {
+		json_writer_str(writer, DATA_VALUE, data->nmea);
+	}
+
+	json_writer_number(writer, DATA_TIMESTAMP, ts);
+
+	err = json_writer_object_end(writer);
+	if (err) {
+		return err;
+	}
+
+	if (!json_writer_is_sizing(writer)) {
+		data->queued = false;
+	}
+
+	return 0;
+}
+
+static int accel_data_write(struct json_writer *writer,
+			    struct cloud_data_accelerometer *data,
+			    const char *object_label)
+{
+	int err;
+	int64_t ts;
+
+	if (!data->queued) {
+		return -ENODATA;
+	}
+
+	err = writer_ts_get(data->ts, &ts);
+	if (err) {
+		return err;
+	}
+
+	json_writer_object_start(writer, object_label);
+	json_writer_object_start(writer, DATA_VALUE);
+	json_writer_number(writer, DATA_MOVEMENT_X, data->values[0]);
+	json_writer_number(writer, DATA_MOVEMENT_Y, data->values[1]);
+	json_writer_number(writer, DATA_MOVEMENT_Z, data->values[2]);
+	json_writer_object_end(writer);
+	json_writer_number(writer, DATA_TIMESTAMP, ts);
+
+	err = json_writer_object_end(writer);
+	if (err) {
+		return err;
+	}
+
+	if (!json_writer_is_sizing(writer)) {
+		data->queued = false;
+	}
+
+	return 0;
+}
+
+static int ui_data_write(struct json_writer *writer,
+			 struct cloud_data_ui *data,
+			 const char *object_label)
+{
+	int err;
+	int64_t ts;
+
+	if (!data->queued) {
+		return -ENODATA;
+	}
+
+	err = writer_ts_get(data->btn_ts, &ts);
+	if (err) {
+		return err;
+	}
+
+	json_writer_object_start(writer, object_label);
+	json_writer_number(writer, DATA_VALUE, data->btn);
+	json_writer_number(writer, DATA_TIMESTAMP, ts);
+
+	err = json_writer_object_end(writer);
+	if (err) {
+		return err;
+	}
+
+	if (!json_writer_is_sizing(writer)) {
+		data->queued = false;
+	}
+
+	return 0;
+}
+
+static int battery_data_write(struct json_writer *writer,
+			      struct cloud_data_battery *data,
+			      const char *object_label)
+{
+	int err;
+	int64_t ts;
+
+	if (!data->queued) {
+		return -ENODATA;
+	}
+
+	err = writer_ts_get(data->bat_ts, &ts);
+	if (err) {
+		return err;
+	}
+
+	json_writer_object_start(writer, object_label);
+	json_writer_number(writer, DATA_VALUE, data->bat);
+	json_writer_number(writer, DATA_TIMESTAMP, ts);
+
+	err = json_writer_object_end(writer);
+	if (err) {
+		return err;
+	}
+
+	if (!json_writer_is_sizing(writer)) {
+		data->queued = false;
+	}
+
+	return 0;
+}
+
+int json_common_batch_data_write(struct json_writer *writer, enum json_common_buffer_type type,
+				 void *buf, size_t buf_count, const char *object_label)
+{
+	int err = 0;
+
+	if (object_label == NULL) {
+		LOG_WRN("Missing object label");
+		return -EINVAL;
+	}
+
+	/* The array is only written with its first entry, so that it is left out if no entry
+	 * is queued.
+	 */
+	err = json_writer_deferred_array_start(writer, object_label);
+	if (err) {
+		return err;
+	}
+
+	for (int i = 0; i < buf_count; i++) {
+		switch (type) {
+		case JSON_COMMON_UI:
+			err = ui_data_write(writer, &((struct cloud_data_ui *)buf)[i], NULL);
+			break;
+		case JSON_COMMON_MODEM_STATIC:
+			err = modem_static_data_write(writer,
+						      &((struct cloud_data_modem_static *)buf)[i],
+						      NULL);
+			break;
+		case JSON_COMMON_MODEM_DYNAMIC:
+			err = modem_dynamic_data_write(writer,
+						       &((struct cloud_data_modem_dynamic *)buf)[i],
+						       NULL);
+			break;
+		case JSON_COMMON_GPS:
+			err = gps_data_write(writer, &((struct cloud_data_gps *)buf)[i], NULL);
+			break;
+		case JSON_COMMON_SENSOR:
+			err = sensor_data_write(writer, &((struct cloud_data_sensors *)buf)[i],
+						NULL);
+			break;
+		case JSON_COMMON_ACCELEROMETER:
+			err = accel_data_write(writer,
+					       &((struct cloud_data_accelerometer *)buf)[i],
+					       NULL);
+			break;
+		case JSON_COMMON_BATTERY:
+			err = battery_data_write(writer, &((struct cloud_data_battery *)buf)[i],
+						 NULL);
+			break;
+		default:
+			LOG_WRN("Unknown buffer type: %d", type);
+			break;
+		}
+
+		if ((err != 0) && (err != -ENODATA)) {
+			LOG_ERR("Failed writing data to array");
+			return err;
+		}
+	}
+
+	return json_writer_deferred_array_end(writer);
+}
+
+static int batch_write(struct json_writer *writer, const struct json_common_batch *batch,
+		       size_t batch_count)
+{
+	int err;
+	bool object_added = false;
+
+	json_writer_object_start(writer, NULL);
+
+	for (size_t i = 0; i < batch_count; i++) {
+		err = json_common_batch_data_write(writer, batch[i].type, batch[i].buf,
+						   batch[i].buf_count, batch[i].object_label);
+		if (err == 0) {
+			object_added = true;
+		} else if (err != -ENODATA) {
+			return err;
+		}
+	}
+
+	if (!object_added) {
+		LOG_DBG("No data to encode, JSON string empty...");
+		return -ENODATA;
+	}
+
+	json_writer_object_end(writer);
+
+	return json_writer_finish(writer);
+}
+
+int json_common_batch_encode(struct cloud_codec_data *output,
+			     const struct json_common_batch *batch, size_t batch_count)
+{
+	struct json_writer writer;
+	char *buffer;
+	int len;
+	int err;
+
+	/* The length of the output is computed first, so that exactly one buffer is allocated
+	 * for it, and no entry is unqueued if the allocation fails.
+	 */
+	json_writer_init(&writer, NULL, 0, NULL, NULL);
+
+	len = batch_write(&writer, batch, batch_count);
+	if (len < 0) {
+		return len;
+	}
+
+	/* Allocated like the strings printed by cJSON, so that it is freed the same way. */
+	buffer = cJSON_malloc(len + 1);
+	if (buffer == NULL) {
+		LOG_ERR("Failed to allocate memory for JSON string");
+		return -ENOMEM;
+	}
+
+	json_writer_init(&writer, buffer, len + 1, NULL, NULL);
+
+	err = batch_write(&writer, batch, batch_count);
+	if (err != len) {
+		LOG_ERR("Encoded length changed from %d to %d", len, err);
+		cJSON_free(buffer);
+		return (err < 0) ? err : -EIO;
+	}
+
+	if (IS_ENABLED(CONFIG_CLOUD_CODEC_LOG_LEVEL_DBG)) {
+		LOG_DBG("Encoded batch message: %s", log_strdup(buffer));
+	}
+
+	output->buf = buffer;
+	output->len = len;
+
+	return 0;
+}
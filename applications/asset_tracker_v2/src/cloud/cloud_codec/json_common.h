@@ -27,6 +27,7 @@ extern "C" {
 
 #include "cloud_codec.h"
 #include "json_protocol_names.h"
+#include "json_writer.h"
 
 /** @brief Type of data to be handled by the respective API. Used to signify what data structure
  *         that is passed in to the function.
@@ -283,6 +284,54 @@ void json_common_config_get(cJSON *parent, struct cloud_data_cfg *data);
 int json_common_batch_data_add(cJSON *parent, enum json_common_buffer_type type, void *buf,
 			       size_t buf_count, const char *object_label);
 
+/** @brief Buffer of entries to be encoded as an array by @ref json_common_batch_encode. */
+struct json_common_batch {
+	/** Type of data in the buffer. */
+	enum json_common_buffer_type type;
+	/** Pointer to data buffer that is to be encoded. */
+	void *buf;
+	/** Number of entries in the buffer. */
+	size_t buf_count;
+	/** Name of the array. */
+	const char *object_label;
+};
+
+/**
+ * @brief Write all queued entries in the passed in buffer as an array, with the same layout as
+ *        @ref json_common_batch_data_add.
+ *
+ * Entries are unqueued as they are written, unless the writer only computes the length of the
+ * output.
+ *
+ * @param[in] writer Writer, in an object.
+ * @param[in] type Type of data passed in to the function.
+ * @param[in] buf Pointer to data buffer that is to be encoded.
+ * @param[in] buf_count Number of entries in passed in data buffer.
+ * @param[in] object_label Name of the array.
+ *
+ * @return 0 on success. -ENODATA if no entry is queued, in which case nothing is written.
+ *         Otherwise a negative error code is returned.
+ */
+int json_common_batch_data_write(struct json_writer *writer, enum json_common_buffer_type type,
+				 void *buf, size_t buf_count, const char *object_label);
+
+/**
+ * @brief Encode buffers of entries into an object of arrays, without building a cJSON tree.
+ *
+ * The output is the same as when each buffer is added to an object with
+ * @ref json_common_batch_data_add and the object is printed with cJSON_PrintUnformatted().
+ * It is allocated once, at its exact length, and must be freed with cJSON_FreeString().
+ *
+ * @param[out] output Encoded output.
+ * @param[in] batch Buffers to encode, in the order of the arrays in the output.
+ * @param[in] batch_count Number of buffers.
+ *
+ * @return 0 on success. -ENODATA if no entry is queued. Otherwise a negative error code is
+ *         returned.
+ */
+int json_common_batch_encode(struct cloud_codec_data *output,
+			     const struct json_common_batch *batch, size_t batch_count);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,401 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr.h>
+#include <errno.h>
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "json_writer.h"
+
+/* Long enough for any number printed with "%1.17g". */
+#define NUMBER_LEN_MAX 26
+
+static void put(struct json_writer *writer, const char *str, size_t len)
+{
+	writer->len += len;
+
+	if (writer->buf == NULL || writer->err) {
+		return;
+	}
+
+	if (writer->flush == NULL) {
+		/* Keep room for the null terminator. */
+		if (writer->used + len >= writer->size) {
+			writer->err = -ENOMEM;
+			return;
+		}
+
+		memcpy(writer->buf + writer->used, str, len);
+		writer->used += len;
+		return;
+	}
+
+	while (len > 0) {
+		size_t chunk;
+
+		if (writer->used == writer->size) {
+			int err = writer->flush(writer->buf, writer->used, writer->user_data);
+
+			if (err) {
+				writer->err = err;
+				return;
+			}
+
+			writer->used = 0;
+		}
+
+		chunk = MIN(len, writer->size - writer->used);
+		memcpy(writer->buf + writer->used, str, chunk);
+		writer->used += chunk;
+		str += chunk;
+		len -= chunk;
+	}
+}
+
+static void put_char(struct json_writer *writer, char c)
+{
+	put(writer, &c, 1);
+}
+
+/* Escape the same characters as cJSON does. */
+static void str_put(struct json_writer *writer, const char *str)
+{
+	const char *run = str;
+
+	put_char(writer, '"');
+
+	for (; *str != '\0'; str++) {
+		unsigned char c = *str;
+		char esc[7];
+		size_t esc_len = 2;
+
+		if (c >= ' ' && c != '"' && c != '\\') {
+			continue;
+		}
+
+		put(writer, run, str - run);
+		run = str + 1;
+
+		esc[0] = '\\';
+
+		switch (c) {
+		case '"':
+			esc[1] = '"';
+			break;
+		case '\\':
+			esc[1] = '\\';
+			break;
+		case '\b':
+			esc[1] = 'b';
+			break;
+		case '\f':
+			esc[1] = 'f';
+			break;
+		case '\n':
+			esc[1] = 'n';
+			break;
+		case '\r':
+			esc[1] = 'r';
+			break;
+		case '\t':
+			esc[1] = 't';
+			break;
+		default:
+			esc_len = snprintf(esc, sizeof(esc), "\\u%04x", c);
+			break;
+		}
+
+		put(writer, esc, esc_len);
+	}
+
+	put(writer, run, str - run);
+	put_char(writer, '"');
+}
+
+static size_t int_format(char *buf, int64_t value)
+{
+	char digits[20];
+	uint64_t mag = value < 0 ? -(uint64_t)value : (uint64_t)value;
+	size_t len = 0;
+	size_t i = 0;
+
+	do {
+		digits[i++] = '0' + (mag % 10);
+		mag /= 10;
+	} while (mag > 0);
+
+	if (value < 0) {
+		buf[len++] = '-';
+	}
+
+	while (i > 0) {
+		buf[len++] = digits[--i];
+	}
+
+	return len;
+}
+
+/* Same output as print_number() in cJSON. Integers below 1e15, which "%1.15g" prints without
+ * exponent, are formatted without going through snprintf(). Negative zero is printed as "-0".
+ */
+static void number_put(struct json_writer *writer, double value)
+{
+	char buf[NUMBER_LEN_MAX];
+	size_t len;
+
+	if (isnan(value) || isinf(value)) {
+		put(writer, "null", 4);
+		return;
+	}
+
+	if (fabs(value) < 1e15 && value == (double)(int64_t)value &&
+	    !(value == 0 && signbit(value))) {
+		len = int_format(buf, (int64_t)value);
+	} else {
+		double test;
+
+		len = snprintf(buf, sizeof(buf), "%1.15g", value);
+		test = strtod(buf, NULL);
+
+		if (fabs(test - value) > MAX(fabs(test), fabs(value)) * DBL_EPSILON) {
+			len = snprintf(buf, sizeof(buf), "%1.17g", value);
+		}
+	}
+
+	put(writer, buf, len);
+}
+
+static void error_set(struct json_writer *writer, int err)
+{
+	if (writer->err == 0) {
+		writer->err = err;
+	}
+}
+
+static bool in_array(const struct json_writer *writer)
+{
+	return writer->arrays & BIT(writer->depth);
+}
+
+static int container_start(struct json_writer *writer, const char *key, bool array);
+
+/* Write what comes before a member: the separator from the previous member, and the key. */
+static int member_start(struct json_writer *writer, const char *key)
+{
+	if (writer->err) {
+		return writer->err;
+	}
+
+	if (writer->deferred && !writer->deferred_written) {
+		writer->deferred_written = true;
+
+		if (container_start(writer, writer->deferred_key, true)) {
+			return writer->err;
+		}
+	}
+
+	/* Members of objects have a key, other values do not. */
+	if ((writer->depth == 0) ? (key != NULL) : (in_array(writer) == (key != NULL))) {
+		error_set(writer, -EINVAL);
+		return writer->err;
+	}
+
+	if (writer->members & BIT(writer->depth)) {
+		put_char(writer, ',');
+	}
+
+	writer->members |= BIT(writer->depth);
+
+	if (key != NULL) {
+		str_put(writer, key);
+		put_char(writer, ':');
+	}
+
+	return writer->err;
+}
+
+static int container_start(struct json_writer *writer, const char *key, bool array)
+{
+	if (member_start(writer, key)) {
+		return writer->err;
+	}
+
+	if (writer->depth + 1 >= JSON_WRITER_DEPTH_MAX) {
+		error_set(writer, -E2BIG);
+		return writer->err;
+	}
+
+	writer->depth++;
+	writer->members &= ~BIT(writer->depth);
+	WRITE_BIT(writer->arrays, writer->depth, array);
+
+	put_char(writer, array ? '[' : '{');
+
+	return writer->err;
+}
+
+static int container_end(struct json_writer *writer, bool array)
+{
+	if (writer->err) {
+		return writer->err;
+	}
+
+	if (writer->depth == 0 || in_array(writer) != array) {
+		error_set(writer, -EINVAL);
+		return writer->err;
+	}
+
+	writer->depth--;
+
+	put_char(writer, array ? ']' : '}');
+
+	return writer->err;
+}
+
+void json_writer_init(struct json_writer *writer, char *buf, size_t size,
+		      json_writer_flush_t flush, void *user_data)
+{
+	__ASSERT_NO_MSG(writer);
+	__ASSERT_NO_MSG(buf == NULL || size > 0);
+
+	memset(writer, 0, sizeof(*writer));
+
+	writer->buf = buf;
+	writer->size = size;
+	writer->flush = flush;
+	writer->user_data = user_data;
+}
+
+int json_writer_object_start(struct json_writer *writer, const char *key)
+{
+	return container_start(writer, key, false);
+}
+
+int json_writer_object_end(struct json_writer *writer)
+{
+	return container_end(writer, false);
+}
+
+int json_writer_array_start(struct json_writer *writer, const char *key)
+{
+	return container_start(writer, key, true);
+}
+
+int json_writer_array_end(struct json_writer *writer)
+{
+	return container_end(writer, true);
+}
+
+int json_writer_deferred_array_start(struct json_writer *writer, const char *key)
+{
+	if (writer->err) {
+		return writer->err;
+	}
+
+	if (writer->deferred || key == NULL) {
+		error_set(writer, -EINVAL);
+		return writer->err;
+	}
+
+	writer->deferred = true;
+	writer->deferred_written = false;
+	writer->deferred_key = key;
+
+	return 0;
+}
+
+int json_writer_deferred_array_end(struct json_writer *writer)
+{
+	bool written = writer->deferred_written;
+
+	if (writer->err) {
+		return writer->err;
+	}
+
+	if (!writer->deferred) {
+		error_set(writer, -EINVAL);
+		return writer->err;
+	}
+
+	writer->deferred = false;
+	writer->deferred_written = false;
+
+	if (!written) {
+		return -ENODATA;
+	}
+
+	return json_writer_array_end(writer);
+}
+
+int json_writer_number(struct json_writer *writer, const char *key, double value)
+{
+	if (member_start(writer, key)) {
+		return writer->err;
+	}
+
+	number_put(writer, value);
+
+	return writer->err;
+}
+
+int json_writer_str(struct json_writer *writer, const char *key, const char *value)
+{
+	if (member_start(writer, key)) {
+		return writer->err;
+	}
+
+	str_put(writer, value);
+
+	return writer->err;
+}
+
+int json_writer_bool(struct json_writer *writer, const char *key, bool value)
+{
+	if (member_start(writer, key)) {
+		return writer->err;
+	}
+
+	if (value) {
+		put(writer, "true", 4);
+	} else {
+		put(writer, "false", 5);
+	}
+
+	return writer->err;
+}
+
+int json_writer_finish(struct json_writer *writer)
+{
+	if (writer->err) {
+		return writer->err;
+	}
+
+	if (writer->depth != 0 || writer->deferred) {
+		return -EINVAL;
+	}
+
+	if (writer->buf != NULL) {
+		if (writer->flush != NULL) {
+			if (writer->used > 0) {
+				writer->err = writer->flush(writer->buf, writer->used,
+							    writer->user_data);
+				writer->used = 0;
+			}
+		} else {
+			writer->buf[writer->used] = '\0';
+		}
+	}
+
+	if (writer->err) {
+		return writer->err;
+	}
+
+	return writer->len;
+}
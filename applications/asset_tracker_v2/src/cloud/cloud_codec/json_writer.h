@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/**@file
+ * @brief Streaming JSON writer.
+ */
+
+#ifndef JSON_WRITER_H__
+#define JSON_WRITER_H__
+
+/**@file
+ *
+ * @defgroup json_writer json_writer
+ * @brief    Module that writes JSON directly into a buffer, without building a cJSON tree.
+ *
+ * The output is the same as the one of cJSON_PrintUnformatted() for the same members, so the
+ * writer can replace cJSON when encoding data. Errors are sticky: after a failure, the following
+ * calls do nothing and return the same error, so that it can be checked once at the end.
+ * @{
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <zephyr.h>
+#include <stdbool.h>
+
+/** Maximum nesting depth of objects and arrays. */
+#define JSON_WRITER_DEPTH_MAX 32
+
+/**
+ * @brief Function called when the output buffer of a writer is full, and at the end of the
+ *	  output.
+ *
+ * @param[in] buf Output written so far.
+ * @param[in] len Length of the output.
+ * @param[in] user_data User data passed to @ref json_writer_init.
+ *
+ * @return 0 on success, otherwise a negative error code that stops the writer.
+ */
+typedef int (*json_writer_flush_t)(const char *buf, size_t len, void *user_data);
+
+/** @brief Writer state. */
+struct json_writer {
+	char *buf;
+	size_t size;
+	size_t used;
+	/** Total length of the output, including flushed chunks. */
+	size_t len;
+	json_writer_flush_t flush;
+	void *user_data;
+	/** One bit per nesting level, set if the level has a member. */
+	uint32_t members;
+	/** One bit per nesting level, set if the level is an array. */
+	uint32_t arrays;
+	uint8_t depth;
+	/** Key of an array that is written with its first member. */
+	const char *deferred_key;
+	bool deferred;
+	bool deferred_written;
+	int err;
+};
+
+/**
+ * @brief Initialize a writer.
+ *
+ * The writer works in one of three modes:
+ *  - If @p buf is NULL, nothing is written. This can be used to get the length of the output
+ *    before allocating a buffer for it.
+ *  - If @p flush is NULL, the output must fit in @p buf, including a null terminator.
+ *  - Otherwise, @p flush is called with each chunk of output when @p buf is full.
+ *
+ * @param[out] writer Writer.
+ * @param[in] buf Output buffer, or NULL.
+ * @param[in] size Size of the output buffer.
+ * @param[in] flush Function called with full chunks of output, or NULL.
+ * @param[in] user_data User data passed to @p flush.
+ */
+void json_writer_init(struct json_writer *writer, char *buf, size_t size,
+		      json_writer_flush_t flush, void *user_data);
+
+/**
+ * @brief Check if the writer only computes the length of the output.
+ *
+ * @param[in] writer Writer.
+ *
+ * @return true if nothing is written.
+ */
+static inline bool json_writer_is_sizing(const struct json_writer *writer)
+{
+	return writer->buf == NULL;
+}
+
+/**
+ * @brief Start an object.
+ *
+ * @param[in] writer Writer.
+ * @param[in] key Name of the object in its parent object, or NULL in an array or at the root.
+ *
+ * @return 0 on success, otherwise a negative error code.
+ */
+int json_writer_object_start(struct json_writer *writer, const char *key);
+
+/**
+ * @brief End the current object.
+ *
+ * @param[in] writer Writer.
+ *
+ * @return 0 on success, otherwise a negative error code.
+ */
+int json_writer_object_end(struct json_writer *writer);
+
+/**
+ * @brief Start an array.
+ *
+ * @param[in] writer Writer.
+ * @param[in] key Name of the array in its parent object, or NULL in an array or at the root.
+ *
+ * @return 0 on success, otherwise a negative error code.
+ */
+int json_writer_array_start(struct json_writer *writer, const char *key);
+
+/**
+ * @brief End the current array.
+ *
+ * @param[in] writer Writer.
+ *
+ * @return 0 on success, otherwise a negative error code.
+ */
+int json_writer_array_end(struct json_writer *writer);
+
+/**
+ * @brief Start an array that is only written if a member is added to it.
+ *
+ * The array is written when its first member is started, which is how empty arrays are left
+ * out of the output. Deferred arrays cannot be nested.
+ *
+ * @param[in] writer Writer.
+ * @param[in] key Name of the array in its parent object.
+ *
+ * @return 0 on success, otherwise a negative error code.
+ */
+int json_writer_deferred_array_start(struct json_writer *writer, const char *key);
+
+/**
+ * @brief End an array started with @ref json_writer_deferred_array_start.
+ *
+ * @param[in] writer Writer.
+ *
+ * @retval 0 if the array was written.
+ * @retval -ENODATA if the array was empty, and therefore not written.
+ * @return Otherwise a negative error code.
+ */
+int json_writer_deferred_array_end(struct json_writer *writer);
+
+/**
+ * @brief Add a number, formatted as cJSON does.
+ *
+ * @param[in] writer Writer.
+ * @param[in] key Name of the number, or NULL in an array.
+ * @param[in] value Number.
+ *
+ * @return 0 on success, otherwise a negative error code.
+ */
+int json_writer_number(struct json_writer *writer, const char *key, double value);
+
+/**
+ * @brief Add a string.
+ *
+ * @param[in] writer Writer.
+ * @param[in] key Name of the string, or NULL in an array.
+ * @param[in] value Null-terminated string, which is escaped as needed.
+ *
+ * @return 0 on success, otherwise a negative error code.
+ */
+int json_writer_str(struct json_writer *writer, const char *key, const char *value);
+
+/**
+ * @brief Add a boolean.
+ *
+ * @param[in] writer Writer.
+ * @param[in] key Name of the boolean, or NULL in an array.
+ * @param[in] value Boolean.
+ *
+ * @return 0 on success, otherwise a negative error code.
+ */
+int json_writer_bool(struct json_writer *writer, const char *key, bool value);
+
+/**
+ * @brief Finish the output.
+ *
+ * If the writer has an output buffer, the output is null-terminated, and the last chunk is
+ * passed to the flush function, if any.
+ *
+ * @param[in] writer Writer.
+ *
+ * @return Length of the output, without null terminator, on success. -EINVAL if an object or
+ *	   array is not ended. -ENOMEM if the output did not fit in the buffer. Otherwise a negative
+ *	   error code.
+ */
+int json_writer_finish(struct json_writer *writer);
+
+#ifdef __cplusplus
+}
+#endif
+/**
+ * @}
+ */
+#endif /* JSON_WRITER_H__ */
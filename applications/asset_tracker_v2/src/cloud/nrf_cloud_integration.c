@@ -6,6 +6,7 @@
 #include "json_helpers.h"
 #include "json_protocol_names.h"
 #include "cloud/cloud_wrapper.h"
+#include "cloud/cloud_codec/cloud_codec_shadow.h"
 
 #define MODULE nrf_cloud_integration
 
@@ -58,6 +59,14 @@ static int send_service_info(void)
 		.topic_type = NRF_CLOUD_TOPIC_STATE,
 	};
 
+#if defined(CONFIG_CLOUD_CODEC_SHADOW_DIFF)
+	if (!cloud_codec_shadow_update(CLOUD_CODEC_SHADOW_SERVICE_INFO, 0,
+				       msg.data.ptr, msg.data.len)) {
+		LOG_DBG("nRF Cloud service info already reported");
+		return 0;
+	}
+#endif
+
 	err = nrf_cloud_send(&msg);
 	if (err) {
 		LOG_ERR("nrf_cloud_send, error: %d", err);
@@ -66,6 +75,10 @@ static int send_service_info(void)
 
 	LOG_DBG("nRF Cloud service info sent: %s", NRF_CLOUD_SERVICE_INFO);
 
+#if defined(CONFIG_CLOUD_CODEC_SHADOW_DIFF)
+	cloud_codec_shadow_commit(CLOUD_CODEC_SHADOW_SERVICE_INFO);
+#endif
+
 	return 0;
 }
 
@@ -124,6 +137,10 @@ static void nrf_cloud_event_handler(const struct nrf_cloud_evt *evt)
 		break;
 	case NRF_CLOUD_EVT_USER_ASSOCIATED:
 		LOG_DBG("NRF_CLOUD_EVT_USER_ASSOCIATED");
+#if defined(CONFIG_CLOUD_CODEC_SHADOW_DIFF)
+		/* The device state is reported again to the newly associated account. */
+		cloud_codec_shadow_reset();
+#endif
 		break;
 	default:
 		LOG_ERR("Unknown nRF Cloud event type: %d", evt->type);
@@ -0,0 +1,711 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/* The spool partition is used as a ring of flash sectors. Every sector starts with a header
+ * holding a sequence number, followed by records:
+ *
+ * - data records holding a message and its type,
+ * - cursor records holding the ID of the newest consumed message.
+ *
+ * Every record is protected by a CRC, and is written header first. A record that is interrupted by
+ * a reset therefore fails the CRC check, and the rest of its sector is skipped. The ID of a
+ * message is the position of its record in the log.
+ *
+ * Consumed messages are not deleted. Instead, the cursor is kept in RAM and appended to the log
+ * every CONFIG_DATA_SPOOL_CURSOR_INTERVAL acknowledgments, on data_spool_sync() and at the
+ * beginning of every sector, so that it is not lost when older sectors are erased.
+ */
+
+#include <zephyr.h>
+#include <string.h>
+#include <storage/flash_map.h>
+#include <sys/crc.h>
+
+#include "data_spool.h"
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(data_spool, CONFIG_DATA_SPOOL_LOG_LEVEL);
+
+#define SPOOL_SECTOR_MAGIC	0x4c4f5053 /* "SPOL" */
+#define SPOOL_ALIGN_MAX		8
+/* Records up to this size, such as cursor records, are written in a single operation. */
+#define SPOOL_SMALL_RECORD_SIZE	64
+
+enum spool_record_kind {
+	SPOOL_RECORD_DATA	= 0x01,
+	SPOOL_RECORD_CURSOR	= 0x02,
+};
+
+struct spool_sector_hdr {
+	uint32_t magic;
+	uint32_t seq;
+};
+
+struct spool_record_hdr {
+	uint8_t kind;
+	/* Message type, for data records. */
+	uint8_t type;
+	/* Length of the payload following the header. */
+	uint16_t len;
+	/* CRC of the fields above and the payload. */
+	uint32_t crc;
+};
+
+BUILD_ASSERT(sizeof(struct spool_sector_hdr) == SPOOL_ALIGN_MAX);
+BUILD_ASSERT(sizeof(struct spool_record_hdr) == SPOOL_ALIGN_MAX);
+
+static struct data_spool {
+	const struct flash_area *fa;
+	size_t sector_size;
+	uint32_t sector_cnt;
+	size_t align;
+	uint8_t erased_val;
+
+	uint32_t oldest_sector;
+	uint32_t oldest_seq;
+
+	uint32_t write_sector;
+	uint32_t write_seq;
+	size_t write_off;
+
+	uint32_t read_sector;
+	uint32_t read_seq;
+	size_t read_off;
+
+	/* ID of the newest consumed message. */
+	uint32_t consumed_id;
+	/* Number of acknowledgments since the cursor was last persisted. */
+	uint32_t ack_cnt;
+
+	/* Number of messages of the current round whose outcome is not known yet. */
+	size_t round_cnt;
+	/* ID of the newest message of the current round. */
+	uint32_t round_id;
+	/* Set if any message of the current round failed to be sent. */
+	bool round_failed;
+
+	struct data_spool_stats stats;
+} spool;
+
+static size_t record_size(size_t payload_len)
+{
+	return ROUND_UP(sizeof(struct spool_record_hdr) + payload_len, spool.align);
+}
+
+static size_t first_record_off(void)
+{
+	return ROUND_UP(sizeof(struct spool_sector_hdr), spool.align);
+}
+
+static off_t sector_addr(uint32_t sector)
+{
+	return (off_t)sector * spool.sector_size;
+}
+
+static uint32_t next_sector(uint32_t sector)
+{
+	return (sector + 1) % spool.sector_cnt;
+}
+
+static uint32_t record_id(uint32_t seq, size_t off)
+{
+	return seq * spool.sector_size + off;
+}
+
+static uint32_t record_crc(const struct spool_record_hdr *hdr, const void *payload)
+{
+	uint32_t crc = crc32_ieee((const uint8_t *)hdr, offsetof(struct spool_record_hdr, crc));
+
+	return crc32_ieee_update(crc, payload, hdr->len);
+}
+
+static bool is_erased(const void *data, size_t len)
+{
+	const uint8_t *bytes = data;
+
+	for (size_t i = 0; i < len; i++) {
+		if (bytes[i] != spool.erased_val) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static int sector_hdr_read(uint32_t sector, struct spool_sector_hdr *hdr)
+{
+	int err = flash_area_read(spool.fa, sector_addr(sector), hdr, sizeof(*hdr));
+
+	if (err) {
+		return err;
+	}
+
+	return (hdr->magic == SPOOL_SECTOR_MAGIC) ? 0 : -ENOENT;
+}
+
+/* Read the header of a record. Returns -ENOENT at the end of the written part of a sector, and
+ * -EBADMSG if the header is invalid.
+ */
+static int record_hdr_read(uint32_t sector, size_t off, struct spool_record_hdr *hdr)
+{
+	int err;
+
+	if (off + sizeof(*hdr) > spool.sector_size) {
+		return -ENOENT;
+	}
+
+	err = flash_area_read(spool.fa, sector_addr(sector) + off, hdr, sizeof(*hdr));
+	if (err) {
+		return err;
+	}
+
+	if (is_erased(hdr, sizeof(*hdr))) {
+		return -ENOENT;
+	}
+
+	if (((hdr->kind != SPOOL_RECORD_DATA) && (hdr->kind != SPOOL_RECORD_CURSOR)) ||
+	    (off + record_size(hdr->len) > spool.sector_size)) {
+		return -EBADMSG;
+	}
+
+	return 0;
+}
+
+/* Validate a record. For cursor records, the consumed message ID is returned in cursor. */
+static int record_check(uint32_t sector, size_t off, struct spool_record_hdr *hdr,
+			uint32_t *cursor)
+{
+	uint8_t chunk[32];
+	uint32_t crc;
+	int err = record_hdr_read(sector, off, hdr);
+
+	if (err) {
+		return err;
+	}
+
+	if ((hdr->kind == SPOOL_RECORD_CURSOR) && (hdr->len != sizeof(*cursor))) {
+		return -EBADMSG;
+	}
+
+	crc = crc32_ieee((const uint8_t *)hdr, offsetof(struct spool_record_hdr, crc));
+
+	for (size_t pos = 0; pos < hdr->len; pos += sizeof(chunk)) {
+		size_t len = MIN(sizeof(chunk), hdr->len - pos);
+
+		err = flash_area_read(spool.fa, sector_addr(sector) + off + sizeof(*hdr) + pos,
+				      chunk, len);
+		if (err) {
+			return err;
+		}
+
+		if ((pos == 0) && (hdr->kind == SPOOL_RECORD_CURSOR)) {
+			memcpy(cursor, chunk, sizeof(*cursor));
+		}
+
+		crc = crc32_ieee_update(crc, chunk, len);
+	}
+
+	return (crc == hdr->crc) ? 0 : -EBADMSG;
+}
+
+static int small_record_write(off_t addr, const struct spool_record_hdr *hdr, const void *payload)
+{
+	uint8_t buf[SPOOL_SMALL_RECORD_SIZE] __aligned(4);
+	size_t size = record_size(hdr->len);
+
+	memcpy(buf, hdr, sizeof(*hdr));
+	memcpy(buf + sizeof(*hdr), payload, hdr->len);
+	memset(buf + sizeof(*hdr) + hdr->len, spool.erased_val, size - sizeof(*hdr) - hdr->len);
+
+	spool.stats.write_cnt++;
+
+	return flash_area_write(spool.fa, addr, buf, size);
+}
+
+/* The payload of large records is written directly from the caller's buffer, only its unaligned
+ * tail is padded.
+ */
+static int large_record_write(off_t addr, const struct spool_record_hdr *hdr, const void *payload)
+{
+	uint8_t tail[SPOOL_ALIGN_MAX];
+	size_t body_len = ROUND_DOWN(hdr->len, spool.align);
+	int err;
+
+	err = flash_area_write(spool.fa, addr, hdr, sizeof(*hdr));
+	spool.stats.write_cnt++;
+
+	if (!err && (body_len > 0)) {
+		err = flash_area_write(spool.fa, addr + sizeof(*hdr), payload, body_len);
+		spool.stats.write_cnt++;
+	}
+
+	if (!err && (hdr->len > body_len)) {
+		memset(tail, spool.erased_val, spool.align);
+		memcpy(tail, (const uint8_t *)payload + body_len, hdr->len - body_len);
+
+		err = flash_area_write(spool.fa, addr + sizeof(*hdr) + body_len, tail, spool.align);
+		spool.stats.write_cnt++;
+	}
+
+	return err;
+}
+
+/* Write a record at the write offset. The caller makes sure that the record fits in the sector. */
+static int record_write(uint8_t kind, uint8_t type, const void *payload, size_t len)
+{
+	struct spool_record_hdr hdr = {
+		.kind = kind,
+		.type = type,
+		.len = len,
+	};
+	off_t addr = sector_addr(spool.write_sector) + spool.write_off;
+	int err;
+
+	hdr.crc = record_crc(&hdr, payload);
+
+	if (record_size(len) <= SPOOL_SMALL_RECORD_SIZE) {
+		err = small_record_write(addr, &hdr, payload);
+	} else {
+		err = large_record_write(addr, &hdr, payload);
+	}
+
+	if (err) {
+		LOG_ERR("Cannot write spool record, err %d", err);
+		/* Part of the record may have been written. Continue in the next sector. */
+		spool.write_off = spool.sector_size;
+		return err;
+	}
+
+	spool.stats.flash_bytes += record_size(len);
+	spool.write_off += record_size(len);
+
+	return 0;
+}
+
+static int cursor_write(void)
+{
+	int err = record_write(SPOOL_RECORD_CURSOR, 0, &spool.consumed_id,
+			       sizeof(spool.consumed_id));
+
+	if (!err) {
+		spool.ack_cnt = 0;
+	}
+
+	return err;
+}
+
+static int sector_open(uint32_t sector, uint32_t seq)
+{
+	struct spool_sector_hdr hdr = {
+		.magic = SPOOL_SECTOR_MAGIC,
+		.seq = seq,
+	};
+	int err = flash_area_erase(spool.fa, sector_addr(sector), spool.sector_size);
+
+	if (err) {
+		return err;
+	}
+
+	spool.stats.erase_cnt++;
+
+	/* Sector header size is a multiple of the supported write block sizes, no padding is
+	 * needed.
+	 */
+	err = flash_area_write(spool.fa, sector_addr(sector), &hdr, sizeof(hdr));
+	spool.stats.write_cnt++;
+	if (err) {
+		return err;
+	}
+
+	spool.stats.flash_bytes += sizeof(hdr);
+
+	spool.write_sector = sector;
+	spool.write_seq = seq;
+	spool.write_off = first_record_off();
+
+	return cursor_write();
+}
+
+static void oldest_sector_drop(void)
+{
+	struct spool_record_hdr hdr;
+	size_t off = first_record_off();
+	uint32_t dropped = 0;
+
+	while (!record_hdr_read(spool.oldest_sector, off, &hdr)) {
+		if ((hdr.kind == SPOOL_RECORD_DATA) &&
+		    (record_id(spool.oldest_seq, off) > spool.consumed_id)) {
+			dropped++;
+		}
+
+		off += record_size(hdr.len);
+	}
+
+	if (dropped > 0) {
+		LOG_WRN("Spool full, %d unsent messages dropped", dropped);
+		spool.stats.dropped_cnt += dropped;
+	}
+
+	spool.oldest_sector = next_sector(spool.oldest_sector);
+	spool.oldest_seq++;
+}
+
+static int sector_open_next(void)
+{
+	uint32_t sector = next_sector(spool.write_sector);
+
+	if (sector == spool.oldest_sector) {
+		oldest_sector_drop();
+	}
+
+	return sector_open(sector, spool.write_seq + 1);
+}
+
+/* Make room for a record of a given size in the write sector. */
+static int reserve(size_t rec_size)
+{
+	if (spool.write_off + rec_size > spool.sector_size) {
+		return sector_open_next();
+	}
+
+	return 0;
+}
+
+static int cursor_persist(void)
+{
+	int err = reserve(record_size(sizeof(spool.consumed_id)));
+
+	if (err) {
+		return err;
+	}
+
+	if (spool.ack_cnt == 0) {
+		/* Persisted at the beginning of the new sector. */
+		return 0;
+	}
+
+	return cursor_write();
+}
+
+static int spool_recover(void)
+{
+	struct spool_sector_hdr hdr;
+	struct spool_record_hdr rec;
+	uint32_t newest = 0;
+	uint32_t newest_seq = 0;
+	uint32_t sector;
+	size_t off = 0;
+	bool found = false;
+	int err = 0;
+
+	for (uint32_t i = 0; i < spool.sector_cnt; i++) {
+		err = sector_hdr_read(i, &hdr);
+		if (err == -ENOENT) {
+			continue;
+		} else if (err) {
+			return err;
+		}
+
+		if (!found || (hdr.seq > newest_seq)) {
+			newest = i;
+			newest_seq = hdr.seq;
+			found = true;
+		}
+	}
+
+	if (!found) {
+		LOG_DBG("Spool empty");
+		spool.oldest_sector = 0;
+		spool.oldest_seq = 1;
+		return sector_open(0, 1);
+	}
+
+	/* Sectors are written in ring order. Walk back to the oldest one. */
+	spool.oldest_sector = newest;
+	spool.oldest_seq = newest_seq;
+
+	for (uint32_t i = 1; i < spool.sector_cnt; i++) {
+		sector = (newest + spool.sector_cnt - i) % spool.sector_cnt;
+
+		if (sector_hdr_read(sector, &hdr) || (hdr.seq != newest_seq - i)) {
+			break;
+		}
+
+		spool.oldest_sector = sector;
+		spool.oldest_seq = hdr.seq;
+	}
+
+	/* Restore the cursor and find the end of the log. */
+	sector = spool.oldest_sector;
+
+	for (uint32_t seq = spool.oldest_seq; seq <= newest_seq; seq++) {
+		uint32_t cursor;
+
+		off = first_record_off();
+
+		while (!(err = record_check(sector, off, &rec, &cursor))) {
+			if (rec.kind == SPOOL_RECORD_CURSOR) {
+				spool.consumed_id = MAX(spool.consumed_id, cursor);
+			}
+
+			off += record_size(rec.len);
+		}
+
+		if ((err != -ENOENT) && (err != -EBADMSG)) {
+			return err;
+		}
+
+		sector = next_sector(sector);
+	}
+
+	spool.write_sector = newest;
+	spool.write_seq = newest_seq;
+	/* After an interrupted record, continue in the next sector. */
+	spool.write_off = (err == -ENOENT) ? off : spool.sector_size;
+
+	LOG_DBG("Spool sectors %d..%d, cursor %d", spool.oldest_seq, newest_seq,
+		spool.consumed_id);
+
+	return 0;
+}
+
+int data_spool_init(uint8_t area_id)
+{
+	uint32_t sector_cnt = 1;
+	struct flash_sector hw_flash_sector;
+	int err;
+
+	memset(&spool, 0, sizeof(spool));
+
+	err = flash_area_open(area_id, &spool.fa);
+	if (err) {
+		return err;
+	}
+
+	err = flash_area_get_sectors(area_id, &sector_cnt, &hw_flash_sector);
+	if ((err != 0) && (err != -ENOMEM)) {
+		return err;
+	}
+
+	spool.sector_size = hw_flash_sector.fs_size;
+	spool.sector_cnt = spool.fa->fa_size / spool.sector_size;
+	spool.align = flash_area_align(spool.fa);
+	spool.erased_val = flash_area_erased_val(spool.fa);
+
+	if ((spool.sector_cnt < 2) || (spool.align > SPOOL_ALIGN_MAX) ||
+	    (SPOOL_ALIGN_MAX % spool.align)) {
+		LOG_ERR("Unsupported spool partition layout");
+		return -EINVAL;
+	}
+
+	err = spool_recover();
+	if (err) {
+		return err;
+	}
+
+	data_spool_rewind();
+
+	return 0;
+}
+
+int data_spool_append(uint8_t type, const void *buf, size_t len)
+{
+	size_t rec_size = record_size(len);
+	int err;
+
+	if (len == 0) {
+		return -EINVAL;
+	}
+
+	/* The record must fit in a sector together with the sector header and the cursor. */
+	if ((len > UINT16_MAX) ||
+	    (rec_size > spool.sector_size - first_record_off() -
+			record_size(sizeof(spool.consumed_id)))) {
+		return -EFBIG;
+	}
+
+	err = reserve(rec_size);
+	if (err) {
+		return err;
+	}
+
+	err = record_write(SPOOL_RECORD_DATA, type, buf, len);
+	if (err) {
+		return err;
+	}
+
+	spool.stats.append_cnt++;
+	spool.stats.payload_bytes += len;
+
+	return 0;
+}
+
+int data_spool_read(struct data_spool_entry *entry)
+{
+	struct spool_record_hdr hdr;
+	int err;
+
+	if (spool.read_seq < spool.oldest_seq) {
+		/* The sector being read has been dropped. */
+		data_spool_rewind();
+	}
+
+	while (true) {
+		off_t addr = sector_addr(spool.read_sector) + spool.read_off;
+		uint32_t id = record_id(spool.read_seq, spool.read_off);
+		void *buf;
+
+		err = record_hdr_read(spool.read_sector, spool.read_off, &hdr);
+		if ((err == -ENOENT) || (err == -EBADMSG)) {
+			if (spool.read_seq >= spool.write_seq) {
+				return -ENOENT;
+			}
+
+			spool.read_sector = next_sector(spool.read_sector);
+			spool.read_seq++;
+			spool.read_off = first_record_off();
+			continue;
+		} else if (err) {
+			return err;
+		}
+
+		if ((hdr.kind != SPOOL_RECORD_DATA) || (id <= spool.consumed_id)) {
+			spool.read_off += record_size(hdr.len);
+			continue;
+		}
+
+		buf = k_malloc(hdr.len);
+		if (buf == NULL) {
+			LOG_ERR("Could not allocate %d bytes for spooled message", hdr.len);
+			return -ENOMEM;
+		}
+
+		err = flash_area_read(spool.fa, addr + sizeof(hdr), buf, hdr.len);
+		if (err) {
+			k_free(buf);
+			return err;
+		}
+
+		if (record_crc(&hdr, buf) != hdr.crc) {
+			LOG_WRN("Corrupted spool record %d, skipping the rest of the sector", id);
+			k_free(buf);
+			spool.read_off = spool.sector_size;
+			continue;
+		}
+
+		spool.read_off += record_size(hdr.len);
+
+		entry->id = id;
+		entry->type = hdr.type;
+		entry->buf = buf;
+		entry->len = hdr.len;
+
+		return 0;
+	}
+}
+
+void data_spool_rewind(void)
+{
+	spool.read_sector = spool.oldest_sector;
+	spool.read_seq = spool.oldest_seq;
+	spool.read_off = first_record_off();
+}
+
+int data_spool_ack(uint32_t id)
+{
+	if (id <= spool.consumed_id) {
+		return 0;
+	}
+
+	spool.consumed_id = id;
+	spool.ack_cnt++;
+
+	if (spool.ack_cnt >= CONFIG_DATA_SPOOL_CURSOR_INTERVAL) {
+		return cursor_persist();
+	}
+
+	return 0;
+}
+
+int data_spool_sync(void)
+{
+	if (spool.ack_cnt == 0) {
+		return 0;
+	}
+
+	return cursor_persist();
+}
+
+bool data_spool_round_begin(void)
+{
+	if (spool.round_cnt > 0) {
+		return false;
+	}
+
+	spool.round_id = 0;
+	spool.round_failed = false;
+
+	return true;
+}
+
+void data_spool_round_add(uint32_t id)
+{
+	spool.round_cnt++;
+	spool.round_id = id;
+}
+
+bool data_spool_round_done(bool sent)
+{
+	int err;
+
+	if (spool.round_cnt == 0) {
+		/* Outcome of a message of an aborted round. */
+		return false;
+	}
+
+	spool.round_cnt--;
+
+	if (!sent) {
+		spool.round_failed = true;
+	}
+
+	if (spool.round_cnt > 0) {
+		return false;
+	}
+
+	if (spool.round_failed) {
+		/* Send all messages of the round again, from the oldest one that has not been
+		 * acknowledged.
+		 */
+		LOG_WRN("Spooled messages failed to be sent");
+		data_spool_rewind();
+		return false;
+	}
+
+	err = data_spool_ack(spool.round_id);
+	if (err) {
+		LOG_ERR("Could not ACK spooled messages, error: %d", err);
+	}
+
+	return true;
+}
+
+void data_spool_round_abort(void)
+{
+	if (spool.round_cnt == 0) {
+		return;
+	}
+
+	LOG_WRN("Outcome of %d spooled messages lost", spool.round_cnt);
+
+	spool.round_cnt = 0;
+	data_spool_rewind();
+}
+
+void data_spool_stats_get(struct data_spool_stats *stats)
+{
+	*stats = spool.stats;
+}
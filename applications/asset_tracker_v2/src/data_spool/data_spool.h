@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/**@file
+ * @brief Data spool header.
+ */
+
+#ifndef DATA_SPOOL_H__
+#define DATA_SPOOL_H__
+
+/**@file
+ *
+ * @defgroup data_spool data_spool
+ * @brief    Flash-backed spool of encoded messages that could not be sent to cloud.
+ *
+ * Messages are appended to a log of records in a dedicated flash partition, and read back oldest
+ * first. A message is consumed when its ID is acknowledged. The position of the oldest
+ * unconsumed message is persisted lazily, so a few messages might be read again after a reboot.
+ * When the partition is full, the oldest messages are dropped.
+ *
+ * The API is not thread safe and is meant to be used from a single thread.
+ * @{
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <zephyr.h>
+#include <stddef.h>
+
+/** @brief Message read from the spool. */
+struct data_spool_entry {
+	/** ID of the message, used to acknowledge it. Never 0. */
+	uint32_t id;
+	/** Type of the message, as passed to data_spool_append(). */
+	uint8_t type;
+	/** Message, allocated on the heap. Must be freed with k_free(). */
+	void *buf;
+	/** Length of the message. */
+	size_t len;
+};
+
+/** @brief Spool statistics, since boot. */
+struct data_spool_stats {
+	/** Number of messages appended. */
+	uint32_t append_cnt;
+	/** Number of bytes of messages appended. */
+	uint32_t payload_bytes;
+	/** Number of flash write operations. */
+	uint32_t write_cnt;
+	/** Number of bytes written to flash, including headers and padding. */
+	uint32_t flash_bytes;
+	/** Number of flash sectors erased. */
+	uint32_t erase_cnt;
+	/** Number of unconsumed messages dropped because the spool was full. */
+	uint32_t dropped_cnt;
+};
+
+/**
+ * @brief Initialize the spool and recover its content from flash.
+ *
+ * @param[in] area_id ID of the flash area used by the spool, typically
+ *		      FLASH_AREA_ID(data_spool).
+ *
+ * @return 0 on success, otherwise a negative error code.
+ */
+int data_spool_init(uint8_t area_id);
+
+/**
+ * @brief Append a message to the spool.
+ *
+ * @param[in] type Type of the message, returned with the message when it is read.
+ * @param[in] buf Message.
+ * @param[in] len Length of the message.
+ *
+ * @return 0 on success. -EFBIG if the message does not fit in a flash sector, otherwise a negative
+ *	   error code.
+ */
+int data_spool_append(uint8_t type, const void *buf, size_t len);
+
+/**
+ * @brief Read the next unconsumed message, oldest first.
+ *
+ * @param[out] entry Message. The buffer must be freed with k_free().
+ *
+ * @return 0 on success. -ENOENT if there are no more messages. -ENOMEM if the message could not
+ *	   be allocated, in which case it is read again on the next call.
+ */
+int data_spool_read(struct data_spool_entry *entry);
+
+/**
+ * @brief Read unconsumed messages again from the oldest one, typically after they failed to be
+ *	  sent.
+ */
+void data_spool_rewind(void);
+
+/**
+ * @brief Consume a message and all messages older than it.
+ *
+ * The consumption is persisted every CONFIG_DATA_SPOOL_CURSOR_INTERVAL acknowledgments, or when
+ * data_spool_sync() is called.
+ *
+ * @param[in] id ID of the message.
+ *
+ * @return 0 on success, otherwise a negative error code.
+ */
+int data_spool_ack(uint32_t id);
+
+/**
+ * @brief Persist the consumption of all acknowledged messages.
+ *
+ * @return 0 on success, otherwise a negative error code.
+ */
+int data_spool_sync(void);
+
+/**
+ * @brief Start a round of spooled messages sent to cloud.
+ *
+ * Messages are read with data_spool_read() and sent in rounds. Every message sent is added to the
+ * round with data_spool_round_add(), and its outcome is reported with data_spool_round_done().
+ * When all messages of a round have been sent, they are consumed. If any of them failed to be
+ * sent, all unconsumed messages are read again from the oldest one.
+ *
+ * @return true if a new round is started, false if the outcome of messages of the current round
+ *	   is not known yet.
+ */
+bool data_spool_round_begin(void);
+
+/**
+ * @brief Add a message that is being sent to the current round.
+ *
+ * @param[in] id ID of the message.
+ */
+void data_spool_round_add(uint32_t id);
+
+/**
+ * @brief Report the outcome of a message of the current round.
+ *
+ * @param[in] sent true if the message was sent, false if it failed to be sent.
+ *
+ * @return true if the round has ended and all its messages were sent, so that the next round can
+ *	   be started.
+ */
+bool data_spool_round_done(bool sent);
+
+/**
+ * @brief End the current round without waiting for the outcome of its messages, typically when
+ *	  the connection to cloud is lost. The messages are read again from the oldest unconsumed
+ *	  one, and later outcomes are ignored.
+ */
+void data_spool_round_abort(void);
+
+/**
+ * @brief Get the spool statistics.
+ *
+ * @param[out] stats Statistics.
+ */
+void data_spool_stats_get(struct data_spool_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+/**
+ * @}
+ */
+#endif /* DATA_SPOOL_H__ */
@@ -368,6 +368,13 @@ static void data_get(void)
 			app_module_event->data_list[count++] = APP_DATA_GNSS;
 			app_module_event->timeout = MAX(app_cfg.gps_timeout + 15, 75);
 		}
+
+		/* Only the static modem data that has changed since it was last reported is
+		 * sent to cloud.
+		 */
+		if (IS_ENABLED(CONFIG_CLOUD_CODEC_SHADOW_DIFF)) {
+			app_module_event->data_list[count++] = APP_DATA_MODEM_STATIC;
+		}
 	}
 
 	/* Set list count to number of data types passed in app_module_event. */
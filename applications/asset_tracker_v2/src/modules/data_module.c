@@ -18,7 +18,14 @@
 #include <pm_config.h>
 #endif
 
+#if defined(CONFIG_DATA_SPOOL)
+#include <storage/flash_map.h>
+#endif
+
 #include "cloud/cloud_codec/cloud_codec.h"
+#include "cloud/cloud_codec/cloud_codec_ringbuffer.h"
+#include "cloud/cloud_codec/cloud_codec_shadow.h"
+#include "data_spool/data_spool.h"
 
 #define MODULE data_module
 
@@ -66,13 +73,88 @@ static enum state_type {
 /* Ringbuffers. All data received by the Data module are stored in ringbuffers.
  * Upon a LTE connection loss the device will keep sampling/storing data in
  * the buffers, and empty the buffers in batches upon a reconnect.
+ *
+ * The entries are stored column by column, with measurements in fixed-point
+ * and timestamps as differences, and are copied out as structures when they
+ * are encoded.
  */
-static struct cloud_data_gps gps_buf[CONFIG_DATA_GPS_BUFFER_COUNT];
-static struct cloud_data_sensors sensors_buf[CONFIG_DATA_SENSOR_BUFFER_COUNT];
-static struct cloud_data_ui ui_buf[CONFIG_DATA_UI_BUFFER_COUNT];
-static struct cloud_data_accelerometer accel_buf[CONFIG_DATA_ACCELEROMETER_BUFFER_COUNT];
-static struct cloud_data_battery bat_buf[CONFIG_DATA_BATTERY_BUFFER_COUNT];
-static struct cloud_data_modem_dynamic modem_dyn_buf[CONFIG_DATA_MODEM_DYNAMIC_BUFFER_COUNT];
+#define GPS_COLUMN(_field, _type, _scale)					\
+	CLOUD_CODEC_RINGBUFFER_COLUMN(struct cloud_data_gps, _field, _type, _scale,	\
+				      CONFIG_DATA_GPS_BUFFER_COUNT)
+
+CLOUD_CODEC_RINGBUFFER_DEFINE(gps_buf, struct cloud_data_gps, gps_ts,
+			      CONFIG_DATA_GPS_BUFFER_COUNT,
+#if defined(CONFIG_GPS_MODULE_NMEA)
+	GPS_COLUMN(nmea, CLOUD_CODEC_RINGBUFFER_COPY, 0),
+#else
+	/* 1e-7 degrees, about one centimeter. */
+	GPS_COLUMN(pvt.longi, CLOUD_CODEC_RINGBUFFER_FIXED, 10000000),
+	GPS_COLUMN(pvt.lat, CLOUD_CODEC_RINGBUFFER_FIXED, 10000000),
+	GPS_COLUMN(pvt.alt, CLOUD_CODEC_RINGBUFFER_COPY, 0),
+	GPS_COLUMN(pvt.acc, CLOUD_CODEC_RINGBUFFER_COPY, 0),
+	GPS_COLUMN(pvt.spd, CLOUD_CODEC_RINGBUFFER_COPY, 0),
+	GPS_COLUMN(pvt.hdg, CLOUD_CODEC_RINGBUFFER_COPY, 0),
+#endif
+	GPS_COLUMN(format, CLOUD_CODEC_RINGBUFFER_U8, 0),
+	GPS_COLUMN(queued, CLOUD_CODEC_RINGBUFFER_BOOL, 0));
+
+#define SENSOR_COLUMN(_field, _type, _scale)						\
+	CLOUD_CODEC_RINGBUFFER_COLUMN(struct cloud_data_sensors, _field, _type, _scale,	\
+				      CONFIG_DATA_SENSOR_BUFFER_COUNT)
+
+CLOUD_CODEC_RINGBUFFER_DEFINE(sensors_buf, struct cloud_data_sensors, env_ts,
+			      CONFIG_DATA_SENSOR_BUFFER_COUNT,
+	SENSOR_COLUMN(temp, CLOUD_CODEC_RINGBUFFER_FIXED, 100),
+	SENSOR_COLUMN(hum, CLOUD_CODEC_RINGBUFFER_FIXED, 100),
+	SENSOR_COLUMN(queued, CLOUD_CODEC_RINGBUFFER_BOOL, 0));
+
+#define UI_COLUMN(_field, _type, _scale)						\
+	CLOUD_CODEC_RINGBUFFER_COLUMN(struct cloud_data_ui, _field, _type, _scale,	\
+				      CONFIG_DATA_UI_BUFFER_COUNT)
+
+CLOUD_CODEC_RINGBUFFER_DEFINE(ui_buf, struct cloud_data_ui, btn_ts,
+			      CONFIG_DATA_UI_BUFFER_COUNT,
+	UI_COLUMN(btn, CLOUD_CODEC_RINGBUFFER_U8, 0),
+	UI_COLUMN(queued, CLOUD_CODEC_RINGBUFFER_BOOL, 0));
+
+#define ACCEL_COLUMN(_field, _type, _scale)						\
+	CLOUD_CODEC_RINGBUFFER_COLUMN(struct cloud_data_accelerometer, _field, _type,	\
+				      _scale, CONFIG_DATA_ACCELEROMETER_BUFFER_COUNT)
+
+CLOUD_CODEC_RINGBUFFER_DEFINE(accel_buf, struct cloud_data_accelerometer, ts,
+			      CONFIG_DATA_ACCELEROMETER_BUFFER_COUNT,
+	ACCEL_COLUMN(values[0], CLOUD_CODEC_RINGBUFFER_FIXED, 1000),
+	ACCEL_COLUMN(values[1], CLOUD_CODEC_RINGBUFFER_FIXED, 1000),
+	ACCEL_COLUMN(values[2], CLOUD_CODEC_RINGBUFFER_FIXED, 1000),
+	ACCEL_COLUMN(queued, CLOUD_CODEC_RINGBUFFER_BOOL, 0));
+
+#define BAT_COLUMN(_field, _type, _scale)						\
+	CLOUD_CODEC_RINGBUFFER_COLUMN(struct cloud_data_battery, _field, _type, _scale,	\
+				      CONFIG_DATA_BATTERY_BUFFER_COUNT)
+
+CLOUD_CODEC_RINGBUFFER_DEFINE(bat_buf, struct cloud_data_battery, bat_ts,
+			      CONFIG_DATA_BATTERY_BUFFER_COUNT,
+	BAT_COLUMN(bat, CLOUD_CODEC_RINGBUFFER_COPY, 0),
+	BAT_COLUMN(queued, CLOUD_CODEC_RINGBUFFER_BOOL, 0));
+
+#define MODEM_DYN_COLUMN(_field, _type, _scale)						\
+	CLOUD_CODEC_RINGBUFFER_COLUMN(struct cloud_data_modem_dynamic, _field, _type,	\
+				      _scale, CONFIG_DATA_MODEM_DYNAMIC_BUFFER_COUNT)
+
+CLOUD_CODEC_RINGBUFFER_DEFINE(modem_dyn_buf, struct cloud_data_modem_dynamic, ts,
+			      CONFIG_DATA_MODEM_DYNAMIC_BUFFER_COUNT,
+	MODEM_DYN_COLUMN(area, CLOUD_CODEC_RINGBUFFER_COPY, 0),
+	MODEM_DYN_COLUMN(cell, CLOUD_CODEC_RINGBUFFER_COPY, 0),
+	MODEM_DYN_COLUMN(rsrp, CLOUD_CODEC_RINGBUFFER_COPY, 0),
+	MODEM_DYN_COLUMN(ip, CLOUD_CODEC_RINGBUFFER_COPY, 0),
+	MODEM_DYN_COLUMN(mccmnc, CLOUD_CODEC_RINGBUFFER_COPY, 0),
+	MODEM_DYN_COLUMN(queued, CLOUD_CODEC_RINGBUFFER_BOOL, 0),
+	MODEM_DYN_COLUMN(area_code_fresh, CLOUD_CODEC_RINGBUFFER_BOOL, 0),
+	MODEM_DYN_COLUMN(cell_id_fresh, CLOUD_CODEC_RINGBUFFER_BOOL, 0),
+	MODEM_DYN_COLUMN(rsrp_fresh, CLOUD_CODEC_RINGBUFFER_BOOL, 0),
+	MODEM_DYN_COLUMN(ip_address_fresh, CLOUD_CODEC_RINGBUFFER_BOOL, 0),
+	MODEM_DYN_COLUMN(mccmnc_fresh, CLOUD_CODEC_RINGBUFFER_BOOL, 0));
+
 static struct cloud_data_neighbor_cells neighbor_cells;
 
 /* Static modem data does not change between firmware versions and does not
@@ -80,14 +162,6 @@ static struct cloud_data_neighbor_cells neighbor_cells;
  */
 static struct cloud_data_modem_static modem_stat;
 
-/* Head of ringbuffers. */
-static int head_gps_buf;
-static int head_sensor_buf;
-static int head_modem_dyn_buf;
-static int head_ui_buf;
-static int head_accel_buf;
-static int head_bat_buf;
-
 /* Default device configuration. */
 static struct cloud_data_cfg current_cfg = {
 	.gps_timeout			= CONFIG_DATA_GPS_TIMEOUT_SECONDS,
@@ -135,6 +209,8 @@ struct ack_data {
 	enum data_type type;
 	size_t len;
 	void *ptr;
+	/* ID of the data in the spool, 0 if the data has not been read from the spool. */
+	uint32_t spool_id;
 };
 
 /* Data that has been attempted to be sent but failed. */
@@ -143,6 +219,19 @@ static struct ack_data failed_data[CONFIG_FAILED_DATA_COUNT];
 /* Data that has been encoded and shipped on, but has not yet been ACKed. */
 static struct ack_data pending_data[CONFIG_PENDING_DATA_COUNT];
 
+#if defined(CONFIG_DATA_SPOOL)
+/* Number of sample cycles after which the entries queued in the ringbuffers are spooled when
+ * disconnected, so that the periodically sampled ringbuffers never overflow.
+ */
+#define SPOOL_CYCLE_COUNT MIN(MIN(CONFIG_DATA_GPS_BUFFER_COUNT,				\
+				  CONFIG_DATA_SENSOR_BUFFER_COUNT),			\
+			      MIN(CONFIG_DATA_MODEM_DYNAMIC_BUFFER_COUNT,		\
+				  CONFIG_DATA_BATTERY_BUFFER_COUNT))
+
+/* Number of sample cycles since the ringbuffers were last spooled. */
+static int spool_cycle_count;
+#endif /* CONFIG_DATA_SPOOL */
+
 /* Data module message queue. */
 #define DATA_QUEUE_ENTRY_COUNT		10
 #define DATA_QUEUE_BYTE_ALIGNMENT	4
@@ -316,6 +405,7 @@ static void data_list_clear_entry(struct ack_data *data)
 	data->ptr = NULL,
 	data->len = 0;
 	data->type = UNUSED;
+	data->spool_id = 0;
 }
 
 static void data_list_clear_and_free(struct ack_data *list, size_t list_count)
@@ -352,7 +442,7 @@ static void data_list_add_failed(void *ptr, size_t len, enum data_type type)
 	}
 }
 
-static void data_list_add_pending(void *ptr, size_t len, enum data_type type)
+static struct ack_data *data_list_add_pending(void *ptr, size_t len, enum data_type type)
 {
 	for (size_t i = 0; i < ARRAY_SIZE(pending_data); i++) {
 		if (pending_data[i].ptr == NULL) {
@@ -361,12 +451,34 @@ static void data_list_add_pending(void *ptr, size_t len, enum data_type type)
 			pending_data[i].type = type;
 
 			LOG_DBG("Pending data added: %p", pending_data[i].ptr);
-			return;
+			return &pending_data[i];
 		}
 	}
 
 	LOG_ERR("Could not add data to pending data list, list is full");
 	SEND_ERROR(data, DATA_EVT_ERROR, -ENFILE);
+
+	return NULL;
+}
+
+static enum data_module_event_type data_send_event_get(enum data_type type)
+{
+	switch (type) {
+	case GENERIC:
+		return DATA_EVT_DATA_SEND;
+	case BATCH:
+		return DATA_EVT_DATA_SEND_BATCH;
+	case CONFIG:
+		return DATA_EVT_CONFIG_SEND;
+	case UI:
+		return DATA_EVT_UI_DATA_SEND;
+	case NEIGHBOR_CELLS:
+		return DATA_EVT_NEIGHBOR_CELLS_DATA_SEND;
+	case AGPS_REQUEST:
+		return DATA_EVT_AGPS_REQUEST_DATA_SEND;
+	default:
+		return DATA_EVT_ERROR;
+	}
 }
 
 static void data_resend(void)
@@ -376,33 +488,14 @@ static void data_resend(void)
 	for (size_t i = 0; i < ARRAY_SIZE(failed_data); i++) {
 		if (failed_data[i].ptr != NULL) {
 
-			evt = new_data_module_event();
-
-			switch (failed_data[i].type) {
-			case GENERIC:
-				evt->type = DATA_EVT_DATA_SEND;
-				break;
-			case BATCH:
-				evt->type = DATA_EVT_DATA_SEND_BATCH;
-				break;
-			case CONFIG:
-				evt->type = DATA_EVT_CONFIG_SEND;
-				break;
-			case UI:
-				evt->type = DATA_EVT_UI_DATA_SEND;
-				break;
-			case NEIGHBOR_CELLS:
-				evt->type = DATA_EVT_NEIGHBOR_CELLS_DATA_SEND;
-				break;
-			case AGPS_REQUEST:
-				evt->type = DATA_EVT_AGPS_REQUEST_DATA_SEND;
-				break;
-			default:
+			if (data_send_event_get(failed_data[i].type) == DATA_EVT_ERROR) {
 				LOG_WRN("Unknown associated data type");
 				SEND_ERROR(data, DATA_EVT_ERROR, -ENODATA);
 				return;
 			}
 
+			evt = new_data_module_event();
+			evt->type = data_send_event_get(failed_data[i].type);
 			evt->data.buffer.buf = failed_data[i].ptr;
 			evt->data.buffer.len = failed_data[i].len;
 			LOG_WRN("Resending data: %.*s", failed_data[i].len,
@@ -424,6 +517,140 @@ static void data_resend(void)
 	}
 }
 
+#if defined(CONFIG_DATA_SPOOL)
+static size_t data_list_free_count(const struct ack_data *list, size_t list_count)
+{
+	size_t count = 0;
+
+	for (size_t i = 0; i < list_count; i++) {
+		if (list[i].ptr == NULL) {
+			count++;
+		}
+	}
+
+	return count;
+}
+
+static void spool_store(enum data_type type, const void *buf, size_t len)
+{
+	int err = data_spool_append(type, buf, len);
+
+	if (err) {
+		LOG_ERR("Could not spool data, error: %d", err);
+		return;
+	}
+
+	LOG_DBG("%d bytes of data spooled", len);
+}
+
+/* Send spooled data, oldest first. The next spooled data is sent when all data sent has been
+ * ACKed, so that the spool can be consumed up to the newest data sent.
+ */
+static void spool_drain(void)
+{
+	int err;
+	struct data_spool_entry entry;
+	struct data_module_event *evt;
+	struct ack_data *pending;
+	size_t sent_count = 0;
+
+	if (!data_spool_round_begin()) {
+		return;
+	}
+
+	while ((sent_count < CONFIG_DATA_SPOOL_DRAIN_COUNT) &&
+	       (data_list_free_count(pending_data, ARRAY_SIZE(pending_data)) > 0)) {
+		err = data_spool_read(&entry);
+		if (err == -ENOENT) {
+			break;
+		} else if (err) {
+			LOG_ERR("Could not read spooled data, error: %d", err);
+			break;
+		}
+
+		if (data_send_event_get(entry.type) == DATA_EVT_ERROR) {
+			LOG_WRN("Unknown spooled data type, skipping");
+			k_free(entry.buf);
+			continue;
+		}
+
+		pending = data_list_add_pending(entry.buf, entry.len, entry.type);
+		pending->spool_id = entry.id;
+
+		data_spool_round_add(entry.id);
+		sent_count++;
+
+		evt = new_data_module_event();
+		evt->type = data_send_event_get(entry.type);
+		evt->data.buffer.buf = entry.buf;
+		evt->data.buffer.len = entry.len;
+
+		LOG_DBG("Sending spooled data: %d bytes", entry.len);
+		EVENT_SUBMIT(evt);
+	}
+
+	if (sent_count == 0) {
+		/* The spool is empty. Persist its state so that data is not sent again after a
+		 * reboot.
+		 */
+		err = data_spool_sync();
+		if (err) {
+			LOG_ERR("Could not sync spool, error: %d", err);
+		}
+	}
+}
+
+static void spool_ack(bool sent)
+{
+	if (data_spool_round_done(sent) && (state == STATE_CLOUD_CONNECTED)) {
+		spool_drain();
+	}
+}
+
+/* Spooled data that has not been handled by the cloud module when the connection is lost is never
+ * ACKed. Drop it, it is read from the spool again when the connection is back.
+ */
+static void spool_pending_clear(void)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(pending_data); i++) {
+		if (pending_data[i].spool_id != 0) {
+			k_free(pending_data[i].ptr);
+			data_list_clear_entry(&pending_data[i]);
+		}
+	}
+
+	data_spool_round_abort();
+}
+#endif /* CONFIG_DATA_SPOOL */
+
+#if defined(CONFIG_CLOUD_CODEC_SHADOW_DIFF)
+/* Update the cached shadow state with the outcome of a message that reports device state. */
+static void shadow_ack(enum data_type type, bool sent)
+{
+	enum cloud_codec_shadow_section section;
+
+	switch (type) {
+	case GENERIC:
+		section = CLOUD_CODEC_SHADOW_MODEM_STATIC;
+		break;
+	case CONFIG:
+		section = CLOUD_CODEC_SHADOW_CONFIG;
+		break;
+	default:
+		return;
+	}
+
+	if (sent) {
+		cloud_codec_shadow_commit(section);
+	} else {
+		/* Report the complete section next time, the cloud might have missed any of the
+		 * changes that were not acknowledged.
+		 */
+		cloud_codec_shadow_invalidate(section);
+	}
+}
+#endif /* CONFIG_CLOUD_CODEC_SHADOW_DIFF */
+
 static void data_ack(void *ptr, bool sent)
 {
 	/* Move data from pending to failed data list if incoming data is
@@ -433,6 +660,28 @@ static void data_ack(void *ptr, bool sent)
 
 	for (size_t i = 0; i < ARRAY_SIZE(pending_data); i++) {
 		if (pending_data[i].ptr == ptr) {
+#if defined(CONFIG_CLOUD_CODEC_SHADOW_DIFF)
+			shadow_ack(pending_data[i].type, sent);
+#endif
+#if defined(CONFIG_DATA_SPOOL)
+			if (pending_data[i].spool_id != 0) {
+				/* Spooled data is sent again from flash if it failed. */
+				k_free(ptr);
+				data_list_clear_entry(&pending_data[i]);
+				spool_ack(sent);
+				return;
+			}
+
+			if (!sent && ((pending_data[i].type == BATCH) ||
+				      (pending_data[i].type == UI))) {
+				LOG_DBG("Moving %p data from pending to spool", ptr);
+
+				spool_store(pending_data[i].type, ptr, pending_data[i].len);
+				k_free(ptr);
+				data_list_clear_entry(&pending_data[i]);
+				return;
+			}
+#endif
 			if (sent) {
 				k_free(ptr);
 				LOG_DBG("Pending data ACKed: %p",
@@ -490,6 +739,16 @@ static int setup(void)
 		return err;
 	}
 
+#if defined(CONFIG_DATA_SPOOL)
+	err = data_spool_init(FLASH_AREA_ID(data_spool));
+	if (err) {
+		LOG_ERR("data_spool_init, error: %d", err);
+		return err;
+	}
+#endif
+
+	ringbuffer_ram_usage_print_all();
+
 	return 0;
 }
 
@@ -541,6 +800,152 @@ static void config_status_set_all(bool fresh)
 	current_cfg.nod_list_fresh = fresh;
 }
 
+/* Get the newest entry of a ringbuffer. If the ringbuffer is empty, the entry is not queued. */
+static void ringbuffer_newest_get(const struct cloud_codec_ringbuffer *ring, void *entry)
+{
+	size_t len = cloud_codec_ringbuffer_len(ring);
+
+	if ((len == 0) || cloud_codec_ringbuffer_get(ring, len - 1, entry)) {
+		memset(entry, 0, ring->entry_size);
+	}
+}
+
+static void ringbuffer_newest_set(struct cloud_codec_ringbuffer *ring, const void *entry)
+{
+	size_t len = cloud_codec_ringbuffer_len(ring);
+
+	if (len > 0) {
+		(void)cloud_codec_ringbuffer_set(ring, len - 1, entry);
+	}
+}
+
+/* Copy the entries of a ringbuffer to an array on the heap, that is passed to the codec. At least
+ * one entry is allocated, so that the codec always gets an array.
+ */
+static void *ringbuffer_entries_get(const struct cloud_codec_ringbuffer *ring, size_t *count)
+{
+	void *entries;
+
+	*count = MAX(cloud_codec_ringbuffer_len(ring), 1);
+
+	entries = k_calloc(*count, ring->entry_size);
+	if (entries == NULL) {
+		LOG_ERR("Failed to allocate %d entries of %s", *count, ring->name);
+		return NULL;
+	}
+
+	cloud_codec_ringbuffer_copy(ring, entries);
+
+	return entries;
+}
+
+/* Store the queued flags cleared by the codec back in the ringbuffer, and free the array. */
+static void ringbuffer_entries_put(struct cloud_codec_ringbuffer *ring, void *entries)
+{
+	if (entries == NULL) {
+		return;
+	}
+
+	cloud_codec_ringbuffer_update(ring, entries);
+	k_free(entries);
+}
+
+static void ringbuffer_ram_usage_print(const struct cloud_codec_ringbuffer *ring)
+{
+	size_t size = cloud_codec_ringbuffer_ram_size(ring);
+	size_t per_sample = 100 * size / ring->count;
+
+	LOG_DBG("%s: %d entries in %d bytes, %d.%02d bytes of RAM per sample (%d as a structure)",
+		ring->name, ring->count, size, per_sample / 100, per_sample % 100,
+		ring->entry_size);
+}
+
+static void ringbuffer_ram_usage_print_all(void)
+{
+	ringbuffer_ram_usage_print(&gps_buf);
+	ringbuffer_ram_usage_print(&sensors_buf);
+	ringbuffer_ram_usage_print(&modem_dyn_buf);
+	ringbuffer_ram_usage_print(&ui_buf);
+	ringbuffer_ram_usage_print(&accel_buf);
+	ringbuffer_ram_usage_print(&bat_buf);
+}
+
+/* This function allocates the arrays passed to the codec on the heap, and frees them. */
+static int batch_data_encode(struct cloud_codec_data *codec)
+{
+	int err;
+	size_t gps_count, sensors_count, modem_dyn_count, ui_count, accel_count, bat_count;
+	struct cloud_data_gps *gps = ringbuffer_entries_get(&gps_buf, &gps_count);
+	struct cloud_data_sensors *sensors = ringbuffer_entries_get(&sensors_buf, &sensors_count);
+	struct cloud_data_modem_dynamic *modem_dyn = ringbuffer_entries_get(&modem_dyn_buf,
+									   &modem_dyn_count);
+	struct cloud_data_ui *ui = ringbuffer_entries_get(&ui_buf, &ui_count);
+	struct cloud_data_accelerometer *accel = ringbuffer_entries_get(&accel_buf, &accel_count);
+	struct cloud_data_battery *bat = ringbuffer_entries_get(&bat_buf, &bat_count);
+
+	if (!gps || !sensors || !modem_dyn || !ui || !accel || !bat) {
+		err = -ENOMEM;
+		goto exit;
+	}
+
+	err = cloud_codec_encode_batch_data(codec,
+					gps,
+					sensors,
+					modem_dyn,
+					ui,
+					accel,
+					bat,
+					gps_count,
+					sensors_count,
+					modem_dyn_count,
+					ui_count,
+					accel_count,
+					bat_count);
+
+exit:
+	ringbuffer_entries_put(&gps_buf, gps);
+	ringbuffer_entries_put(&sensors_buf, sensors);
+	ringbuffer_entries_put(&modem_dyn_buf, modem_dyn);
+	ringbuffer_entries_put(&ui_buf, ui);
+	ringbuffer_entries_put(&accel_buf, accel);
+	ringbuffer_entries_put(&bat_buf, bat);
+
+	return err;
+}
+
+#if defined(CONFIG_DATA_SPOOL)
+/* Encode the entries queued in the ringbuffers in a single batch message and append it to the
+ * spool, so that many samples are written to flash at once.
+ */
+static void spool_batch_store(void)
+{
+	int err;
+	struct cloud_codec_data codec = {0};
+
+	if (!date_time_is_valid()) {
+		/* Entries cannot be timestamped yet and are kept in the ringbuffers. */
+		return;
+	}
+
+	spool_cycle_count = 0;
+
+	err = batch_data_encode(&codec);
+	switch (err) {
+	case 0:
+		spool_store(BATCH, codec.buf, codec.len);
+		k_free(codec.buf);
+		break;
+	case -ENODATA:
+		LOG_DBG("No batch data to spool, ringbuffers are empty");
+		break;
+	default:
+		LOG_ERR("Error batch-encoding data: %d", err);
+		SEND_ERROR(data, DATA_EVT_ERROR, err);
+		break;
+	}
+}
+#endif /* CONFIG_DATA_SPOOL */
+
 static void data_send(enum data_module_event_type event,
 		      enum data_type type,
 		      struct cloud_codec_data *data)
@@ -564,6 +969,12 @@ static void data_encode(void)
 {
 	int err;
 	struct cloud_codec_data codec = {0};
+	struct cloud_data_gps gps;
+	struct cloud_data_sensors sensors;
+	struct cloud_data_modem_dynamic modem_dyn;
+	struct cloud_data_ui ui;
+	struct cloud_data_accelerometer accel;
+	struct cloud_data_battery bat;
 
 	if (!date_time_is_valid()) {
 		/* Date time library does not have valid time to
@@ -591,15 +1002,38 @@ static void data_encode(void)
 		return;
 	}
 
+	ringbuffer_newest_get(&gps_buf, &gps);
+	ringbuffer_newest_get(&sensors_buf, &sensors);
+	ringbuffer_newest_get(&modem_dyn_buf, &modem_dyn);
+	ringbuffer_newest_get(&ui_buf, &ui);
+	ringbuffer_newest_get(&accel_buf, &accel);
+	ringbuffer_newest_get(&bat_buf, &bat);
+
+#if defined(CONFIG_CLOUD_CODEC_SHADOW_DIFF)
+	if (modem_stat.queued && !cloud_codec_shadow_modem_static_diff(&modem_stat)) {
+		LOG_DBG("Static modem data has not changed since it was last reported");
+		modem_stat.queued = false;
+	}
+#endif
+
 	err = cloud_codec_encode_data(
 		&codec,
-		&gps_buf[head_gps_buf],
-		&sensors_buf[head_sensor_buf],
+		&gps,
+		&sensors,
 		&modem_stat,
-		&modem_dyn_buf[head_modem_dyn_buf],
-		&ui_buf[head_ui_buf],
-		&accel_buf[head_accel_buf],
-		&bat_buf[head_bat_buf]);
+		&modem_dyn,
+		&ui,
+		&accel,
+		&bat);
+
+	/* Entries encoded by the codec are no longer queued. */
+	ringbuffer_newest_set(&gps_buf, &gps);
+	ringbuffer_newest_set(&sensors_buf, &sensors);
+	ringbuffer_newest_set(&modem_dyn_buf, &modem_dyn);
+	ringbuffer_newest_set(&ui_buf, &ui);
+	ringbuffer_newest_set(&accel_buf, &accel);
+	ringbuffer_newest_set(&bat_buf, &bat);
+
 	switch (err) {
 	case 0:
 		LOG_DBG("Data encoded successfully");
@@ -617,19 +1051,7 @@ static void data_encode(void)
 		return;
 	}
 
-	err = cloud_codec_encode_batch_data(&codec,
-					gps_buf,
-					sensors_buf,
-					modem_dyn_buf,
-					ui_buf,
-					accel_buf,
-					bat_buf,
-					ARRAY_SIZE(gps_buf),
-					ARRAY_SIZE(sensors_buf),
-					ARRAY_SIZE(modem_dyn_buf),
-					ARRAY_SIZE(ui_buf),
-					ARRAY_SIZE(accel_buf),
-					ARRAY_SIZE(bat_buf));
+	err = batch_data_encode(&codec);
 	switch (err) {
 	case 0:
 		LOG_DBG("Batch data encoded successfully");
@@ -763,6 +1185,20 @@ static void config_send(bool send_all)
 		config_status_set_all(true);
 	}
 
+#if defined(CONFIG_CLOUD_CODEC_SHADOW_DIFF)
+	/* Report the values that differ from the last acknowledged configuration, instead of the
+	 * values that differ from the previously applied configuration.
+	 */
+	if (send_all || IS_ENABLED(CONFIG_DATA_SEND_ALL_DEVICE_CONFIGURATIONS)) {
+		cloud_codec_shadow_invalidate(CLOUD_CODEC_SHADOW_CONFIG);
+	}
+
+	if (!cloud_codec_shadow_config_diff(&current_cfg)) {
+		LOG_DBG("Configuration has not changed since it was last reported");
+		goto exit;
+	}
+#endif
+
 	err = cloud_codec_encode_config(&codec, &current_cfg);
 	if (err) {
 		LOG_ERR("Error encoding configuration, error: %d", err);
@@ -788,6 +1224,7 @@ static void data_ui_send(void)
 	int err;
 	struct data_module_event *evt;
 	struct cloud_codec_data codec = {0};
+	struct cloud_data_ui ui;
 
 	if (!date_time_is_valid()) {
 		/* Date time library does not have valid time to
@@ -797,7 +1234,12 @@ static void data_ui_send(void)
 		return;
 	}
 
-	err = cloud_codec_encode_ui_data(&codec, &ui_buf[head_ui_buf]);
+	ringbuffer_newest_get(&ui_buf, &ui);
+
+	err = cloud_codec_encode_ui_data(&codec, &ui);
+
+	ringbuffer_newest_set(&ui_buf, &ui);
+
 	if (err == -ENODATA) {
 		LOG_DBG("No new UI data to encode, error: %d", err);
 		return;
@@ -1062,7 +1504,18 @@ static void on_cloud_state_disconnected(struct data_msg_data *msg)
 	if (IS_EVENT(msg, cloud, CLOUD_EVT_CONNECTED)) {
 		date_time_update_async(date_time_event_handler);
 		state_set(STATE_CLOUD_CONNECTED);
+		return;
+	}
+
+#if defined(CONFIG_DATA_SPOOL)
+	if (IS_EVENT(msg, data, DATA_EVT_DATA_READY)) {
+		/* Spool the sampled data before the ringbuffers overflow. */
+		if (++spool_cycle_count >= SPOOL_CYCLE_COUNT) {
+			spool_batch_store();
+		}
+		return;
 	}
+#endif
 }
 
 /* Message handler for STATE_CLOUD_CONNECTED. */
@@ -1071,6 +1524,10 @@ static void on_cloud_state_connected(struct data_msg_data *msg)
 	if (IS_EVENT(msg, data, DATA_EVT_DATA_READY)) {
 		/* Resend data previously failed to be sent. */
 		data_resend();
+#if defined(CONFIG_DATA_SPOOL)
+		/* Spooled data is older than the data in the ringbuffers. */
+		spool_drain();
+#endif
 		data_encode();
 		return;
 	}
@@ -1086,11 +1543,18 @@ static void on_cloud_state_connected(struct data_msg_data *msg)
 	}
 
 	if (IS_EVENT(msg, cloud, CLOUD_EVT_DISCONNECTED)) {
+#if defined(CONFIG_DATA_SPOOL)
+		spool_pending_clear();
+#endif
 		state_set(STATE_CLOUD_DISCONNECTED);
 		return;
 	}
 
 	if (IS_EVENT(msg, cloud, CLOUD_EVT_CONFIG_EMPTY)) {
+#if defined(CONFIG_CLOUD_CODEC_SHADOW_DIFF)
+		/* The cloud has no stored state, report all of it again. */
+		cloud_codec_shadow_reset();
+#endif
 		config_send(true);
 		return;
 	}
@@ -1135,7 +1599,11 @@ static void on_all_states(struct data_msg_data *msg)
 	}
 
 	if (IS_EVENT(msg, util, UTIL_EVT_SHUTDOWN_REQUEST)) {
-		/* The module doesn't have anything to shut down and can
+#if defined(CONFIG_DATA_SPOOL)
+		/* Keep the data that has not been sent across the reboot. */
+		spool_batch_store();
+#endif
+		/* The module doesn't have anything else to shut down and can
 		 * report back immediately.
 		 */
 		SEND_SHUTDOWN_ACK(data, DATA_EVT_SHUTDOWN_READY, self.id);
@@ -1165,9 +1633,9 @@ static void on_all_states(struct data_msg_data *msg)
 			.queued = true
 		};
 
-		cloud_codec_populate_ui_buffer(ui_buf, &new_ui_data,
-					       &head_ui_buf,
-					       ARRAY_SIZE(ui_buf));
+		if (IS_ENABLED(CONFIG_DATA_UI_BUFFER_STORE)) {
+			cloud_codec_ringbuffer_put(&ui_buf, &new_ui_data);
+		}
 
 		SEND_EVENT(data, DATA_EVT_UI_DATA_READY);
 		return;
@@ -1184,6 +1652,12 @@ static void on_all_states(struct data_msg_data *msg)
 		modem_stat.bnd = msg->module.modem.data.modem_static.band;
 		modem_stat.ts = msg->module.modem.data.modem_static.timestamp;
 		modem_stat.queued = true;
+		modem_stat.bnd_fresh = true;
+		modem_stat.nw_mode_fresh = true;
+		modem_stat.iccid_fresh = true;
+		modem_stat.appv_fresh = true;
+		modem_stat.brdv_fresh = true;
+		modem_stat.fw_fresh = true;
 
 		BUILD_ASSERT(sizeof(modem_stat.appv) >=
 			     sizeof(msg->module.modem.data.modem_static.app_version));
@@ -1233,11 +1707,9 @@ static void on_all_states(struct data_msg_data *msg)
 		strcpy(new_modem_data.ip, msg->module.modem.data.modem_dynamic.ip_address);
 		strcpy(new_modem_data.mccmnc, msg->module.modem.data.modem_dynamic.mccmnc);
 
-		cloud_codec_populate_modem_dynamic_buffer(
-						modem_dyn_buf,
-						&new_modem_data,
-						&head_modem_dyn_buf,
-						ARRAY_SIZE(modem_dyn_buf));
+		if (IS_ENABLED(CONFIG_DATA_DYNAMIC_MODEM_BUFFER_STORE)) {
+			cloud_codec_ringbuffer_put(&modem_dyn_buf, &new_modem_data);
+		}
 
 		requested_data_status_set(APP_DATA_MODEM_DYNAMIC);
 	}
@@ -1253,9 +1725,9 @@ static void on_all_states(struct data_msg_data *msg)
 			.queued = true
 		};
 
-		cloud_codec_populate_bat_buffer(bat_buf, &new_battery_data,
-						&head_bat_buf,
-						ARRAY_SIZE(bat_buf));
+		if (IS_ENABLED(CONFIG_DATA_BATTERY_BUFFER_STORE)) {
+			cloud_codec_ringbuffer_put(&bat_buf, &new_battery_data);
+		}
 
 		requested_data_status_set(APP_DATA_BATTERY);
 	}
@@ -1268,10 +1740,9 @@ static void on_all_states(struct data_msg_data *msg)
 			.queued = true
 		};
 
-		cloud_codec_populate_sensor_buffer(sensors_buf,
-						   &new_sensor_data,
-						   &head_sensor_buf,
-						   ARRAY_SIZE(sensors_buf));
+		if (IS_ENABLED(CONFIG_DATA_SENSOR_BUFFER_STORE)) {
+			cloud_codec_ringbuffer_put(&sensors_buf, &new_sensor_data);
+		}
 
 		requested_data_status_set(APP_DATA_ENVIRONMENTAL);
 	}
@@ -1289,9 +1760,9 @@ static void on_all_states(struct data_msg_data *msg)
 			.queued = true
 		};
 
-		cloud_codec_populate_accel_buffer(accel_buf, &new_movement_data,
-						  &head_accel_buf,
-						  ARRAY_SIZE(accel_buf));
+		if (IS_ENABLED(CONFIG_DATA_ACCELEROMETER_BUFFER_STORE)) {
+			cloud_codec_ringbuffer_put(&accel_buf, &new_movement_data);
+		}
 	}
 
 	if (IS_EVENT(msg, gps, GPS_EVT_DATA_READY)) {
@@ -1328,9 +1799,9 @@ static void on_all_states(struct data_msg_data *msg)
 			return;
 		}
 
-		cloud_codec_populate_gps_buffer(gps_buf, &new_gps_data,
-						&head_gps_buf,
-						ARRAY_SIZE(gps_buf));
+		if (IS_ENABLED(CONFIG_DATA_GPS_BUFFER_STORE)) {
+			cloud_codec_ringbuffer_put(&gps_buf, &new_gps_data);
+		}
 
 		requested_data_status_set(APP_DATA_GNSS);
 	}
@@ -0,0 +1,19 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr.h>
+
+#include "date_time.h"
+
+#define BOOT_TIME_MS 1563968747123
+
+/* Mocking function that converts the input uptime as if the device booted at a known time. */
+int date_time_uptime_to_unix_time_ms(int64_t *uptime)
+{
+	*uptime += BOOT_TIME_MS;
+
+	return 0;
+}
@@ -0,0 +1,554 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <ztest.h>
+#include <zephyr.h>
+#include <stdio.h>
+#include <string.h>
+#include <cJSON.h>
+#include <cJSON_os.h>
+
+#include "cloud_codec.h"
+#include "cbor_common.h"
+#include "json_common.h"
+#include "json_protocol_names.h"
+
+#define BOOT_TIME_MS	1563968747123
+#define ENTRIES_MAX	24
+
+/* Entries of each type, filled with samples as the application takes them. */
+static struct test_data {
+	struct cloud_data_gps gps[ENTRIES_MAX];
+	struct cloud_data_sensors sensor[ENTRIES_MAX];
+	struct cloud_data_modem_dynamic modem_dynamic[ENTRIES_MAX];
+	struct cloud_data_ui ui[ENTRIES_MAX];
+	struct cloud_data_accelerometer accel[ENTRIES_MAX];
+	struct cloud_data_battery battery[ENTRIES_MAX];
+	size_t count;
+} data, expected;
+
+static uint32_t rand_state;
+
+static uint32_t rand_get(void)
+{
+	rand_state = rand_state * 1103515245 + 12345;
+
+	return rand_state >> 16;
+}
+
+/* Random value in [-range, range], with a resolution of a thousandth of the range. */
+static double jitter(double range)
+{
+	return range * ((int32_t)(rand_get() % 2001) - 1000) / 1000;
+}
+
+static void data_fill(size_t count)
+{
+	memset(&data, 0, sizeof(data));
+	rand_state = 1;
+	data.count = count;
+
+	for (size_t i = 0; i < count; i++) {
+		/* Samples are taken about once a minute. */
+		int64_t ts = 60000 * (i + 1) + rand_get() % 1000;
+
+		data.gps[i] = (struct cloud_data_gps) {
+			.pvt.longi = 10.4 + 0.0003 * i + jitter(0.00005),
+			.pvt.lat = 63.43 + 0.0002 * i + jitter(0.00005),
+			.pvt.acc = 8 + jitter(4),
+			.pvt.alt = 170 + jitter(10),
+			.pvt.spd = 1.2 + jitter(0.5),
+			.pvt.hdg = 176 + jitter(20),
+			.gps_ts = ts,
+			.format = CLOUD_CODEC_GPS_FORMAT_PVT,
+			.queued = true
+		};
+		data.sensor[i] = (struct cloud_data_sensors) {
+			.temp = 22.5 + jitter(0.3),
+			.hum = 48.2 + jitter(1),
+			.env_ts = ts,
+			.queued = true
+		};
+		data.modem_dynamic[i] = (struct cloud_data_modem_dynamic) {
+			.rsrp = -80 + (int16_t)jitter(5),
+			.area = 12,
+			.mccmnc = "24202",
+			.cell = 33703719,
+			.ip = "10.81.183.99",
+			.ts = ts,
+			.queued = true,
+			/* Only the values that changed are fresh after the first sample. */
+			.rsrp_fresh = true,
+			.area_code_fresh = (i == 0),
+			.mccmnc_fresh = (i == 0),
+			.cell_id_fresh = (i == 0),
+			.ip_address_fresh = (i == 0)
+		};
+		data.ui[i] = (struct cloud_data_ui) {
+			.btn = 1 + (i % 2),
+			.btn_ts = ts,
+			.queued = true
+		};
+		data.accel[i] = (struct cloud_data_accelerometer) {
+			.values = { jitter(0.5), jitter(0.5), 9.81 + jitter(0.5) },
+			.ts = ts,
+			.queued = true
+		};
+		data.battery[i] = (struct cloud_data_battery) {
+			.bat = 4100 - i,
+			.bat_ts = ts,
+			.queued = true
+		};
+	}
+
+	if (count > 5) {
+		/* Entries that are left out, or not delta encoded. */
+		data.gps[1].queued = false;
+		data.gps[3].format = CLOUD_CODEC_GPS_FORMAT_NMEA;
+		strcpy(data.gps[3].nmea,
+		       "$GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*47");
+		data.sensor[2].queued = false;
+		data.modem_dynamic[4].rsrp_fresh = false;
+	}
+
+	expected = data;
+}
+
+static int batch_encode(struct cloud_codec_data *output, size_t count)
+{
+	return cbor_common_batch_encode(output, data.gps, data.sensor, data.modem_dynamic,
+					data.ui, data.accel, data.battery, count, count, count,
+					count, count, count);
+}
+
+static int batch_json_encode(struct cloud_codec_data *output, size_t count)
+{
+	const struct json_common_batch batch[] = {
+		{ JSON_COMMON_MODEM_DYNAMIC, data.modem_dynamic, count, DATA_MODEM_DYNAMIC },
+		{ JSON_COMMON_GPS, data.gps, count, DATA_GPS },
+		{ JSON_COMMON_SENSOR, data.sensor, count, DATA_ENVIRONMENTALS },
+		{ JSON_COMMON_UI, data.ui, count, DATA_BUTTON },
+		{ JSON_COMMON_BATTERY, data.battery, count, DATA_BATTERY },
+		{ JSON_COMMON_ACCELEROMETER, data.accel, count, DATA_MOVEMENT },
+	};
+
+	return json_common_batch_encode(output, batch, ARRAY_SIZE(batch));
+}
+
+/* Minimal CBOR reader, for the data items written by the codec. */
+struct reader {
+	const uint8_t *buf;
+	size_t len;
+	size_t pos;
+};
+
+static uint64_t head_read(struct reader *reader, uint8_t *major)
+{
+	uint8_t info;
+	size_t arg_len;
+	uint64_t arg = 0;
+
+	zassert_true(reader->pos < reader->len, "Output too short");
+
+	*major = reader->buf[reader->pos] >> 5;
+	info = reader->buf[reader->pos] & 0x1f;
+	reader->pos++;
+
+	if (info < 24) {
+		return info;
+	}
+
+	zassert_true(info <= 27, "Unexpected additional information %u", info);
+
+	arg_len = 1 << (info - 24);
+	zassert_true(reader->pos + arg_len <= reader->len, "Output too short");
+
+	for (size_t i = 0; i < arg_len; i++) {
+		arg = (arg << 8) | reader->buf[reader->pos++];
+	}
+
+	/* Each argument is written in its shortest form. */
+	zassert_true(arg >= ((arg_len == 1) ? 24 : (1ULL << (4 * arg_len))),
+		     "Argument not in shortest form");
+
+	return arg;
+}
+
+static int64_t int_read(struct reader *reader)
+{
+	uint8_t major;
+	uint64_t arg = head_read(reader, &major);
+
+	zassert_true(major == 0 || major == 1, "Not an integer");
+
+	return (major == 0) ? (int64_t)arg : -1 - (int64_t)arg;
+}
+
+static size_t container_read(struct reader *reader, uint8_t expected_major)
+{
+	uint8_t major;
+	uint64_t count = head_read(reader, &major);
+
+	zassert_equal(expected_major, major, "Wrong major type %u", major);
+
+	return count;
+}
+
+static void tstr_read(struct reader *reader, const char *expected_str)
+{
+	size_t len = container_read(reader, 3);
+
+	zassert_equal(strlen(expected_str), len, "Wrong string length");
+	zassert_true(reader->pos + len <= reader->len, "Output too short");
+	zassert_mem_equal(expected_str, reader->buf + reader->pos, len, "Wrong string");
+
+	reader->pos += len;
+}
+
+/* Timestamp of an entry, which is a difference from the previous entry except for the first. */
+static void ts_check(struct reader *reader, int64_t *prev_ts, int64_t uptime)
+{
+	int64_t ts = int_read(reader) + *prev_ts;
+
+	zassert_equal(BOOT_TIME_MS + uptime, ts, "Wrong timestamp");
+	*prev_ts = ts;
+}
+
+static void value_check(struct reader *reader, int64_t *prev, double value, int32_t scale)
+{
+	double scaled = value * scale;
+	int64_t fixed = (int64_t)(scaled < 0 ? scaled - 0.5 : scaled + 0.5);
+
+	zassert_equal(fixed, int_read(reader) + *prev, "Wrong value %f", value);
+	*prev = fixed;
+}
+
+static void modem_dynamic_check(struct reader *reader)
+{
+	size_t count = container_read(reader, 4);
+	int64_t prev_ts = 0;
+
+	for (size_t i = 0; i < expected.count; i++) {
+		const struct cloud_data_modem_dynamic *entry = &expected.modem_dynamic[i];
+		size_t pairs;
+
+		if (!entry->rsrp_fresh && !entry->area_code_fresh && !entry->mccmnc_fresh &&
+		    !entry->cell_id_fresh && !entry->ip_address_fresh) {
+			continue;
+		}
+
+		zassert_true(count-- > 0, "Missing entry");
+
+		pairs = container_read(reader, 5);
+		zassert_equal(1 + entry->rsrp_fresh + entry->area_code_fresh +
+			      entry->mccmnc_fresh + entry->cell_id_fresh + entry->ip_address_fresh,
+			      pairs, "Wrong number of values");
+
+		zassert_equal(CBOR_COMMON_MODEM_TIMESTAMP, int_read(reader), "Wrong key");
+		ts_check(reader, &prev_ts, entry->ts);
+
+		if (entry->rsrp_fresh) {
+			zassert_equal(CBOR_COMMON_MODEM_RSRP, int_read(reader), "Wrong key");
+			zassert_equal(entry->rsrp, int_read(reader), "Wrong RSRP");
+		}
+
+		if (entry->area_code_fresh) {
+			zassert_equal(CBOR_COMMON_MODEM_AREA_CODE, int_read(reader), "Wrong key");
+			zassert_equal(entry->area, int_read(reader), "Wrong area code");
+		}
+
+		if (entry->mccmnc_fresh) {
+			zassert_equal(CBOR_COMMON_MODEM_MCCMNC, int_read(reader), "Wrong key");
+			zassert_equal(strtoul(entry->mccmnc, NULL, 10), int_read(reader),
+				      "Wrong MCCMNC");
+		}
+
+		if (entry->cell_id_fresh) {
+			zassert_equal(CBOR_COMMON_MODEM_CELL_ID, int_read(reader), "Wrong key");
+			zassert_equal(entry->cell, int_read(reader), "Wrong cell ID");
+		}
+
+		if (entry->ip_address_fresh) {
+			zassert_equal(CBOR_COMMON_MODEM_IP_ADDRESS, int_read(reader), "Wrong key");
+			tstr_read(reader, entry->ip);
+		}
+	}
+
+	zassert_equal(0, count, "Unexpected entries");
+}
+
+static void gps_check(struct reader *reader)
+{
+	size_t count = container_read(reader, 4);
+	int64_t prev_ts = 0;
+	int64_t prev[6] = { 0 };
+
+	for (size_t i = 0; i < expected.count; i++) {
+		const struct cloud_data_gps *entry = &expected.gps[i];
+
+		if (!entry->queued) {
+			continue;
+		}
+
+		zassert_true(count-- > 0, "Missing entry");
+
+		if (entry->format == CLOUD_CODEC_GPS_FORMAT_NMEA) {
+			zassert_equal(2, container_read(reader, 4), "Wrong NMEA entry");
+			ts_check(reader, &prev_ts, entry->gps_ts);
+			tstr_read(reader, entry->nmea);
+			continue;
+		}
+
+		zassert_equal(7, container_read(reader, 4), "Wrong PVT entry");
+		ts_check(reader, &prev_ts, entry->gps_ts);
+		value_check(reader, &prev[0], entry->pvt.longi, CBOR_COMMON_GPS_COORD_SCALE);
+		value_check(reader, &prev[1], entry->pvt.lat, CBOR_COMMON_GPS_COORD_SCALE);
+		value_check(reader, &prev[2], entry->pvt.acc, CBOR_COMMON_GPS_METER_SCALE);
+		value_check(reader, &prev[3], entry->pvt.alt, CBOR_COMMON_GPS_METER_SCALE);
+		value_check(reader, &prev[4], entry->pvt.spd, CBOR_COMMON_GPS_METER_SCALE);
+		value_check(reader, &prev[5], entry->pvt.hdg, CBOR_COMMON_GPS_HEADING_SCALE);
+	}
+
+	zassert_equal(0, count, "Unexpected entries");
+}
+
+static void sensor_check(struct reader *reader)
+{
+	size_t count = container_read(reader, 4);
+	int64_t prev_ts = 0;
+	int64_t prev[2] = { 0 };
+
+	for (size_t i = 0; i < expected.count; i++) {
+		const struct cloud_data_sensors *entry = &expected.sensor[i];
+
+		if (!entry->queued) {
+			continue;
+		}
+
+		zassert_true(count-- > 0, "Missing entry");
+		zassert_equal(3, container_read(reader, 4), "Wrong entry");
+		ts_check(reader, &prev_ts, entry->env_ts);
+		value_check(reader, &prev[0], entry->temp, CBOR_COMMON_SENSOR_SCALE);
+		value_check(reader, &prev[1], entry->hum, CBOR_COMMON_SENSOR_SCALE);
+	}
+
+	zassert_equal(0, count, "Unexpected entries");
+}
+
+static void ui_check(struct reader *reader)
+{
+	size_t count = container_read(reader, 4);
+	int64_t prev_ts = 0;
+
+	zassert_equal(expected.count, count, "Wrong number of entries");
+
+	for (size_t i = 0; i < expected.count; i++) {
+		zassert_equal(2, container_read(reader, 4), "Wrong entry");
+		ts_check(reader, &prev_ts, expected.ui[i].btn_ts);
+		zassert_equal(expected.ui[i].btn, int_read(reader), "Wrong button");
+	}
+}
+
+static void battery_check(struct reader *reader)
+{
+	size_t count = container_read(reader, 4);
+	int64_t prev_ts = 0;
+
+	zassert_equal(expected.count, count, "Wrong number of entries");
+
+	for (size_t i = 0; i < expected.count; i++) {
+		zassert_equal(2, container_read(reader, 4), "Wrong entry");
+		ts_check(reader, &prev_ts, expected.battery[i].bat_ts);
+		zassert_equal(expected.battery[i].bat, int_read(reader), "Wrong battery level");
+	}
+}
+
+static void accel_check(struct reader *reader)
+{
+	size_t count = container_read(reader, 4);
+	int64_t prev_ts = 0;
+
+	zassert_equal(expected.count, count, "Wrong number of entries");
+
+	for (size_t i = 0; i < expected.count; i++) {
+		zassert_equal(4, container_read(reader, 4), "Wrong entry");
+		ts_check(reader, &prev_ts, expected.accel[i].ts);
+
+		for (size_t j = 0; j < 3; j++) {
+			int64_t absolute = 0;
+
+			value_check(reader, &absolute, expected.accel[i].values[j],
+				    CBOR_COMMON_ACCEL_SCALE);
+		}
+	}
+}
+
+static void test_encode_batch_data(void)
+{
+	struct cloud_codec_data output;
+	struct reader reader;
+	int ret;
+
+	data_fill(12);
+
+	ret = batch_encode(&output, data.count);
+	zassert_equal(0, ret, "Return value %d is wrong", ret);
+
+	reader = (struct reader) { .buf = (uint8_t *)output.buf, .len = output.len };
+
+	zassert_equal(7, container_read(&reader, 5), "Wrong number of arrays");
+	zassert_equal(CBOR_COMMON_BATCH_VERSION, int_read(&reader), "Wrong key");
+	zassert_equal(CBOR_COMMON_SCHEMA_VERSION, int_read(&reader), "Wrong version");
+	zassert_equal(CBOR_COMMON_BATCH_MODEM_DYNAMIC, int_read(&reader), "Wrong key");
+	modem_dynamic_check(&reader);
+	zassert_equal(CBOR_COMMON_BATCH_GPS, int_read(&reader), "Wrong key");
+	gps_check(&reader);
+	zassert_equal(CBOR_COMMON_BATCH_SENSOR, int_read(&reader), "Wrong key");
+	sensor_check(&reader);
+	zassert_equal(CBOR_COMMON_BATCH_UI, int_read(&reader), "Wrong key");
+	ui_check(&reader);
+	zassert_equal(CBOR_COMMON_BATCH_BATTERY, int_read(&reader), "Wrong key");
+	battery_check(&reader);
+	zassert_equal(CBOR_COMMON_BATCH_ACCELEROMETER, int_read(&reader), "Wrong key");
+	accel_check(&reader);
+	zassert_equal(output.len, reader.pos, "Trailing bytes");
+
+	k_free(output.buf);
+
+	for (size_t i = 0; i < data.count; i++) {
+		zassert_false(data.gps[i].queued || data.sensor[i].queued ||
+			      data.modem_dynamic[i].queued || data.ui[i].queued ||
+			      data.accel[i].queued || data.battery[i].queued,
+			      "Entry %zu left queued", i);
+	}
+
+	/* Nothing is left to encode. */
+	ret = batch_encode(&output, data.count);
+	zassert_equal(-ENODATA, ret, "Return value %d is wrong", ret);
+}
+
+static void test_encode_known_output(void)
+{
+	struct cloud_codec_data output;
+	struct cloud_data_battery battery = {
+		.bat = 3600,
+		.bat_ts = 1000,
+		.queued = true
+	};
+	struct cloud_data_sensors sensor[2] = {
+		[0].temp = 23.5,
+		[0].hum = 50,
+		[0].env_ts = 1000,
+		[0].queued = true,
+		[1].temp = 23.25,
+		[1].hum = 51,
+		[1].env_ts = 61000,
+		[1].queued = true
+	};
+	static const uint8_t expected_output[] = {
+		0xa3,					/* map(3) */
+		0x00, 0x01,				/* version: 1 */
+		0x03, 0x82,				/* 3: array(2) */
+		0x83,					/* array(3) */
+		0x1b, 0x00, 0x00, 0x01, 0x6c, 0x23,	/* 1563968748123 */
+		0xcd, 0x3a, 0x5b,
+		0x19, 0x09, 0x2e,			/* 2350 */
+		0x19, 0x13, 0x88,			/* 5000 */
+		0x83,					/* array(3) */
+		0x19, 0xea, 0x60,			/* +60000 */
+		0x38, 0x18,				/* -25 */
+		0x18, 0x64,				/* +100 */
+		0x05, 0x81,				/* 5: array(1) */
+		0x82,					/* array(2) */
+		0x1b, 0x00, 0x00, 0x01, 0x6c, 0x23,	/* 1563968748123 */
+		0xcd, 0x3a, 0x5b,
+		0x19, 0x0e, 0x10,			/* 3600 */
+	};
+	int ret;
+
+	ret = cbor_common_batch_encode(&output, NULL, sensor, NULL, NULL, NULL, &battery,
+				       0, ARRAY_SIZE(sensor), 0, 0, 0, 1);
+	zassert_equal(0, ret, "Return value %d is wrong", ret);
+	zassert_equal(sizeof(expected_output), output.len, "Wrong length %zu", output.len);
+	zassert_mem_equal(expected_output, output.buf, output.len, "Wrong output");
+
+	k_free(output.buf);
+}
+
+static void test_encode_invalid_data(void)
+{
+	struct cloud_codec_data output;
+	struct cloud_data_gps gps = {
+		.gps_ts = 1000,
+		.queued = true,
+		.format = CLOUD_CODEC_GPS_FORMAT_INVALID
+	};
+	struct cloud_data_modem_dynamic modem_dynamic = {
+		.mccmnc = "242O2",
+		.ts = 1000,
+		.queued = true,
+		.mccmnc_fresh = true
+	};
+	int ret;
+
+	ret = cbor_common_batch_encode(&output, &gps, NULL, NULL, NULL, NULL, NULL,
+				       1, 0, 0, 0, 0, 0);
+	zassert_equal(-EINVAL, ret, "Return value %d is wrong", ret);
+	zassert_true(gps.queued, "Entry unqueued");
+
+	ret = cbor_common_batch_encode(&output, NULL, NULL, &modem_dynamic, NULL, NULL, NULL,
+				       0, 0, 1, 0, 0, 0);
+	zassert_equal(-ENOTEMPTY, ret, "Return value %d is wrong", ret);
+	zassert_true(modem_dynamic.queued, "Entry unqueued");
+}
+
+/* Compare the size of the CBOR and JSON outputs for the same entries. */
+static void test_size_compared_to_json(void)
+{
+	static const size_t counts[] = { 1, 6, ENTRIES_MAX };
+
+	for (size_t i = 0; i < ARRAY_SIZE(counts); i++) {
+		struct cloud_codec_data cbor;
+		struct cloud_codec_data json;
+		int ret;
+
+		data_fill(counts[i]);
+		ret = batch_encode(&cbor, counts[i]);
+		zassert_equal(0, ret, "Return value %d is wrong", ret);
+
+		data_fill(counts[i]);
+		ret = batch_json_encode(&json, counts[i]);
+		zassert_equal(0, ret, "Return value %d is wrong", ret);
+
+		printk("%zu entries of each type: JSON %zu bytes, CBOR %zu bytes (%zu%%)\n",
+		       counts[i], json.len, cbor.len, 100 * cbor.len / json.len);
+
+		/* Keys are not repeated, and values are smaller. */
+		zassert_true(cbor.len * 2 < json.len, "CBOR output not smaller than JSON");
+
+		if (counts[i] == ENTRIES_MAX) {
+			/* Consecutive entries are delta encoded. */
+			zassert_true(cbor.len * 4 < json.len, "Batch not delta encoded");
+		}
+
+		k_free(cbor.buf);
+		cJSON_FreeString(json.buf);
+	}
+}
+
+void test_main(void)
+{
+	cJSON_Init();
+
+	ztest_test_suite(cbor_common,
+		ztest_unit_test(test_encode_batch_data),
+		ztest_unit_test(test_encode_known_output),
+		ztest_unit_test(test_encode_invalid_data),
+		ztest_unit_test(test_size_compared_to_json)
+	);
+
+	ztest_run_test_suite(cbor_common);
+}
@@ -0,0 +1,284 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <ztest.h>
+#include <zephyr.h>
+#include <string.h>
+
+#include "cloud_codec.h"
+#include "cloud_codec_ringbuffer.h"
+
+#define ENTRIES 4
+
+#define SENSOR_COLUMN(_field, _type, _scale)						\
+	CLOUD_CODEC_RINGBUFFER_COLUMN(struct cloud_data_sensors, _field, _type, _scale,	\
+				      ENTRIES)
+
+CLOUD_CODEC_RINGBUFFER_DEFINE(sensors_buf, struct cloud_data_sensors, env_ts, ENTRIES,
+	SENSOR_COLUMN(temp, CLOUD_CODEC_RINGBUFFER_FIXED, 100),
+	SENSOR_COLUMN(hum, CLOUD_CODEC_RINGBUFFER_FIXED, 100),
+	SENSOR_COLUMN(queued, CLOUD_CODEC_RINGBUFFER_BOOL, 0));
+
+#define GPS_COLUMN(_field, _type, _scale)						\
+	CLOUD_CODEC_RINGBUFFER_COLUMN(struct cloud_data_gps, _field, _type, _scale, ENTRIES)
+
+CLOUD_CODEC_RINGBUFFER_DEFINE(gps_buf, struct cloud_data_gps, gps_ts, ENTRIES,
+	GPS_COLUMN(pvt.longi, CLOUD_CODEC_RINGBUFFER_FIXED, 10000000),
+	GPS_COLUMN(pvt.lat, CLOUD_CODEC_RINGBUFFER_FIXED, 10000000),
+	GPS_COLUMN(pvt.alt, CLOUD_CODEC_RINGBUFFER_COPY, 0),
+	GPS_COLUMN(pvt.acc, CLOUD_CODEC_RINGBUFFER_COPY, 0),
+	GPS_COLUMN(pvt.spd, CLOUD_CODEC_RINGBUFFER_COPY, 0),
+	GPS_COLUMN(pvt.hdg, CLOUD_CODEC_RINGBUFFER_COPY, 0),
+	GPS_COLUMN(format, CLOUD_CODEC_RINGBUFFER_U8, 0),
+	GPS_COLUMN(queued, CLOUD_CODEC_RINGBUFFER_BOOL, 0));
+
+#define MODEM_DYN_COLUMN(_field, _type, _scale)						\
+	CLOUD_CODEC_RINGBUFFER_COLUMN(struct cloud_data_modem_dynamic, _field, _type,	\
+				      _scale, ENTRIES)
+
+CLOUD_CODEC_RINGBUFFER_DEFINE(modem_dyn_buf, struct cloud_data_modem_dynamic, ts, ENTRIES,
+	MODEM_DYN_COLUMN(area, CLOUD_CODEC_RINGBUFFER_COPY, 0),
+	MODEM_DYN_COLUMN(cell, CLOUD_CODEC_RINGBUFFER_COPY, 0),
+	MODEM_DYN_COLUMN(rsrp, CLOUD_CODEC_RINGBUFFER_COPY, 0),
+	MODEM_DYN_COLUMN(ip, CLOUD_CODEC_RINGBUFFER_COPY, 0),
+	MODEM_DYN_COLUMN(mccmnc, CLOUD_CODEC_RINGBUFFER_COPY, 0),
+	MODEM_DYN_COLUMN(queued, CLOUD_CODEC_RINGBUFFER_BOOL, 0),
+	MODEM_DYN_COLUMN(area_code_fresh, CLOUD_CODEC_RINGBUFFER_BOOL, 0),
+	MODEM_DYN_COLUMN(cell_id_fresh, CLOUD_CODEC_RINGBUFFER_BOOL, 0),
+	MODEM_DYN_COLUMN(rsrp_fresh, CLOUD_CODEC_RINGBUFFER_BOOL, 0),
+	MODEM_DYN_COLUMN(ip_address_fresh, CLOUD_CODEC_RINGBUFFER_BOOL, 0),
+	MODEM_DYN_COLUMN(mccmnc_fresh, CLOUD_CODEC_RINGBUFFER_BOOL, 0));
+
+static struct cloud_data_sensors sensor_entry(size_t i)
+{
+	return (struct cloud_data_sensors) {
+		.temp = 20.25 + i,
+		.hum = 40.5 - i,
+		/* Samples are not always in order. */
+		.env_ts = 1000 + 60000 * i - ((i % 3 == 2) ? 70000 : 0),
+		.queued = (i % 2 == 0)
+	};
+}
+
+static void sensor_entry_check(const struct cloud_data_sensors *entry, size_t i)
+{
+	struct cloud_data_sensors expected = sensor_entry(i);
+
+	zassert_equal(expected.env_ts, entry->env_ts, "Wrong timestamp for entry %zu", i);
+	zassert_within(expected.temp, entry->temp, 0.005, "Wrong temperature for entry %zu", i);
+	zassert_within(expected.hum, entry->hum, 0.005, "Wrong humidity for entry %zu", i);
+	zassert_equal(expected.queued, entry->queued, "Wrong queued flag for entry %zu", i);
+}
+
+static void ringbuffers_reset(void)
+{
+	sensors_buf.len = 0;
+	gps_buf.len = 0;
+	modem_dyn_buf.len = 0;
+}
+
+static void test_put_get(void)
+{
+	struct cloud_data_sensors entry;
+	int ret;
+
+	ringbuffers_reset();
+
+	ret = cloud_codec_ringbuffer_get(&sensors_buf, 0, &entry);
+	zassert_equal(-ENOENT, ret, "Return value %d is wrong", ret);
+
+	for (size_t i = 0; i < ENTRIES - 1; i++) {
+		entry = sensor_entry(i);
+		cloud_codec_ringbuffer_put(&sensors_buf, &entry);
+	}
+
+	zassert_equal(ENTRIES - 1, cloud_codec_ringbuffer_len(&sensors_buf), "Wrong length");
+
+	for (size_t i = 0; i < ENTRIES - 1; i++) {
+		ret = cloud_codec_ringbuffer_get(&sensors_buf, i, &entry);
+		zassert_equal(0, ret, "Return value %d is wrong", ret);
+		sensor_entry_check(&entry, i);
+	}
+
+	ret = cloud_codec_ringbuffer_get(&sensors_buf, ENTRIES - 1, &entry);
+	zassert_equal(-ENOENT, ret, "Return value %d is wrong", ret);
+}
+
+static void test_wrap_around(void)
+{
+	struct cloud_data_sensors entries[ENTRIES];
+	const size_t total = 3 * ENTRIES + 1;
+
+	ringbuffers_reset();
+
+	for (size_t i = 0; i < total; i++) {
+		struct cloud_data_sensors entry = sensor_entry(i);
+
+		cloud_codec_ringbuffer_put(&sensors_buf, &entry);
+		zassert_equal(MIN(i + 1, ENTRIES), cloud_codec_ringbuffer_len(&sensors_buf),
+			      "Wrong length");
+	}
+
+	/* The newest entries are kept, oldest first. */
+	cloud_codec_ringbuffer_copy(&sensors_buf, entries);
+
+	for (size_t i = 0; i < ENTRIES; i++) {
+		sensor_entry_check(&entries[i], total - ENTRIES + i);
+	}
+}
+
+static void test_timestamp_gap(void)
+{
+	struct cloud_data_sensors entry = sensor_entry(0);
+	int ret;
+
+	ringbuffers_reset();
+
+	cloud_codec_ringbuffer_put(&sensors_buf, &entry);
+	entry.env_ts += INT32_MAX;
+	cloud_codec_ringbuffer_put(&sensors_buf, &entry);
+	zassert_equal(2, cloud_codec_ringbuffer_len(&sensors_buf), "Wrong length");
+
+	/* A difference that does not fit drops the older entries. */
+	entry.env_ts += (int64_t)INT32_MAX + 1;
+	cloud_codec_ringbuffer_put(&sensors_buf, &entry);
+	zassert_equal(1, cloud_codec_ringbuffer_len(&sensors_buf), "Wrong length");
+
+	ret = cloud_codec_ringbuffer_get(&sensors_buf, 0, &entry);
+	zassert_equal(0, ret, "Return value %d is wrong", ret);
+	zassert_equal(sensor_entry(0).env_ts + 2 * (int64_t)INT32_MAX + 1, entry.env_ts,
+		      "Wrong timestamp");
+}
+
+static void test_update(void)
+{
+	struct cloud_data_sensors entries[ENTRIES];
+	struct cloud_data_sensors entry;
+	int ret;
+
+	ringbuffers_reset();
+
+	for (size_t i = 0; i < ENTRIES + 1; i++) {
+		entry = sensor_entry(i);
+		cloud_codec_ringbuffer_put(&sensors_buf, &entry);
+	}
+
+	/* As done by the codecs, which also convert the timestamps in place. */
+	cloud_codec_ringbuffer_copy(&sensors_buf, entries);
+
+	for (size_t i = 0; i < ENTRIES; i++) {
+		entries[i].queued = false;
+		entries[i].env_ts += 1563968747123;
+	}
+
+	cloud_codec_ringbuffer_update(&sensors_buf, entries);
+
+	for (size_t i = 0; i < ENTRIES; i++) {
+		ret = cloud_codec_ringbuffer_get(&sensors_buf, i, &entry);
+		zassert_equal(0, ret, "Return value %d is wrong", ret);
+		zassert_false(entry.queued, "Entry %zu still queued", i);
+		zassert_equal(sensor_entry(i + 1).env_ts, entry.env_ts, "Timestamp changed");
+	}
+
+	entry.queued = true;
+	ret = cloud_codec_ringbuffer_set(&sensors_buf, ENTRIES - 1, &entry);
+	zassert_equal(0, ret, "Return value %d is wrong", ret);
+	ret = cloud_codec_ringbuffer_set(&sensors_buf, ENTRIES, &entry);
+	zassert_equal(-ENOENT, ret, "Return value %d is wrong", ret);
+
+	ret = cloud_codec_ringbuffer_get(&sensors_buf, ENTRIES - 1, &entry);
+	zassert_equal(0, ret, "Return value %d is wrong", ret);
+	zassert_true(entry.queued, "Entry not queued");
+}
+
+static void test_column_types(void)
+{
+	struct cloud_data_gps gps = {
+		.gps_ts = 1000,
+		.pvt.longi = 10.4373381,
+		.pvt.lat = -63.4209432,
+		.pvt.alt = 173.5f,
+		.pvt.acc = 6.8f,
+		.pvt.spd = 0.5f,
+		.pvt.hdg = 310.25f,
+		.format = CLOUD_CODEC_GPS_FORMAT_PVT,
+		.queued = true
+	};
+	struct cloud_data_modem_dynamic modem_dyn = {
+		.area = 30401,
+		.cell = 33703719,
+		.rsrp = -8,
+		.ip = "2001:db8::8a2e:370:7334",
+		.mccmnc = "24202",
+		.ts = 2000,
+		.queued = true,
+		.cell_id_fresh = true,
+		.ip_address_fresh = true
+	};
+	struct cloud_data_gps gps_out;
+	struct cloud_data_modem_dynamic modem_dyn_out;
+
+	ringbuffers_reset();
+
+	cloud_codec_ringbuffer_put(&gps_buf, &gps);
+	cloud_codec_ringbuffer_get(&gps_buf, 0, &gps_out);
+	zassert_equal(gps.gps_ts, gps_out.gps_ts, "Wrong timestamp");
+	zassert_within(gps.pvt.longi, gps_out.pvt.longi, 0.00000005, "Wrong longitude");
+	zassert_within(gps.pvt.lat, gps_out.pvt.lat, 0.00000005, "Wrong latitude");
+	zassert_equal(gps.pvt.alt, gps_out.pvt.alt, "Wrong altitude");
+	zassert_equal(gps.pvt.acc, gps_out.pvt.acc, "Wrong accuracy");
+	zassert_equal(gps.pvt.spd, gps_out.pvt.spd, "Wrong speed");
+	zassert_equal(gps.pvt.hdg, gps_out.pvt.hdg, "Wrong heading");
+	zassert_equal(gps.format, gps_out.format, "Wrong format");
+	zassert_true(gps_out.queued, "Entry not queued");
+
+	cloud_codec_ringbuffer_put(&modem_dyn_buf, &modem_dyn);
+	cloud_codec_ringbuffer_get(&modem_dyn_buf, 0, &modem_dyn_out);
+	zassert_equal(modem_dyn.ts, modem_dyn_out.ts, "Wrong timestamp");
+	zassert_equal(modem_dyn.area, modem_dyn_out.area, "Wrong area code");
+	zassert_equal(modem_dyn.cell, modem_dyn_out.cell, "Wrong cell ID");
+	zassert_equal(modem_dyn.rsrp, modem_dyn_out.rsrp, "Wrong RSRP");
+	zassert_equal(0, strcmp(modem_dyn.ip, modem_dyn_out.ip), "Wrong IP address");
+	zassert_equal(0, strcmp(modem_dyn.mccmnc, modem_dyn_out.mccmnc), "Wrong MCCMNC");
+	zassert_true(modem_dyn_out.queued, "Entry not queued");
+	zassert_false(modem_dyn_out.area_code_fresh, "Wrong fresh flag");
+	zassert_true(modem_dyn_out.cell_id_fresh, "Wrong fresh flag");
+	zassert_false(modem_dyn_out.rsrp_fresh, "Wrong fresh flag");
+	zassert_true(modem_dyn_out.ip_address_fresh, "Wrong fresh flag");
+	zassert_false(modem_dyn_out.mccmnc_fresh, "Wrong fresh flag");
+}
+
+static void ram_size_check(const struct cloud_codec_ringbuffer *ring, size_t factor)
+{
+	size_t size = cloud_codec_ringbuffer_ram_size(ring);
+
+	printk("%s: %zu bytes of RAM per %zu samples, %zu bytes as structures\n",
+	       ring->name, size, ring->count, ring->count * ring->entry_size);
+
+	zassert_true(size * factor <= ring->count * ring->entry_size,
+		     "%s uses more than 1/%zu of the RAM of the structures", ring->name, factor);
+}
+
+static void test_ram_per_sample(void)
+{
+	ram_size_check(&sensors_buf, 2);
+	ram_size_check(&gps_buf, 3);
+	ram_size_check(&modem_dyn_buf, 1);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(cloud_codec_ringbuffer,
+		ztest_unit_test(test_put_get),
+		ztest_unit_test(test_wrap_around),
+		ztest_unit_test(test_timestamp_gap),
+		ztest_unit_test(test_update),
+		ztest_unit_test(test_column_types),
+		ztest_unit_test(test_ram_per_sample)
+	);
+
+	ztest_run_test_suite(cloud_codec_ringbuffer);
+}
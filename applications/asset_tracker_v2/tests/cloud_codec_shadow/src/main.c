@@ -0,0 +1,382 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <ztest.h>
+#include <zephyr.h>
+#include <string.h>
+
+#include "cJSON.h"
+#include "cloud_codec.h"
+#include "cloud_codec_shadow.h"
+#include "json_common.h"
+#include "json_protocol_names.h"
+
+/* Shadow document objects, as used by AWS IoT. */
+#define SHADOW_STATE	"state"
+#define SHADOW_REPORTED "reported"
+
+/* A day of updates, every 15 minutes. */
+#define UPDATE_COUNT 96
+
+static const struct cloud_data_modem_static modem_default = {
+	.bnd = 20,
+	.nw_lte_m = 1,
+	.nw_gps = 1,
+	.iccid = "89450421180216216095",
+	.fw = "mfw_nrf9160_1.3.0",
+	.brdv = "nrf9160dk_nrf9160",
+	.appv = "v1.0.0-development",
+};
+
+static const struct cloud_data_cfg cfg_default = {
+	.active_mode = true,
+	.gps_timeout = 60,
+	.active_wait_timeout = 120,
+	.movement_resolution = 120,
+	.movement_timeout = 3600,
+	.accelerometer_threshold = 10,
+};
+
+static void setup(void)
+{
+	cloud_codec_shadow_reset();
+}
+
+static void teardown(void)
+{
+}
+
+static void modem_static_fresh_set_all(struct cloud_data_modem_static *data)
+{
+	data->bnd_fresh = true;
+	data->nw_mode_fresh = true;
+	data->iccid_fresh = true;
+	data->fw_fresh = true;
+	data->brdv_fresh = true;
+	data->appv_fresh = true;
+}
+
+static void cfg_fresh_set_all(struct cloud_data_cfg *cfg)
+{
+	cfg->active_mode_fresh = true;
+	cfg->gps_timeout_fresh = true;
+	cfg->active_wait_timeout_fresh = true;
+	cfg->movement_resolution_fresh = true;
+	cfg->movement_timeout_fresh = true;
+	cfg->accelerometer_threshold_fresh = true;
+	cfg->nod_list_fresh = true;
+}
+
+/* Encode a shadow update with the fresh fields of both sections, like the codecs do. */
+static cJSON *report_encode(struct cloud_data_modem_static *modem, struct cloud_data_cfg *cfg)
+{
+	int err;
+	bool object_added = false;
+	cJSON *root_obj = cJSON_CreateObject();
+	cJSON *state_obj = cJSON_CreateObject();
+	cJSON *rep_obj = cJSON_CreateObject();
+
+	zassert_not_null(root_obj, "Allocation failed");
+	zassert_not_null(state_obj, "Allocation failed");
+	zassert_not_null(rep_obj, "Allocation failed");
+
+	modem->ts = 1000;
+	modem->queued = true;
+
+	err = json_common_modem_static_data_add(rep_obj, modem, JSON_COMMON_ADD_DATA_TO_OBJECT,
+						DATA_MODEM_STATIC, NULL);
+	zassert_true((err == 0) || (err == -ENODATA), "Unexpected error %d", err);
+	object_added |= (err == 0);
+
+	err = json_common_config_add(rep_obj, cfg, DATA_CONFIG);
+	zassert_true((err == 0) || (err == -ENODATA), "Unexpected error %d", err);
+	object_added |= (err == 0);
+
+	cJSON_AddItemToObject(state_obj, SHADOW_REPORTED, rep_obj);
+	cJSON_AddItemToObject(root_obj, SHADOW_STATE, state_obj);
+
+	if (!object_added) {
+		cJSON_Delete(root_obj);
+		return NULL;
+	}
+
+	return root_obj;
+}
+
+static size_t report_len(cJSON *root_obj)
+{
+	char *buf = cJSON_PrintUnformatted(root_obj);
+	size_t len;
+
+	zassert_not_null(buf, "Printing failed");
+
+	len = strlen(buf);
+	cJSON_FreeString(buf);
+
+	return len;
+}
+
+/* Apply an update to a shadow document, the way the cloud merges reported state. */
+static void shadow_merge(cJSON *shadow, const cJSON *update)
+{
+	const cJSON *item;
+
+	cJSON_ArrayForEach(item, update) {
+		cJSON *current = cJSON_GetObjectItem(shadow, item->string);
+
+		if (current == NULL) {
+			cJSON_AddItemToObject(shadow, item->string, cJSON_Duplicate(item, true));
+		} else if (cJSON_IsObject(item) && cJSON_IsObject(current)) {
+			shadow_merge(current, item);
+		} else {
+			cJSON_ReplaceItemViaPointer(shadow, current, cJSON_Duplicate(item, true));
+		}
+	}
+}
+
+/* Compare two shadow documents, ignoring the timestamp of the static modem data. */
+static bool shadow_equal(cJSON *a, cJSON *b)
+{
+	cJSON *a_copy = cJSON_Duplicate(a, true);
+	cJSON *b_copy = cJSON_Duplicate(b, true);
+	cJSON *a_modem = cJSON_GetObjectItem(cJSON_GetObjectItem(cJSON_GetObjectItem(a_copy,
+			 SHADOW_STATE), SHADOW_REPORTED), DATA_MODEM_STATIC);
+	cJSON *b_modem = cJSON_GetObjectItem(cJSON_GetObjectItem(cJSON_GetObjectItem(b_copy,
+			 SHADOW_STATE), SHADOW_REPORTED), DATA_MODEM_STATIC);
+	bool equal;
+
+	cJSON_DeleteItemFromObject(a_modem, DATA_TIMESTAMP);
+	cJSON_DeleteItemFromObject(b_modem, DATA_TIMESTAMP);
+
+	equal = cJSON_Compare(a_copy, b_copy, true);
+
+	cJSON_Delete(a_copy);
+	cJSON_Delete(b_copy);
+
+	return equal;
+}
+
+static void test_field_update(void)
+{
+	int value = 1;
+
+	zassert_true(cloud_codec_shadow_update(CLOUD_CODEC_SHADOW_CONFIG, 0, &value,
+					       sizeof(value)),
+		     "Field never reported must be reported");
+
+	/* Not acknowledged yet, the field is reported again. */
+	zassert_true(cloud_codec_shadow_update(CLOUD_CODEC_SHADOW_CONFIG, 0, &value,
+					       sizeof(value)),
+		     "Field not acknowledged must be reported");
+
+	cloud_codec_shadow_commit(CLOUD_CODEC_SHADOW_CONFIG);
+
+	zassert_false(cloud_codec_shadow_update(CLOUD_CODEC_SHADOW_CONFIG, 0, &value,
+						sizeof(value)),
+		      "Unchanged field must not be reported");
+
+	value = 2;
+	zassert_true(cloud_codec_shadow_update(CLOUD_CODEC_SHADOW_CONFIG, 0, &value,
+					       sizeof(value)),
+		     "Changed field must be reported");
+
+	/* Changed back before the change was acknowledged. */
+	value = 1;
+	zassert_false(cloud_codec_shadow_update(CLOUD_CODEC_SHADOW_CONFIG, 0, &value,
+						sizeof(value)),
+		      "Field equal to the acknowledged value must not be reported");
+
+	/* Sections are independent. */
+	zassert_true(cloud_codec_shadow_update(CLOUD_CODEC_SHADOW_MODEM_STATIC, 0, &value,
+					       sizeof(value)),
+		     "Field of another section must be reported");
+}
+
+static void test_invalidate(void)
+{
+	int value = 1;
+
+	cloud_codec_shadow_update(CLOUD_CODEC_SHADOW_CONFIG, 0, &value, sizeof(value));
+	cloud_codec_shadow_commit(CLOUD_CODEC_SHADOW_CONFIG);
+
+	cloud_codec_shadow_invalidate(CLOUD_CODEC_SHADOW_CONFIG);
+
+	zassert_true(cloud_codec_shadow_update(CLOUD_CODEC_SHADOW_CONFIG, 0, &value,
+					       sizeof(value)),
+		     "Field must be reported after invalidation");
+
+	/* A failed message discards the pending values, a later acknowledgment does not
+	 * commit them.
+	 */
+	cloud_codec_shadow_invalidate(CLOUD_CODEC_SHADOW_CONFIG);
+	cloud_codec_shadow_commit(CLOUD_CODEC_SHADOW_CONFIG);
+
+	zassert_true(cloud_codec_shadow_update(CLOUD_CODEC_SHADOW_CONFIG, 0, &value,
+					       sizeof(value)),
+		     "Discarded field must be reported");
+
+	cloud_codec_shadow_commit(CLOUD_CODEC_SHADOW_CONFIG);
+	cloud_codec_shadow_reset();
+
+	zassert_true(cloud_codec_shadow_update(CLOUD_CODEC_SHADOW_CONFIG, 0, &value,
+					       sizeof(value)),
+		     "Field must be reported after reset");
+}
+
+static void test_modem_static_diff(void)
+{
+	struct cloud_data_modem_static modem = modem_default;
+
+	zassert_true(cloud_codec_shadow_modem_static_diff(&modem), "First report must be sent");
+	zassert_true(modem.bnd_fresh && modem.nw_mode_fresh && modem.iccid_fresh &&
+		     modem.fw_fresh && modem.brdv_fresh && modem.appv_fresh,
+		     "First report must be complete");
+
+	cloud_codec_shadow_commit(CLOUD_CODEC_SHADOW_MODEM_STATIC);
+
+	zassert_false(cloud_codec_shadow_modem_static_diff(&modem),
+		      "Unchanged data must not be reported");
+
+	modem.bnd = 3;
+	modem.nw_gps = 0;
+
+	zassert_true(cloud_codec_shadow_modem_static_diff(&modem), "Changes must be reported");
+	zassert_true(modem.bnd_fresh && modem.nw_mode_fresh, "Changed fields must be fresh");
+	zassert_false(modem.iccid_fresh || modem.fw_fresh || modem.brdv_fresh ||
+		      modem.appv_fresh, "Unchanged fields must not be fresh");
+}
+
+static void test_config_diff(void)
+{
+	struct cloud_data_cfg cfg = cfg_default;
+
+	zassert_true(cloud_codec_shadow_config_diff(&cfg), "First report must be sent");
+	cloud_codec_shadow_commit(CLOUD_CODEC_SHADOW_CONFIG);
+
+	zassert_false(cloud_codec_shadow_config_diff(&cfg), "Unchanged data must not be reported");
+
+	cfg.no_data.gnss = true;
+	cfg.accelerometer_threshold = 2.5;
+
+	zassert_true(cloud_codec_shadow_config_diff(&cfg), "Changes must be reported");
+	zassert_true(cfg.nod_list_fresh && cfg.accelerometer_threshold_fresh,
+		     "Changed fields must be fresh");
+	zassert_false(cfg.active_mode_fresh || cfg.gps_timeout_fresh ||
+		      cfg.active_wait_timeout_fresh || cfg.movement_resolution_fresh ||
+		      cfg.movement_timeout_fresh, "Unchanged fields must not be fresh");
+}
+
+/* Report the device state every 15 minutes for a day, with a few typical changes: the LTE band
+ * changes twice, the cloud changes the configuration three times and one of these reports is
+ * lost. The
+ * shadow built from the incremental updates must always match the complete state.
+ */
+static void test_bytes_per_update(void)
+{
+	struct cloud_data_modem_static modem = modem_default;
+	struct cloud_data_cfg cfg = cfg_default;
+	size_t full_bytes = 0;
+	size_t diff_bytes = 0;
+	size_t diff_count = 0;
+	cJSON *shadow = cJSON_CreateObject();
+
+	zassert_not_null(shadow, "Allocation failed");
+
+	for (int i = 0; i < UPDATE_COUNT; i++) {
+		struct cloud_data_modem_static modem_full;
+		struct cloud_data_cfg cfg_full;
+		bool sent = (i != 72);
+		cJSON *full;
+		cJSON *diff;
+		bool modem_changed;
+		bool cfg_changed;
+
+		switch (i) {
+		case 24:
+			modem.bnd = 3;
+			break;
+		case 36:
+			cfg.active_wait_timeout = 60;
+			break;
+		case 60:
+			modem.bnd = 20;
+			break;
+		case 72:
+			cfg.active_wait_timeout = 120;
+			break;
+		case 84:
+			cfg.no_data.gnss = true;
+			break;
+		default:
+			break;
+		}
+
+		/* Complete state, as reported without the cache. */
+		modem_full = modem;
+		cfg_full = cfg;
+		modem_static_fresh_set_all(&modem_full);
+		cfg_fresh_set_all(&cfg_full);
+
+		full = report_encode(&modem_full, &cfg_full);
+		zassert_not_null(full, "Complete state must be encoded");
+		full_bytes += report_len(full);
+
+		/* Changed state only. */
+		modem_changed = cloud_codec_shadow_modem_static_diff(&modem);
+		cfg_changed = cloud_codec_shadow_config_diff(&cfg);
+
+		diff = report_encode(&modem, &cfg);
+		zassert_equal(modem_changed || cfg_changed, diff != NULL,
+			      "Update %d encoded without changes", i);
+
+		if (diff != NULL) {
+			diff_bytes += report_len(diff);
+			diff_count++;
+		}
+
+		if (sent) {
+			cloud_codec_shadow_commit(CLOUD_CODEC_SHADOW_MODEM_STATIC);
+			cloud_codec_shadow_commit(CLOUD_CODEC_SHADOW_CONFIG);
+
+			if (diff != NULL) {
+				shadow_merge(shadow, diff);
+			}
+
+			zassert_true(shadow_equal(shadow, full),
+				     "Shadow differs from the state after update %d", i);
+		} else {
+			cloud_codec_shadow_invalidate(CLOUD_CODEC_SHADOW_MODEM_STATIC);
+			cloud_codec_shadow_invalidate(CLOUD_CODEC_SHADOW_CONFIG);
+		}
+
+		cJSON_Delete(full);
+		cJSON_Delete(diff);
+	}
+
+	cJSON_Delete(shadow);
+
+	printk("%d updates: %zu bytes per update when complete, %zu bytes per update when "
+	       "incremental, %zu messages sent\n", UPDATE_COUNT, full_bytes / UPDATE_COUNT,
+	       diff_bytes / UPDATE_COUNT, diff_count);
+
+	/* Boot, band changes, configuration changes, and the report after the lost one. */
+	zassert_equal(diff_count, 7, "Unexpected number of messages: %zu", diff_count);
+	zassert_true(diff_bytes * 10 <= full_bytes,
+		     "Incremental updates use more than 1/10 of the bytes");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(cloud_codec_shadow,
+		ztest_unit_test_setup_teardown(test_field_update, setup, teardown),
+		ztest_unit_test_setup_teardown(test_invalidate, setup, teardown),
+		ztest_unit_test_setup_teardown(test_modem_static_diff, setup, teardown),
+		ztest_unit_test_setup_teardown(test_config_diff, setup, teardown),
+		ztest_unit_test_setup_teardown(test_bytes_per_update, setup, teardown)
+	);
+
+	ztest_run_test_suite(cloud_codec_shadow);
+}
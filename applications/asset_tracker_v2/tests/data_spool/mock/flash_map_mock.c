@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr.h>
+#include <string.h>
+#include <storage/flash_map.h>
+
+#include "flash_map_mock.h"
+
+#define FLASH_MOCK_SIZE_MAX	0x20000
+#define FLASH_MOCK_SECTORS_MAX	64
+#define FLASH_MOCK_ERASED_VAL	0xff
+
+/* RAM copy of a NOR flash area. Bytes can only be written once after being erased. */
+static uint8_t flash[FLASH_MOCK_SIZE_MAX];
+static uint32_t sector_erase_cnt[FLASH_MOCK_SECTORS_MAX];
+static struct flash_area area;
+static size_t sector_size;
+static uint8_t write_align;
+static int write_budget = -1;
+static struct flash_mock_stats stats;
+
+void flash_mock_init(size_t size, size_t new_sector_size, uint8_t align)
+{
+	__ASSERT_NO_MSG(size <= sizeof(flash));
+	__ASSERT_NO_MSG(size / new_sector_size <= FLASH_MOCK_SECTORS_MAX);
+
+	memset(flash, FLASH_MOCK_ERASED_VAL, sizeof(flash));
+	memset(sector_erase_cnt, 0, sizeof(sector_erase_cnt));
+	memset(&stats, 0, sizeof(stats));
+
+	area.fa_id = FLASH_MOCK_AREA_ID;
+	area.fa_off = 0;
+	area.fa_size = size;
+	sector_size = new_sector_size;
+	write_align = align;
+	write_budget = -1;
+}
+
+void flash_mock_power_loss_after(int bytes)
+{
+	write_budget = bytes;
+}
+
+void flash_mock_stats_get(struct flash_mock_stats *out)
+{
+	*out = stats;
+}
+
+int flash_area_open(uint8_t id, const struct flash_area **fa)
+{
+	if (id != FLASH_MOCK_AREA_ID) {
+		return -ENOENT;
+	}
+
+	*fa = &area;
+
+	return 0;
+}
+
+void flash_area_close(const struct flash_area *fa)
+{
+}
+
+int flash_area_get_sectors(int fa_id, uint32_t *count, struct flash_sector *sectors)
+{
+	uint32_t total = area.fa_size / sector_size;
+
+	if (fa_id != FLASH_MOCK_AREA_ID) {
+		return -ENOENT;
+	}
+
+	for (uint32_t i = 0; i < MIN(*count, total); i++) {
+		sectors[i].fs_off = i * sector_size;
+		sectors[i].fs_size = sector_size;
+	}
+
+	if (*count < total) {
+		return -ENOMEM;
+	}
+
+	*count = total;
+
+	return 0;
+}
+
+uint8_t flash_area_align(const struct flash_area *fa)
+{
+	return write_align;
+}
+
+uint8_t flash_area_erased_val(const struct flash_area *fa)
+{
+	return FLASH_MOCK_ERASED_VAL;
+}
+
+int flash_area_read(const struct flash_area *fa, off_t off, void *dst, size_t len)
+{
+	if ((off < 0) || (off + len > area.fa_size)) {
+		return -EINVAL;
+	}
+
+	memcpy(dst, &flash[off], len);
+
+	return 0;
+}
+
+int flash_area_write(const struct flash_area *fa, off_t off, const void *src, size_t len)
+{
+	size_t written = len;
+
+	if ((off < 0) || (off + len > area.fa_size) || (off % write_align) ||
+	    (len % write_align)) {
+		return -EINVAL;
+	}
+
+	for (size_t i = 0; i < len; i++) {
+		if (flash[off + i] != FLASH_MOCK_ERASED_VAL) {
+			/* NOR flash cannot be written twice without an erase. */
+			return -EIO;
+		}
+	}
+
+	if (write_budget >= 0) {
+		written = MIN(len, (size_t)write_budget);
+		write_budget -= written;
+	}
+
+	memcpy(&flash[off], src, written);
+
+	stats.write_cnt++;
+	stats.write_bytes += written;
+
+	return (written == len) ? 0 : -EIO;
+}
+
+int flash_area_erase(const struct flash_area *fa, off_t off, size_t len)
+{
+	if ((off < 0) || (off + len > area.fa_size) || (off % sector_size) ||
+	    (len % sector_size)) {
+		return -EINVAL;
+	}
+
+	memset(&flash[off], FLASH_MOCK_ERASED_VAL, len);
+
+	for (size_t sector = off / sector_size; sector < (off + len) / sector_size; sector++) {
+		sector_erase_cnt[sector]++;
+		stats.erase_cnt++;
+		stats.erase_max = MAX(stats.erase_max, sector_erase_cnt[sector]);
+	}
+
+	return 0;
+}
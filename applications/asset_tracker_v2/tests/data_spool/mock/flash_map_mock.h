@@ -0,0 +1,35 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef FLASH_MAP_MOCK_H__
+#define FLASH_MAP_MOCK_H__
+
+#include <zephyr.h>
+
+#define FLASH_MOCK_AREA_ID 1
+
+struct flash_mock_stats {
+	/* Number of write operations. */
+	uint32_t write_cnt;
+	/* Number of bytes written. */
+	uint32_t write_bytes;
+	/* Number of sector erase operations. */
+	uint32_t erase_cnt;
+	/* Highest number of erase operations of a single sector. */
+	uint32_t erase_max;
+};
+
+/* Erase the flash area and reset the statistics. */
+void flash_mock_init(size_t size, size_t sector_size, uint8_t align);
+
+/* Simulate a power loss after a number of bytes have been written. The write that crosses the
+ * limit is torn, and it and all following writes fail. A negative value disables the simulation.
+ */
+void flash_mock_power_loss_after(int bytes);
+
+void flash_mock_stats_get(struct flash_mock_stats *stats);
+
+#endif /* FLASH_MAP_MOCK_H__ */
@@ -0,0 +1,524 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <ztest.h>
+#include <zephyr.h>
+#include <string.h>
+
+#include "data_spool.h"
+#include "flash_map_mock.h"
+
+#define SECTOR_SIZE	4096
+#define WRITE_ALIGN	4
+#define TYPE_BATCH	2
+#define TYPE_UI		3
+
+/* Outage simulation. Samples are taken every two minutes in active mode. The data module spools
+ * the samples queued in the ringbuffers every three sample cycles, which is the smallest default
+ * ringbuffer count, and sends up to four spooled messages at once when the connection is back.
+ */
+#define OUTAGE_HOURS		24
+#define SAMPLE_INTERVAL_S	120
+#define SAMPLE_CYCLES		(OUTAGE_HOURS * 3600 / SAMPLE_INTERVAL_S)
+/* GNSS, environmental, dynamic modem and battery data. */
+#define SAMPLES_PER_CYCLE	4
+/* Average size of an encoded sample in a batch message. */
+#define SAMPLE_SIZE		24
+#define CYCLES_PER_MESSAGE	3
+#define DRAIN_COUNT		4
+#define OUTAGE_SPOOL_SIZE	0x20000
+
+static uint8_t message[SECTOR_SIZE];
+
+static void spool_setup(size_t size)
+{
+	flash_mock_init(size, SECTOR_SIZE, WRITE_ALIGN);
+	zassert_equal(data_spool_init(FLASH_MOCK_AREA_ID), 0, "Init failed");
+}
+
+static void spool_reboot(void)
+{
+	flash_mock_power_loss_after(-1);
+	zassert_equal(data_spool_init(FLASH_MOCK_AREA_ID), 0, "Init after reboot failed");
+}
+
+/* Messages are filled with a pattern derived from their sequence number, so that their content
+ * can be checked when they are read back.
+ */
+static void message_fill(uint32_t seq, size_t len)
+{
+	for (size_t i = 0; i < len; i++) {
+		message[i] = seq + i;
+	}
+}
+
+static int message_append(uint32_t seq, size_t len)
+{
+	message_fill(seq, len);
+
+	return data_spool_append(TYPE_BATCH, message, len);
+}
+
+static void message_check(const struct data_spool_entry *entry, uint32_t seq, size_t len)
+{
+	message_fill(seq, len);
+
+	zassert_equal(entry->type, TYPE_BATCH, "Wrong type");
+	zassert_equal(entry->len, len, "Wrong length of message %d: %zu", seq, entry->len);
+	zassert_mem_equal(entry->buf, message, len, "Wrong content of message %d", seq);
+	zassert_not_equal(entry->id, 0, "Invalid ID");
+}
+
+/* Read the next message and check that it is the expected one. Returns the message ID. */
+static uint32_t message_read_check(uint32_t seq, size_t len)
+{
+	struct data_spool_entry entry;
+	uint32_t id;
+
+	zassert_equal(data_spool_read(&entry), 0, "Message %d not read", seq);
+	message_check(&entry, seq, len);
+
+	id = entry.id;
+	k_free(entry.buf);
+
+	return id;
+}
+
+static void spool_empty_check(void)
+{
+	struct data_spool_entry entry;
+
+	zassert_equal(data_spool_read(&entry), -ENOENT, "Spool not empty");
+}
+
+static void test_append_read(void)
+{
+	static const size_t lengths[] = { 1, 7, 8, 100, 1021 };
+	struct data_spool_entry entry;
+
+	spool_setup(4 * SECTOR_SIZE);
+	spool_empty_check();
+
+	for (size_t i = 0; i < ARRAY_SIZE(lengths); i++) {
+		zassert_equal(message_append(i, lengths[i]), 0, "Append failed");
+	}
+
+	zassert_equal(data_spool_append(TYPE_UI, "btn", 3), 0, "Append failed");
+
+	for (size_t i = 0; i < ARRAY_SIZE(lengths); i++) {
+		message_read_check(i, lengths[i]);
+	}
+
+	zassert_equal(data_spool_read(&entry), 0, "UI message not read");
+	zassert_equal(entry.type, TYPE_UI, "Wrong type");
+	zassert_equal(entry.len, 3, "Wrong length");
+	zassert_mem_equal(entry.buf, "btn", 3, "Wrong content");
+	k_free(entry.buf);
+
+	spool_empty_check();
+	spool_empty_check();
+}
+
+static void test_append_invalid(void)
+{
+	spool_setup(2 * SECTOR_SIZE);
+
+	zassert_equal(data_spool_append(TYPE_BATCH, message, 0), -EINVAL, "Empty message");
+	zassert_equal(data_spool_append(TYPE_BATCH, message, SECTOR_SIZE), -EFBIG,
+		      "Message larger than a sector");
+	spool_empty_check();
+}
+
+static void test_ack_rewind(void)
+{
+	uint32_t id;
+
+	spool_setup(4 * SECTOR_SIZE);
+
+	for (uint32_t seq = 0; seq < 3; seq++) {
+		zassert_equal(message_append(seq, 50), 0, "Append failed");
+	}
+
+	id = message_read_check(0, 50);
+	message_read_check(1, 50);
+
+	/* Messages that are not ACKed are read again after a rewind. */
+	data_spool_rewind();
+	message_read_check(0, 50);
+
+	zassert_equal(data_spool_ack(id), 0, "ACK failed");
+	data_spool_rewind();
+	message_read_check(1, 50);
+	id = message_read_check(2, 50);
+	spool_empty_check();
+
+	zassert_equal(data_spool_ack(id), 0, "ACK failed");
+	data_spool_rewind();
+	spool_empty_check();
+}
+
+/* Start a round and read up to count messages of a given length, starting with message seq.
+ * Returns the number of messages added to the round.
+ */
+static size_t round_send(uint32_t seq, size_t count, size_t len)
+{
+	struct data_spool_entry entry;
+	size_t sent;
+
+	zassert_true(data_spool_round_begin(), "Round not started");
+
+	for (sent = 0; sent < count; sent++) {
+		if (data_spool_read(&entry)) {
+			break;
+		}
+
+		message_check(&entry, seq + sent, len);
+		data_spool_round_add(entry.id);
+		k_free(entry.buf);
+	}
+
+	return sent;
+}
+
+static void test_round_ack(void)
+{
+	spool_setup(4 * SECTOR_SIZE);
+
+	for (uint32_t seq = 0; seq < 10; seq++) {
+		zassert_equal(message_append(seq, 50), 0, "Append failed");
+	}
+
+	zassert_equal(round_send(0, DRAIN_COUNT, 50), DRAIN_COUNT, "Wrong round size");
+
+	/* No new round is started before the outcome of all messages is known. */
+	zassert_false(data_spool_round_begin(), "Round started with messages in flight");
+
+	for (size_t i = 0; i < DRAIN_COUNT - 1; i++) {
+		zassert_false(data_spool_round_done(true), "Round ended early");
+	}
+	zassert_true(data_spool_round_done(true), "Round not ended");
+
+	/* The next rounds continue after the consumed messages. */
+	zassert_equal(round_send(4, DRAIN_COUNT, 50), DRAIN_COUNT, "Wrong round size");
+	for (size_t i = 0; i < DRAIN_COUNT; i++) {
+		data_spool_round_done(true);
+	}
+
+	zassert_equal(round_send(8, DRAIN_COUNT, 50), 2, "Wrong round size");
+	zassert_false(data_spool_round_done(true), "Round ended early");
+	zassert_true(data_spool_round_done(true), "Round not ended");
+
+	zassert_equal(round_send(10, DRAIN_COUNT, 50), 0, "Spool not empty");
+	zassert_equal(data_spool_sync(), 0, "Sync failed");
+
+	spool_reboot();
+	spool_empty_check();
+}
+
+static void test_round_failed(void)
+{
+	spool_setup(4 * SECTOR_SIZE);
+
+	for (uint32_t seq = 0; seq < 6; seq++) {
+		zassert_equal(message_append(seq, 50), 0, "Append failed");
+	}
+
+	zassert_equal(round_send(0, DRAIN_COUNT, 50), DRAIN_COUNT, "Wrong round size");
+	zassert_false(data_spool_round_done(true), "Round ended early");
+	zassert_false(data_spool_round_done(false), "Round ended early");
+	zassert_false(data_spool_round_done(true), "Round ended early");
+	zassert_false(data_spool_round_done(true), "Failed round ended successfully");
+
+	/* All messages of the failed round are sent again. */
+	zassert_equal(round_send(0, DRAIN_COUNT, 50), DRAIN_COUNT, "Wrong round size");
+	for (size_t i = 0; i < DRAIN_COUNT - 1; i++) {
+		data_spool_round_done(true);
+	}
+	zassert_true(data_spool_round_done(true), "Round not ended");
+
+	zassert_equal(round_send(4, DRAIN_COUNT, 50), 2, "Wrong round size");
+}
+
+static void test_round_abort(void)
+{
+	spool_setup(4 * SECTOR_SIZE);
+
+	for (uint32_t seq = 0; seq < 6; seq++) {
+		zassert_equal(message_append(seq, 50), 0, "Append failed");
+	}
+
+	/* The connection is lost before the outcome of all messages is known. */
+	zassert_equal(round_send(0, DRAIN_COUNT, 50), DRAIN_COUNT, "Wrong round size");
+	zassert_false(data_spool_round_done(true), "Round ended early");
+	data_spool_round_abort();
+
+	/* Outcomes reported after the abort are ignored. */
+	zassert_false(data_spool_round_done(true), "Outcome of aborted round counted");
+
+	/* The messages of the aborted round are sent again when the connection is back. */
+	zassert_equal(round_send(0, DRAIN_COUNT, 50), DRAIN_COUNT, "Wrong round size");
+	for (size_t i = 0; i < DRAIN_COUNT - 1; i++) {
+		data_spool_round_done(true);
+	}
+	zassert_true(data_spool_round_done(true), "Round not ended");
+
+	zassert_equal(round_send(4, DRAIN_COUNT, 50), 2, "Wrong round size");
+}
+
+static void test_reboot(void)
+{
+	uint32_t id;
+
+	spool_setup(4 * SECTOR_SIZE);
+
+	for (uint32_t seq = 0; seq < 5; seq++) {
+		zassert_equal(message_append(seq, 200), 0, "Append failed");
+	}
+
+	message_read_check(0, 200);
+	message_read_check(1, 200);
+	id = message_read_check(2, 200);
+	zassert_equal(data_spool_ack(id), 0, "ACK failed");
+	zassert_equal(data_spool_sync(), 0, "Sync failed");
+
+	spool_reboot();
+	message_read_check(3, 200);
+	id = message_read_check(4, 200);
+	spool_empty_check();
+
+	/* The ACK is not persisted until the cursor interval is reached or the spool is synced,
+	 * so the messages are read again after a reboot.
+	 */
+	zassert_equal(data_spool_ack(id), 0, "ACK failed");
+
+	spool_reboot();
+	message_read_check(3, 200);
+	message_read_check(4, 200);
+	spool_empty_check();
+
+	/* New messages are appended after the recovered ones. */
+	zassert_equal(message_append(5, 10), 0, "Append failed");
+	message_read_check(5, 10);
+	spool_empty_check();
+}
+
+static void test_power_loss(void)
+{
+	spool_setup(4 * SECTOR_SIZE);
+
+	zassert_equal(message_append(0, 300), 0, "Append failed");
+	zassert_equal(message_append(1, 300), 0, "Append failed");
+
+	/* Power is lost in the middle of a message. */
+	flash_mock_power_loss_after(100);
+	zassert_not_equal(message_append(2, 300), 0, "Torn append succeeded");
+
+	spool_reboot();
+	message_read_check(0, 300);
+	message_read_check(1, 300);
+	spool_empty_check();
+
+	/* Writing continues in the next sector, without writing twice to the same flash. */
+	zassert_equal(message_append(3, 300), 0, "Append failed");
+	message_read_check(3, 300);
+	spool_empty_check();
+
+	spool_reboot();
+	message_read_check(0, 300);
+	message_read_check(1, 300);
+	message_read_check(3, 300);
+	spool_empty_check();
+}
+
+static void test_full(void)
+{
+	struct data_spool_stats stats;
+	struct data_spool_entry entry;
+	uint32_t seq = 0;
+	uint32_t last_seq = 0;
+
+	spool_setup(2 * SECTOR_SIZE);
+
+	for (seq = 0; seq < 40; seq++) {
+		zassert_equal(message_append(seq, 500), 0, "Append failed");
+	}
+
+	data_spool_stats_get(&stats);
+	zassert_true(stats.dropped_cnt > 0, "No message dropped");
+
+	/* The oldest messages are dropped, the others are read in order. */
+	seq = stats.dropped_cnt;
+
+	while (data_spool_read(&entry) == 0) {
+		message_check(&entry, seq, 500);
+		k_free(entry.buf);
+		last_seq = seq++;
+	}
+
+	zassert_equal(last_seq, 39, "Newest message not read");
+
+	spool_reboot();
+	message_read_check(stats.dropped_cnt, 500);
+}
+
+static void outage_message_fill(uint32_t first_sample, size_t samples)
+{
+	for (size_t i = 0; i < samples; i++) {
+		memset(&message[i * SAMPLE_SIZE], 0, SAMPLE_SIZE);
+		memcpy(&message[i * SAMPLE_SIZE], &first_sample, sizeof(first_sample));
+		first_sample++;
+	}
+}
+
+/* Simulate an outage with a reboot halfway, then drain the spool. Returns the flash statistics of
+ * the outage.
+ */
+static void outage_simulate(size_t cycles_per_message, struct flash_mock_stats *outage,
+			    struct flash_mock_stats *drain)
+{
+	struct flash_mock_stats start;
+	struct data_spool_stats stats;
+	struct data_spool_entry entry;
+	size_t samples_per_message = cycles_per_message * SAMPLES_PER_CYCLE;
+	uint32_t sample = 0;
+	uint32_t expected = 0;
+	int err;
+
+	spool_setup(OUTAGE_SPOOL_SIZE);
+	flash_mock_stats_get(&start);
+
+	for (size_t cycle = cycles_per_message; cycle <= SAMPLE_CYCLES;
+	     cycle += cycles_per_message) {
+		outage_message_fill(sample, samples_per_message);
+		sample += samples_per_message;
+
+		zassert_equal(data_spool_append(TYPE_BATCH, message,
+						samples_per_message * SAMPLE_SIZE), 0,
+			      "Append failed");
+
+		if (cycle == SAMPLE_CYCLES / 2) {
+			spool_reboot();
+		}
+	}
+
+	flash_mock_stats_get(outage);
+	outage->write_cnt -= start.write_cnt;
+	outage->write_bytes -= start.write_bytes;
+	outage->erase_cnt -= start.erase_cnt;
+
+	data_spool_stats_get(&stats);
+	zassert_equal(stats.dropped_cnt, 0, "Messages dropped during the outage");
+
+	/* Connection is back, send the spooled messages oldest first. */
+	while (true) {
+		uint32_t last_id = 0;
+		size_t sent = 0;
+
+		for (sent = 0; sent < DRAIN_COUNT; sent++) {
+			err = data_spool_read(&entry);
+			if (err) {
+				break;
+			}
+
+			zassert_equal(entry.len, samples_per_message * SAMPLE_SIZE, "Wrong length");
+
+			for (size_t i = 0; i < samples_per_message; i++) {
+				uint32_t value;
+
+				memcpy(&value, (uint8_t *)entry.buf + i * SAMPLE_SIZE,
+				       sizeof(value));
+				zassert_equal(value, expected, "Sample %d missing", expected);
+				expected++;
+			}
+
+			last_id = entry.id;
+			k_free(entry.buf);
+		}
+
+		zassert_true((err == 0) || (err == -ENOENT), "Read failed");
+
+		if (sent == 0) {
+			break;
+		}
+
+		zassert_equal(data_spool_ack(last_id), 0, "ACK failed");
+	}
+
+	zassert_equal(data_spool_sync(), 0, "Sync failed");
+	zassert_equal(expected, SAMPLE_CYCLES * SAMPLES_PER_CYCLE, "Samples missing");
+
+	flash_mock_stats_get(drain);
+	drain->write_cnt -= outage->write_cnt + start.write_cnt;
+	drain->write_bytes -= outage->write_bytes + start.write_bytes;
+	drain->erase_cnt -= outage->erase_cnt + start.erase_cnt;
+
+	/* Nothing is sent again after a reboot. */
+	spool_reboot();
+	spool_empty_check();
+}
+
+static void outage_print(const char *name, const struct flash_mock_stats *outage,
+			 const struct flash_mock_stats *drain)
+{
+	uint32_t samples = SAMPLE_CYCLES * SAMPLES_PER_CYCLE;
+	uint32_t writes = 100 * (outage->write_cnt + drain->write_cnt) / samples;
+	uint32_t bytes = 100 * (outage->write_bytes + drain->write_bytes) / samples;
+
+	printk("%s: %d h outage, %d samples: %d + %d flash writes (%d.%02d per sample), "
+	       "%d.%02d bytes per sample, %d sector erases\n", name, OUTAGE_HOURS, samples,
+	       outage->write_cnt, drain->write_cnt, writes / 100, writes % 100, bytes / 100,
+	       bytes % 100, outage->erase_cnt + drain->erase_cnt);
+}
+
+static void test_outage_24h(void)
+{
+	struct flash_mock_stats coalesced_outage, coalesced_drain;
+	struct flash_mock_stats single_outage, single_drain;
+	uint32_t samples = SAMPLE_CYCLES * SAMPLES_PER_CYCLE;
+	uint32_t coalesced_writes, single_writes;
+
+	/* One message per sample cycle, as if every cycle was spooled on its own. */
+	outage_simulate(1, &single_outage, &single_drain);
+	outage_simulate(CYCLES_PER_MESSAGE, &coalesced_outage, &coalesced_drain);
+
+	outage_print("One message per cycle", &single_outage, &single_drain);
+	outage_print("Coalesced", &coalesced_outage, &coalesced_drain);
+
+	coalesced_writes = coalesced_outage.write_cnt + coalesced_drain.write_cnt;
+	single_writes = single_outage.write_cnt + single_drain.write_cnt;
+
+	/* Less than one flash write per four samples, header and cursors included. */
+	zassert_true(4 * coalesced_writes < samples, "%d flash writes for %d samples",
+		     coalesced_writes, samples);
+	zassert_true(2 * coalesced_writes < single_writes, "Writes are not coalesced");
+
+	/* The cursor is written lazily while draining. */
+	zassert_true(coalesced_drain.write_cnt <=
+		     DIV_ROUND_UP(SAMPLE_CYCLES / CYCLES_PER_MESSAGE,
+				  DRAIN_COUNT * CONFIG_DATA_SPOOL_CURSOR_INTERVAL) + 1,
+		     "%d cursor writes", coalesced_drain.write_cnt);
+
+	/* The outage fits in the partition, no sector is erased twice. */
+	zassert_equal(coalesced_outage.erase_max, 1, "Sectors erased more than once");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(data_spool,
+		ztest_unit_test(test_append_read),
+		ztest_unit_test(test_append_invalid),
+		ztest_unit_test(test_ack_rewind),
+		ztest_unit_test(test_round_ack),
+		ztest_unit_test(test_round_failed),
+		ztest_unit_test(test_round_abort),
+		ztest_unit_test(test_reboot),
+		ztest_unit_test(test_power_loss),
+		ztest_unit_test(test_full),
+		ztest_unit_test(test_outage_24h)
+	);
+
+	ztest_run_test_suite(data_spool);
+}
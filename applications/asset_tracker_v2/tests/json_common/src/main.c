@@ -8,11 +8,13 @@
 #include <zephyr.h>
 #include <stdio.h>
 #include <string.h>
+#include <math.h>
 #include <cJSON.h>
 #include <cJSON_os.h>
 
 #include "json_helpers.h"
 #include "json_common.h"
+#include "json_writer.h"
 #include "cloud_codec.h"
 #include "json_protocol_names.h"
 #include "json_validate.h"
@@ -390,7 +392,13 @@ static void test_encode_modem_static_data_object(void)
 		.brdv = "nrf9160dk_nrf9160",
 		.appv = "v1.0.0-development",
 		.ts = 1000,
-		.queued = true
+		.queued = true,
+		.bnd_fresh = true,
+		.nw_mode_fresh = true,
+		.iccid_fresh = true,
+		.fw_fresh = true,
+		.brdv_fresh = true,
+		.appv_fresh = true
 	};
 
 	ret = json_common_modem_static_data_add(dummy.root_obj,
@@ -444,7 +452,13 @@ static void test_encode_modem_static_data_array(void)
 		.brdv = "nrf9160dk_nrf9160",
 		.appv = "v1.0.0-development",
 		.ts = 1000,
-		.queued = true
+		.queued = true,
+		.bnd_fresh = true,
+		.nw_mode_fresh = true,
+		.iccid_fresh = true,
+		.fw_fresh = true,
+		.brdv_fresh = true,
+		.appv_fresh = true
 	};
 
 	ret = json_common_modem_static_data_add(dummy.array_obj,
@@ -848,6 +862,12 @@ static void test_encode_batch_data_object(void)
 		[0].appv = "v1.0.0-development",
 		[0].ts = 1000,
 		[0].queued = true,
+		[0].bnd_fresh = true,
+		[0].nw_mode_fresh = true,
+		[0].iccid_fresh = true,
+		[0].fw_fresh = true,
+		[0].brdv_fresh = true,
+		[0].appv_fresh = true,
 		/* Second entry */
 		[1].bnd = 3,
 		[1].nw_nb_iot = 1,
@@ -857,7 +877,13 @@ static void test_encode_batch_data_object(void)
 		[1].brdv = "nrf9160dk_nrf9160",
 		[1].appv = "v1.0.0-development",
 		[1].ts = 1000,
-		[1].queued = true
+		[1].queued = true,
+		[1].bnd_fresh = true,
+		[1].nw_mode_fresh = true,
+		[1].iccid_fresh = true,
+		[1].fw_fresh = true,
+		[1].brdv_fresh = true,
+		[1].appv_fresh = true
 	};
 	struct cloud_data_ui ui[2] = {
 		[0].btn = 1,
@@ -1204,6 +1230,416 @@ static void test_teardown_array(void)
 	cJSON_Delete(dummy.array_obj);
 }
 
+#define BENCH_ITERATIONS	100
+#define BENCH_ENTRIES		4
+
+static const struct cloud_data_gps gps_template = {
+	.pvt.longi = 10.417397,
+	.pvt.lat = 63.431278,
+	.pvt.acc = 12.3f,
+	.pvt.alt = 170.3f,
+	.pvt.spd = 0.1f,
+	.pvt.hdg = 176.12f,
+	.gps_ts = 1000,
+	.queued = true,
+	.format = CLOUD_CODEC_GPS_FORMAT_PVT
+};
+
+static const struct cloud_data_sensors sensor_template = {
+	.temp = 23.4,
+	.hum = 50.78,
+	.env_ts = 1000,
+	.queued = true
+};
+
+static const struct cloud_data_modem_dynamic modem_dynamic_template = {
+	.rsrp = -8,
+	.area = 12,
+	.mccmnc = "24202",
+	.cell = 33703719,
+	.ip = "10.81.183.99",
+	.ts = 1000,
+	.queued = true,
+	.area_code_fresh = true,
+	.cell_id_fresh = true,
+	.rsrp_fresh = true,
+	.ip_address_fresh = true,
+	.mccmnc_fresh = true
+};
+
+static const struct cloud_data_ui ui_template = {
+	.btn = 1,
+	.btn_ts = 1000,
+	.queued = true
+};
+
+static const struct cloud_data_accelerometer accel_template = {
+	.values = { -0.0918, 9.81, 1e-7 },
+	.ts = 1000,
+	.queued = true
+};
+
+static const struct cloud_data_battery battery_template = {
+	.bat = 3600,
+	.bat_ts = 1000,
+	.queued = true
+};
+
+static struct batch_buffers {
+	struct cloud_data_gps gps[BENCH_ENTRIES];
+	struct cloud_data_sensors sensor[BENCH_ENTRIES];
+	struct cloud_data_modem_dynamic modem_dynamic[BENCH_ENTRIES];
+	struct cloud_data_ui ui[BENCH_ENTRIES];
+	struct cloud_data_accelerometer accel[BENCH_ENTRIES];
+	struct cloud_data_battery battery[BENCH_ENTRIES];
+} batch_bufs;
+
+static struct json_common_batch batch[] = {
+	{ JSON_COMMON_MODEM_DYNAMIC, batch_bufs.modem_dynamic, BENCH_ENTRIES,
+	  DATA_MODEM_DYNAMIC },
+	{ JSON_COMMON_GPS, batch_bufs.gps, BENCH_ENTRIES, DATA_GPS },
+	{ JSON_COMMON_SENSOR, batch_bufs.sensor, BENCH_ENTRIES, DATA_ENVIRONMENTALS },
+	{ JSON_COMMON_UI, batch_bufs.ui, BENCH_ENTRIES, DATA_BUTTON },
+	{ JSON_COMMON_BATTERY, batch_bufs.battery, BENCH_ENTRIES, DATA_BATTERY },
+	{ JSON_COMMON_ACCELEROMETER, batch_bufs.accel, BENCH_ENTRIES, DATA_MOVEMENT },
+};
+
+/* Queue all entries, with different values in each entry. */
+static void batch_bufs_fill(void)
+{
+	for (size_t i = 0; i < BENCH_ENTRIES; i++) {
+		batch_bufs.gps[i] = gps_template;
+		batch_bufs.gps[i].pvt.lat += i * 0.001;
+		batch_bufs.sensor[i] = sensor_template;
+		batch_bufs.sensor[i].temp -= i * 0.1;
+		batch_bufs.modem_dynamic[i] = modem_dynamic_template;
+		batch_bufs.modem_dynamic[i].rsrp -= i;
+		batch_bufs.ui[i] = ui_template;
+		batch_bufs.ui[i].btn += i;
+		batch_bufs.accel[i] = accel_template;
+		batch_bufs.accel[i].values[0] *= i;
+		batch_bufs.battery[i] = battery_template;
+		batch_bufs.battery[i].bat -= i * 10;
+	}
+
+	/* Entries that are not queued or have no fresh values are left out. */
+	batch_bufs.gps[1].queued = false;
+	batch_bufs.modem_dynamic[2].rsrp_fresh = false;
+	batch_bufs.modem_dynamic[3].area_code_fresh = false;
+	batch_bufs.modem_dynamic[3].cell_id_fresh = false;
+	batch_bufs.modem_dynamic[3].rsrp_fresh = false;
+	batch_bufs.modem_dynamic[3].ip_address_fresh = false;
+	batch_bufs.modem_dynamic[3].mccmnc_fresh = false;
+}
+
+static bool batch_bufs_queued(void)
+{
+	for (size_t i = 0; i < BENCH_ENTRIES; i++) {
+		if (batch_bufs.gps[i].queued || batch_bufs.sensor[i].queued ||
+		    batch_bufs.modem_dynamic[i].queued || batch_bufs.ui[i].queued ||
+		    batch_bufs.accel[i].queued || batch_bufs.battery[i].queued) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/* Encode the batch buffers as the codecs do without the streaming writer. */
+static int batch_cjson_encode(struct cloud_codec_data *output)
+{
+	cJSON *root_obj = cJSON_CreateObject();
+	int err;
+
+	zassert_not_null(root_obj, "Root object is NULL");
+
+	for (size_t i = 0; i < ARRAY_SIZE(batch); i++) {
+		err = json_common_batch_data_add(root_obj, batch[i].type, batch[i].buf,
+						 batch[i].buf_count, batch[i].object_label);
+		if (err && err != -ENODATA) {
+			cJSON_Delete(root_obj);
+			return err;
+		}
+	}
+
+	output->buf = cJSON_PrintUnformatted(root_obj);
+	output->len = output->buf ? strlen(output->buf) : 0;
+
+	cJSON_Delete(root_obj);
+
+	return output->buf ? 0 : -ENOMEM;
+}
+
+static void test_writer_batch_matches_cjson(void)
+{
+	struct cloud_codec_data expected;
+	struct cloud_codec_data output;
+	int ret;
+
+	batch_bufs_fill();
+	ret = batch_cjson_encode(&expected);
+	zassert_equal(0, ret, "Return value %d is wrong", ret);
+
+	batch_bufs_fill();
+	ret = json_common_batch_encode(&output, batch, ARRAY_SIZE(batch));
+	zassert_equal(0, ret, "Return value %d is wrong", ret);
+
+	zassert_false(batch_bufs_queued(), "Entries left queued");
+	zassert_true(strcmp(expected.buf, output.buf) == 0, "Output differs from cJSON:\n%s\n%s",
+		     expected.buf, output.buf);
+	zassert_equal(expected.len, output.len, "Wrong length");
+
+	cJSON_free(expected.buf);
+	cJSON_free(output.buf);
+
+	/* Nothing is left to encode. */
+	ret = json_common_batch_encode(&output, batch, ARRAY_SIZE(batch));
+	zassert_equal(-ENODATA, ret, "Return value %d is wrong", ret);
+}
+
+static void test_writer_values_match_cjson(void)
+{
+	static const double numbers[] = {
+		0, -0.0, 1, -1, 2147483647, 2147483648.0, -2147483649.0, 1563968747123,
+		1e15, -1e15, 1e300, 0.1, 1.0 / 3, 23.5, -12.345678, 170.3f, 5e-324, NAN, INFINITY,
+	};
+	static const char *const strings[] = {
+		"", "plain", "\"quoted\"", "back\\slash", "\b\f\n\r\t", "\x01\x1f\x7f", "\xc3\xa6",
+	};
+	cJSON *root_obj = cJSON_CreateObject();
+	cJSON *array_obj = cJSON_CreateArray();
+	struct json_writer writer;
+	char buf[512];
+	char *expected;
+	int ret;
+
+	zassert_not_null(root_obj, "Root object is NULL");
+	zassert_not_null(array_obj, "Array object is NULL");
+
+	json_writer_init(&writer, buf, sizeof(buf), NULL, NULL);
+	json_writer_object_start(&writer, NULL);
+	json_writer_array_start(&writer, "n");
+
+	for (size_t i = 0; i < ARRAY_SIZE(numbers); i++) {
+		json_add_number_to_array(array_obj, numbers[i]);
+		json_writer_number(&writer, NULL, numbers[i]);
+	}
+
+	json_add_obj(root_obj, "n", array_obj);
+	json_writer_array_end(&writer);
+
+	for (size_t i = 0; i < ARRAY_SIZE(strings); i++) {
+		char key[] = { 'a' + i, '\0' };
+
+		json_add_str(root_obj, key, strings[i]);
+		json_writer_str(&writer, key, strings[i]);
+	}
+
+	json_add_bool(root_obj, "t", true);
+	json_writer_bool(&writer, "t", true);
+	json_add_bool(root_obj, "f", false);
+	json_writer_bool(&writer, "f", false);
+	json_writer_object_end(&writer);
+
+	ret = json_writer_finish(&writer);
+	expected = cJSON_PrintUnformatted(root_obj);
+
+	zassert_not_null(expected, "Failed to print object");
+	zassert_equal(strlen(expected), ret, "Return value %d is wrong", ret);
+	zassert_true(strcmp(expected, buf) == 0, "Output differs from cJSON:\n%s\n%s",
+		     expected, buf);
+
+	cJSON_free(expected);
+	cJSON_Delete(root_obj);
+}
+
+static char chunked_buf[2048];
+static size_t chunked_len;
+
+static int chunk_append(const char *buf, size_t len, void *user_data)
+{
+	size_t *chunk_count = user_data;
+
+	zassert_true(chunked_len + len < sizeof(chunked_buf), "Output too long");
+
+	memcpy(chunked_buf + chunked_len, buf, len);
+	chunked_len += len;
+	(*chunk_count)++;
+
+	return 0;
+}
+
+static int chunk_refuse(const char *buf, size_t len, void *user_data)
+{
+	return -EAGAIN;
+}
+
+static void test_writer_modes(void)
+{
+	struct cloud_codec_data output;
+	struct json_writer writer;
+	char chunk[16];
+	char small[32];
+	size_t chunk_count = 0;
+	int ret;
+
+	batch_bufs_fill();
+	ret = json_common_batch_encode(&output, batch, ARRAY_SIZE(batch));
+	zassert_equal(0, ret, "Return value %d is wrong", ret);
+
+	/* Chunked output, through a buffer smaller than any entry. */
+	batch_bufs_fill();
+	chunked_len = 0;
+	json_writer_init(&writer, chunk, sizeof(chunk), chunk_append, &chunk_count);
+	json_writer_object_start(&writer, NULL);
+
+	for (size_t i = 0; i < ARRAY_SIZE(batch); i++) {
+		json_common_batch_data_write(&writer, batch[i].type, batch[i].buf,
+					     batch[i].buf_count, batch[i].object_label);
+	}
+
+	json_writer_object_end(&writer);
+	ret = json_writer_finish(&writer);
+
+	zassert_equal(output.len, ret, "Return value %d is wrong", ret);
+	zassert_equal(output.len, chunked_len, "Wrong chunked length");
+	zassert_equal(DIV_ROUND_UP(output.len, sizeof(chunk)), chunk_count, "Wrong chunk count");
+	zassert_mem_equal(output.buf, chunked_buf, output.len, "Wrong chunked output");
+
+	cJSON_free(output.buf);
+
+	/* Output that does not fit. Entries are still unqueued, as they have been written. */
+	batch_bufs_fill();
+	json_writer_init(&writer, small, sizeof(small), NULL, NULL);
+	json_writer_object_start(&writer, NULL);
+	ret = json_common_batch_data_write(&writer, JSON_COMMON_GPS, batch_bufs.gps,
+					   BENCH_ENTRIES, DATA_GPS);
+	zassert_equal(-ENOMEM, ret, "Return value %d is wrong", ret);
+	zassert_equal(-ENOMEM, json_writer_finish(&writer), "Error not kept");
+
+	/* Errors from the flush function stop the writer. */
+	json_writer_init(&writer, small, sizeof(small), chunk_refuse, NULL);
+	json_writer_array_start(&writer, NULL);
+
+	for (size_t i = 0; i < sizeof(small); i++) {
+		json_writer_number(&writer, NULL, i);
+	}
+
+	json_writer_array_end(&writer);
+	zassert_equal(-EAGAIN, json_writer_finish(&writer), "Error not kept");
+
+	/* Members and values mixed up. */
+	json_writer_init(&writer, NULL, 0, NULL, NULL);
+	json_writer_object_start(&writer, NULL);
+	zassert_equal(-EINVAL, json_writer_number(&writer, NULL, 1), "Value without key");
+
+	json_writer_init(&writer, NULL, 0, NULL, NULL);
+	json_writer_array_start(&writer, NULL);
+	zassert_equal(-EINVAL, json_writer_number(&writer, "n", 1), "Member in array");
+
+	json_writer_init(&writer, NULL, 0, NULL, NULL);
+	json_writer_array_start(&writer, NULL);
+	zassert_equal(-EINVAL, json_writer_object_end(&writer), "Wrong container ended");
+
+	json_writer_init(&writer, NULL, 0, NULL, NULL);
+	json_writer_object_start(&writer, NULL);
+	zassert_equal(-EINVAL, json_writer_finish(&writer), "Object not ended");
+}
+
+/* Allocator that keeps track of the heap used by cJSON, and by the output of the writer which is
+ * allocated the same way.
+ */
+static size_t heap_used;
+static size_t heap_peak;
+
+static void *counting_malloc(size_t size)
+{
+	size_t *ptr = k_malloc(sizeof(size_t) + size);
+
+	if (ptr == NULL) {
+		return NULL;
+	}
+
+	*ptr = size;
+	heap_used += size;
+	heap_peak = MAX(heap_peak, heap_used);
+
+	return ptr + 1;
+}
+
+static void counting_free(void *ptr)
+{
+	size_t *header = (size_t *)ptr - 1;
+
+	if (ptr == NULL) {
+		return;
+	}
+
+	heap_used -= *header;
+	k_free(header);
+}
+
+static uint32_t batch_bench(bool writer, size_t *len, size_t *peak)
+{
+	uint32_t cycles = 0;
+
+	heap_used = 0;
+	heap_peak = 0;
+
+	for (size_t i = 0; i < BENCH_ITERATIONS; i++) {
+		struct cloud_codec_data output;
+		uint32_t start;
+		int ret;
+
+		batch_bufs_fill();
+
+		start = k_cycle_get_32();
+
+		if (writer) {
+			ret = json_common_batch_encode(&output, batch, ARRAY_SIZE(batch));
+		} else {
+			ret = batch_cjson_encode(&output);
+		}
+
+		cycles += k_cycle_get_32() - start;
+
+		zassert_equal(0, ret, "Return value %d is wrong", ret);
+
+		*len = output.len;
+		cJSON_free(output.buf);
+	}
+
+	zassert_equal(0, heap_used, "Memory leaked");
+	*peak = heap_peak;
+
+	return cycles / BENCH_ITERATIONS;
+}
+
+static void test_writer_bench(void)
+{
+	cJSON_Hooks hooks = {
+		.malloc_fn = counting_malloc,
+		.free_fn = counting_free
+	};
+	size_t cjson_len, writer_len;
+	size_t cjson_peak, writer_peak;
+	uint32_t cjson_cycles, writer_cycles;
+
+	cJSON_InitHooks(&hooks);
+
+	cjson_cycles = batch_bench(false, &cjson_len, &cjson_peak);
+	writer_cycles = batch_bench(true, &writer_len, &writer_peak);
+
+	cJSON_Init();
+
+	zassert_equal(cjson_len, writer_len, "Different output lengths");
+	zassert_true(writer_peak < cjson_peak, "Writer used more heap than cJSON");
+
+	printk("Batch of %u bytes: cJSON %u cycles, peak heap %zu bytes; "
+	       "writer %u cycles, peak heap %zu bytes\n",
+	       (unsigned int)cjson_len, cjson_cycles, cjson_peak, writer_cycles, writer_peak);
+}
+
 void test_main(void)
 {
 	cJSON_Init();
@@ -1312,7 +1748,13 @@ void test_main(void)
 		/* Configuration floating point values comparison */
 		ztest_unit_test_setup_teardown(test_floating_point_encoding_configuration,
 					       test_setup_object,
-					       test_teardown_object)
+					       test_teardown_object),
+
+		/* Streaming writer */
+		ztest_unit_test(test_writer_batch_matches_cjson),
+		ztest_unit_test(test_writer_values_match_cjson),
+		ztest_unit_test(test_writer_modes),
+		ztest_unit_test(test_writer_bench)
 	);
 
 	ztest_run_test_suite(json_common);
@@ -156,16 +156,17 @@ static void ncell_meas_mon(const char *notify)
 {
 	int err;
 	uint32_t param_count;
+	const struct at_param_list *params;
 
 	ncell_meas_status = -1;
-	at_params_list_clear(&at_param_list);
-	err = at_parser_params_from_str(notify, NULL, &at_param_list);
-	if (err) {
+	params = at_monitor_notif_params_get(notify);
+	if (!params) {
+		err = -EINVAL;
 		goto exit;
 	}
 
 	/* parse status, 0: success 1: fail */
-	err = at_params_int_get(&at_param_list, 1, &ncell_meas_status);
+	err = at_params_int_get(params, 1, &ncell_meas_status);
 	if (err) {
 		goto exit;
 	}
@@ -174,7 +175,7 @@ static void ncell_meas_mon(const char *notify)
 		err = -EAGAIN;
 		goto exit;
 	}
-	param_count = at_params_valid_count_get(&at_param_list);
+	param_count = at_params_valid_count_get(params);
 	if (param_count < MAX_PARAM_CELL) { /* at least current cell */
 		LOG_ERR("Missing param in NCELLMEAS notification");
 		err = -EAGAIN;
@@ -186,7 +187,7 @@ static void ncell_meas_mon(const char *notify)
 	size_t size;
 
 	size = sizeof(cid);
-	err = util_string_get(&at_param_list, 2, cid, &size);
+	err = util_string_get(params, 2, cid, &size);
 	if (err) {
 		goto exit;
 	}
@@ -200,7 +201,7 @@ static void ncell_meas_mon(const char *notify)
 	char mcc[4]  = {0};
 
 	size = sizeof(plmn);
-	err = util_string_get(&at_param_list, 3, plmn, &size);
+	err = util_string_get(params, 3, plmn, &size);
 	if (err) {
 		goto exit;
 	}
@@ -218,7 +219,7 @@ static void ncell_meas_mon(const char *notify)
 	char tac[9] = {0};
 
 	size = sizeof(tac);
-	err = util_string_get(&at_param_list, 4, tac, &size);
+	err = util_string_get(params, 4, tac, &size);
 	if (err) {
 		goto exit;
 	}
@@ -231,24 +232,24 @@ static void ncell_meas_mon(const char *notify)
 	cell_data.current_cell.timing_advance = NRF_CLOUD_CELL_POS_OMIT_TIME_ADV;
 
 	/* parse EARFCN */
-	err = at_params_unsigned_int_get(&at_param_list, 6, &cell_data.current_cell.earfcn);
+	err = at_params_unsigned_int_get(params, 6, &cell_data.current_cell.earfcn);
 	if (err) {
 		goto exit;
 	}
 
 	/* parse PCI */
-	err = at_params_unsigned_short_get(&at_param_list, 7,
+	err = at_params_unsigned_short_get(params, 7,
 					   &cell_data.current_cell.phys_cell_id);
 	if (err) {
 		goto exit;
 	}
 
 	/* parse RSRP and RSRQ */
-	err = at_params_short_get(&at_param_list, 8, &cell_data.current_cell.rsrp);
+	err = at_params_short_get(params, 8, &cell_data.current_cell.rsrp);
 	if (err < 0) {
 		goto exit;
 	}
-	err = at_params_short_get(&at_param_list, 9, &cell_data.current_cell.rsrq);
+	err = at_params_short_get(params, 9, &cell_data.current_cell.rsrq);
 	if (err < 0) {
 		goto exit;
 	}
@@ -264,27 +265,27 @@ static void ncell_meas_mon(const char *notify)
 		}
 
 		/* parse n_earfcn */
-		err = at_params_unsigned_int_get(&at_param_list, offset,
+		err = at_params_unsigned_int_get(params, offset,
 						 &neighbor_cells[i].earfcn);
 		if (err < 0) {
 			goto exit;
 		}
 
 		/* parse n_phys_cell_id */
-		err = at_params_unsigned_short_get(&at_param_list, offset + 1,
+		err = at_params_unsigned_short_get(params, offset + 1,
 						   &neighbor_cells[i].phys_cell_id);
 		if (err < 0) {
 			goto exit;
 		}
 
 		/* parse n_rsrp */
-		err = at_params_short_get(&at_param_list, offset + 2, &neighbor_cells[i].rsrp);
+		err = at_params_short_get(params, offset + 2, &neighbor_cells[i].rsrp);
 		if (err < 0) {
 			goto exit;
 		}
 
 		/* parse n_rsrq */
-		err = at_params_short_get(&at_param_list, offset + 3, &neighbor_cells[i].rsrq);
+		err = at_params_short_get(params, offset + 3, &neighbor_cells[i].rsrq);
 		if (err < 0) {
 			goto exit;
 		}
@@ -54,6 +54,27 @@ extern "C" {
 #define SUBS_PRIO_COUNT (SUBS_PRIO_MAX - SUBS_PRIO_MIN + 1)
 
 
+/** @brief Event dispatch classes.
+ *
+ * Events of every dispatch class are processed by a separate work queue
+ * thread with its own priority. Events of the same dispatch class are
+ * processed in the order of submission.
+ */
+enum event_dispatch_class {
+	/** Latency critical events. */
+	EVENT_DISPATCH_CLASS_REALTIME,
+
+	/** Default dispatch class. */
+	EVENT_DISPATCH_CLASS_NORMAL,
+
+	/** Events that can wait until other events are processed. */
+	EVENT_DISPATCH_CLASS_BACKGROUND,
+
+	/** Number of dispatch classes. */
+	EVENT_DISPATCH_CLASS_COUNT
+};
+
+
 /** @brief Event header.
  *
  * When defining an event structure, the event header
@@ -70,6 +91,11 @@ struct event_header {
 	/** Entry id used in one of the storage backend */
 	size_t entry_id;
 #endif
+
+#if defined(CONFIG_EVENT_MANAGER_DISPATCH_STATS)
+	/** Cycle counter value at the time of submission. */
+	uint32_t submit_time;
+#endif
 };
 
 
@@ -150,13 +176,125 @@ struct event_type {
 	/** Logging and formatting information. */
 	const struct event_info *ev_info;
 
-#if defined(CONFIG_EVENT_MANAGER_STORAGE)
+#if defined(CONFIG_EVENT_MANAGER_DISPATCH_CLASSES)
+	/** Dispatch class of the event. */
+	enum event_dispatch_class dispatch_class;
+#endif
+
+#if defined(CONFIG_EVENT_MANAGER_STORAGE) || \
+	defined(CONFIG_EVENT_MANAGER_EVENT_POOL)
 	/** Size of the static payload used by the event */
 	const size_t event_size;
 #endif
 };
 
 
+/** @def EVENT_POOL_CNT
+ *
+ * @brief Number of event memory pools.
+ */
+#define EVENT_POOL_CNT 3
+
+
+/** @brief Event memory pool statistics.
+ */
+struct event_pool_stats {
+	/** Size of a single block in the pool. */
+	size_t block_size;
+
+	/** Number of blocks in the pool. */
+	uint32_t block_cnt;
+
+	/** Number of blocks currently in use. */
+	uint32_t used_cnt;
+
+	/** Maximum number of blocks that were in use at the same time. */
+	uint32_t max_used_cnt;
+
+	/** Number of events allocated from the pool. */
+	uint32_t alloc_cnt;
+
+	/** Number of events that did not fit in the pool because it was
+	 *  exhausted and were allocated from the heap instead. */
+	uint32_t exhausted_cnt;
+};
+
+
+/** @brief Event queue statistics.
+ */
+struct event_queue_stats {
+	/** Number of events waiting in the queue. */
+	uint32_t depth;
+
+	/** Maximum number of events waiting in the queue. */
+	uint32_t max_depth;
+
+	/** Number of dispatched events. */
+	uint32_t dispatch_cnt;
+
+	/** Maximum time between event submission and dispatch. */
+	uint32_t latency_max_us;
+
+	/** Sum of times between event submission and dispatch. */
+	uint64_t latency_total_us;
+};
+
+
+#if defined(CONFIG_EVENT_MANAGER_TIMING_HISTOGRAMS)
+/** @def EVENT_HISTOGRAM_BUCKET_CNT
+ *
+ * @brief Number of buckets in a timing histogram.
+ */
+#define EVENT_HISTOGRAM_BUCKET_CNT \
+	CONFIG_EVENT_MANAGER_TIMING_HISTOGRAM_BUCKET_CNT
+
+/** @def EVENT_HISTOGRAM_BUCKET_LIMIT_US
+ *
+ * @brief Upper limit (exclusive) of a histogram bucket in microseconds.
+ *
+ * Bucket 0 counts durations below 1 us, and bucket i counts durations from
+ * 2^(i-1) us up to 2^i us. The last bucket also counts all longer durations.
+ */
+#define EVENT_HISTOGRAM_BUCKET_LIMIT_US(i) (1UL << (i))
+
+/** @brief Timing histogram.
+ */
+struct event_histogram {
+	/** Number of samples in every bucket. */
+	uint32_t bucket[EVENT_HISTOGRAM_BUCKET_CNT];
+
+	/** Number of samples. */
+	uint32_t cnt;
+
+	/** Longest sample. */
+	uint32_t max_us;
+
+	/** Sum of all samples. */
+	uint64_t total_us;
+};
+#endif /* CONFIG_EVENT_MANAGER_TIMING_HISTOGRAMS */
+
+
+/** @brief Event storage statistics.
+ *
+ * The write amplification of the storage backend is the ratio of
+ * @ref flash_bytes to @ref payload_bytes.
+ */
+struct event_storage_stats {
+	/** Number of bytes of event payload stored. */
+	uint32_t payload_bytes;
+
+	/** Number of bytes written to flash, including metadata. */
+	uint32_t flash_bytes;
+
+	/** Number of erased flash sectors. */
+	uint32_t erase_cnt;
+
+	/** Number of times unconsumed events were dropped. */
+	uint32_t dropped_cnt;
+};
+
+
 extern const struct event_listener __start_event_listeners[];
 extern const struct event_listener __stop_event_listeners[];
 
@@ -271,6 +409,26 @@ extern const struct event_type __stop_event_types[];
 	_EVENT_TYPE_DEFINE(ename, init_log_en, log_fn, ev_info_struct)
 
 
+/** Define an event type with a given dispatch class.
+ *
+ * This macro works like @ref EVENT_TYPE_DEFINE, but the event is processed
+ * by the work queue of the given dispatch class. If
+ * @kconfig{CONFIG_EVENT_MANAGER_DISPATCH_CLASSES} is disabled, the dispatch
+ * class is ignored and all events are processed by a single work queue.
+ *
+ * @param ename     	   Name of the event.
+ * @param dclass	   Dispatch class (@ref event_dispatch_class).
+ * @param init_log_en	   Bool indicating if the event is logged
+ *                         by default.
+ * @param log_fn  	   Function to stringify an event of this type.
+ * @param ev_info_struct   Data structure describing the event type.
+ */
+#define EVENT_TYPE_DEFINE_DISPATCH_CLASS(ename, dclass, init_log_en, log_fn,	\
+					 ev_info_struct)			\
+	_EVENT_TYPE_DEFINE_DISPATCH_CLASS(ename, dclass, init_log_en, log_fn,	\
+					  ev_info_struct)
+
+
 /** Verify if an event ID is valid.
  *
  * The pointer to an event type structure is used as its ID. This macro
@@ -304,6 +462,77 @@ void _event_submit(struct event_header *eh);
 
 #define EVENT_SUBMIT(event) _event_submit(&event->header)
 
+/** Free an event that was allocated but not submitted.
+ *
+ * Events that were submitted are freed by the Event Manager after they are
+ * processed. This function must be used to release an event that was
+ * allocated with the <i>new_%event_type</i> function, but never submitted.
+ *
+ * @param addr  Pointer to the event object.
+ */
+void event_manager_free(void *addr);
+
+/** Get statistics of the event memory pools.
+ *
+ * @note Requires @kconfig{CONFIG_EVENT_MANAGER_EVENT_POOL}.
+ *
+ * @param[out] stats     Array to be filled with statistics of every pool.
+ * @param[in]  stats_cnt Number of elements in the @p stats array.
+ * @param[out] heap_cnt  Number of events that were too big for any of the
+ *                       pools and were allocated from the heap.
+ *
+ * @return Number of pools, or a negative error code on failure.
+ */
+int event_manager_pool_stats_get(struct event_pool_stats *stats,
+				 size_t stats_cnt, uint32_t *heap_cnt);
+
+/** Get statistics of the queue processing events of a given dispatch class.
+ *
+ * @note Requires @kconfig{CONFIG_EVENT_MANAGER_DISPATCH_STATS}.
+ *
+ * @param[in]  dclass Dispatch class.
+ * @param[out] stats  Queue statistics.
+ *
+ * @retval 0 If the operation was successful.
+ */
+int event_manager_queue_stats_get(enum event_dispatch_class dclass,
+				  struct event_queue_stats *stats);
+
+/** Get the histogram of the time between submission and dispatch of events
+ *  of a given type.
+ *
+ * @note Requires @kconfig{CONFIG_EVENT_MANAGER_TIMING_HISTOGRAMS}.
+ *
+ * @param[in]  et   Event type.
+ * @param[out] hist Latency histogram.
+ *
+ * @retval 0 If the operation was successful.
+ */
+int event_manager_latency_histogram_get(const struct event_type *et,
+					struct event_histogram *hist);
+
+/** Get the histogram of the execution time of an event listener.
+ *
+ * The execution time is measured from the call to the notification handler
+ * until it returns, so it includes the time for which the listener was
+ * preempted.
+ *
+ * @note Requires @kconfig{CONFIG_EVENT_MANAGER_TIMING_HISTOGRAMS}.
+ *
+ * @param[in]  el   Event listener.
+ * @param[out] hist Execution time histogram.
+ *
+ * @retval 0 If the operation was successful.
+ */
+int event_manager_listener_histogram_get(const struct event_listener *el,
+					 struct event_histogram *hist);
+
+/** Reset all timing histograms.
+ *
+ * @note Requires @kconfig{CONFIG_EVENT_MANAGER_TIMING_HISTOGRAMS}.
+ */
+void event_manager_histograms_reset(void);
+
 /** Initialize the Event Manager.
  *
  * @retval 0 If the operation was successful.
@@ -316,6 +545,16 @@ int event_manager_init(void);
  */
 int event_manager_clear_storage(void);
 
+/** Get statistics of the event storage.
+ *
+ * @param[out] stats  Storage statistics.
+ *
+ * @retval 0 If the operation was successful.
+ * @retval -ENOTSUP If the storage or the backend does not support
+ *                  statistics.
+ */
+int event_manager_storage_stats_get(struct event_storage_stats *stats);
+
 #ifdef __cplusplus
 }
 #endif
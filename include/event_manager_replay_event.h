@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _EVENT_MANAGER_REPLAY_EVENT_H_
+#define _EVENT_MANAGER_REPLAY_EVENT_H_
+
+/**
+ * @file
+ * @defgroup event_manager_replay_event Event Manager Replay Event
+ * @{
+ * @brief Event Manager Replay Event.
+ */
+
+#include "event_manager.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Event replay progress event.
+ *
+ * The event is submitted by the Event Manager after every batch of stored
+ * events is played, if incremental replay of stored events is enabled
+ * (@kconfig{CONFIG_EVENT_MANAGER_STORAGE_REPLAY_INCREMENTAL}).
+ */
+struct event_replay_progress_event {
+	/** Event header. */
+	struct event_header header;
+
+	/** Number of stored events played since boot. */
+	uint32_t replayed_cnt;
+
+	/** Information if all stored events were played. */
+	bool done;
+};
+
+EVENT_TYPE_DECLARE(event_replay_progress_event);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif /* _EVENT_MANAGER_REPLAY_EVENT_H_ */
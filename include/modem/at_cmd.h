@@ -23,6 +23,7 @@ extern "C" {
 
 #include <zephyr/types.h>
 #include <stddef.h>
+#include <kernel.h>
 
 /**
  * @brief AT command return codes
@@ -143,6 +144,99 @@ int at_cmd_write(const char *const cmd,
  */
 void at_cmd_set_notification_handler(at_cmd_handler_t handler);
 
+/**
+ * @brief AT command in a batch.
+ */
+struct at_cmd_batch_cmd {
+	/** Null terminated AT command string. Must remain valid until the
+	 *  batch is completed.
+	 */
+	const char *cmd;
+	/** Buffer for the response, or NULL to drop the response. */
+	char *resp;
+	/** Size of the response buffer. */
+	size_t resp_size;
+	/** Handler called with the response, or NULL. */
+	at_cmd_handler_t handler;
+	/** Return code of the command, set when the command completes.
+	 *  See @ref at_cmd_write for the possible values.
+	 */
+	int code;
+	/** State of the command, set when the command completes. */
+	enum at_cmd_state state;
+};
+
+struct at_cmd_batch;
+
+/**
+ * @typedef at_cmd_batch_handler_t
+ *
+ * Handler called when all commands of a batch are completed. It is called
+ * without the driver lock held, so it may queue new commands.
+ *
+ * @param batch The completed batch.
+ */
+typedef void (*at_cmd_batch_handler_t)(struct at_cmd_batch *batch);
+
+/**
+ * @brief Batch of AT commands.
+ *
+ * The batch and its commands are owned by the caller and must remain valid
+ * until the batch is completed. No memory is allocated by the driver.
+ */
+struct at_cmd_batch {
+	/** Commands, executed in array order. */
+	struct at_cmd_batch_cmd *cmds;
+	/** Number of commands. */
+	size_t cmd_cnt;
+	/** Skip the remaining commands after the first failed command. */
+	bool stop_on_error;
+	/** Handler called when the batch is completed, or NULL. */
+	at_cmd_batch_handler_t handler;
+	/** Return code of the first failed command, set on completion. */
+	int err;
+
+	/* Private fields, used by the driver. */
+	size_t next;
+	struct k_sem done;
+};
+
+/**
+ * @brief Queue a batch of AT commands.
+ *
+ * The batch is queued as a single entry. When it is dequeued, its commands
+ * are written to the modem back-to-back from the AT command driver thread,
+ * without other commands in between. The result of every command is stored
+ * in its @ref at_cmd_batch_cmd, and the batch handler is called when all
+ * commands are completed. Skipped commands have the -ECANCELED return code.
+ *
+ * The batch handler is called from the AT command driver thread or, if the
+ * last command could not be written, from the thread that wrote it.
+ *
+ * @note The command handlers run from the AT command driver thread and must
+ *       not call at_cmd_write, as that would lead to a deadlock. The same
+ *       applies to the batch handler when it runs from that thread.
+ *
+ * @param batch Batch of AT commands.
+ *
+ * @retval 0 If the batch was queued.
+ * @retval -EINVAL is returned if the batch or one of its commands is invalid.
+ * @retval -EHOSTDOWN is returned if the Modem library is shutdown.
+ */
+int at_cmd_batch_submit(struct at_cmd_batch *batch);
+
+/**
+ * @brief Wait for a batch of AT commands to complete.
+ *
+ * @param batch Batch of AT commands queued with @ref at_cmd_batch_submit.
+ * @param timeout Waiting period.
+ *
+ * @retval 0 If all commands of the batch were successful.
+ * @retval -EAGAIN is returned if the batch did not complete in time.
+ * @return Otherwise, the return code of the first failed command.
+ */
+int at_cmd_batch_wait(struct at_cmd_batch *batch, k_timeout_t timeout);
+
 /** @} */
 
 #ifdef __cplusplus
@@ -26,6 +26,8 @@ extern "C" {
 #include <sys/util_macro.h>
 #include <toolchain/common.h>
 
+struct at_param_list;
+
 /**
  * @brief AT monitor callback.
  *
@@ -95,6 +97,62 @@ void at_monitor_init(void);
 #define at_monitor_resume(mon) \
 	at_monitor_##mon.paused = 0
 
+/**
+ * @brief AT monitor heap statistics.
+ */
+struct at_monitor_heap_stats {
+	/** Bytes currently allocated for notifications. */
+	size_t used;
+	/** Highest number of bytes allocated for notifications. */
+	size_t max_used;
+	/** Number of notifications dropped for lack of heap space. */
+	uint32_t alloc_fail_cnt;
+};
+
+/**
+ * @brief Take a reference to a notification.
+ *
+ * By default, a notification is only valid until the monitor callback
+ * returns. A monitor can take a reference to keep the notification, instead
+ * of copying it. The notification stays valid until the reference is
+ * released with @ref at_monitor_notif_unref.
+ *
+ * @param notif The AT notification received by a monitor callback.
+ *
+ * @return The AT notification.
+ */
+const char *at_monitor_notif_ref(const char *notif);
+
+/**
+ * @brief Release a reference to a notification.
+ *
+ * @param notif The AT notification referenced with
+ *		@ref at_monitor_notif_ref.
+ */
+void at_monitor_notif_unref(const char *notif);
+
+/**
+ * @brief Get the parameters of a notification.
+ *
+ * The notification is parsed on the first call only. The parameter list is
+ * shared by all monitors receiving the notification and must not be
+ * modified. It is valid as long as the notification is.
+ *
+ * Requires @kconfig{CONFIG_AT_MONITOR_PARAMS}.
+ *
+ * @param notif The AT notification received by a monitor callback.
+ *
+ * @return The parameter list, or NULL if the notification cannot be parsed.
+ */
+const struct at_param_list *at_monitor_notif_params_get(const char *notif);
+
+/**
+ * @brief Get the AT monitor heap statistics.
+ *
+ * @param stats Statistics.
+ */
+void at_monitor_heap_stats_get(struct at_monitor_heap_stats *stats);
+
 /** @} */
 
 #ifdef __cplusplus
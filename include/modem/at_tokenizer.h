@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/**
+ * @file at_tokenizer.h
+ *
+ * @defgroup at_tokenizer AT response tokenizer
+ * @ingroup at_cmd_parser
+ * @{
+ * @brief Streaming tokenizer for AT commands, responses and notifications.
+ *
+ * The tokenizer returns the parameters of a string one by one, as views into
+ * the string. Nothing is allocated or copied until the value of a parameter
+ * is retrieved with one of the getter functions, so the string must remain
+ * valid as long as its tokens are used.
+ */
+#ifndef AT_TOKENIZER_H__
+#define AT_TOKENIZER_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <zephyr/types.h>
+
+#include <modem/at_params.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Parameter of an AT string. */
+struct at_token {
+	/** Start of the parameter in the string, without quotes or
+	 *  parentheses.
+	 */
+	const char *start;
+	/** Length of the parameter. */
+	size_t len;
+	/** Parameter type. */
+	enum at_param_type type;
+	/** Index of the parameter, as in an @ref at_param_list. */
+	size_t index;
+};
+
+/** @brief Tokenizer state. */
+struct at_tokenizer {
+	const char *cursor;
+	size_t index;
+	enum at_param_type prev_type;
+	bool string_forced;
+	bool param_expected;
+};
+
+/**
+ * @brief Start tokenizing a string.
+ *
+ * @param[out] tokenizer Tokenizer.
+ * @param[in] str AT command, response or notification as a null-terminated
+ *		  string.
+ */
+void at_tokenizer_init(struct at_tokenizer *tokenizer, const char *str);
+
+/**
+ * @brief Get the next parameter.
+ *
+ * The parameters are parsed with the same rules as
+ * @ref at_parser_max_params_from_str, except that AT+CLAC responses are not
+ * detected. The first parameter is the command or notification name.
+ *
+ * @param[in] tokenizer Tokenizer.
+ * @param[out] token Next parameter.
+ *
+ * @retval 0 If a parameter was found.
+ * @retval -ENODATA There are no more parameters in the string.
+ * @retval -EAGAIN A new notification or response line was detected. It can
+ *		   be tokenized with the string pointed to by
+ *		   @ref at_tokenizer_remaining_get.
+ * @retval -EBADMSG The parameter could not be parsed.
+ */
+int at_tokenizer_next(struct at_tokenizer *tokenizer, struct at_token *token);
+
+/**
+ * @brief Get the part of the string that has not been tokenized yet.
+ *
+ * @param[in] tokenizer Tokenizer.
+ *
+ * @return Pointer to the remainder of the string.
+ */
+const char *at_tokenizer_remaining_get(const struct at_tokenizer *tokenizer);
+
+/**
+ * @brief Get the value of an integer parameter.
+ *
+ * @param[in] token Parameter.
+ * @param[out] value Parameter value.
+ *
+ * @retval 0 If the operation was successful.
+ *           Otherwise, a (negative) error code is returned.
+ */
+int at_token_int64_get(const struct at_token *token, int64_t *value);
+
+/**
+ * @brief Get the value of an integer parameter as a 32-bit integer.
+ *
+ * @param[in] token Parameter.
+ * @param[out] value Parameter value.
+ *
+ * @retval 0 If the operation was successful.
+ * @retval -EINVAL The parameter is not an integer or is out of range.
+ */
+int at_token_int_get(const struct at_token *token, int32_t *value);
+
+/**
+ * @brief Get the value of an integer parameter as an unsigned 32-bit integer.
+ *
+ * @param[in] token Parameter.
+ * @param[out] value Parameter value.
+ *
+ * @retval 0 If the operation was successful.
+ * @retval -EINVAL The parameter is not an integer or is out of range.
+ */
+int at_token_unsigned_int_get(const struct at_token *token, uint32_t *value);
+
+/**
+ * @brief Get the value of an integer parameter as a 16-bit integer.
+ *
+ * @param[in] token Parameter.
+ * @param[out] value Parameter value.
+ *
+ * @retval 0 If the operation was successful.
+ * @retval -EINVAL The parameter is not an integer or is out of range.
+ */
+int at_token_short_get(const struct at_token *token, int16_t *value);
+
+/**
+ * @brief Get the value of an integer parameter as an unsigned 16-bit integer.
+ *
+ * @param[in] token Parameter.
+ * @param[out] value Parameter value.
+ *
+ * @retval 0 If the operation was successful.
+ * @retval -EINVAL The parameter is not an integer or is out of range.
+ */
+int at_token_unsigned_short_get(const struct at_token *token,
+				uint16_t *value);
+
+/**
+ * @brief Copy a string parameter.
+ *
+ * The string is not null-terminated.
+ *
+ * @param[in] token Parameter.
+ * @param[out] value Buffer where the string is copied.
+ * @param[in,out] len Size of the buffer as input, length of the string as
+ *		      output.
+ *
+ * @retval 0 If the operation was successful.
+ * @retval -EINVAL The parameter is not a string.
+ * @retval -ENOMEM The buffer is too small.
+ */
+int at_token_string_get(const struct at_token *token, char *value,
+			size_t *len);
+
+/**
+ * @brief Get the elements of an array parameter.
+ *
+ * @param[in] token Parameter.
+ * @param[out] array Buffer where the elements are stored.
+ * @param[in,out] len Size of the buffer in bytes as input, size of the
+ *		      elements in bytes as output.
+ *
+ * @retval 0 If the operation was successful.
+ * @retval -EINVAL The parameter is not an array.
+ * @retval -ENOMEM The buffer is too small, the elements that fit are stored.
+ */
+int at_token_array_get(const struct at_token *token, uint32_t *array,
+		       size_t *len);
+
+/**
+ * @brief Check if a string parameter is equal to a string.
+ *
+ * @param[in] token Parameter.
+ * @param[in] str Null-terminated string.
+ *
+ * @return true if the parameter is a string equal to @p str.
+ */
+bool at_token_string_equals(const struct at_token *token, const char *str);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AT_TOKENIZER_H__ */
@@ -230,6 +230,15 @@ int modem_info_json_object_encode(struct modem_param_info *modem,
 				  cJSON *root_obj);
 #endif
 
+/** @brief Invalidate the cached modem information.
+ *
+ * When @kconfig{CONFIG_MODEM_INFO_CACHE} is enabled, the next request of any
+ * information value is read from the modem. Cached network information is
+ * also invalidated automatically when a +CEREG or %XMODEMSLEEP notification
+ * is received. Without the cache, this function has no effect.
+ */
+void modem_info_cache_invalidate(void);
+
 /** @brief Obtain the modem parameters.
  *
  * The data is stored in the provided info structure.
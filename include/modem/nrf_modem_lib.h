@@ -83,6 +83,15 @@ void nrf_modem_lib_shm_tx_diagnose(void);
  */
 void nrf_modem_lib_heap_diagnose(void);
 
+/**
+ * @brief Print diagnostic information for the threads waiting on the library.
+ *
+ * Every RPC event wakes up all waiting threads. A wakeup is counted as
+ * spurious when the thread goes back to waiting on the same context without
+ * any RPC event in between.
+ */
+void nrf_modem_lib_wait_diagnose(void);
+
 /** @} */
 
 #ifdef __cplusplus
@@ -47,6 +47,9 @@ enum download_client_evt_id {
 	 * - EHOSTDOWN: host went down during download
 	 * - EBADMSG: HTTP response header not as expected
 	 * - E2BIG: HTTP response header could not fit in buffer
+	 * - ESTALE: the file changed on the server since the progress of the
+	 *   download was saved. The saved progress is deleted, and the
+	 *   download must be started again from the beginning.
 	 *
 	 * In case of errors on the socket during send() or recv() (ECONNRESET),
 	 * returning zero from the callback will let the library attempt
@@ -110,6 +113,25 @@ struct download_client_cfg {
 	bool set_tls_hostname;
 };
 
+/** Maximum length of an HTTP entity tag that is saved with the progress. */
+#define DOWNLOAD_CLIENT_ETAG_SIZE 64
+
+/**
+ * @brief Progress of a download, saved to resume it.
+ */
+struct download_client_resume_record {
+	/** Size of the file. */
+	uint32_t file_size;
+	/** Number of bytes delivered to the application. */
+	uint32_t offset;
+	/** CRC32 of the last bytes before @c offset. */
+	uint32_t tail_crc;
+	/** Number of bytes covered by @c tail_crc. */
+	uint16_t tail_len;
+	/** HTTP entity tag of the file, null-terminated, or empty. */
+	char etag[DOWNLOAD_CLIENT_ETAG_SIZE];
+};
+
 /**
  * @brief Download client asynchronous event handler.
  *
@@ -141,6 +163,10 @@ struct download_client {
 	size_t file_size;
 	/** Download progress, number of bytes downloaded. */
 	size_t progress;
+	/** Offset from where the download was started. */
+	size_t start_offset;
+	/** Uptime when the download was started, in milliseconds. */
+	int64_t start_time;
 
 	/** Server hosting the file, null-terminated. */
 	const char *host;
@@ -159,6 +185,27 @@ struct download_client {
 		bool has_header;
 		/** The server has closed the connection. */
 		bool connection_close;
+#if CONFIG_DOWNLOAD_CLIENT_HTTP_PIPELINE_DEPTH > 1
+		/** Number of range requests sent, whose response
+		 *  has not been fully received.
+		 */
+		uint8_t in_flight;
+		/** Offset of the first byte that has not been requested. */
+		size_t requested;
+		/** Payload length of the current response. */
+		size_t body_len;
+		/** Payload received for the current response. */
+		size_t body_received;
+		/** Bytes of the next response received together with
+		 *  the current fragment, stored after it in the buffer.
+		 */
+		size_t carry;
+		/** Buffer for range requests, so that requests can be sent
+		 *  while the response buffer is in use.
+		 */
+		char request[CONFIG_DOWNLOAD_CLIENT_MAX_FILENAME_SIZE +
+			     CONFIG_DOWNLOAD_CLIENT_MAX_HOSTNAME_SIZE + 128];
+#endif
 	} http;
 
 	struct {
@@ -166,6 +213,25 @@ struct download_client {
 		struct coap_block_context block_ctx;
 	} coap;
 
+#if defined(CONFIG_DOWNLOAD_CLIENT_RESUME)
+	struct {
+		/** Settings key of the download. */
+		char key[24];
+		/** Last saved progress, and expected file size and tag. */
+		struct download_client_resume_record record;
+		/** Entity tag received in the last HTTP response. */
+		char etag[DOWNLOAD_CLIENT_ETAG_SIZE];
+		/** Bytes left to download again to verify the progress. */
+		size_t verify_len;
+		/** CRC32 of the bytes verified so far. */
+		uint32_t verify_crc;
+		/** Last bytes before the current progress. */
+		uint8_t tail[CONFIG_DOWNLOAD_CLIENT_RESUME_OVERLAP];
+		/** Number of bytes in @c tail. */
+		size_t tail_len;
+	} resume;
+#endif
+
 	/** Internal thread ID. */
 	k_tid_t tid;
 	/** Internal download thread. */
@@ -222,6 +288,26 @@ int download_client_connect(struct download_client *client, const char *host,
 int download_client_start(struct download_client *client, const char *file,
 			  size_t from);
 
+/**
+ * @brief Get the offset from where a download can be resumed.
+ *
+ * Look up the progress saved for the file, on the host the client is
+ * connected to. The application must pass the offset to
+ * @ref download_client_start to resume the download. The last bytes before
+ * the offset are then downloaded again, and compared with the saved progress
+ * to detect that the file changed on the server. These bytes are not
+ * delivered to the application.
+ *
+ * @param[in]  client	Client instance.
+ * @param[in]  file	File to download, null-terminated.
+ * @param[out] offset	Offset where to resume, or zero if the download
+ *			cannot be resumed.
+ *
+ * @retval int Zero on success, a negative error code otherwise.
+ */
+int download_client_resume_offset_get(struct download_client *client,
+				      const char *file, size_t *offset);
+
 /**
  * @brief Pause the download.
  *
@@ -290,6 +290,35 @@ static inline void profiler_log_send(struct log_event_buf *buf,
 #endif
 
 
+#ifdef CONFIG_PROFILER_NORDIC_BACKEND_RAM
+/** @brief Read profiled data stored by the RAM backend.
+ *
+ * @param data Buffer for the data.
+ * @param len Size of the buffer.
+ *
+ * @return Number of bytes read.
+ */
+size_t profiler_ram_data_read(uint8_t *data, size_t len);
+
+/** @brief Read event descriptions stored by the RAM backend.
+ *
+ * @param data Buffer for the descriptions.
+ * @param len Size of the buffer.
+ *
+ * @return Number of bytes read.
+ */
+size_t profiler_ram_info_read(uint8_t *data, size_t len);
+
+/** @brief Pass a command to the profiler through the RAM backend.
+ *
+ * @param command Command as sent by the host tools.
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+int profiler_ram_command_write(uint8_t command);
+#endif
+
+
 /**
  * @}
  */
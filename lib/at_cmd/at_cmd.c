@@ -32,6 +32,7 @@ LOG_MODULE_REGISTER(at_cmd, CONFIG_AT_CMD_LOG_LEVEL);
 enum at_cmd_flags {
 	AT_CMD_BUF_CMD = 1 << 0,	/* Command is buffered by at_cmd */
 	AT_CMD_SYNC = 1 << 1,		/* Command is synchronous */
+	AT_CMD_BATCH = 1 << 2,		/* Command is part of a batch */
 };
 
 /* Metadata for a queued AT command */
@@ -41,6 +42,7 @@ struct cmd_item  {
 	at_cmd_handler_t callback;	/* Callback to execute on result */
 	size_t resp_size;		/* Size of response buffer */
 	enum at_cmd_flags flags;	/* Flags describing the request */
+	struct at_cmd_batch *batch;	/* Batch of the command, if any */
 };
 
 /* Metadata for an AT response */
@@ -65,6 +67,12 @@ static K_MUTEX_DEFINE(at_cmd_init_mutex);
 static struct cmd_item current_cmd;
 K_MUTEX_DEFINE(current_cmd_mutex);
 
+/* Batch whose commands are being written, guarded by current_cmd_mutex.
+ * A batch is queued as a single command item. Once dequeued, its commands
+ * are loaded one after another before any other queued command.
+ */
+static struct at_cmd_batch *active_batch;
+
 /* Queue for queued command metadata */
 K_MSGQ_DEFINE(commands, sizeof(struct cmd_item), CONFIG_AT_CMD_QUEUE_LEN, 4);
 
@@ -186,6 +194,92 @@ static void complete_cmd(void)
 	k_mutex_unlock(&current_cmd_mutex);
 }
 
+/* Store the result of the current batch command. Returns the batch if it was
+ * its last command, so that the caller completes it with batch_complete().
+ */
+static struct at_cmd_batch *batch_cmd_done(const struct resp_item *resp)
+{
+	struct at_cmd_batch *batch;
+	struct at_cmd_batch_cmd *batch_cmd;
+	bool done = false;
+
+	k_mutex_lock(&current_cmd_mutex, K_FOREVER);
+
+	batch = current_cmd.batch;
+	batch_cmd = &batch->cmds[batch->next];
+
+	batch_cmd->code = resp->code;
+	batch_cmd->state = resp->state;
+	batch->next++;
+
+	if (resp->code != 0) {
+		if (batch->err == 0) {
+			batch->err = resp->code;
+		}
+
+		if (batch->stop_on_error) {
+			for (; batch->next < batch->cmd_cnt; batch->next++) {
+				batch->cmds[batch->next].code = -ECANCELED;
+				batch->cmds[batch->next].state =
+					AT_CMD_ERROR_QUEUE;
+			}
+		}
+	}
+
+	if (batch->next == batch->cmd_cnt) {
+		active_batch = NULL;
+		done = true;
+	}
+
+	k_mutex_unlock(&current_cmd_mutex);
+
+	return done ? batch : NULL;
+}
+
+/* Notify the completion of a batch. Must be called without current_cmd_mutex
+ * held, so that the handler can write AT commands.
+ */
+static void batch_complete(struct at_cmd_batch *batch)
+{
+	if (batch->handler != NULL) {
+		batch->handler(batch);
+	}
+	k_sem_give(&batch->done);
+}
+
+/*
+ * Load the next command of the active batch or, if there is none, the next
+ * queued command. Must be called with current_cmd_mutex held.
+ */
+static int load_cmd(void)
+{
+	struct at_cmd_batch_cmd *batch_cmd;
+
+	if (active_batch == NULL) {
+		if (k_msgq_get(&commands, &current_cmd, K_NO_WAIT) != 0) {
+			return -ENOENT;
+		}
+
+		if (!(current_cmd.flags & AT_CMD_BATCH)) {
+			return 0;
+		}
+
+		active_batch = current_cmd.batch;
+	}
+
+	batch_cmd = &active_batch->cmds[active_batch->next];
+
+	/* This cast is safe; we do not free cmd without AT_CMD_BUF_CMD */
+	current_cmd.cmd = (char *)batch_cmd->cmd;
+	current_cmd.resp = batch_cmd->resp;
+	current_cmd.resp_size = batch_cmd->resp_size;
+	current_cmd.callback = batch_cmd->handler;
+	current_cmd.flags = AT_CMD_BATCH;
+	current_cmd.batch = active_batch;
+
+	return 0;
+}
+
 /*
  * Atomically load a new command if appropriate, then write it to the socket.
  * The operations are repeated until the queue is empty or a command is pending
@@ -196,34 +290,47 @@ static void load_cmd_and_write(void)
 {
 	int ret;
 	struct resp_item resp;
+	struct at_cmd_batch *done_batch;
 
-	k_mutex_lock(&current_cmd_mutex, K_FOREVER);
 	do {
-		ret = 0;
+		done_batch = NULL;
 
-		/* Do not load a new command if already loaded or none queued */
-		if (current_cmd.cmd != NULL ||
-		    k_msgq_get(&commands, &current_cmd, K_NO_WAIT) != 0) {
-			break;
-		}
+		k_mutex_lock(&current_cmd_mutex, K_FOREVER);
+		do {
+			ret = 0;
 
-		ret = at_write(current_cmd.cmd);
+			/* Skip if a command is loaded or none is queued */
+			if (current_cmd.cmd != NULL || load_cmd() != 0) {
+				break;
+			}
 
-		if (current_cmd.flags & AT_CMD_BUF_CMD) {
-			k_free(current_cmd.cmd);
-		}
+			ret = at_write(current_cmd.cmd);
 
-		/* If write failed, make an error response and complete cmd */
-		if (ret != 0) {
-			resp.state = AT_CMD_ERROR_WRITE;
-			resp.code = ret;
-			if (current_cmd.flags & AT_CMD_SYNC) {
-				k_msgq_put(&response_sync, &resp, K_FOREVER);
+			if (current_cmd.flags & AT_CMD_BUF_CMD) {
+				k_free(current_cmd.cmd);
 			}
-			complete_cmd();
+
+			/* If write failed, make an error response */
+			if (ret != 0) {
+				resp.state = AT_CMD_ERROR_WRITE;
+				resp.code = ret;
+				if (current_cmd.flags & AT_CMD_SYNC) {
+					k_msgq_put(&response_sync, &resp,
+						   K_FOREVER);
+				}
+				if (current_cmd.flags & AT_CMD_BATCH) {
+					done_batch = batch_cmd_done(&resp);
+				}
+				complete_cmd();
+			}
+		} while (ret != 0 && done_batch == NULL);
+		k_mutex_unlock(&current_cmd_mutex);
+
+		/* Complete a failed batch before writing the next command */
+		if (done_batch != NULL) {
+			batch_complete(done_batch);
 		}
-	} while (ret != 0);
-	k_mutex_unlock(&current_cmd_mutex);
+	} while (done_batch != NULL);
 }
 
 static void socket_thread_fn(void *arg1, void *arg2, void *arg3)
@@ -232,6 +339,7 @@ static void socket_thread_fn(void *arg1, void *arg2, void *arg3)
 	static size_t payload_len;
 	static struct resp_item ret;
 	static char buf[CONFIG_AT_CMD_RESPONSE_MAX_LEN];
+	struct at_cmd_batch *done_batch;
 
 	ARG_UNUSED(arg1);
 	ARG_UNUSED(arg2);
@@ -332,10 +440,22 @@ next:
 			k_msgq_put(&response_sync, &ret, K_FOREVER);
 		}
 
+		/* Store the result of a batch command */
+		done_batch = NULL;
+		if (current_cmd.cmd != NULL &&
+		    current_cmd.flags & AT_CMD_BATCH &&
+		    ret.state != AT_CMD_NOTIFICATION) {
+			done_batch = batch_cmd_done(&ret);
+		}
+
 		/* We have now handled a command if it was not a notification */
 		if (ret.state != AT_CMD_NOTIFICATION) {
 			complete_cmd();
 		}
+
+		if (done_batch != NULL) {
+			batch_complete(done_batch);
+		}
 	}
 }
 
@@ -368,6 +488,7 @@ int at_cmd_write_with_callback(const char *const cmd,
 	command.resp = NULL;
 	command.callback = handler;
 	command.flags = AT_CMD_BUF_CMD;
+	command.batch = NULL;
 
 	ret = k_msgq_put(&commands, &command, K_FOREVER);
 	if (ret) {
@@ -415,6 +536,7 @@ int at_cmd_write(const char *const cmd,
 	command.resp_size = buf_len;
 	command.callback = NULL;
 	command.flags = AT_CMD_SYNC;
+	command.batch = NULL;
 
 	/* Ensure we get our own AT response, not an old one */
 	k_mutex_lock(&response_sync_get, K_FOREVER);
@@ -442,6 +564,59 @@ int at_cmd_write(const char *const cmd,
 	return ret.code;
 }
 
+int at_cmd_batch_submit(struct at_cmd_batch *batch)
+{
+	struct cmd_item command = {
+		.batch = batch,
+		.flags = AT_CMD_BATCH,
+	};
+	int ret;
+
+	if (atomic_get(&shutdown_mode) == 1) {
+		return -EHOSTDOWN;
+	}
+
+	if (batch == NULL || batch->cmds == NULL || batch->cmd_cnt == 0) {
+		LOG_ERR("Invalid batch");
+		return -EINVAL;
+	}
+
+	for (size_t i = 0; i < batch->cmd_cnt; i++) {
+		if (check_cmd(batch->cmds[i].cmd)) {
+			LOG_ERR("Invalid command at index %zu", i);
+			return -EINVAL;
+		}
+	}
+
+	batch->next = 0;
+	batch->err = 0;
+	k_sem_init(&batch->done, 0, 1);
+
+	ret = k_msgq_put(&commands, &command, K_FOREVER);
+	if (ret) {
+		LOG_ERR("Could not enqueue batch, error %d", ret);
+		return ret;
+	}
+
+	load_cmd_and_write();
+	return 0;
+}
+
+int at_cmd_batch_wait(struct at_cmd_batch *batch, k_timeout_t timeout)
+{
+	__ASSERT(k_current_get() != socket_tid,
+		 "at_cmd deadlock: socket thread blocking self\n");
+
+	if (k_sem_take(&batch->done, timeout) != 0) {
+		return -EAGAIN;
+	}
+
+	/* Let later calls return immediately */
+	k_sem_give(&batch->done);
+
+	return batch->err;
+}
+
 void at_cmd_set_notification_handler(at_cmd_handler_t handler)
 {
 	LOG_DBG("Setting notification handler to %p", handler);
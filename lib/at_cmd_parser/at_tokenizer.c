@@ -0,0 +1,424 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <ctype.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zephyr.h>
+#include <zephyr/types.h>
+
+#include <modem/at_tokenizer.h>
+#include "at_utils.h"
+
+static const char *skip_lfcr(const char *str)
+{
+	while (is_lfcr(*str)) {
+		str++;
+	}
+
+	return str;
+}
+
+static void token_set(struct at_token *token, enum at_param_type type,
+		      const char *start, const char *end)
+{
+	token->type = type;
+	token->start = start;
+	token->len = end - start;
+}
+
+/* First parameter, the command or notification name. */
+static int name_token_get(struct at_tokenizer *tokenizer, const char **str,
+			  struct at_token *token)
+{
+	const char *start = *str;
+	const char *end;
+
+	if (is_terminated(*start)) {
+		return -ENODATA;
+	}
+
+	end = start;
+
+	if (is_notification(*start)) {
+		end++;
+		while (is_valid_notification_char(*end)) {
+			end++;
+		}
+
+		tokenizer->string_forced =
+			check_response_for_forced_string(start);
+		token_set(token, AT_PARAM_TYPE_STRING, start, end);
+	} else if (is_command(start)) {
+		skip_command_prefix(&end);
+		while (is_valid_command_char(*end)) {
+			end++;
+		}
+
+		token_set(token, AT_PARAM_TYPE_STRING, start, end);
+
+		/* Skip read/test special characters. */
+		if ((*end == AT_CMD_SEPARATOR) &&
+		    (*(end + 1) == AT_CMD_READ_TEST_IDENTIFIER)) {
+			end += 2;
+		} else if (*end == AT_CMD_READ_TEST_IDENTIFIER) {
+			end++;
+		}
+	} else {
+		/* Without a name, the whole line is one string. */
+		while (!is_lfcr(*end) && !is_terminated(*end)) {
+			end++;
+		}
+
+		token_set(token, AT_PARAM_TYPE_STRING, start, end);
+	}
+
+	*str = end;
+	return 0;
+}
+
+/* End of the line, or SMS PDU data following a number on the next line. */
+static int line_end_token_get(struct at_tokenizer *tokenizer,
+			      const char **str, struct at_token *token)
+{
+	const char *start = *str;
+	const char *end;
+
+	if (tokenizer->param_expected) {
+		/* Empty parameter between a separator and the line end. */
+		token_set(token, AT_PARAM_TYPE_EMPTY, start, start);
+		return 0;
+	}
+
+	start = skip_lfcr(start);
+
+	if ((start != *str) &&
+	    (tokenizer->prev_type == AT_PARAM_TYPE_NUM_INT) &&
+	    isxdigit((int)*start)) {
+		end = start;
+		while (isxdigit((int)*end)) {
+			end++;
+		}
+
+		token_set(token, AT_PARAM_TYPE_STRING, start, end);
+		*str = end;
+		return 0;
+	}
+
+	*str = start;
+
+	return is_terminated(*start) ? -ENODATA : -EAGAIN;
+}
+
+static int param_token_get(struct at_tokenizer *tokenizer, const char **str,
+			   struct at_token *token)
+{
+	const char *start = *str;
+	const char *end;
+
+	if (*start == ' ') {
+		start++;
+	}
+
+	end = start;
+
+	if (is_lfcr(*start) || is_terminated(*start)) {
+		*str = start;
+		return line_end_token_get(tokenizer, str, token);
+	}
+
+	if (tokenizer->string_forced) {
+		while (!is_lfcr(*end) && !is_terminated(*end)) {
+			end++;
+		}
+
+		token_set(token, AT_PARAM_TYPE_STRING, start, end);
+	} else if (is_separator(*start)) {
+		token_set(token, AT_PARAM_TYPE_EMPTY, start, start);
+	} else if (is_notification(*start)) {
+		/* Next notification on the same line. */
+		*str = start;
+		return -EAGAIN;
+	} else if (is_number(*start)) {
+		char *next;
+
+		(void)strtoll(start, &next, 10);
+		if (next == start) {
+			*str = start;
+			return -EBADMSG;
+		}
+
+		end = next;
+		token_set(token, AT_PARAM_TYPE_NUM_INT, start, end);
+	} else if (is_dblquote(*start)) {
+		start++;
+		end = start;
+		while (!is_dblquote(*end) && !is_terminated(*end)) {
+			end++;
+		}
+
+		token_set(token, AT_PARAM_TYPE_STRING, start, end);
+
+		if (is_dblquote(*end)) {
+			end++;
+		}
+	} else if (is_array_start(*start)) {
+		start++;
+		end = start;
+		while (!is_array_stop(*end) && !is_terminated(*end)) {
+			end++;
+		}
+
+		token_set(token, AT_PARAM_TYPE_ARRAY, start, end);
+
+		if (is_array_stop(*end)) {
+			end++;
+		}
+	} else {
+		*str = start;
+		return -EBADMSG;
+	}
+
+	*str = end;
+	return 0;
+}
+
+void at_tokenizer_init(struct at_tokenizer *tokenizer, const char *str)
+{
+	__ASSERT_NO_MSG(tokenizer);
+	__ASSERT_NO_MSG(str);
+
+	tokenizer->cursor = str;
+	tokenizer->index = 0;
+	tokenizer->prev_type = AT_PARAM_TYPE_INVALID;
+	tokenizer->string_forced = false;
+	tokenizer->param_expected = false;
+}
+
+int at_tokenizer_next(struct at_tokenizer *tokenizer, struct at_token *token)
+{
+	const char *str;
+	int err;
+
+	if (tokenizer == NULL || token == NULL) {
+		return -EINVAL;
+	}
+
+	str = tokenizer->cursor;
+
+	if (tokenizer->index == 0) {
+		err = name_token_get(tokenizer, &str, token);
+	} else {
+		err = param_token_get(tokenizer, &str, token);
+	}
+
+	if (err) {
+		tokenizer->cursor = str;
+		return err;
+	}
+
+	token->index = tokenizer->index++;
+	tokenizer->prev_type = token->type;
+
+	/* A parameter always follows a separator, even if it is empty. */
+	tokenizer->param_expected = is_separator(*str);
+	if (tokenizer->param_expected) {
+		str++;
+	}
+
+	tokenizer->cursor = str;
+
+	return 0;
+}
+
+const char *at_tokenizer_remaining_get(const struct at_tokenizer *tokenizer)
+{
+	return tokenizer->cursor;
+}
+
+int at_token_int64_get(const struct at_token *token, int64_t *value)
+{
+	if (token == NULL || value == NULL) {
+		return -EINVAL;
+	}
+
+	if (token->type != AT_PARAM_TYPE_NUM_INT) {
+		return -EINVAL;
+	}
+
+	/* The token ends with the first character that is not a digit. */
+	*value = (int64_t)strtoll(token->start, NULL, 10);
+
+	return 0;
+}
+
+static int int_range_get(const struct at_token *token, int64_t min,
+			 int64_t max, int64_t *value)
+{
+	int err = at_token_int64_get(token, value);
+
+	if (err) {
+		return err;
+	}
+
+	if ((*value > max) || (*value < min)) {
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+int at_token_int_get(const struct at_token *token, int32_t *value)
+{
+	int64_t tmp;
+	int err;
+
+	if (value == NULL) {
+		return -EINVAL;
+	}
+
+	err = int_range_get(token, INT32_MIN, INT32_MAX, &tmp);
+	if (err) {
+		return err;
+	}
+
+	*value = (int32_t)tmp;
+	return 0;
+}
+
+int at_token_unsigned_int_get(const struct at_token *token, uint32_t *value)
+{
+	int64_t tmp;
+	int err;
+
+	if (value == NULL) {
+		return -EINVAL;
+	}
+
+	err = int_range_get(token, 0, UINT32_MAX, &tmp);
+	if (err) {
+		return err;
+	}
+
+	*value = (uint32_t)tmp;
+	return 0;
+}
+
+int at_token_short_get(const struct at_token *token, int16_t *value)
+{
+	int64_t tmp;
+	int err;
+
+	if (value == NULL) {
+		return -EINVAL;
+	}
+
+	err = int_range_get(token, INT16_MIN, INT16_MAX, &tmp);
+	if (err) {
+		return err;
+	}
+
+	*value = (int16_t)tmp;
+	return 0;
+}
+
+int at_token_unsigned_short_get(const struct at_token *token,
+				uint16_t *value)
+{
+	int64_t tmp;
+	int err;
+
+	if (value == NULL) {
+		return -EINVAL;
+	}
+
+	err = int_range_get(token, 0, UINT16_MAX, &tmp);
+	if (err) {
+		return err;
+	}
+
+	*value = (uint16_t)tmp;
+	return 0;
+}
+
+int at_token_string_get(const struct at_token *token, char *value,
+			size_t *len)
+{
+	if (token == NULL || value == NULL || len == NULL) {
+		return -EINVAL;
+	}
+
+	if (token->type != AT_PARAM_TYPE_STRING) {
+		return -EINVAL;
+	}
+
+	if (*len < token->len) {
+		return -ENOMEM;
+	}
+
+	memcpy(value, token->start, token->len);
+	*len = token->len;
+
+	return 0;
+}
+
+int at_token_array_get(const struct at_token *token, uint32_t *array,
+		       size_t *len)
+{
+	const char *str;
+	const char *end;
+	size_t cnt = 0;
+
+	if (token == NULL || array == NULL || len == NULL) {
+		return -EINVAL;
+	}
+
+	if (token->type != AT_PARAM_TYPE_ARRAY) {
+		return -EINVAL;
+	}
+
+	str = token->start;
+	end = token->start + token->len;
+
+	while (str < end) {
+		char *next;
+		uint32_t value = (uint32_t)strtoul(str, &next, 10);
+
+		if (next == str) {
+			break;
+		}
+
+		if ((cnt + 1) * sizeof(uint32_t) > *len) {
+			*len = cnt * sizeof(uint32_t);
+			return -ENOMEM;
+		}
+
+		array[cnt++] = value;
+		str = next;
+
+		if (is_separator(*str)) {
+			str++;
+		}
+	}
+
+	*len = cnt * sizeof(uint32_t);
+
+	return 0;
+}
+
+bool at_token_string_equals(const struct at_token *token, const char *str)
+{
+	if (token == NULL || str == NULL) {
+		return false;
+	}
+
+	return (token->type == AT_PARAM_TYPE_STRING) &&
+	       (strlen(str) == token->len) &&
+	       !memcmp(token->start, str, token->len);
+}
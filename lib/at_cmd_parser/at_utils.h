@@ -19,6 +19,7 @@
 #include <zephyr/types.h>
 #include <stddef.h>
 #include <ctype.h>
+#include <string.h>
 
 #define AT_PARAM_SEPARATOR ','
 #define AT_RSP_SEPARATOR ':'
@@ -30,6 +31,13 @@
 #define AT_PROP_NOTIFICATION_PREFX '%'
 #define AT_CUSTOM_COMMAND_PREFX '#'
 
+#define AT_CMD_CGEV_LEN         5
+#define AT_CMD_CPIN_LEN         5
+#define AT_CMD_SHORTSWVER_LEN   11
+#define AT_CMD_HWVERSION_LEN    10
+#define AT_CMD_XMODEMUUID_LEN   11
+#define AT_CMD_XICCID_LEN       7
+
 /**
  * @brief Check if character is a notification start character
  *
@@ -261,6 +269,46 @@ static inline bool is_command(const char *str)
 	return false;
 }
 
+/**
+ * @brief Skip the "AT" prefix of a command and the character following it
+ *
+ * @param[in,out] cmd Pointer to the command
+ */
+static inline void skip_command_prefix(const char **cmd)
+{
+	*cmd += sizeof("AT") - 1;
+
+	if (is_lfcr(**cmd) || is_terminated(**cmd)) {
+		return;
+	}
+
+	(*cmd)++;
+}
+
+/**
+ * @brief Check if the parameters of a response must be parsed as strings
+ *
+ * @param[in] str Response, starting with the notification ID
+ *
+ * @retval true  If the parameters are strings
+ * @retval false Otherwise
+ */
+static inline bool check_response_for_forced_string(const char *str)
+{
+	bool retval = false;
+
+	if (!strncmp(str, "+CGEV", AT_CMD_CGEV_LEN) ||
+	    !strncmp(str, "+CPIN", AT_CMD_CPIN_LEN) ||
+	    !strncmp(str, "%SHORTSWVER", AT_CMD_SHORTSWVER_LEN) ||
+	    !strncmp(str, "%HWVERSION", AT_CMD_HWVERSION_LEN) ||
+	    !strncmp(str, "%XMODEMUUID", AT_CMD_XMODEMUUID_LEN) ||
+	    !strncmp(str, "%XICCID", AT_CMD_XICCID_LEN)) {
+			retval = true;
+	}
+
+	return retval;
+}
+
 /**
  * @brief Check if a string is a beginning of an AT CLAC response
  *
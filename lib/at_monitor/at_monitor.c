@@ -10,6 +10,10 @@
 #include <device.h>
 #include <nrf_modem_at.h>
 #include <modem/at_monitor.h>
+#if defined(CONFIG_AT_MONITOR_PARAMS)
+#include <modem/at_cmd_parser.h>
+#include <modem/at_params.h>
+#endif
 #include <toolchain/common.h>
 #include <logging/log.h>
 
@@ -17,29 +21,249 @@ LOG_MODULE_REGISTER(at_monitor);
 
 struct at_notif_fifo {
 	void *fifo_reserved;
+	/* Number of references, the dispatcher holds one. */
+	atomic_t refcnt;
+	/* Bytes allocated on the heap. */
+	size_t size;
+#if defined(CONFIG_AT_MONITOR_PARAMS)
+	struct at_param_list params;
+	int params_err;
+	bool params_parsed;
+#endif
 	char data[];
 };
 
+#define AT_NOTIF(_notif) CONTAINER_OF(_notif, struct at_notif_fifo, data)
+
 static void at_monitor_task(struct k_work *work);
 
 static K_FIFO_DEFINE(at_monitor_fifo);
 static K_HEAP_DEFINE(at_monitor_heap, CONFIG_AT_MONITOR_HEAP_SIZE);
 static K_WORK_DEFINE(at_monitor_work, at_monitor_task);
 
+static struct at_monitor_heap_stats heap_stats;
+static struct k_spinlock heap_stats_lock;
+
+#if defined(CONFIG_AT_MONITOR_PARAMS)
+/* Serializes parsing of notifications held by monitors. */
+static K_MUTEX_DEFINE(params_mutex);
+#endif
+
+#if defined(CONFIG_AT_MONITOR_TRIE)
+/* Monitor filters are stored in a prefix trie built at initialization.
+ * A notification is matched by walking the trie along the notification,
+ * from its first character and, if the notification starts with '+' or '%',
+ * from its second character. Every filter that ends on the walked path
+ * matches. Matching monitors are collected in a bitmask, so that they are
+ * notified in the same order as without the trie.
+ */
+#define TRIE_NODE_CNT	CONFIG_AT_MONITOR_TRIE_NODES
+#define MONITOR_CNT_MAX	CONFIG_AT_MONITOR_TRIE_MAX_MONITORS
+#define MASK_WORDS	DIV_ROUND_UP(MONITOR_CNT_MAX, 32)
+#define NO_IDX		UINT8_MAX
+
+BUILD_ASSERT(TRIE_NODE_CNT < NO_IDX);
+BUILD_ASSERT(MONITOR_CNT_MAX < NO_IDX);
+
+struct trie_node {
+	char c;
+	uint8_t child;
+	uint8_t sibling;
+	/* First monitor whose filter ends in this node. */
+	uint8_t monitor;
+};
+
+/* Root is node 0. */
+static struct trie_node trie[TRIE_NODE_CNT];
+static size_t trie_node_cnt;
+/* Next monitor with the same filter. */
+static uint8_t monitor_next[MONITOR_CNT_MAX];
+/* Monitors matching any notification. */
+static uint32_t any_monitors[MASK_WORDS];
+static bool trie_ready;
+
+static uint8_t trie_child_get(uint8_t node, char c)
+{
+	for (uint8_t i = trie[node].child; i != NO_IDX; i = trie[i].sibling) {
+		if (trie[i].c == c) {
+			return i;
+		}
+	}
+
+	return NO_IDX;
+}
+
+static uint8_t trie_child_add(uint8_t node, char c)
+{
+	uint8_t child = trie_child_get(node, c);
+
+	if (child != NO_IDX) {
+		return child;
+	}
+
+	if (trie_node_cnt >= ARRAY_SIZE(trie)) {
+		return NO_IDX;
+	}
+
+	child = trie_node_cnt++;
+	trie[child] = (struct trie_node) {
+		.c = c,
+		.child = NO_IDX,
+		.sibling = trie[node].child,
+		.monitor = NO_IDX,
+	};
+	trie[node].child = child;
+
+	return child;
+}
+
+static int trie_build(void)
+{
+	size_t monitor_idx = 0;
+
+	trie_node_cnt = 1;
+	trie[0] = (struct trie_node) {
+		.child = NO_IDX,
+		.sibling = NO_IDX,
+		.monitor = NO_IDX,
+	};
+
+	Z_STRUCT_SECTION_FOREACH(at_monitor_entry, e) {
+		if (monitor_idx >= MONITOR_CNT_MAX) {
+			LOG_ERR("Too many AT monitors, increase "
+				"CONFIG_AT_MONITOR_TRIE_MAX_MONITORS");
+			return -ENOMEM;
+		}
+
+		if ((e->filter == ANY) || (e->filter[0] == '\0')) {
+			any_monitors[monitor_idx / 32] |= BIT(monitor_idx % 32);
+			monitor_idx++;
+			continue;
+		}
+
+		uint8_t node = 0;
+
+		for (const char *c = e->filter; *c != '\0'; c++) {
+			node = trie_child_add(node, *c);
+			if (node == NO_IDX) {
+				LOG_ERR("AT monitor filters do not fit in the "
+					"trie, increase "
+					"CONFIG_AT_MONITOR_TRIE_NODES");
+				return -ENOMEM;
+			}
+		}
+
+		monitor_next[monitor_idx] = trie[node].monitor;
+		trie[node].monitor = monitor_idx;
+		monitor_idx++;
+	}
+
+	LOG_DBG("AT monitor trie uses %zu of %zu nodes", trie_node_cnt,
+		ARRAY_SIZE(trie));
+
+	return 0;
+}
+
+static void trie_match(const char *notif, uint32_t *matched)
+{
+	uint8_t node = 0;
+
+	for (const char *c = notif; *c != '\0'; c++) {
+		node = trie_child_get(node, *c);
+		if (node == NO_IDX) {
+			break;
+		}
+
+		for (uint8_t m = trie[node].monitor; m != NO_IDX;
+		     m = monitor_next[m]) {
+			matched[m / 32] |= BIT(m % 32);
+		}
+	}
+}
+
+static void at_monitor_notify(const char *notif)
+{
+	uint32_t matched[MASK_WORDS];
+	size_t monitor_idx = 0;
+
+	memcpy(matched, any_monitors, sizeof(matched));
+
+	trie_match(notif, matched);
+	if ((notif[0] == '+') || (notif[0] == '%')) {
+		trie_match(notif + 1, matched);
+	}
+
+	Z_STRUCT_SECTION_FOREACH(at_monitor_entry, e) {
+		if (!e->paused &&
+		    (matched[monitor_idx / 32] & BIT(monitor_idx % 32))) {
+			LOG_DBG("Dispatching to %p", e->handler);
+			e->handler(notif);
+		}
+		monitor_idx++;
+	}
+}
+#endif /* CONFIG_AT_MONITOR_TRIE */
+
+static void at_monitor_notify_all(const char *notif)
+{
+	Z_STRUCT_SECTION_FOREACH(at_monitor_entry, e) {
+		if (!e->paused &&
+		   (e->filter == ANY || strstr(notif, e->filter))) {
+			LOG_DBG("Dispatching to %p", e->handler);
+			e->handler(notif);
+		}
+	}
+}
+
+static void at_notif_free(struct at_notif_fifo *at_notif)
+{
+	size_t size = at_notif->size;
+	k_spinlock_key_t key;
+
+#if defined(CONFIG_AT_MONITOR_PARAMS)
+	if (at_notif->params_parsed && !at_notif->params_err) {
+		at_params_list_free(&at_notif->params);
+	}
+#endif
+
+	k_heap_free(&at_monitor_heap, at_notif);
+
+	key = k_spin_lock(&heap_stats_lock);
+	heap_stats.used -= size;
+	k_spin_unlock(&heap_stats_lock, key);
+}
+
 static void at_monitor_dispatch(const char *notif)
 {
 	struct at_notif_fifo *at_notif;
 	size_t sz_needed;
 
+	k_spinlock_key_t key;
+
 	sz_needed = sizeof(struct at_notif_fifo) + strlen(notif) + sizeof(char);
 
 	at_notif = k_heap_alloc(&at_monitor_heap, sz_needed, K_NO_WAIT);
+
+	key = k_spin_lock(&heap_stats_lock);
+	if (at_notif) {
+		heap_stats.used += sz_needed;
+		heap_stats.max_used = MAX(heap_stats.max_used, heap_stats.used);
+	} else {
+		heap_stats.alloc_fail_cnt++;
+	}
+	k_spin_unlock(&heap_stats_lock, key);
+
 	if (!at_notif) {
 		LOG_WRN("No heap space for incoming notification: %s",
 			log_strdup(notif));
 		return;
 	}
 
+	atomic_set(&at_notif->refcnt, 1);
+	at_notif->size = sz_needed;
+#if defined(CONFIG_AT_MONITOR_PARAMS)
+	at_notif->params_parsed = false;
+#endif
 	strcpy(at_notif->data, notif);
 
 	k_fifo_put(&at_monitor_fifo, at_notif);
@@ -53,14 +277,16 @@ static void at_monitor_task(struct k_work *work)
 	while ((at_notif = k_fifo_get(&at_monitor_fifo, K_NO_WAIT))) {
 		/* Match notification with all monitors */
 		LOG_DBG("AT notif: %s", at_notif->data);
-		Z_STRUCT_SECTION_FOREACH(at_monitor_entry, e) {
-			if (!e->paused &&
-			   (e->filter == ANY || strstr(at_notif->data, e->filter))) {
-				LOG_DBG("Dispatching to %p", e->handler);
-				e->handler(at_notif->data);
-			}
+#if defined(CONFIG_AT_MONITOR_TRIE)
+		if (trie_ready) {
+			at_monitor_notify(at_notif->data);
+		} else {
+			at_monitor_notify_all(at_notif->data);
 		}
-		k_heap_free(&at_monitor_heap, at_notif);
+#else
+		at_monitor_notify_all(at_notif->data);
+#endif
+		at_monitor_notif_unref(at_notif->data);
 	}
 }
 
@@ -68,6 +294,15 @@ static int at_monitor_sys_init(const struct device *unused)
 {
 	int err;
 
+#if defined(CONFIG_AT_MONITOR_TRIE)
+	if (!trie_ready) {
+		/* Fall back to matching every filter if the trie is too
+		 * small.
+		 */
+		trie_ready = (trie_build() == 0);
+	}
+#endif
+
 	err = nrf_modem_at_notif_handler_set(at_monitor_dispatch);
 	if (err) {
 		LOG_ERR("Failed to hook the dispatch function, err %d", err);
@@ -85,3 +320,86 @@ void at_monitor_init(void)
 {
 	at_monitor_sys_init(NULL);
 }
+
+const char *at_monitor_notif_ref(const char *notif)
+{
+	__ASSERT_NO_MSG(notif);
+
+	atomic_inc(&AT_NOTIF(notif)->refcnt);
+
+	return notif;
+}
+
+void at_monitor_notif_unref(const char *notif)
+{
+	struct at_notif_fifo *at_notif = AT_NOTIF(notif);
+
+	__ASSERT_NO_MSG(notif);
+	__ASSERT_NO_MSG(atomic_get(&at_notif->refcnt) > 0);
+
+	if (atomic_dec(&at_notif->refcnt) == 1) {
+		at_notif_free(at_notif);
+	}
+}
+
+#if defined(CONFIG_AT_MONITOR_PARAMS)
+static int notif_params_parse(struct at_notif_fifo *at_notif)
+{
+	/* Every parameter, except the last one, is followed by a comma.
+	 * The command name is an additional parameter.
+	 */
+	size_t max_params = 2;
+	int err;
+
+	for (const char *c = at_notif->data; *c != '\0'; c++) {
+		if (*c == ',') {
+			max_params++;
+		}
+	}
+
+	err = at_params_list_init(&at_notif->params, max_params);
+	if (err) {
+		return err;
+	}
+
+	err = at_parser_params_from_str(at_notif->data, NULL,
+					&at_notif->params);
+	if (err) {
+		at_params_list_free(&at_notif->params);
+	}
+
+	return err;
+}
+
+const struct at_param_list *at_monitor_notif_params_get(const char *notif)
+{
+	struct at_notif_fifo *at_notif = AT_NOTIF(notif);
+
+	__ASSERT_NO_MSG(notif);
+
+	k_mutex_lock(&params_mutex, K_FOREVER);
+
+	if (!at_notif->params_parsed) {
+		at_notif->params_err = notif_params_parse(at_notif);
+		at_notif->params_parsed = true;
+
+		if (at_notif->params_err) {
+			LOG_WRN("Cannot parse notification, err %d",
+				at_notif->params_err);
+		}
+	}
+
+	k_mutex_unlock(&params_mutex);
+
+	return at_notif->params_err ? NULL : &at_notif->params;
+}
+#endif /* CONFIG_AT_MONITOR_PARAMS */
+
+void at_monitor_heap_stats_get(struct at_monitor_heap_stats *stats)
+{
+	k_spinlock_key_t key = k_spin_lock(&heap_stats_lock);
+
+	*stats = heap_stats;
+
+	k_spin_unlock(&heap_stats_lock, key);
+}
@@ -493,50 +493,81 @@ static void at_handler(void *context, const char *response)
 static int enable_notifications(void)
 {
 	int err;
-	char buf_sub[35];
+	char xt3412_sub[35];
+	char xmodemsleep_sub[35];
+	struct at_cmd_batch_cmd cmds[4] = { 0 };
+	struct at_cmd_batch batch = { .cmds = cmds };
+	struct at_cmd_batch_cmd *cereg_cmd;
+	struct at_cmd_batch_cmd *xt3412_cmd = NULL;
+	struct at_cmd_batch_cmd *xmodemsleep_cmd = NULL;
+	struct at_cmd_batch_cmd *cscon_cmd;
 
 	/* +CEREG notifications, level 5 */
-	err = at_cmd_write(cereg_5_subscribe, NULL, 0, NULL);
-	if (err) {
-		LOG_ERR("Failed to subscribe to CEREG notifications");
-		return err;
-	}
+	cereg_cmd = &cmds[batch.cmd_cnt++];
+	cereg_cmd->cmd = cereg_5_subscribe;
 
 	if (IS_ENABLED(CONFIG_LTE_LC_TAU_PRE_WARNING_NOTIFICATIONS)) {
-		snprintk(buf_sub,
-			 sizeof(buf_sub),
+		snprintk(xt3412_sub,
+			 sizeof(xt3412_sub),
 			 AT_XT3412_SUB,
 			 CONFIG_LTE_LC_TAU_PRE_WARNING_TIME_MS,
 			 CONFIG_LTE_LC_TAU_PRE_WARNING_THRESHOLD_MS);
 
 		/* %XT3412 notifications subscribe */
-		err = at_cmd_write(buf_sub, NULL, 0, NULL);
-		if (err) {
-			LOG_WRN("%s failed (%d), TAU pre-warning notifications are not enabled",
-				log_strdup(buf_sub), err);
-			LOG_WRN("%s is supported in nRF9160 modem >= v1.3.0", log_strdup(buf_sub));
-		}
+		xt3412_cmd = &cmds[batch.cmd_cnt++];
+		xt3412_cmd->cmd = xt3412_sub;
 	}
 
 	if (IS_ENABLED(CONFIG_LTE_LC_MODEM_SLEEP_NOTIFICATIONS)) {
-		snprintk(buf_sub,
-			 sizeof(buf_sub),
+		snprintk(xmodemsleep_sub,
+			 sizeof(xmodemsleep_sub),
 			 AT_XMODEMSLEEP_SUB,
 			 CONFIG_LTE_LC_MODEM_SLEEP_PRE_WARNING_TIME_MS,
 			 CONFIG_LTE_LC_MODEM_SLEEP_NOTIFICATIONS_THRESHOLD_MS);
 
 		/* %XMODEMSLEEP notifications subscribe */
-		err = at_cmd_write(buf_sub, NULL, 0, NULL);
-		if (err) {
-			LOG_WRN("%s failed (%d), modem sleep notifications are not enabled",
-				log_strdup(buf_sub), err);
-			LOG_WRN("%s is supported in nRF9160 modem >= v1.3.0", log_strdup(buf_sub));
-		}
+		xmodemsleep_cmd = &cmds[batch.cmd_cnt++];
+		xmodemsleep_cmd->cmd = xmodemsleep_sub;
 	}
 
 	/* +CSCON notifications */
-	err = at_cmd_write(cscon, NULL, 0, NULL);
+	cscon_cmd = &cmds[batch.cmd_cnt++];
+	cscon_cmd->cmd = cscon;
+
+	/* Write all subscriptions back-to-back and wait for the last one */
+	err = at_cmd_batch_submit(&batch);
 	if (err) {
+		LOG_ERR("Failed to queue notification subscriptions");
+		return err;
+	}
+
+	/* The result of every subscription is checked below, as some of them
+	 * are optional.
+	 */
+	err = at_cmd_batch_wait(&batch, K_FOREVER);
+	if (err) {
+		LOG_DBG("Notification subscriptions failed, error: %d", err);
+	}
+
+	if (cereg_cmd->code) {
+		LOG_ERR("Failed to subscribe to CEREG notifications");
+		return cereg_cmd->code;
+	}
+
+	if (xt3412_cmd && xt3412_cmd->code) {
+		LOG_WRN("%s failed (%d), TAU pre-warning notifications are not enabled",
+			log_strdup(xt3412_sub), xt3412_cmd->code);
+		LOG_WRN("%s is supported in nRF9160 modem >= v1.3.0", log_strdup(xt3412_sub));
+	}
+
+	if (xmodemsleep_cmd && xmodemsleep_cmd->code) {
+		LOG_WRN("%s failed (%d), modem sleep notifications are not enabled",
+			log_strdup(xmodemsleep_sub), xmodemsleep_cmd->code);
+		LOG_WRN("%s is supported in nRF9160 modem >= v1.3.0",
+			log_strdup(xmodemsleep_sub));
+	}
+
+	if (cscon_cmd->code) {
 		char buf[50];
 
 		/* AT+CSCON is supported from modem firmware v1.1.0, and will
@@ -546,7 +577,7 @@ static int enable_notifications(void)
 		 * not returned, while informative log messageas are printed.
 		 */
 		LOG_WRN("%s failed (%d), RRC notifications are not enabled",
-			cscon, err);
+			cscon, cscon_cmd->code);
 		LOG_WRN("%s is supported in nRF9160 modem >= v1.1.0", cscon);
 
 		err = at_cmd_write("AT+CGMR", buf, sizeof(buf), NULL);
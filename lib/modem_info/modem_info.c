@@ -67,6 +67,9 @@ LOG_MODULE_REGISTER(modem_info);
 #define DATE_TIME_DATA_NAME	"dateTime"
 #define APN_DATA_NAME		"apn"
 
+#define AT_NOTIF_CEREG		"+CEREG"
+#define AT_NOTIF_XMODEMSLEEP	"%XMODEMSLEEP"
+
 #define AT_CMD_RSP_DELIM "\r\n"
 #define IP_ADDR_SEPARATOR ", "
 #define IP_ADDR_SEPARATOR_LEN (sizeof(IP_ADDR_SEPARATOR)-1)
@@ -131,14 +134,65 @@ LOG_MODULE_REGISTER(modem_info);
 #define APN_PARAM_INDEX		3
 #define APN_PARAM_COUNT		7
 
+struct modem_info_cache;
+
 struct modem_info_data {
 	const char *cmd;
 	const char *data_name;
 	uint8_t param_index;
 	uint8_t param_count;
 	enum at_param_type data_type;
+	/* Cached response of cmd, or NULL if the response is not cached. */
+	struct modem_info_cache *cache;
+};
+
+#if defined(CONFIG_MODEM_INFO_CACHE)
+/* Response of an AT command, shared by the data read with the command. */
+struct modem_info_cache {
+	int64_t timestamp;
+	bool valid;
+	/* Invalidated by network registration and modem sleep notifications. */
+	bool network;
+	char resp[CONFIG_MODEM_INFO_BUFFER_SIZE];
+};
+
+#define CACHE_DEFINE(_name, _network)					\
+	static struct modem_info_cache _name##_cache = {		\
+		.network = _network,					\
+	}
+#define CACHE(_name) (&_name##_cache)
+
+/* The UE mode, UICC state and system mode are not cached, because they
+ * change when the system mode or the functional mode is set, for example by
+ * the LTE link controller, without a notification.
+ */
+CACHE_DEFINE(band, true);
+CACHE_DEFINE(band_sup, false);
+CACHE_DEFINE(operator, true);
+CACHE_DEFINE(network_status, true);
+CACHE_DEFINE(pdp_context, true);
+CACHE_DEFINE(fw, false);
+CACHE_DEFINE(iccid, false);
+CACHE_DEFINE(imsi, false);
+CACHE_DEFINE(imei, false);
+
+static struct modem_info_cache *const caches[] = {
+	CACHE(band), CACHE(band_sup), CACHE(operator), CACHE(network_status),
+	CACHE(pdp_context), CACHE(fw), CACHE(iccid), CACHE(imsi), CACHE(imei),
 };
 
+/* Protects the caches. Not held while waiting for the modem, so that the
+ * notification handler can invalidate the caches while a command is pending.
+ */
+static K_MUTEX_DEFINE(cache_mutex);
+/* Incremented on every invalidation, so that a response read from the modem
+ * before an invalidation is not stored.
+ */
+static uint32_t cache_generation;
+#else
+#define CACHE(_name) NULL
+#endif /* CONFIG_MODEM_INFO_CACHE */
+
 static const struct modem_info_data rsrp_data = {
 	.cmd		= AT_CMD_CESQ,
 	.data_name	= RSRP_DATA_NAME,
@@ -153,6 +207,7 @@ static const struct modem_info_data band_data = {
 	.param_index	= BAND_PARAM_INDEX,
 	.param_count	= BAND_PARAM_COUNT,
 	.data_type	= AT_PARAM_TYPE_NUM_INT,
+	.cache		= CACHE(band),
 };
 
 static const struct modem_info_data band_sup_data = {
@@ -161,6 +216,7 @@ static const struct modem_info_data band_sup_data = {
 	.param_index	= BAND_PARAM_INDEX,
 	.param_count	= BAND_PARAM_COUNT,
 	.data_type	= AT_PARAM_TYPE_STRING,
+	.cache		= CACHE(band_sup),
 };
 
 static const struct modem_info_data mode_data = {
@@ -177,6 +233,7 @@ static const struct modem_info_data operator_data = {
 	.param_index	= OPERATOR_PARAM_INDEX,
 	.param_count	= OPERATOR_PARAM_COUNT,
 	.data_type	= AT_PARAM_TYPE_STRING,
+	.cache		= CACHE(operator),
 };
 
 static const struct modem_info_data mcc_data = {
@@ -185,6 +242,7 @@ static const struct modem_info_data mcc_data = {
 	.param_index	= OPERATOR_PARAM_INDEX,
 	.param_count	= OPERATOR_PARAM_COUNT,
 	.data_type	= AT_PARAM_TYPE_NUM_INT,
+	.cache		= CACHE(operator),
 };
 
 static const struct modem_info_data mnc_data = {
@@ -193,6 +251,7 @@ static const struct modem_info_data mnc_data = {
 	.param_index	= OPERATOR_PARAM_INDEX,
 	.param_count	= OPERATOR_PARAM_COUNT,
 	.data_type	= AT_PARAM_TYPE_NUM_INT,
+	.cache		= CACHE(operator),
 };
 
 static const struct modem_info_data cellid_data = {
@@ -201,6 +260,7 @@ static const struct modem_info_data cellid_data = {
 	.param_index	= CELLID_PARAM_INDEX,
 	.param_count	= CELLID_PARAM_COUNT,
 	.data_type	= AT_PARAM_TYPE_STRING,
+	.cache		= CACHE(network_status),
 };
 
 static const struct modem_info_data area_data = {
@@ -209,6 +269,7 @@ static const struct modem_info_data area_data = {
 	.param_index	= AREA_CODE_PARAM_INDEX,
 	.param_count	= AREA_CODE_PARAM_COUNT,
 	.data_type	= AT_PARAM_TYPE_STRING,
+	.cache		= CACHE(network_status),
 };
 
 static const struct modem_info_data ip_data = {
@@ -217,6 +278,7 @@ static const struct modem_info_data ip_data = {
 	.param_index	= IP_ADDRESS_PARAM_INDEX,
 	.param_count	= IP_ADDRESS_PARAM_COUNT,
 	.data_type	= AT_PARAM_TYPE_STRING,
+	.cache		= CACHE(pdp_context),
 };
 
 static const struct modem_info_data uicc_data = {
@@ -249,6 +311,7 @@ static const struct modem_info_data fw_data = {
 	.param_index	= MODEM_FW_PARAM_INDEX,
 	.param_count	= MODEM_FW_PARAM_COUNT,
 	.data_type	= AT_PARAM_TYPE_STRING,
+	.cache		= CACHE(fw),
 };
 
 static const struct modem_info_data iccid_data = {
@@ -257,6 +320,7 @@ static const struct modem_info_data iccid_data = {
 	.param_index	= ICCID_PARAM_INDEX,
 	.param_count	= ICCID_PARAM_COUNT,
 	.data_type	= AT_PARAM_TYPE_STRING,
+	.cache		= CACHE(iccid),
 };
 
 static const struct modem_info_data lte_mode_data = {
@@ -289,6 +353,7 @@ static const struct modem_info_data imsi_data = {
 	.param_index	= IMSI_PARAM_INDEX,
 	.param_count	= IMSI_PARAM_COUNT,
 	.data_type	= AT_PARAM_TYPE_STRING,
+	.cache		= CACHE(imsi),
 };
 
 static const struct modem_info_data imei_data = {
@@ -297,6 +362,7 @@ static const struct modem_info_data imei_data = {
 	.param_index	= MODEM_IMEI_PARAM_INDEX,
 	.param_count	= MODEM_IMEI_PARAM_COUNT,
 	.data_type	= AT_PARAM_TYPE_STRING,
+	.cache		= CACHE(imei),
 };
 
 static const struct modem_info_data date_time_data = {
@@ -313,6 +379,7 @@ static const struct modem_info_data apn_data = {
 	.param_index	= APN_PARAM_INDEX,
 	.param_count	= APN_PARAM_COUNT,
 	.data_type	= AT_PARAM_TYPE_STRING,
+	.cache		= CACHE(pdp_context),
 };
 
 static const struct modem_info_data *const modem_data[] = {
@@ -387,6 +454,95 @@ static int modem_info_parse(const struct modem_info_data *modem_data,
 	return err;
 }
 
+#if defined(CONFIG_MODEM_INFO_CACHE)
+static bool cache_hit(const struct modem_info_cache *cache)
+{
+	return cache->valid &&
+	       (k_uptime_get() - cache->timestamp <
+		CONFIG_MODEM_INFO_CACHE_TTL_MS);
+}
+
+static void cache_invalidate(bool network_only)
+{
+	k_mutex_lock(&cache_mutex, K_FOREVER);
+
+	for (size_t i = 0; i < ARRAY_SIZE(caches); i++) {
+		if (!network_only || caches[i]->network) {
+			caches[i]->valid = false;
+		}
+	}
+
+	cache_generation++;
+
+	k_mutex_unlock(&cache_mutex);
+}
+
+static void modem_info_cache_notif_handler(void *context, const char *notif)
+{
+	ARG_UNUSED(context);
+
+	if (strstr(notif, AT_NOTIF_CEREG) ||
+	    strstr(notif, AT_NOTIF_XMODEMSLEEP)) {
+		LOG_DBG("Network state changed, invalidating cache");
+		cache_invalidate(true);
+	}
+}
+#endif /* CONFIG_MODEM_INFO_CACHE */
+
+/* Write the command of modem_data to the modem, or copy its cached response. */
+static int modem_info_cmd_write(const struct modem_info_data *modem_data,
+				char *buf, size_t buf_size)
+{
+	int err;
+
+#if defined(CONFIG_MODEM_INFO_CACHE)
+	struct modem_info_cache *cache = modem_data->cache;
+
+	if (cache != NULL) {
+		uint32_t generation;
+
+		__ASSERT_NO_MSG(buf_size == sizeof(cache->resp));
+
+		k_mutex_lock(&cache_mutex, K_FOREVER);
+
+		if (cache_hit(cache)) {
+			memcpy(buf, cache->resp, buf_size);
+			k_mutex_unlock(&cache_mutex);
+
+			return 0;
+		}
+
+		generation = cache_generation;
+
+		k_mutex_unlock(&cache_mutex);
+
+		err = at_cmd_write(modem_data->cmd, buf, buf_size, NULL);
+		if (err) {
+			return err;
+		}
+
+		k_mutex_lock(&cache_mutex, K_FOREVER);
+
+		/* Drop the response if the cache was invalidated meanwhile,
+		 * it might be outdated already.
+		 */
+		if (generation == cache_generation) {
+			memcpy(cache->resp, buf, buf_size);
+			cache->timestamp = k_uptime_get();
+			cache->valid = true;
+		}
+
+		k_mutex_unlock(&cache_mutex);
+
+		return 0;
+	}
+#endif
+
+	err = at_cmd_write(modem_data->cmd, buf, buf_size, NULL);
+
+	return err;
+}
+
 enum at_param_type modem_info_type_get(enum modem_info info_type)
 {
 	if (info_type >= MODEM_INFO_COUNT) {
@@ -431,10 +587,8 @@ int modem_info_short_get(enum modem_info info, uint16_t *buf)
 		return -EINVAL;
 	}
 
-	err = at_cmd_write(modem_data[info]->cmd,
-			   recv_buf,
-			   CONFIG_MODEM_INFO_BUFFER_SIZE,
-			   NULL);
+	err = modem_info_cmd_write(modem_data[info], recv_buf,
+				   sizeof(recv_buf));
 
 	if (err != 0) {
 		return -EIO;
@@ -588,10 +742,8 @@ int modem_info_string_get(enum modem_info info, char *buf, const size_t buf_size
 
 	buf[0] = '\0';
 
-	err = at_cmd_write(modem_data[info]->cmd,
-			  recv_buf,
-			  CONFIG_MODEM_INFO_BUFFER_SIZE,
-			  NULL);
+	err = modem_info_cmd_write(modem_data[info], recv_buf,
+				   sizeof(recv_buf));
 	if (err != 0) {
 		return -EIO;
 	}
@@ -731,6 +883,13 @@ int modem_info_rsrp_register(rsrp_cb_t cb)
 	return 0;
 }
 
+void modem_info_cache_invalidate(void)
+{
+#if defined(CONFIG_MODEM_INFO_CACHE)
+	cache_invalidate(false);
+#endif
+}
+
 int modem_info_init(void)
 {
 	int err = 0;
@@ -739,6 +898,17 @@ int modem_info_init(void)
 		/* Init at_cmd_parser storage module */
 		err = at_params_list_init(&m_param_list,
 					  CONFIG_MODEM_INFO_MAX_AT_PARAMS_RSP);
+		if (err) {
+			return err;
+		}
+
+#if defined(CONFIG_MODEM_INFO_CACHE)
+		err = at_notif_register_handler(NULL,
+						modem_info_cache_notif_handler);
+		if (err) {
+			LOG_ERR("Can't register cache handler rc=%d", err);
+		}
+#endif
 	}
 
 	return err;
@@ -42,14 +42,22 @@
 /* Offloading context related to nRF socket. */
 static struct nrf_sock_ctx {
 	int nrf_fd; /* nRF socket descriptior. */
+	int type; /* Socket type, as passed to socket(). */
 	struct k_mutex *lock; /* Mutex associated with the socket. */
 } offload_ctx[NRF_MODEM_MAX_SOCKET_COUNT];
 
 static K_MUTEX_DEFINE(ctx_lock);
 
+/* Buffers used by `sendmsg` to gather a message before sending it.
+ * Each call takes its own buffer, so callers on different sockets
+ * do not wait for each other.
+ */
+K_MEM_SLAB_DEFINE(sendmsg_slab, CONFIG_NRF_MODEM_LIB_SENDMSG_BUF_SIZE,
+		  CONFIG_NRF_MODEM_LIB_SENDMSG_BUF_COUNT, 4);
+
 static const struct socket_op_vtable nrf91_socket_fd_op_vtable;
 
-static struct nrf_sock_ctx *allocate_ctx(int nrf_fd)
+static struct nrf_sock_ctx *allocate_ctx(int nrf_fd, int type)
 {
 	struct nrf_sock_ctx *ctx = NULL;
 
@@ -59,6 +67,7 @@ static struct nrf_sock_ctx *allocate_ctx(int nrf_fd)
 		if (offload_ctx[i].nrf_fd == -1) {
 			ctx = &offload_ctx[i];
 			ctx->nrf_fd = nrf_fd;
+			ctx->type = type;
 			break;
 		}
 	}
@@ -636,7 +645,7 @@ static int nrf91_socket_offload_accept(void *obj, struct sockaddr *addr,
 		return -1;
 	}
 
-	ctx = allocate_ctx(new_sd);
+	ctx = allocate_ctx(new_sd, SOCK_STREAM);
 	if (ctx == NULL) {
 		errno = ENOMEM;
 		goto error;
@@ -917,59 +926,103 @@ error:
 	return retval;
 }
 
+static bool sendmsg_nonblock(int sd, int flags)
+{
+	int sd_flags;
+
+	if (flags & MSG_DONTWAIT) {
+		return true;
+	}
+
+	sd_flags = nrf_fcntl(sd, NRF_F_GETFL, 0);
+
+	return (sd_flags >= 0) && (sd_flags & NRF_O_NONBLOCK);
+}
+
+static ssize_t sendmsg_gather(void *obj, const struct msghdr *msg,
+			      int flags, uint8_t *buf, size_t len)
+{
+	size_t offset;
+	ssize_t ret;
+	int i;
+
+	offset = 0;
+	for (i = 0; i < msg->msg_iovlen; i++) {
+		memcpy(buf + offset, msg->msg_iov[i].iov_base,
+		       msg->msg_iov[i].iov_len);
+		offset += msg->msg_iov[i].iov_len;
+	}
+
+	offset = 0;
+	do {
+		ret = nrf91_socket_offload_sendto(obj, buf + offset,
+						  len - offset, flags,
+						  msg->msg_name,
+						  msg->msg_namelen);
+		if (ret > 0) {
+			offset += ret;
+		}
+	} while ((ret > 0) && (offset < len) &&
+		 (OBJ_TO_CTX(obj)->type == SOCK_STREAM));
+
+	/* Report the data that was sent before an error, like send() does. */
+	return (offset > 0) ? offset : ret;
+}
+
 static ssize_t nrf91_socket_offload_sendmsg(void *obj, const struct msghdr *msg,
 					    int flags)
 {
+	k_timeout_t timeout = K_FOREVER;
+	uint8_t *buf;
 	ssize_t len = 0;
 	ssize_t ret;
 	ssize_t offset;
 	int i;
-	static K_MUTEX_DEFINE(sendmsg_lock);
-	static uint8_t buf[CONFIG_NRF_MODEM_LIB_SENDMSG_BUF_SIZE];
 
 	if (msg == NULL) {
 		errno = EINVAL;
 		return -1;
 	}
 
-	/* The standard POSIX definition of sendmsg says it should return
-	 * EWOULDBLOCK if the socket is in NONBLOCK mode and handed too much data.
-	 * This implementation doesn't meet that requirement and will always
-	 * block, even in NONBLOCK mode.  See POSIX.1-2017:
-	 * <http://pubs.opengroup.org/onlinepubs/9699919799/functions/sendmsg.html>
-	 */
-
-	/* Try to reduce number of `sendto` calls - copy data if they fit into
-	 * a single buffer
-	 */
-
 	for (i = 0; i < msg->msg_iovlen; i++) {
 		len += msg->msg_iov[i].iov_len;
 	}
 
-	if (len <= sizeof(buf)) {
-		/* Protect `buf` access with a mutex. */
-		k_mutex_lock(&sendmsg_lock, K_FOREVER);
-		len = 0;
+	/* Gather the message into a single buffer if it fits, to reduce the
+	 * number of `sendto` calls.
+	 */
+	if (len <= CONFIG_NRF_MODEM_LIB_SENDMSG_BUF_SIZE) {
+		if (sendmsg_nonblock(OBJ_TO_SD(obj), flags)) {
+			timeout = K_NO_WAIT;
+		}
 
-		for (i = 0; i < msg->msg_iovlen; i++) {
-			memcpy(buf + len, msg->msg_iov[i].iov_base,
-			       msg->msg_iov[i].iov_len);
-			len += msg->msg_iov[i].iov_len;
+		if (k_mem_slab_alloc(&sendmsg_slab, (void **)&buf,
+				     timeout) != 0) {
+			errno = EAGAIN;
+			return -1;
 		}
 
-		offset = 0;
-		ret = 0;
-		while ((offset < len) && (ret >= 0)) {
-			ret = nrf91_socket_offload_sendto(obj,
-				(buf + offset), (len - offset), flags,
-				msg->msg_name, msg->msg_namelen);
-			if (ret > 0) {
-				offset += ret;
-			}
+		ret = sendmsg_gather(obj, msg, flags, buf, len);
+
+		k_mem_slab_free(&sendmsg_slab, (void **)&buf);
+
+		return ret;
+	}
+
+	/* A datagram must always be sent in a single call, otherwise it would
+	 * be split into several datagrams. Gather larger ones on the heap.
+	 */
+	if (OBJ_TO_CTX(obj)->type != SOCK_STREAM) {
+		buf = k_malloc(len);
+		if (buf == NULL) {
+			errno = ENOMEM;
+			return -1;
 		}
 
-		k_mutex_unlock(&sendmsg_lock);
+		ret = sendmsg_gather(obj, msg, flags, buf, len);
+
+		k_free(buf);
+
 		return ret;
 	}
 
@@ -991,7 +1044,7 @@ static ssize_t nrf91_socket_offload_sendmsg(void *obj, const struct msghdr *msg,
 				(msg->msg_iov[i].iov_len - offset), flags,
 				msg->msg_name, msg->msg_namelen);
 			if (ret < 0) {
-				return ret;
+				return (len > 0) ? len : ret;
 			}
 			offset += ret;
 			len += ret;
@@ -1333,7 +1386,7 @@ static int nrf91_socket_create(int family, int type, int proto)
 		return -1;
 	}
 
-	ctx = allocate_ctx(sd);
+	ctx = allocate_ctx(sd, type);
 	if (ctx == NULL) {
 		errno = ENOMEM;
 		nrf_close(sd);
@@ -17,6 +17,10 @@
 #include <pm_config.h>
 #include <logging/log.h>
 
+#ifdef CONFIG_NRF_MODEM_LIB_SHM_TX_POOL
+#include "shm_tx_pool.h"
+#endif
+
 #ifdef CONFIG_NRF_MODEM_LIB_TRACE_MEDIUM_UART
 #include <nrfx_uarte.h>
 #endif
@@ -60,9 +64,16 @@ struct mem_diagnostic_info {
 	uint32_t failed_allocs;
 };
 
+struct wait_diagnostic_info {
+	atomic_t events;
+	atomic_t wakeups;
+	atomic_t spurious_wakeups;
+};
+
 struct sleeping_thread {
-	sys_snode_t node;
+	sys_dnode_t node;
 	struct k_sem sem;
+	struct thread_monitor_entry *entry;
 };
 
 /* Shared memory heap
@@ -70,7 +81,24 @@ struct sleeping_thread {
  * it should be initialized in the shared memory area reserved by
  * the Partition Manager. This happens in `nrf_modem_os_init()`.
  */
+#ifdef CONFIG_NRF_MODEM_LIB_SHM_TX_POOL
+/* With the size classes, the heap is part of the pool. */
+static struct shm_tx_pool shmem_pool;
+
+static const struct shm_tx_pool_class_config shmem_pool_config[] = {
+	{ 64, CONFIG_NRF_MODEM_LIB_SHM_TX_POOL_64_COUNT },
+	{ 256, CONFIG_NRF_MODEM_LIB_SHM_TX_POOL_256_COUNT },
+	{ 1024, CONFIG_NRF_MODEM_LIB_SHM_TX_POOL_1024_COUNT },
+};
+
+BUILD_ASSERT(64 * CONFIG_NRF_MODEM_LIB_SHM_TX_POOL_64_COUNT +
+	     256 * CONFIG_NRF_MODEM_LIB_SHM_TX_POOL_256_COUNT +
+	     1024 * CONFIG_NRF_MODEM_LIB_SHM_TX_POOL_1024_COUNT <
+	     CONFIG_NRF_MODEM_LIB_SHMEM_TX_SIZE / 2,
+	     "Size classes must leave at least half of the TX region to the heap");
+#else
 static struct k_heap shmem_heap;
+#endif
 
 /* Library heap, defined here in application RAM */
 static K_HEAP_DEFINE(library_heap, CONFIG_NRF_MODEM_LIB_HEAP_SIZE);
@@ -79,16 +107,23 @@ static K_HEAP_DEFINE(library_heap, CONFIG_NRF_MODEM_LIB_HEAP_SIZE);
 static struct mem_diagnostic_info shmem_diag;
 static struct mem_diagnostic_info heap_diag;
 
+/* Store information about RPC events and the threads they woke up */
+static struct wait_diagnostic_info wait_diag;
+
 /* An array of thread ID and RPC counter pairs, used to avoid race conditions.
  * It allows to identify whether it is safe to put the thread to sleep or not.
  */
 static struct thread_monitor_entry {
 	k_tid_t id; /* Thread ID. */
 	int cnt; /* Last RPC event count. */
+	uint32_t context; /* Context of the last wait. */
+	bool woken; /* Last wait ended with an RPC event. */
 } thread_event_monitor[THREAD_MONITOR_ENTRIES];
 
-/* A list of threads that are sleeping and should be woken up on next event. */
-static sys_slist_t sleeping_threads;
+/* A list of threads that are sleeping and should be woken up on next event.
+ * A doubly-linked list, so that a thread removes itself in constant time.
+ */
+static sys_dlist_t sleeping_threads;
 
 /* RPC event counter, incremented on each RPC event. */
 static atomic_t rpc_event_cnt;
@@ -121,6 +156,7 @@ static struct thread_monitor_entry *thread_monitor_entry_get(k_tid_t id)
 
 	new_entry->id = id;
 	new_entry->cnt = rpc_event_cnt - 1;
+	new_entry->woken = false;
 
 	return new_entry;
 }
@@ -156,7 +192,8 @@ static void sleeping_thread_init(struct sleeping_thread *thread)
 /* Add thread to the sleeping threads list. Will return information whether
  * the thread was allowed to sleep or not.
  */
-static bool sleeping_thread_add(struct sleeping_thread *thread)
+static bool sleeping_thread_add(struct sleeping_thread *thread,
+				uint32_t context)
 {
 	bool allow_to_sleep = false;
 	struct thread_monitor_entry *entry;
@@ -167,25 +204,46 @@ static bool sleeping_thread_add(struct sleeping_thread *thread)
 
 	if (can_thread_sleep(entry)) {
 		allow_to_sleep = true;
-		sys_slist_append(&sleeping_threads, &thread->node);
+		sys_dlist_append(&sleeping_threads, &thread->node);
+
+		/* The thread was woken up, but goes back to sleep on the
+		 * same context without any RPC event in between, so the
+		 * event it was woken up for was not relevant to it.
+		 */
+		if (entry->woken && entry->context == context) {
+			atomic_inc(&wait_diag.spurious_wakeups);
+		}
 	}
 
+	entry->woken = false;
+	thread->entry = entry;
+
 	irq_unlock(key);
 
 	return allow_to_sleep;
 }
 
 /* Remove a thread form the sleeping threads list. */
-static void sleeping_thread_remove(struct sleeping_thread *thread)
+static void sleeping_thread_remove(struct sleeping_thread *thread,
+				   uint32_t context, bool woken)
 {
 	struct thread_monitor_entry *entry;
 
 	uint32_t key = irq_lock();
 
-	sys_slist_find_and_remove(&sleeping_threads, &thread->node);
+	sys_dlist_remove(&thread->node);
+
+	/* The entry is reused only if it was not taken over by another
+	 * thread while this one was sleeping.
+	 */
+	entry = thread->entry;
+	if (entry->id != k_current_get()) {
+		entry = thread_monitor_entry_get(k_current_get());
+	}
 
-	entry = thread_monitor_entry_get(k_current_get());
 	thread_monitor_entry_update(entry);
+	entry->context = context;
+	entry->woken = woken;
 
 	irq_unlock(key);
 }
@@ -199,6 +257,7 @@ int32_t nrf_modem_os_timedwait(uint32_t context, int32_t *timeout)
 {
 	struct sleeping_thread thread;
 	int64_t start, remaining;
+	bool woken;
 
 	start = k_uptime_get();
 
@@ -213,13 +272,13 @@ int32_t nrf_modem_os_timedwait(uint32_t context, int32_t *timeout)
 
 	sleeping_thread_init(&thread);
 
-	if (!sleeping_thread_add(&thread)) {
+	if (!sleeping_thread_add(&thread, context)) {
 		return 0;
 	}
 
-	(void)k_sem_take(&thread.sem, SYS_TIMEOUT_MS(*timeout));
+	woken = (k_sem_take(&thread.sem, SYS_TIMEOUT_MS(*timeout)) == 0);
 
-	sleeping_thread_remove(&thread);
+	sleeping_thread_remove(&thread, context, woken);
 
 	if (*timeout == SYS_FOREVER_MS) {
 		return 0;
@@ -441,12 +500,19 @@ ISR_DIRECT_DECLARE(rpc_proxy_irq_handler)
 	nrf_modem_os_application_irq_handler();
 
 	struct sleeping_thread *thread;
+	atomic_val_t wakeups = 0;
 
-	/* Wake up all sleeping threads. */
-	SYS_SLIST_FOR_EACH_CONTAINER(&sleeping_threads, thread, node) {
+	/* Wake up all sleeping threads. The event does not tell which
+	 * context it is for, so each thread has to check it.
+	 */
+	SYS_DLIST_FOR_EACH_CONTAINER(&sleeping_threads, thread, node) {
 		k_sem_give(&thread->sem);
+		wakeups++;
 	}
 
+	atomic_inc(&wait_diag.events);
+	atomic_add(&wait_diag.wakeups, wakeups);
+
 	ISR_DIRECT_PM(); /* PM done after servicing interrupt for best latency
 			  */
 	return 1; /* We should check if scheduling decision should be made */
@@ -551,7 +617,11 @@ void nrf_modem_os_free(void *mem)
 
 void *nrf_modem_os_shm_tx_alloc(size_t bytes)
 {
+#ifdef CONFIG_NRF_MODEM_LIB_SHM_TX_POOL
+	void *addr = shm_tx_pool_alloc(&shmem_pool, bytes);
+#else
 	void *addr = k_heap_alloc(&shmem_heap, bytes, K_NO_WAIT);
+#endif
 #ifdef CONFIG_NRF_MODEM_LIB_DEBUG_SHM_TX_ALLOC
 	if (addr) {
 		LOG_INF("shm_tx_alloc(%d) -> %p", bytes, addr);
@@ -565,7 +635,11 @@ void *nrf_modem_os_shm_tx_alloc(size_t bytes)
 
 void nrf_modem_os_shm_tx_free(void *mem)
 {
+#ifdef CONFIG_NRF_MODEM_LIB_SHM_TX_POOL
+	shm_tx_pool_free(&shmem_pool, mem);
+#else
 	k_heap_free(&shmem_heap, mem);
+#endif
 #ifdef CONFIG_NRF_MODEM_LIB_DEBUG_SHM_TX_ALLOC
 	LOG_INF("shm_tx_free(%p)", mem);
 #endif
@@ -581,8 +655,22 @@ void nrf_modem_lib_heap_diagnose(void)
 void nrf_modem_lib_shm_tx_diagnose(void)
 {
 	printk("nrf_modem tx dump:\n");
+#ifdef CONFIG_NRF_MODEM_LIB_SHM_TX_POOL
+	shm_tx_pool_print(&shmem_pool);
+#else
 	sys_heap_print_info(&shmem_heap.heap, false);
 	printk("Failed allocations: %u\n", shmem_diag.failed_allocs);
+#endif
+}
+
+void nrf_modem_lib_wait_diagnose(void)
+{
+	printk("nrf_modem wait dump:\n");
+	printk("RPC events: %u\n", (uint32_t)atomic_get(&wait_diag.events));
+	printk("Thread wakeups: %u\n",
+	       (uint32_t)atomic_get(&wait_diag.wakeups));
+	printk("Spurious wakeups: %u\n",
+	       (uint32_t)atomic_get(&wait_diag.spurious_wakeups));
 }
 
 #if defined(CONFIG_NRF_MODEM_LIB_SHM_TX_DUMP_PERIODIC) || \
@@ -633,7 +721,7 @@ static void diag_task(struct k_work *item)
 /* This function is called by nrf_modem_init() */
 void nrf_modem_os_init(void)
 {
-	sys_slist_init(&sleeping_threads);
+	sys_dlist_init(&sleeping_threads);
 	atomic_clear(&rpc_event_cnt);
 
 	read_task_create();
@@ -645,11 +733,22 @@ void nrf_modem_os_init(void)
 
 	memset(&heap_diag, 0x00, sizeof(heap_diag));
 	memset(&shmem_diag, 0x00, sizeof(shmem_diag));
+	memset(&wait_diag, 0x00, sizeof(wait_diag));
 
 	/* Initialize TX heap */
+#ifdef CONFIG_NRF_MODEM_LIB_SHM_TX_POOL
+	if (shm_tx_pool_init(&shmem_pool,
+			     (void *)PM_NRF_MODEM_LIB_TX_ADDRESS,
+			     CONFIG_NRF_MODEM_LIB_SHMEM_TX_SIZE,
+			     shmem_pool_config,
+			     ARRAY_SIZE(shmem_pool_config))) {
+		LOG_ERR("Failed to initialize TX region size classes");
+	}
+#else
 	k_heap_init(&shmem_heap,
 		    (void *)PM_NRF_MODEM_LIB_TX_ADDRESS,
 		    CONFIG_NRF_MODEM_LIB_SHMEM_TX_SIZE);
+#endif
 
 #if defined(CONFIG_NRF_MODEM_LIB_SHM_TX_DUMP_PERIODIC) || \
 	defined(CONFIG_NRF_MODEM_LIB_HEAP_DUMP_PERIODIC)
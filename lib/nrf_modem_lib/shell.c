@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <shell/shell.h>
+#include <modem/nrf_modem_lib.h>
+
+/* The diagnostic functions print with printk, which is routed to the
+ * same backend as the shell in the default configuration.
+ */
+
+static int heap_diagnose(const struct shell *shell, size_t argc, char **argv)
+{
+	nrf_modem_lib_heap_diagnose();
+	return 0;
+}
+
+static int shm_tx_diagnose(const struct shell *shell, size_t argc,
+			   char **argv)
+{
+	nrf_modem_lib_shm_tx_diagnose();
+	return 0;
+}
+
+static int wait_diagnose(const struct shell *shell, size_t argc, char **argv)
+{
+	nrf_modem_lib_wait_diagnose();
+	return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_nrf_modem_lib,
+	SHELL_CMD_ARG(heap, NULL, "Print library heap diagnostics",
+		      heap_diagnose, 0, 0),
+	SHELL_CMD_ARG(shm_tx, NULL,
+		      "Print TX region diagnostics, including size classes",
+		      shm_tx_diagnose, 0, 0),
+	SHELL_CMD_ARG(wait, NULL, "Print RPC event and wakeup counters",
+		      wait_diagnose, 0, 0),
+	SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(nrf_modem_lib, &sub_nrf_modem_lib,
+		   "Modem library diagnostics", NULL);
@@ -0,0 +1,179 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <zephyr.h>
+#include <sys/atomic.h>
+#include <sys/sys_heap.h>
+
+#include "shm_tx_pool.h"
+
+/* Minimum size of the heap, to fit its metadata and a few allocations. */
+#define HEAP_MIN_SIZE 256
+
+size_t shm_tx_pool_classes_size(const struct shm_tx_pool_class_config *config,
+				size_t class_cnt)
+{
+	size_t size = 0;
+
+	for (size_t i = 0; i < class_cnt; i++) {
+		size += config[i].block_size * config[i].block_cnt;
+	}
+
+	return size;
+}
+
+int shm_tx_pool_init(struct shm_tx_pool *pool, void *region, size_t size,
+		     const struct shm_tx_pool_class_config *config,
+		     size_t class_cnt)
+{
+	uint8_t *start = region;
+	size_t classes_size;
+	int err;
+
+	if (class_cnt > SHM_TX_POOL_MAX_CLASSES) {
+		return -EINVAL;
+	}
+
+	for (size_t i = 0; i < class_cnt; i++) {
+		if ((config[i].block_size == 0) ||
+		    (config[i].block_size % sizeof(void *)) ||
+		    ((i > 0) &&
+		     (config[i].block_size <= config[i - 1].block_size))) {
+			return -EINVAL;
+		}
+	}
+
+	classes_size = shm_tx_pool_classes_size(config, class_cnt);
+	if (classes_size + HEAP_MIN_SIZE > size) {
+		return -ENOMEM;
+	}
+
+	memset(pool, 0, sizeof(*pool));
+	pool->class_cnt = class_cnt;
+
+	for (size_t i = 0; i < class_cnt; i++) {
+		struct shm_tx_pool_class *class = &pool->classes[i];
+
+		class->start = start;
+		class->end = start + config[i].block_size * config[i].block_cnt;
+
+		if (config[i].block_cnt > 0) {
+			err = k_mem_slab_init(&class->slab, start,
+					      config[i].block_size,
+					      config[i].block_cnt);
+			if (err) {
+				return err;
+			}
+		}
+
+		start = class->end;
+	}
+
+	k_heap_init(&pool->heap, start, size - classes_size);
+
+	return 0;
+}
+
+static void max_used_update(struct shm_tx_pool_class *class)
+{
+	atomic_val_t used = k_mem_slab_num_used_get(&class->slab);
+	atomic_val_t max_used;
+
+	do {
+		max_used = atomic_get(&class->max_used);
+		if (used <= max_used) {
+			break;
+		}
+	} while (!atomic_cas(&class->max_used, max_used, used));
+}
+
+void *shm_tx_pool_alloc(struct shm_tx_pool *pool, size_t bytes)
+{
+	struct shm_tx_pool_class *fit = NULL;
+	void *mem;
+
+	for (size_t i = 0; i < pool->class_cnt; i++) {
+		struct shm_tx_pool_class *class = &pool->classes[i];
+
+		if ((class->start == class->end) ||
+		    (class->slab.block_size < bytes)) {
+			continue;
+		}
+
+		if (fit == NULL) {
+			fit = class;
+		}
+
+		if (k_mem_slab_alloc(&class->slab, &mem, K_NO_WAIT) == 0) {
+			atomic_inc(&class->hits);
+			max_used_update(class);
+			if (class != fit) {
+				atomic_inc(&fit->misses);
+			}
+			return mem;
+		}
+	}
+
+	if (fit != NULL) {
+		atomic_inc(&fit->misses);
+	}
+
+	mem = k_heap_alloc(&pool->heap, bytes, K_NO_WAIT);
+	if (mem == NULL) {
+		atomic_inc(&pool->failed_allocs);
+		return NULL;
+	}
+
+	atomic_inc(&pool->heap_allocs);
+
+	return mem;
+}
+
+void shm_tx_pool_free(struct shm_tx_pool *pool, void *mem)
+{
+	if (mem == NULL) {
+		return;
+	}
+
+	for (size_t i = 0; i < pool->class_cnt; i++) {
+		struct shm_tx_pool_class *class = &pool->classes[i];
+
+		if (((uint8_t *)mem >= class->start) &&
+		    ((uint8_t *)mem < class->end)) {
+			k_mem_slab_free(&class->slab, &mem);
+			return;
+		}
+	}
+
+	k_heap_free(&pool->heap, mem);
+}
+
+void shm_tx_pool_print(struct shm_tx_pool *pool)
+{
+	for (size_t i = 0; i < pool->class_cnt; i++) {
+		struct shm_tx_pool_class *class = &pool->classes[i];
+
+		if (class->start == class->end) {
+			continue;
+		}
+
+		printk("Class %zu B: %u/%u used, max %u, hits %u, misses %u\n",
+		       class->slab.block_size,
+		       k_mem_slab_num_used_get(&class->slab),
+		       class->slab.num_blocks,
+		       (uint32_t)atomic_get(&class->max_used),
+		       (uint32_t)atomic_get(&class->hits),
+		       (uint32_t)atomic_get(&class->misses));
+	}
+
+	printk("Heap allocations: %u\n",
+	       (uint32_t)atomic_get(&pool->heap_allocs));
+	sys_heap_print_info(&pool->heap.heap, false);
+	printk("Failed allocations: %u\n",
+	       (uint32_t)atomic_get(&pool->failed_allocs));
+}
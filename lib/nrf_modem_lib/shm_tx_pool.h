@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef SHM_TX_POOL_H__
+#define SHM_TX_POOL_H__
+
+#include <zephyr.h>
+#include <sys/atomic.h>
+
+/* Allocator for the shared memory TX region.
+ *
+ * The start of the region is split into size classes of fixed-size blocks,
+ * served by memory slabs. An allocation takes a block from the smallest
+ * class that fits it, or from the next larger class if that one is empty.
+ * Allocations that do not fit into any class, and those for which all
+ * fitting classes are empty, are served by a heap in the rest of the region.
+ *
+ * Short-lived small buffers, such as AT commands, therefore no longer
+ * fragment the heap that holds the large socket payloads.
+ */
+
+#define SHM_TX_POOL_MAX_CLASSES 4
+
+struct shm_tx_pool_class_config {
+	/* Size of the blocks, a multiple of 4 bytes. */
+	size_t block_size;
+	/* Number of blocks, zero to disable the class. */
+	size_t block_cnt;
+};
+
+struct shm_tx_pool_class {
+	struct k_mem_slab slab;
+	uint8_t *start;
+	uint8_t *end;
+	/* Allocations served by the class. */
+	atomic_t hits;
+	/* Allocations that fit the class but were served elsewhere. */
+	atomic_t misses;
+	/* Highest number of blocks used at the same time. */
+	atomic_t max_used;
+};
+
+struct shm_tx_pool {
+	struct shm_tx_pool_class classes[SHM_TX_POOL_MAX_CLASSES];
+	size_t class_cnt;
+	struct k_heap heap;
+	/* Allocations served by the heap. */
+	atomic_t heap_allocs;
+	/* Allocations that could not be served at all. */
+	atomic_t failed_allocs;
+};
+
+/* Size of the region taken by the size classes. */
+size_t shm_tx_pool_classes_size(const struct shm_tx_pool_class_config *config,
+				size_t class_cnt);
+
+/* Initialize the pool in a region. The classes must be sorted by block size.
+ * Returns -EINVAL if the configuration is invalid and -ENOMEM if the classes
+ * do not leave any room for the heap.
+ */
+int shm_tx_pool_init(struct shm_tx_pool *pool, void *region, size_t size,
+		     const struct shm_tx_pool_class_config *config,
+		     size_t class_cnt);
+
+void *shm_tx_pool_alloc(struct shm_tx_pool *pool, size_t bytes);
+
+void shm_tx_pool_free(struct shm_tx_pool *pool, void *mem);
+
+/* Print the statistics of the size classes and the contents of the heap. */
+void shm_tx_pool_print(struct shm_tx_pool *pool);
+
+#endif /* SHM_TX_POOL_H__ */
@@ -30,6 +30,7 @@ class RttNordicProfilerHost:
         self.queue = queue
         self.received_events = EventsData([], {})
         self.timestamp_overflows = 0
+        self.dropped_cnt = 0
         self.after_half = False
 
         self.desc_buf = ""
@@ -338,6 +339,12 @@ class RttNordicProfilerHost:
         data=[]
         for event_data_type in et.data_types:
             READ_BYTES[event_data_type](self, data)
+
+        if et.name == 'profiler_dropped':
+            self.dropped_cnt += data[0]
+            self.logger.warning("Device dropped {} records ({} in total)".format(
+                data[0], self.dropped_cnt))
+
         return Event(id, timestamp, data)
 
     def _read_remaining_events(self):
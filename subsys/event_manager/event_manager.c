@@ -10,6 +10,9 @@
 #include <sys/slist.h>
 #include <event_manager.h>
 #include <logging/log.h>
+#if defined(CONFIG_EVENT_MANAGER_QUEUE_MPSC)
+#include "event_manager_mpsc.h"
+#endif
 #if defined(CONFIG_EVENT_MANAGER_STORAGE)
 #include "event_manager_storage_priv.h"
 #endif
@@ -37,10 +40,124 @@ extern uint32_t event_manager_displayed_events;
 static uint32_t event_manager_displayed_events;
 #endif
 
+#if defined(CONFIG_EVENT_MANAGER_DISPATCH_CLASSES)
+#define EVENT_QUEUE_CNT EVENT_DISPATCH_CLASS_COUNT
+#else
+#define EVENT_QUEUE_CNT 1
+#endif
+
+#if defined(CONFIG_EVENT_MANAGER_QUEUE_MPSC)
+typedef struct mpsc_queue eventq_t;
+#define EVENTQ_INITIALIZER(_eventq) MPSC_QUEUE_INITIALIZER(_eventq)
+#else
+typedef sys_slist_t eventq_t;
+#define EVENTQ_INITIALIZER(_eventq) SYS_SLIST_STATIC_INIT(&(_eventq))
+#endif
+
+struct event_queue {
+	eventq_t eventq;
+	/* Protects the event list and the statistics. The MPSC event queue
+	 * does not need it.
+	 */
+	struct k_spinlock lock;
+	struct k_work work;
+	struct k_work_q work_q;
+	k_thread_stack_t *stack;
+	size_t stack_size;
+	int prio;
+	const char *name;
+#if defined(CONFIG_EVENT_MANAGER_DISPATCH_STATS)
+	struct event_queue_stats stats;
+#endif
+};
+
+#define EVENT_QUEUE_INITIALIZER(_queue, _stack, _prio, _name)		\
+	{								\
+		.eventq = EVENTQ_INITIALIZER((_queue).eventq),		\
+		.work = Z_WORK_INITIALIZER(event_processor_fn),		\
+		.stack = (_stack),					\
+		.stack_size = K_THREAD_STACK_SIZEOF(_stack),		\
+		.prio = (_prio),					\
+		.name = (_name),					\
+	}
+
 static uint16_t profiler_event_ids[IDS_COUNT];
-static K_WORK_DEFINE(event_processor, event_processor_fn);
-static sys_slist_t eventq = SYS_SLIST_STATIC_INIT(&eventq);
-static struct k_spinlock lock;
+
+#if defined(CONFIG_EVENT_MANAGER_DISPATCH_TABLE)
+/* Listeners of every event type, ordered by subscriber priority, are placed
+ * next to each other in a single array, so that dispatching an event is
+ * a single loop over its listeners.
+ */
+struct dispatch_entry {
+	const struct event_listener * const *listeners;
+	size_t listener_cnt;
+};
+
+static const struct event_listener
+	*dispatch_listeners[CONFIG_EVENT_MANAGER_DISPATCH_TABLE_SIZE];
+/* One entry per event type, the number of event types is limited by the size
+ * of the displayed events bitmask.
+ */
+static struct dispatch_entry
+	dispatch_table[sizeof(event_manager_displayed_events) * 8];
+#endif
+
+static K_THREAD_STACK_DEFINE(normal_stack_area,
+			     CONFIG_EVENT_MANAGER_WORKQ_STACK_SIZE);
+
+#if defined(CONFIG_EVENT_MANAGER_DISPATCH_CLASSES)
+static K_THREAD_STACK_DEFINE(realtime_stack_area,
+			     CONFIG_EVENT_MANAGER_REALTIME_WORKQ_STACK_SIZE);
+static K_THREAD_STACK_DEFINE(background_stack_area,
+			     CONFIG_EVENT_MANAGER_BACKGROUND_WORKQ_STACK_SIZE);
+
+static struct event_queue event_queues[EVENT_QUEUE_CNT] = {
+	[EVENT_DISPATCH_CLASS_REALTIME] = EVENT_QUEUE_INITIALIZER(
+		event_queues[EVENT_DISPATCH_CLASS_REALTIME],
+		realtime_stack_area,
+		CONFIG_EVENT_MANAGER_REALTIME_WORKQ_PRIORITY,
+		"em_realtime"),
+	[EVENT_DISPATCH_CLASS_NORMAL] = EVENT_QUEUE_INITIALIZER(
+		event_queues[EVENT_DISPATCH_CLASS_NORMAL],
+		normal_stack_area,
+		CONFIG_EVENT_MANAGER_WORKQ_PRIORITY,
+		"em_normal"),
+	[EVENT_DISPATCH_CLASS_BACKGROUND] = EVENT_QUEUE_INITIALIZER(
+		event_queues[EVENT_DISPATCH_CLASS_BACKGROUND],
+		background_stack_area,
+		CONFIG_EVENT_MANAGER_BACKGROUND_WORKQ_PRIORITY,
+		"em_background"),
+};
+#else
+static struct event_queue event_queues[EVENT_QUEUE_CNT] = {
+	EVENT_QUEUE_INITIALIZER(event_queues[0],
+				normal_stack_area,
+				CONFIG_EVENT_MANAGER_WORKQ_PRIORITY,
+				"event_manager"),
+};
+#endif /* CONFIG_EVENT_MANAGER_DISPATCH_CLASSES */
+
+
+static struct event_queue *event_queue_get(enum event_dispatch_class dclass)
+{
+#if defined(CONFIG_EVENT_MANAGER_DISPATCH_CLASSES)
+	__ASSERT_NO_MSG(dclass < EVENT_DISPATCH_CLASS_COUNT);
+	return &event_queues[dclass];
+#else
+	ARG_UNUSED(dclass);
+	return &event_queues[0];
+#endif
+}
+
+static enum event_dispatch_class event_dispatch_class_get(
+					const struct event_type *et)
+{
+#if defined(CONFIG_EVENT_MANAGER_DISPATCH_CLASSES)
+	return et->dispatch_class;
+#else
+	return EVENT_DISPATCH_CLASS_NORMAL;
+#endif
+}
 
 
 static bool log_is_event_displayed(const struct event_type *et)
@@ -230,90 +347,271 @@ static int trace_event_init(void)
 	return 0;
 }
 
-static void event_processor_fn(struct k_work *work)
+static bool listener_notify(const struct event_listener *el,
+			    const struct event_header *eh)
 {
-	sys_slist_t events = SYS_SLIST_STATIC_INIT(&events);
+#if defined(CONFIG_EVENT_MANAGER_TIMING_HISTOGRAMS)
+	uint32_t start = k_cycle_get_32();
+	bool consumed = el->notification(eh);
 
-	/* Make current event list local. */
-	k_spinlock_key_t key = k_spin_lock(&lock);
+	_event_timing_listener_add(el, k_cyc_to_us_floor32(k_cycle_get_32() -
+							   start));
 
-	if (sys_slist_is_empty(&eventq)) {
-		k_spin_unlock(&lock, key);
-		return;
+	return consumed;
+#else
+	return el->notification(eh);
+#endif
+}
+
+#if defined(CONFIG_EVENT_MANAGER_DISPATCH_TABLE)
+static int dispatch_table_init(void)
+{
+	size_t listener_cnt = 0;
+
+	if ((__stop_event_types - __start_event_types) >
+	    ARRAY_SIZE(dispatch_table)) {
+		LOG_ERR("Too many event types for the dispatch table (%zu > %zu)",
+			(size_t)(__stop_event_types - __start_event_types),
+			ARRAY_SIZE(dispatch_table));
+		return -ENOMEM;
 	}
 
-	sys_slist_merge_slist(&events, &eventq);
+	for (const struct event_type *et = __start_event_types;
+	     (et != NULL) && (et != __stop_event_types);
+	     et++) {
+		struct dispatch_entry *entry =
+			&dispatch_table[et - __start_event_types];
 
-	k_spin_unlock(&lock, key);
+		entry->listeners = &dispatch_listeners[listener_cnt];
+		entry->listener_cnt = 0;
 
+		for (size_t prio = SUBS_PRIO_MIN; prio <= SUBS_PRIO_MAX;
+		     prio++) {
+			for (const struct event_subscriber *es =
+					et->subs_start[prio];
+			     es != et->subs_stop[prio];
+			     es++) {
+				__ASSERT_NO_MSG(es->listener != NULL);
+				__ASSERT_NO_MSG(es->listener->notification !=
+						NULL);
+
+				if (listener_cnt >=
+				    ARRAY_SIZE(dispatch_listeners)) {
+					LOG_ERR("Dispatch table too small, "
+						"increase "
+						"CONFIG_EVENT_MANAGER_DISPATCH_TABLE_SIZE");
+					return -ENOMEM;
+				}
 
-	/* Traverse the list of events. */
-	sys_snode_t *node;
-	while (NULL != (node = sys_slist_get(&events))) {
-		struct event_header *eh = CONTAINER_OF(node,
-						       struct event_header,
-						       node);
+				dispatch_listeners[listener_cnt] =
+					es->listener;
+				listener_cnt++;
+				entry->listener_cnt++;
+			}
+		}
+	}
 
-		ASSERT_EVENT_ID(eh->type_id);
+	LOG_DBG("Dispatch table uses %zu of %zu entries", listener_cnt,
+		ARRAY_SIZE(dispatch_listeners));
 
-		const struct event_type *et = eh->type_id;
+	return 0;
+}
 
-		trace_event_execution(eh, true);
+static bool event_dispatch(const struct event_type *et,
+			   const struct event_header *eh)
+{
+	const struct dispatch_entry *entry =
+		&dispatch_table[et - __start_event_types];
+	const struct event_listener * const *el = entry->listeners;
+	const struct event_listener * const *el_end =
+		el + entry->listener_cnt;
 
-		log_event(eh);
+	for (; el != el_end; el++) {
+		log_event_progress(et, *el);
 
-		bool consumed = false;
+		if (listener_notify(*el, eh)) {
+			return true;
+		}
+	}
 
-		for (size_t prio = SUBS_PRIO_MIN;
-		     (prio <= SUBS_PRIO_MAX) && !consumed;
-		     prio++) {
-			for (const struct event_subscriber *es =
-					et->subs_start[prio];
-			     (es != et->subs_stop[prio]) && !consumed;
-			     es++) {
+	return false;
+}
+#else
+static int dispatch_table_init(void)
+{
+	return 0;
+}
 
-				__ASSERT_NO_MSG(es != NULL);
+static bool event_dispatch(const struct event_type *et,
+			   const struct event_header *eh)
+{
+	for (size_t prio = SUBS_PRIO_MIN; prio <= SUBS_PRIO_MAX; prio++) {
+		for (const struct event_subscriber *es = et->subs_start[prio];
+		     es != et->subs_stop[prio];
+		     es++) {
 
-				const struct event_listener *el = es->listener;
+			__ASSERT_NO_MSG(es != NULL);
 
-				__ASSERT_NO_MSG(el != NULL);
-				__ASSERT_NO_MSG(el->notification != NULL);
+			const struct event_listener *el = es->listener;
 
-				log_event_progress(et, el);
+			__ASSERT_NO_MSG(el != NULL);
+			__ASSERT_NO_MSG(el->notification != NULL);
 
-				consumed = el->notification(eh);
+			log_event_progress(et, el);
 
-				if (consumed) {
-					log_event_consumed(et);
-#if defined(CONFIG_EVENT_MANAGER_STORAGE)
-					event_store_remove(eh);
-#endif
-				}
+			if (listener_notify(el, eh)) {
+				return true;
 			}
 		}
+	}
+
+	return false;
+}
+#endif /* CONFIG_EVENT_MANAGER_DISPATCH_TABLE */
+
+static void stats_event_submitted(struct event_queue *queue,
+				  struct event_header *eh)
+{
+#if defined(CONFIG_EVENT_MANAGER_DISPATCH_STATS)
+	eh->submit_time = k_cycle_get_32();
+
+	k_spinlock_key_t key = k_spin_lock(&queue->lock);
+
+	queue->stats.depth++;
+	queue->stats.max_depth = MAX(queue->stats.max_depth,
+				     queue->stats.depth);
+
+	k_spin_unlock(&queue->lock, key);
+#endif
+}
+
+static void stats_event_dispatched(struct event_queue *queue,
+				   const struct event_header *eh)
+{
+#if defined(CONFIG_EVENT_MANAGER_DISPATCH_STATS)
+	uint32_t latency = k_cyc_to_us_floor32(k_cycle_get_32() -
+					       eh->submit_time);
+	k_spinlock_key_t key = k_spin_lock(&queue->lock);
+
+	queue->stats.depth--;
+	queue->stats.dispatch_cnt++;
+	queue->stats.latency_total_us += latency;
+	queue->stats.latency_max_us = MAX(queue->stats.latency_max_us,
+					  latency);
+
+	k_spin_unlock(&queue->lock, key);
+#endif
+
+#if defined(CONFIG_EVENT_MANAGER_TIMING_HISTOGRAMS)
+	_event_timing_latency_add(eh->type_id, latency);
+#endif
+}
+
+static void event_process(struct event_queue *queue, struct event_header *eh)
+{
+	ASSERT_EVENT_ID(eh->type_id);
+
+	const struct event_type *et = eh->type_id;
+
+	stats_event_dispatched(queue, eh);
+
+	trace_event_execution(eh, true);
+
+	log_event(eh);
+
+	if (event_dispatch(et, eh)) {
+		log_event_consumed(et);
+#if defined(CONFIG_EVENT_MANAGER_STORAGE)
+		event_store_remove(eh);
+#endif
+	}
+
+	trace_event_execution(eh, false);
+
+	event_manager_free(eh);
+}
 
-		trace_event_execution(eh, false);
+#if defined(CONFIG_EVENT_MANAGER_QUEUE_MPSC)
+static void event_processor_fn(struct k_work *work)
+{
+	struct event_queue *queue = CONTAINER_OF(work, struct event_queue,
+						 work);
+	sys_snode_t *node;
 
-		k_free(eh);
+	while (NULL != (node = mpsc_queue_pop(&queue->eventq))) {
+		event_process(queue, CONTAINER_OF(node, struct event_header,
+						  node));
 	}
 }
 
+static void eventq_append(struct event_queue *queue, struct event_header *eh)
+{
+	mpsc_queue_push(&queue->eventq, &eh->node);
+}
+#else
+static void event_processor_fn(struct k_work *work)
+{
+	struct event_queue *queue = CONTAINER_OF(work, struct event_queue,
+						 work);
+	sys_slist_t events = SYS_SLIST_STATIC_INIT(&events);
+
+	/* Make current event list local. */
+	k_spinlock_key_t key = k_spin_lock(&queue->lock);
+
+	if (sys_slist_is_empty(&queue->eventq)) {
+		k_spin_unlock(&queue->lock, key);
+		return;
+	}
+
+	sys_slist_merge_slist(&events, &queue->eventq);
 
-K_THREAD_STACK_DEFINE(my_stack_area, CONFIG_EVENT_MANAGER_WORKQ_STACK_SIZE);
-struct k_work_q my_work_q;
+	k_spin_unlock(&queue->lock, key);
+
+
+	/* Traverse the list of events. */
+	sys_snode_t *node;
+	while (NULL != (node = sys_slist_get(&events))) {
+		event_process(queue, CONTAINER_OF(node, struct event_header,
+						  node));
+	}
+}
+
+static void eventq_append(struct event_queue *queue, struct event_header *eh)
+{
+	k_spinlock_key_t key = k_spin_lock(&queue->lock);
+
+	sys_slist_append(&queue->eventq, &eh->node);
+
+	k_spin_unlock(&queue->lock, key);
+}
+#endif /* CONFIG_EVENT_MANAGER_QUEUE_MPSC */
 
 void _event_submit(struct event_header *eh)
 {
 	__ASSERT_NO_MSG(eh);
 	ASSERT_EVENT_ID(eh->type_id);
 
+	struct event_queue *queue =
+		event_queue_get(event_dispatch_class_get(eh->type_id));
+
 	trace_event_submission(eh);
 
-	k_spinlock_key_t key = k_spin_lock(&lock);
-	sys_slist_append(&eventq, &eh->node);
-	k_spin_unlock(&lock, key);
+	/* Statistics are updated first, so that the event cannot be dispatched
+	 * before it is counted as submitted.
+	 */
+	stats_event_submitted(queue, eh);
+	eventq_append(queue, eh);
+
+	k_work_submit_to_queue(&queue->work_q, &queue->work);
+}
 
-	k_work_submit_to_queue(&my_work_q, &event_processor);
+void event_manager_free(void *addr)
+{
+#if defined(CONFIG_EVENT_MANAGER_EVENT_POOL)
+	_event_pool_free(addr);
+#else
+	k_free(addr);
+#endif
 }
 
 int event_manager_init(void)
@@ -322,13 +620,25 @@ int event_manager_init(void)
 
 	log_event_init();
 
+	err = dispatch_table_init();
+	if (err) {
+		return err;
+	}
+
 	err = trace_event_init();
 	if (err) {
 		return err;
 	}
 
-	k_work_queue_start(&my_work_q, my_stack_area,
-			K_THREAD_STACK_SIZEOF(my_stack_area), 0, NULL);
+	for (size_t i = 0; i < ARRAY_SIZE(event_queues); i++) {
+		struct event_queue *queue = &event_queues[i];
+		const struct k_work_queue_config cfg = {
+			.name = queue->name,
+		};
+
+		k_work_queue_start(&queue->work_q, queue->stack,
+				   queue->stack_size, queue->prio, &cfg);
+	}
 
 #if defined(CONFIG_EVENT_MANAGER_STORAGE)
 	err = event_store_init();
@@ -340,6 +650,32 @@ int event_manager_init(void)
 	return 0;
 }
 
+#if defined(CONFIG_EVENT_MANAGER_DISPATCH_STATS)
+int event_manager_queue_stats_get(enum event_dispatch_class dclass,
+				  struct event_queue_stats *stats)
+{
+	if (!stats || (dclass >= EVENT_DISPATCH_CLASS_COUNT)) {
+		return -EINVAL;
+	}
+
+	struct event_queue *queue = event_queue_get(dclass);
+	k_spinlock_key_t key = k_spin_lock(&queue->lock);
+
+	*stats = queue->stats;
+
+	k_spin_unlock(&queue->lock, key);
+
+	return 0;
+}
+#endif /* CONFIG_EVENT_MANAGER_DISPATCH_STATS */
+
+#if defined(CONFIG_EVENT_MANAGER_STORAGE)
+struct k_work_q *event_store_work_q_get(void)
+{
+	return &event_queue_get(EVENT_DISPATCH_CLASS_NORMAL)->work_q;
+}
+#endif
+
 int event_manager_clear_storage(void)
 {
 #if defined(CONFIG_EVENT_MANAGER_STORAGE)
@@ -353,3 +689,12 @@ int event_manager_clear_storage(void)
 
 	return 0;
 }
+
+int event_manager_storage_stats_get(struct event_storage_stats *stats)
+{
+#if defined(CONFIG_EVENT_MANAGER_STORAGE)
+	return event_store_stats_get(stats);
+#else
+	return -ENOTSUP;
+#endif
+}
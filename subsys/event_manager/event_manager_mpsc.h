@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _EVENT_MANAGER_MPSC_H_
+#define _EVENT_MANAGER_MPSC_H_
+
+/* Intrusive multi-producer single-consumer queue.
+ *
+ * Producers may push from any context, including interrupts: a push is an
+ * atomic exchange of the queue head followed by linking the previous head to
+ * the new node. Only one thread may pop, without taking a lock.
+ *
+ * The queue always contains a stub node, so that the consumer never has to
+ * modify the head. Between the exchange and the link done by a producer, the
+ * node and all nodes pushed after it are not yet reachable and pop returns
+ * NULL. The exchange and the link are done with a spinlock held, so that
+ * a producer cannot be preempted between them. Otherwise, a preempted low
+ * priority producer would hide the events pushed by higher priorities until
+ * it runs again. The producer must notify the consumer after the push is
+ * complete, so that the remaining nodes are popped.
+ */
+
+#include <zephyr.h>
+#include <sys/atomic.h>
+#include <sys/slist.h>
+#include <spinlock.h>
+
+struct mpsc_queue {
+	/* Node pushed last. Modified by producers. */
+	atomic_ptr_t head;
+
+	/* Node to be popped next. Modified by the consumer only. */
+	sys_snode_t *tail;
+
+	sys_snode_t stub;
+
+	/* Makes the exchange and the link of a push non-preemptible. */
+	struct k_spinlock push_lock;
+};
+
+#define MPSC_QUEUE_INITIALIZER(_queue)			\
+	{						\
+		.head = &(_queue).stub,			\
+		.tail = &(_queue).stub,			\
+		.stub = { .next = NULL },		\
+	}
+
+static inline sys_snode_t *mpsc_node_next(sys_snode_t *node)
+{
+	return atomic_ptr_get((atomic_ptr_t *)&node->next);
+}
+
+static inline void mpsc_queue_push(struct mpsc_queue *queue,
+				   sys_snode_t *node)
+{
+	atomic_ptr_set((atomic_ptr_t *)&node->next, NULL);
+
+	k_spinlock_key_t key = k_spin_lock(&queue->push_lock);
+	sys_snode_t *prev = atomic_ptr_set(&queue->head, node);
+
+	atomic_ptr_set((atomic_ptr_t *)&prev->next, node);
+	k_spin_unlock(&queue->push_lock, key);
+}
+
+static inline sys_snode_t *mpsc_queue_pop(struct mpsc_queue *queue)
+{
+	sys_snode_t *tail = queue->tail;
+	sys_snode_t *next = mpsc_node_next(tail);
+
+	if (tail == &queue->stub) {
+		if (!next) {
+			return NULL;
+		}
+
+		queue->tail = next;
+		tail = next;
+		next = mpsc_node_next(next);
+	}
+
+	if (next) {
+		queue->tail = next;
+		return tail;
+	}
+
+	if (tail != atomic_ptr_get(&queue->head)) {
+		/* A producer did not link its node yet. */
+		return NULL;
+	}
+
+	/* The last node can be popped only if another node follows it. */
+	mpsc_queue_push(queue, &queue->stub);
+
+	next = mpsc_node_next(tail);
+	if (next) {
+		queue->tail = next;
+		return tail;
+	}
+
+	return NULL;
+}
+
+#endif /* _EVENT_MANAGER_MPSC_H_ */
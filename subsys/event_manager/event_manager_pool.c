@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr.h>
+#include <spinlock.h>
+#include <event_manager.h>
+#include <logging/log.h>
+LOG_MODULE_DECLARE(event_manager, CONFIG_EVENT_MANAGER_LOG_LEVEL);
+
+/* Blocks are aligned like heap allocations, so that events with 64-bit
+ * fields can be placed in any pool.
+ */
+#define POOL_ALIGN 8
+
+#define SMALL_BLOCK_SIZE	CONFIG_EVENT_MANAGER_EVENT_POOL_SMALL_BLOCK_SIZE
+#define MEDIUM_BLOCK_SIZE	CONFIG_EVENT_MANAGER_EVENT_POOL_MEDIUM_BLOCK_SIZE
+#define LARGE_BLOCK_SIZE	CONFIG_EVENT_MANAGER_EVENT_POOL_LARGE_BLOCK_SIZE
+
+BUILD_ASSERT((SMALL_BLOCK_SIZE % POOL_ALIGN) == 0,
+	     "Small event pool block size must be a multiple of 8");
+BUILD_ASSERT((MEDIUM_BLOCK_SIZE % POOL_ALIGN) == 0,
+	     "Medium event pool block size must be a multiple of 8");
+BUILD_ASSERT((LARGE_BLOCK_SIZE % POOL_ALIGN) == 0,
+	     "Large event pool block size must be a multiple of 8");
+BUILD_ASSERT((SMALL_BLOCK_SIZE < MEDIUM_BLOCK_SIZE) &&
+	     (MEDIUM_BLOCK_SIZE < LARGE_BLOCK_SIZE),
+	     "Event pool block sizes must be in increasing order");
+
+K_MEM_SLAB_DEFINE(event_pool_small, SMALL_BLOCK_SIZE,
+		  CONFIG_EVENT_MANAGER_EVENT_POOL_SMALL_BLOCK_COUNT, POOL_ALIGN);
+K_MEM_SLAB_DEFINE(event_pool_medium, MEDIUM_BLOCK_SIZE,
+		  CONFIG_EVENT_MANAGER_EVENT_POOL_MEDIUM_BLOCK_COUNT, POOL_ALIGN);
+K_MEM_SLAB_DEFINE(event_pool_large, LARGE_BLOCK_SIZE,
+		  CONFIG_EVENT_MANAGER_EVENT_POOL_LARGE_BLOCK_COUNT, POOL_ALIGN);
+
+struct event_pool {
+	struct k_mem_slab *slab;
+	uint32_t max_used_cnt;
+	uint32_t alloc_cnt;
+	uint32_t exhausted_cnt;
+};
+
+/* Pools must be sorted by block size. */
+static struct event_pool pools[] = {
+	{ .slab = &event_pool_small },
+	{ .slab = &event_pool_medium },
+	{ .slab = &event_pool_large },
+};
+
+BUILD_ASSERT(ARRAY_SIZE(pools) == EVENT_POOL_CNT);
+
+static uint32_t heap_cnt;
+static struct k_spinlock lock;
+
+
+static bool is_pool_block(const struct event_pool *pool, const void *addr)
+{
+	const struct k_mem_slab *slab = pool->slab;
+	const char *start = slab->buffer;
+	const char *end = start + slab->block_size * slab->num_blocks;
+
+	return ((const char *)addr >= start) && ((const char *)addr < end);
+}
+
+static void *heap_alloc(size_t size)
+{
+	void *addr = k_malloc(size);
+
+	if (!addr) {
+		LOG_ERR("No memory for event of size %zu", size);
+	}
+
+	return addr;
+}
+
+void *_event_pool_alloc(size_t size)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(pools); i++) {
+		struct event_pool *pool = &pools[i];
+
+		if (size > pool->slab->block_size) {
+			continue;
+		}
+
+		void *addr;
+		k_spinlock_key_t key = k_spin_lock(&lock);
+
+		if (k_mem_slab_alloc(pool->slab, &addr, K_NO_WAIT)) {
+			pool->exhausted_cnt++;
+			k_spin_unlock(&lock, key);
+
+			/* Do not steal blocks from larger pools. */
+			return heap_alloc(size);
+		}
+
+		uint32_t used_cnt = k_mem_slab_num_used_get(pool->slab);
+
+		pool->alloc_cnt++;
+		pool->max_used_cnt = MAX(pool->max_used_cnt, used_cnt);
+		k_spin_unlock(&lock, key);
+
+		return addr;
+	}
+
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	heap_cnt++;
+	k_spin_unlock(&lock, key);
+
+	return heap_alloc(size);
+}
+
+void _event_pool_free(void *addr)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(pools); i++) {
+		if (is_pool_block(&pools[i], addr)) {
+			k_mem_slab_free(pools[i].slab, &addr);
+			return;
+		}
+	}
+
+	k_free(addr);
+}
+
+int event_manager_pool_stats_get(struct event_pool_stats *stats,
+				 size_t stats_cnt, uint32_t *heap_alloc_cnt)
+{
+	if (!stats || (stats_cnt < ARRAY_SIZE(pools))) {
+		return -EINVAL;
+	}
+
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	for (size_t i = 0; i < ARRAY_SIZE(pools); i++) {
+		const struct event_pool *pool = &pools[i];
+
+		stats[i].block_size = pool->slab->block_size;
+		stats[i].block_cnt = pool->slab->num_blocks;
+		stats[i].used_cnt = k_mem_slab_num_used_get(pool->slab);
+		stats[i].max_used_cnt = pool->max_used_cnt;
+		stats[i].alloc_cnt = pool->alloc_cnt;
+		stats[i].exhausted_cnt = pool->exhausted_cnt;
+	}
+
+	if (heap_alloc_cnt) {
+		*heap_alloc_cnt = heap_cnt;
+	}
+
+	k_spin_unlock(&lock, key);
+
+	return ARRAY_SIZE(pools);
+}
@@ -82,6 +82,26 @@ extern "C" {
 #define _EVENT_ID(ename) (&_CONCAT(__event_type_, ename))
 
 
+/* Allocate memory for an event. Events are taken from the event memory pools
+ * if they are enabled, otherwise from the system heap.
+ */
+#if defined(CONFIG_EVENT_MANAGER_EVENT_POOL)
+void *_event_pool_alloc(size_t size);
+void _event_pool_free(void *addr);
+#define _EVENT_ALLOC(size) _event_pool_alloc(size)
+#else
+#define _EVENT_ALLOC(size) k_malloc(size)
+#endif
+
+
+/* Record event timing samples in the timing histograms. */
+#if defined(CONFIG_EVENT_MANAGER_TIMING_HISTOGRAMS)
+void _event_timing_latency_add(const struct event_type *et, uint32_t time_us);
+void _event_timing_listener_add(const struct event_listener *el,
+				uint32_t time_us);
+#endif
+
+
 /* Macro generates a function of name new_ename where ename is provided as
  * an argument. Allocator function is used to create an event of the given
  * ename type.
@@ -89,7 +109,7 @@ extern "C" {
 #define _EVENT_ALLOCATOR_FN(ename)					\
 	static inline struct ename *_CONCAT(new_, ename)(void)		\
 	{								\
-		struct ename *event = (struct ename *)k_malloc(sizeof(*event));\
+		struct ename *event = (struct ename *)_EVENT_ALLOC(sizeof(*event));\
 		BUILD_ASSERT(offsetof(struct ename, header) == 0,	\
 				 "");					\
 		if (unlikely(!event)) {					\
@@ -114,7 +134,7 @@ extern "C" {
 #define _EVENT_ALLOCATOR_DYNDATA_FN(ename)				\
 	static inline struct ename *_CONCAT(new_, ename)(size_t size)	\
 	{								\
-		struct ename *event = (struct ename *)k_malloc(sizeof(*event) + size);\
+		struct ename *event = (struct ename *)_EVENT_ALLOC(sizeof(*event) + size);\
 		BUILD_ASSERT((offsetof(struct ename, dyndata) +		\
 				  sizeof(event->dyndata.size)) ==	\
 				 sizeof(*event), "");			\
@@ -128,6 +148,9 @@ extern "C" {
 			return NULL;					\
 		}							\
 		event->header.type_id = _EVENT_ID(ename);		\
+		COND_CODE_1(IS_ENABLED(CONFIG_EVENT_MANAGER_STORAGE),	\
+			(event->header.entry_id = 0;),			\
+			())						\
 		event->dyndata.size = size;				\
 		return event;						\
 	}
@@ -224,7 +247,30 @@ extern "C" {
 	_EVENT_ALLOCATOR_DYNDATA_FN(ename)
 
 
+/* Size of the event is kept in the event type if it is needed by storage
+ * or event memory pools.
+ */
+#if defined(CONFIG_EVENT_MANAGER_STORAGE) || \
+	defined(CONFIG_EVENT_MANAGER_EVENT_POOL)
+#define _EVENT_SIZE_DEFINE(ename) .event_size = sizeof(struct ename),
+#else
+#define _EVENT_SIZE_DEFINE(ename)
+#endif
+
+
+#if defined(CONFIG_EVENT_MANAGER_DISPATCH_CLASSES)
+#define _EVENT_DISPATCH_CLASS_DEFINE(dclass) .dispatch_class = dclass,
+#else
+#define _EVENT_DISPATCH_CLASS_DEFINE(dclass)
+#endif
+
+
 #define _EVENT_TYPE_DEFINE(ename, init_log_en, log_fn, ev_info_struct)							\
+	_EVENT_TYPE_DEFINE_DISPATCH_CLASS(ename, EVENT_DISPATCH_CLASS_NORMAL,						\
+					  init_log_en, log_fn, ev_info_struct)
+
+
+#define _EVENT_TYPE_DEFINE_DISPATCH_CLASS(ename, dclass, init_log_en, log_fn, ev_info_struct)				\
 	_EVENT_SUBSCRIBERS_DEFINE(ename);										\
 	BUILD_ASSERT(!(IS_ENABLED(CONFIG_EVENT_MANAGER_STORAGE) &&							\
 		sizeof(struct ename) > CONFIG_EVENT_MANAGER_STORAGE_PAYLOAD_MAX_SIZE));					\
@@ -244,9 +290,8 @@ extern "C" {
 		.init_log_enable		= init_log_en,								\
 		.log_event			= log_fn,								\
 		.ev_info			= ev_info_struct,							\
-		COND_CODE_1(IS_ENABLED(CONFIG_EVENT_MANAGER_STORAGE),							\
-			(.event_size = sizeof(struct ename)),								\
-			())												\
+		_EVENT_SIZE_DEFINE(ename)										\
+		_EVENT_DISPATCH_CLASS_DEFINE(dclass)									\
 	}
 
 #ifdef __cplusplus
@@ -89,6 +89,211 @@ static int show_subscribers(const struct shell *shell, size_t argc,
 	return 0;
 }
 
+#if defined(CONFIG_EVENT_MANAGER_EVENT_POOL)
+static int show_pools(const struct shell *shell, size_t argc,
+		char **argv)
+{
+	struct event_pool_stats stats[EVENT_POOL_CNT];
+	uint32_t heap_cnt;
+	int pool_cnt = event_manager_pool_stats_get(stats, ARRAY_SIZE(stats),
+						    &heap_cnt);
+
+	if (pool_cnt < 0) {
+		shell_error(shell, "Cannot read pool statistics (err %d)",
+			    pool_cnt);
+		return pool_cnt;
+	}
+
+	shell_fprintf(shell, SHELL_NORMAL, "Event pools:\n");
+	for (size_t i = 0; i < pool_cnt; i++) {
+		shell_fprintf(shell, SHELL_NORMAL,
+			      "|\tblock:%zu\tused:%u/%u\tmax:%u\t"
+			      "allocs:%u\texhausted:%u\n",
+			      stats[i].block_size, stats[i].used_cnt,
+			      stats[i].block_cnt, stats[i].max_used_cnt,
+			      stats[i].alloc_cnt, stats[i].exhausted_cnt);
+	}
+	shell_fprintf(shell, SHELL_NORMAL,
+		      "|\ttoo big for any pool: %u\n\n", heap_cnt);
+
+	shell_fprintf(shell, SHELL_NORMAL, "Event sizes:\n");
+	for (const struct event_type *et = __start_event_types;
+	     (et != NULL) && (et != __stop_event_types);
+	     et++) {
+		size_t pool_id;
+
+		for (pool_id = 0; pool_id < pool_cnt; pool_id++) {
+			if (et->event_size <= stats[pool_id].block_size) {
+				break;
+			}
+		}
+
+		if (pool_id < pool_cnt) {
+			shell_fprintf(shell, SHELL_NORMAL,
+				      "|\t[E:%s]\tsize:%zu\tpool:%zu\n",
+				      et->name, et->event_size, pool_id);
+		} else {
+			shell_fprintf(shell, SHELL_NORMAL,
+				      "|\t[E:%s]\tsize:%zu\theap\n",
+				      et->name, et->event_size);
+		}
+	}
+
+	return 0;
+}
+#endif /* CONFIG_EVENT_MANAGER_EVENT_POOL */
+
+#if defined(CONFIG_EVENT_MANAGER_DISPATCH_STATS)
+static int show_queues(const struct shell *shell, size_t argc,
+		char **argv)
+{
+	static const char * const class_names[] = {
+		[EVENT_DISPATCH_CLASS_REALTIME] = "realtime",
+		[EVENT_DISPATCH_CLASS_NORMAL] = "normal",
+		[EVENT_DISPATCH_CLASS_BACKGROUND] = "background",
+	};
+
+	BUILD_ASSERT(ARRAY_SIZE(class_names) == EVENT_DISPATCH_CLASS_COUNT);
+
+	shell_fprintf(shell, SHELL_NORMAL, "Event queues:\n");
+	for (size_t i = 0; i < EVENT_DISPATCH_CLASS_COUNT; i++) {
+		struct event_queue_stats stats;
+		int err = event_manager_queue_stats_get(i, &stats);
+
+		if (err) {
+			shell_error(shell, "Cannot read queue statistics "
+				    "(err %d)", err);
+			return err;
+		}
+
+		uint32_t latency_avg_us = (stats.dispatch_cnt > 0) ?
+			(stats.latency_total_us / stats.dispatch_cnt) : 0;
+
+		const char *name =
+			IS_ENABLED(CONFIG_EVENT_MANAGER_DISPATCH_CLASSES) ?
+			class_names[i] : "all";
+
+		shell_fprintf(shell, SHELL_NORMAL,
+			      "|\t%s\tdepth:%u\tmax depth:%u\t"
+			      "dispatched:%u\tlatency avg:%uus max:%uus\n",
+			      name, stats.depth, stats.max_depth,
+			      stats.dispatch_cnt, latency_avg_us,
+			      stats.latency_max_us);
+
+		if (!IS_ENABLED(CONFIG_EVENT_MANAGER_DISPATCH_CLASSES)) {
+			/* All events are processed by a single queue. */
+			break;
+		}
+	}
+
+	return 0;
+}
+#endif /* CONFIG_EVENT_MANAGER_DISPATCH_STATS */
+
+#if defined(CONFIG_EVENT_MANAGER_TIMING_HISTOGRAMS)
+static void print_histogram(const struct shell *shell, const char *prefix,
+			    const char *name,
+			    const struct event_histogram *hist)
+{
+	uint32_t avg_us = (hist->cnt > 0) ?
+		(hist->total_us / hist->cnt) : 0;
+
+	shell_fprintf(shell, SHELL_NORMAL,
+		      "|\t[%s:%s]\tcnt:%u\tavg:%uus\tmax:%uus\n",
+		      prefix, name, hist->cnt, avg_us, hist->max_us);
+
+	for (size_t i = 0; i < EVENT_HISTOGRAM_BUCKET_CNT; i++) {
+		if (hist->bucket[i] == 0) {
+			continue;
+		}
+
+		if (i == (EVENT_HISTOGRAM_BUCKET_CNT - 1)) {
+			shell_fprintf(shell, SHELL_NORMAL,
+				      "|\t\t>=%luus:\t%u\n",
+				      EVENT_HISTOGRAM_BUCKET_LIMIT_US(i - 1),
+				      hist->bucket[i]);
+		} else {
+			shell_fprintf(shell, SHELL_NORMAL,
+				      "|\t\t<%luus:\t%u\n",
+				      EVENT_HISTOGRAM_BUCKET_LIMIT_US(i),
+				      hist->bucket[i]);
+		}
+	}
+}
+
+static int show_timing(const struct shell *shell, size_t argc,
+		char **argv)
+{
+	struct event_histogram hist;
+
+	shell_fprintf(shell, SHELL_NORMAL, "Event latency:\n");
+	for (const struct event_type *et = __start_event_types;
+	     (et != NULL) && (et != __stop_event_types);
+	     et++) {
+		if (!event_manager_latency_histogram_get(et, &hist) &&
+		    (hist.cnt > 0)) {
+			print_histogram(shell, "E", et->name, &hist);
+		}
+	}
+
+	shell_fprintf(shell, SHELL_NORMAL, "Listener execution time:\n");
+	for (const struct event_listener *el = __start_event_listeners;
+	     el != __stop_event_listeners;
+	     el++) {
+		int err = event_manager_listener_histogram_get(el, &hist);
+
+		if (err) {
+			shell_fprintf(shell, SHELL_NORMAL,
+				      "|\t[L:%s]\tnot measured\n", el->name);
+		} else if (hist.cnt > 0) {
+			print_histogram(shell, "L", el->name, &hist);
+		}
+	}
+
+	return 0;
+}
+
+static int reset_timing(const struct shell *shell, size_t argc,
+		char **argv)
+{
+	event_manager_histograms_reset();
+	shell_fprintf(shell, SHELL_NORMAL, "Timing histograms reset\n");
+
+	return 0;
+}
+#endif /* CONFIG_EVENT_MANAGER_TIMING_HISTOGRAMS */
+
+#if defined(CONFIG_EVENT_MANAGER_STORAGE)
+static int show_storage(const struct shell *shell, size_t argc,
+		char **argv)
+{
+	struct event_storage_stats stats;
+	int err = event_manager_storage_stats_get(&stats);
+
+	if (err) {
+		shell_error(shell, "Cannot read storage statistics (err %d)",
+			    err);
+		return err;
+	}
+
+	uint32_t write_amp = (stats.payload_bytes > 0) ?
+		((uint64_t)stats.flash_bytes * 100 / stats.payload_bytes) : 0;
+
+	shell_fprintf(shell, SHELL_NORMAL,
+		      "Event storage:\n"
+		      "|\tpayload bytes:\t%u\n"
+		      "|\tflash bytes:\t%u\n"
+		      "|\twrite amplification:\t%u.%02u\n"
+		      "|\terased sectors:\t%u\n"
+		      "|\tdropped:\t%u\n",
+		      stats.payload_bytes, stats.flash_bytes,
+		      write_amp / 100, write_amp % 100,
+		      stats.erase_cnt, stats.dropped_cnt);
+
+	return 0;
+}
+#endif /* CONFIG_EVENT_MANAGER_STORAGE */
+
 static void set_event_displaying(const struct shell *shell, size_t argc,
 				 char **argv, bool enable)
 {
@@ -168,6 +373,25 @@ SHELL_STATIC_SUBCMD_SET_CREATE(sub_event_manager,
 	SHELL_CMD_ARG(show_subscribers, NULL, "Show subscribers",
 		      show_subscribers, 0, 0),
 	SHELL_CMD_ARG(show_events, NULL, "Show events", show_events, 0, 0),
+#if defined(CONFIG_EVENT_MANAGER_DISPATCH_STATS)
+	SHELL_CMD_ARG(show_queues, NULL, "Show event queue statistics",
+		      show_queues, 0, 0),
+#endif
+#if defined(CONFIG_EVENT_MANAGER_TIMING_HISTOGRAMS)
+	SHELL_CMD_ARG(show_timing, NULL,
+		      "Show event latency and listener execution time",
+		      show_timing, 0, 0),
+	SHELL_CMD_ARG(reset_timing, NULL, "Reset timing histograms",
+		      reset_timing, 0, 0),
+#endif
+#if defined(CONFIG_EVENT_MANAGER_STORAGE)
+	SHELL_CMD_ARG(show_storage, NULL, "Show event storage statistics",
+		      show_storage, 0, 0),
+#endif
+#if defined(CONFIG_EVENT_MANAGER_EVENT_POOL)
+	SHELL_CMD_ARG(show_pools, NULL, "Show event pool statistics",
+		      show_pools, 0, 0),
+#endif
 	SHELL_CMD_ARG(disable, NULL, "Disable displaying event with given ID",
 		      disable_event_displaying, 0,
 		      sizeof(event_manager_displayed_events) * 8 - 1),
@@ -4,11 +4,134 @@
  * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
  */
 
+#include <string.h>
+#include <stdio.h>
 #include <event_manager.h>
+#include <event_manager_replay_event.h>
+#include <logging/log.h>
 #include "event_manager_storage_priv.h"
+LOG_MODULE_DECLARE(event_manager, CONFIG_EVENT_MANAGER_LOG_LEVEL);
+
+#define TYPE_INDEX_EMPTY	UINT16_MAX
+
+#define FNV_OFFSET_BASIS	0x811c9dc5
+#define FNV_PRIME		0x01000193
 
 static struct event_storage_api *storage_api;
 
+/* Stable identifiers of the event types, indexed by event type index.
+ * Allocated during initialization, as the number of event types is known
+ * only after linking.
+ */
+static uint32_t *type_ids;
+
+/* Open addressing hash table mapping identifiers to event type indexes.
+ * Its size is a power of two, at least twice the number of event types.
+ */
+static uint16_t *type_index;
+static size_t type_index_size;
+
+
+static uint32_t fnv1a(uint32_t hash, const void *data, size_t len)
+{
+	const uint8_t *bytes = data;
+
+	for (size_t i = 0; i < len; i++) {
+		hash ^= bytes[i];
+		hash *= FNV_PRIME;
+	}
+
+	return hash;
+}
+
+/* Identifier of an event type does not depend on the firmware image. It is
+ * computed from the event name and the event size, so that events stored by
+ * a firmware with a different layout of the event are not played.
+ */
+static uint32_t type_id_compute(const struct event_type *et)
+{
+	uint32_t layout = et->event_size;
+	uint32_t hash = fnv1a(FNV_OFFSET_BASIS, et->name, strlen(et->name));
+
+	return fnv1a(hash, &layout, sizeof(layout));
+}
+
+static int type_index_init(void)
+{
+	size_t type_cnt = __stop_event_types - __start_event_types;
+
+	if (type_cnt >= TYPE_INDEX_EMPTY) {
+		return -ENOMEM;
+	}
+
+	if (type_index == NULL) {
+		type_index_size = 1;
+		while (type_index_size < 2 * type_cnt) {
+			type_index_size <<= 1;
+		}
+
+		type_ids = k_malloc(MAX(type_cnt, 1) * sizeof(type_ids[0]));
+		type_index = k_malloc(type_index_size * sizeof(type_index[0]));
+		if ((type_ids == NULL) || (type_index == NULL)) {
+			LOG_ERR("Cannot allocate type index of %zu event types",
+				type_cnt);
+			k_free(type_ids);
+			k_free(type_index);
+			type_ids = NULL;
+			type_index = NULL;
+			return -ENOMEM;
+		}
+	}
+
+	for (size_t slot = 0; slot < type_index_size; slot++) {
+		type_index[slot] = TYPE_INDEX_EMPTY;
+	}
+
+	for (size_t i = 0; i < type_cnt; i++) {
+		uint32_t id = type_id_compute(&__start_event_types[i]);
+		size_t slot = id & (type_index_size - 1);
+
+		while (type_index[slot] != TYPE_INDEX_EMPTY) {
+			if (type_ids[type_index[slot]] == id) {
+				LOG_ERR("Event types %s and %s have the same "
+					"storage identifier",
+					__start_event_types[i].name,
+					__start_event_types[type_index[slot]].name);
+				return -EEXIST;
+			}
+
+			slot = (slot + 1) & (type_index_size - 1);
+		}
+
+		type_ids[i] = id;
+		type_index[slot] = i;
+	}
+
+	return 0;
+}
+
+uint32_t event_store_type_id_get(const struct event_type *et)
+{
+	ASSERT_EVENT_ID(et);
+
+	return type_ids[et - __start_event_types];
+}
+
+const struct event_type *event_store_type_find(uint32_t type_id)
+{
+	size_t slot = type_id & (type_index_size - 1);
+
+	while (type_index[slot] != TYPE_INDEX_EMPTY) {
+		if (type_ids[type_index[slot]] == type_id) {
+			return &__start_event_types[type_index[slot]];
+		}
+
+		slot = (slot + 1) & (type_index_size - 1);
+	}
+
+	return NULL;
+}
+
 int event_store_add(struct event_header *eh)
 {
 	return storage_api->write(eh);
@@ -19,6 +142,123 @@ int event_store_remove(struct event_header *eh)
 	return storage_api->remove(eh);
 }
 
+#if defined(CONFIG_EVENT_MANAGER_STORAGE_REPLAY_INCREMENTAL)
+static int log_replay_progress_event(const struct event_header *eh, char *buf,
+				     size_t buf_len)
+{
+	const struct event_replay_progress_event *event =
+		cast_event_replay_progress_event(eh);
+
+	return snprintf(buf, buf_len, "replayed:%u%s", event->replayed_cnt,
+			event->done ? " done" : "");
+}
+
+EVENT_TYPE_DEFINE(event_replay_progress_event,
+		  true,
+		  log_replay_progress_event,
+		  NULL);
+
+static struct k_work_delayable replay_work;
+static uint32_t replayed_cnt;
+static bool replay_first;
+static bool replay_done;
+
+/* Progress events are allocated without the out of memory handling of the
+ * event allocators, so that the replay continues if there is no memory.
+ * Returns false if the event could not be allocated.
+ */
+static bool replay_progress_submit(bool done)
+{
+	struct event_replay_progress_event *event =
+		_EVENT_ALLOC(sizeof(struct event_replay_progress_event));
+
+	if (!event) {
+		return false;
+	}
+
+	event->header.type_id = _EVENT_ID(event_replay_progress_event);
+	event->header.entry_id = 0;
+	event->replayed_cnt = replayed_cnt;
+	event->done = done;
+	EVENT_SUBMIT(event);
+
+	return true;
+}
+
+/* The final progress event must not be lost, it is retried later if there is
+ * no memory.
+ */
+static void replay_done_submit(void)
+{
+	if (!replay_progress_submit(true)) {
+		LOG_DBG("No memory for replay progress event, retrying");
+		k_work_schedule_for_queue(event_store_work_q_get(),
+			&replay_work,
+			K_MSEC(CONFIG_EVENT_MANAGER_STORAGE_REPLAY_RETRY_MS));
+		return;
+	}
+
+	LOG_DBG("Replay done, %u events played", replayed_cnt);
+}
+
+/* Play a batch of stored events. The work is submitted to the Event Manager
+ * work queue after the batch, so the next batch is read only after the
+ * events of the previous batch are processed.
+ */
+static void replay_work_fn(struct k_work *work)
+{
+	if (replay_done) {
+		replay_done_submit();
+		return;
+	}
+
+	for (size_t i = 0; i < CONFIG_EVENT_MANAGER_STORAGE_REPLAY_BATCH_SIZE;
+	     i++) {
+		struct event_header *header;
+		int err = storage_api->read(&header, replay_first);
+
+		if (err == -ENOMEM) {
+			LOG_DBG("No memory for replayed event, retrying");
+			k_work_schedule_for_queue(event_store_work_q_get(),
+				&replay_work,
+				K_MSEC(CONFIG_EVENT_MANAGER_STORAGE_REPLAY_RETRY_MS));
+			return;
+		} else if (err < 0) {
+			/* No more data */
+			replay_done = true;
+			replay_done_submit();
+			return;
+		}
+
+		replay_first = false;
+		replayed_cnt++;
+		_event_submit(header);
+	}
+
+	/* The next progress event reports the events of this batch, if this
+	 * one cannot be allocated.
+	 */
+	if (!replay_progress_submit(false)) {
+		LOG_DBG("No memory for replay progress event, skipping");
+	}
+
+	k_work_schedule_for_queue(event_store_work_q_get(), &replay_work,
+				  K_NO_WAIT);
+}
+
+static int event_store_play_all(void)
+{
+	replay_first = true;
+	replay_done = false;
+	replayed_cnt = 0;
+
+	k_work_init_delayable(&replay_work, replay_work_fn);
+	k_work_schedule_for_queue(event_store_work_q_get(), &replay_work,
+				  K_NO_WAIT);
+
+	return 0;
+}
+#else
 static int event_store_play_all(void)
 {
 	int err;
@@ -39,11 +279,17 @@ static int event_store_play_all(void)
 		_event_submit(header);
 	}
 }
+#endif /* CONFIG_EVENT_MANAGER_STORAGE_REPLAY_INCREMENTAL */
 
 int event_store_init(void)
 {
 	int err;
 
+	err = type_index_init();
+	if (err) {
+		return err;
+	}
+
 	storage_api = event_store_backend_get_api();
 
 	err = storage_api->init();
@@ -58,3 +304,12 @@ int event_store_clear(void)
 {
 	return storage_api->clear();
 }
+
+int event_store_stats_get(struct event_storage_stats *stats)
+{
+	if (!storage_api->stats_get) {
+		return -ENOTSUP;
+	}
+
+	return storage_api->stats_get(stats);
+}
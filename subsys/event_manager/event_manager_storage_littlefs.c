@@ -4,36 +4,708 @@
  * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
  */
 
+/* LittleFS event storage.
+ *
+ * Events are appended to segment files named after their sequence number.
+ * When a segment reaches CONFIG_EVENT_MANAGER_STORAGE_LITTLEFS_SEGMENT_SIZE,
+ * the next segment is created. Segments containing only consumed events are
+ * deleted. If the number of segments exceeds the number of segments that fit
+ * in the file system, or CONFIG_EVENT_MANAGER_STORAGE_LITTLEFS_MAX_SEGMENTS,
+ * the oldest segment is deleted even if it contains events that were not
+ * consumed.
+ *
+ * The ID of an event is its position in the segment sequence. The ID of the
+ * last consumed event is kept in a cursor file which is updated every
+ * CONFIG_EVENT_MANAGER_STORAGE_LITTLEFS_CURSOR_INTERVAL consumed events.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <event_manager.h>
+#include <fs/fs.h>
+#include <fs/littlefs.h>
+#include <storage/flash_map.h>
+#include <logging/log.h>
 #include "event_manager_storage_priv.h"
+LOG_MODULE_DECLARE(event_manager, CONFIG_EVENT_MANAGER_LOG_LEVEL);
+
+#define STORAGE_PATH	CONFIG_EVENT_MANAGER_STORAGE_LITTLEFS_PATH
+#define SEGMENT_SIZE	CONFIG_EVENT_MANAGER_STORAGE_LITTLEFS_SEGMENT_SIZE
+#define CURSOR_PATH	STORAGE_PATH "/cursor"
+#define PATH_LEN_MAX	(sizeof(STORAGE_PATH) + 16)
+
+/* Blocks used by the superblock and the directory metadata, and free blocks
+ * needed for copy-on-write of the last block of the written segment and for
+ * relocation of a metadata pair.
+ */
+#define FS_RESERVED_BLOCKS	6
+
+struct segment_record_hdr {
+	uint32_t type_id;
+	uint16_t len;
+	uint16_t reserved;
+};
+
+struct event_lfs {
+	uint32_t max_seg_cnt;
+
+	uint32_t oldest_seg;
+	uint32_t write_seg;
+	uint32_t write_off;
+	struct fs_file_t write_file;
+	bool write_file_open;
+	uint32_t unsynced_cnt;
+
+	uint32_t read_seg;
+	uint32_t read_off;
+	struct fs_file_t read_file;
+	bool read_file_open;
+	/* Events written after the replay started are not played. */
+	uint32_t read_end_id;
+
+	uint32_t consumed_id;
+	uint32_t remove_cnt;
+
+	struct event_storage_stats stats;
+};
+
+static struct event_lfs event_lfs;
+static K_MUTEX_DEFINE(lfs_lock);
+static struct k_work_delayable sync_work;
+
+#if defined(CONFIG_EVENT_MANAGER_STORAGE_LITTLEFS_MOUNT)
+FS_LITTLEFS_DECLARE_DEFAULT_CONFIG(events_lfs_data);
+
+static struct fs_mount_t events_lfs_mnt = {
+	.type = FS_LITTLEFS,
+	.fs_data = &events_lfs_data,
+	.storage_dev = (void *)FLASH_AREA_ID(events_storage),
+	.mnt_point = STORAGE_PATH,
+};
+#endif
+
+
+static void segment_path(char *path, uint32_t seg)
+{
+	snprintf(path, PATH_LEN_MAX, STORAGE_PATH "/%08x", seg);
+}
+
+static uint32_t record_id(uint32_t seg, uint32_t off)
+{
+	return seg * SEGMENT_SIZE + off;
+}
+
+static int segment_open(struct fs_file_t *file, uint32_t seg,
+			fs_mode_t flags)
+{
+	char path[PATH_LEN_MAX];
+
+	segment_path(path, seg);
+	fs_file_t_init(file);
+
+	return fs_open(file, path, flags);
+}
+
+/* Events are consumed in order, so a segment is fully consumed once an event
+ * from one of the following segments was consumed.
+ */
+static bool segment_consumed(uint32_t seg)
+{
+	return event_lfs.consumed_id >= record_id(seg + 1, 0);
+}
+
+static int segment_delete(uint32_t seg)
+{
+	char path[PATH_LEN_MAX];
+
+	segment_path(path, seg);
+
+	return fs_unlink(path);
+}
+
+static int write_sync(void)
+{
+	if (event_lfs.unsynced_cnt == 0) {
+		return 0;
+	}
+
+	int err = fs_sync(&event_lfs.write_file);
+
+	if (err) {
+		LOG_ERR("Cannot sync event segment, err %d", err);
+		return err;
+	}
+
+	event_lfs.unsynced_cnt = 0;
+
+	return 0;
+}
+
+static void sync_work_fn(struct k_work *work)
+{
+	k_mutex_lock(&lfs_lock, K_FOREVER);
+	write_sync();
+	k_mutex_unlock(&lfs_lock);
+}
+
+static int cursor_store(void)
+{
+	struct fs_file_t file;
+	int err;
+
+	fs_file_t_init(&file);
+
+	err = fs_open(&file, CURSOR_PATH, FS_O_CREATE | FS_O_RDWR);
+	if (err) {
+		return err;
+	}
+
+	err = fs_write(&file, &event_lfs.consumed_id,
+		       sizeof(event_lfs.consumed_id));
+	fs_close(&file);
+
+	if (err < 0) {
+		return err;
+	}
+
+	event_lfs.stats.flash_bytes += sizeof(event_lfs.consumed_id);
+	event_lfs.remove_cnt = 0;
+
+	/* Delete segments that contain only consumed events. */
+	while ((event_lfs.oldest_seg < event_lfs.write_seg) &&
+	       segment_consumed(event_lfs.oldest_seg)) {
+		if (event_lfs.read_file_open &&
+		    (event_lfs.read_seg == event_lfs.oldest_seg)) {
+			break;
+		}
+
+		err = segment_delete(event_lfs.oldest_seg);
+		if (err) {
+			return err;
+		}
+
+		event_lfs.oldest_seg++;
+	}
+
+	return 0;
+}
+
+static int cursor_load(void)
+{
+	struct fs_file_t file;
+	int err;
+
+	fs_file_t_init(&file);
+
+	err = fs_open(&file, CURSOR_PATH, FS_O_READ);
+	if (err == -ENOENT) {
+		event_lfs.consumed_id = 0;
+		return 0;
+	} else if (err) {
+		return err;
+	}
+
+	err = fs_read(&file, &event_lfs.consumed_id,
+		      sizeof(event_lfs.consumed_id));
+	fs_close(&file);
+
+	if (err != sizeof(event_lfs.consumed_id)) {
+		event_lfs.consumed_id = 0;
+	}
+
+	return 0;
+}
+
+static int segments_scan(void)
+{
+	struct fs_dir_t dir;
+	struct fs_dirent entry;
+	bool found = false;
+	int err;
+
+	fs_dir_t_init(&dir);
+
+	err = fs_opendir(&dir, STORAGE_PATH);
+	if (err) {
+		return err;
+	}
+
+	while (true) {
+		err = fs_readdir(&dir, &entry);
+		if (err || (entry.name[0] == '\0')) {
+			break;
+		}
+
+		char *end;
+		uint32_t seg = strtoul(entry.name, &end, 16);
+
+		if ((entry.type != FS_DIR_ENTRY_FILE) || (*end != '\0')) {
+			continue;
+		}
+
+		if (!found) {
+			event_lfs.oldest_seg = seg;
+			event_lfs.write_seg = seg;
+			found = true;
+		} else {
+			event_lfs.oldest_seg = MIN(event_lfs.oldest_seg, seg);
+			event_lfs.write_seg = MAX(event_lfs.write_seg, seg);
+		}
+	}
+
+	fs_closedir(&dir);
+
+	if (!found) {
+		/* Segment 0 is not used, so that no event has ID 0. */
+		event_lfs.oldest_seg = 1;
+		event_lfs.write_seg = 1;
+	}
+
+	return err;
+}
+
+static int write_segment_open(uint32_t seg)
+{
+	int err = segment_open(&event_lfs.write_file, seg,
+			       FS_O_CREATE | FS_O_RDWR);
+
+	if (err) {
+		return err;
+	}
+
+	err = fs_seek(&event_lfs.write_file, 0, FS_SEEK_END);
+	if (err) {
+		fs_close(&event_lfs.write_file);
+		return err;
+	}
+
+	off_t off = fs_tell(&event_lfs.write_file);
+
+	if (off < 0) {
+		fs_close(&event_lfs.write_file);
+		return off;
+	}
+
+	event_lfs.write_seg = seg;
+	event_lfs.write_off = off;
+	event_lfs.write_file_open = true;
+
+	return 0;
+}
+
+static int write_segment_next(void)
+{
+	int err = write_sync();
+
+	if (err) {
+		return err;
+	}
 
-int event_storage_littlefs_init(void)
+	fs_close(&event_lfs.write_file);
+	event_lfs.write_file_open = false;
+
+	while ((event_lfs.write_seg + 1 - event_lfs.oldest_seg) >=
+	       event_lfs.max_seg_cnt) {
+		if (!segment_consumed(event_lfs.oldest_seg)) {
+			LOG_WRN("Event storage full, dropping unconsumed "
+				"events");
+			event_lfs.stats.dropped_cnt++;
+		}
+
+		if (event_lfs.read_file_open &&
+		    (event_lfs.read_seg == event_lfs.oldest_seg)) {
+			fs_close(&event_lfs.read_file);
+			event_lfs.read_file_open = false;
+			event_lfs.read_seg++;
+			event_lfs.read_off = 0;
+		}
+
+		err = segment_delete(event_lfs.oldest_seg);
+		if (err) {
+			return err;
+		}
+
+		event_lfs.oldest_seg++;
+	}
+
+	return write_segment_open(event_lfs.write_seg + 1);
+}
+
+/* Drop a partially written record, so that the next record is written at
+ * write_off. If the segment cannot be truncated, the next record is written
+ * to a new segment. The partial record is then the last data in the segment,
+ * which the reader skips.
+ */
+static int write_rollback(void)
+{
+	int err = fs_truncate(&event_lfs.write_file, event_lfs.write_off);
+
+	if (!err) {
+		err = fs_seek(&event_lfs.write_file, event_lfs.write_off,
+			      FS_SEEK_SET);
+	}
+
+	if (err) {
+		LOG_WRN("Cannot truncate event segment, err %d", err);
+		err = write_segment_next();
+	}
+
+	return err;
+}
+
+/* Limit the number of segments to the number of segments that fit in the
+ * file system, so that the oldest segment is deleted before the file system
+ * is full.
+ */
+static int max_seg_cnt_init(void)
+{
+	struct fs_statvfs stat;
+	int err = fs_statvfs(STORAGE_PATH, &stat);
+
+	if (err) {
+		return err;
+	}
+
+	/* Blocks following the first block of a file also hold the pointers
+	 * of the littlefs file structure.
+	 */
+	size_t seg_blocks = DIV_ROUND_UP(SEGMENT_SIZE, stat.f_frsize) +
+			    ((SEGMENT_SIZE > stat.f_frsize) ? 1 : 0);
+	size_t seg_cnt = 0;
+
+	if (stat.f_blocks > FS_RESERVED_BLOCKS) {
+		seg_cnt = (stat.f_blocks - FS_RESERVED_BLOCKS) / seg_blocks;
+	}
+
+	if (seg_cnt < 2) {
+		LOG_ERR("Event storage too small for %d byte segments",
+			SEGMENT_SIZE);
+		return -ENOSPC;
+	}
+
+	event_lfs.max_seg_cnt =
+		MIN(seg_cnt, CONFIG_EVENT_MANAGER_STORAGE_LITTLEFS_MAX_SEGMENTS);
+
+	return 0;
+}
+
+/* Close the files of a previous initialization, like after a reset. */
+static void event_storage_littlefs_uninit(void)
+{
+	k_work_cancel_delayable(&sync_work);
+
+	if (event_lfs.read_file_open) {
+		fs_close(&event_lfs.read_file);
+		event_lfs.read_file_open = false;
+	}
+
+	if (event_lfs.write_file_open) {
+		fs_close(&event_lfs.write_file);
+		event_lfs.write_file_open = false;
+	}
+
+#if defined(CONFIG_EVENT_MANAGER_STORAGE_LITTLEFS_MOUNT)
+	fs_unmount(&events_lfs_mnt);
+#endif
+}
+
+static int event_storage_littlefs_init(void)
+{
+	static bool initialized;
+	int err;
+
+	if (initialized) {
+		event_storage_littlefs_uninit();
+	}
+
+	initialized = true;
+
+#if defined(CONFIG_EVENT_MANAGER_STORAGE_LITTLEFS_MOUNT)
+	err = fs_mount(&events_lfs_mnt);
+	if (err) {
+		LOG_ERR("Cannot mount event storage, err %d", err);
+		return err;
+	}
+#else
+	err = fs_mkdir(STORAGE_PATH);
+	if (err && (err != -EEXIST)) {
+		return err;
+	}
+#endif
+
+	k_work_init_delayable(&sync_work, sync_work_fn);
+
+	k_mutex_lock(&lfs_lock, K_FOREVER);
+
+	event_lfs.unsynced_cnt = 0;
+	event_lfs.remove_cnt = 0;
+
+	err = max_seg_cnt_init();
+	if (!err) {
+		err = segments_scan();
+	}
+	if (!err) {
+		err = cursor_load();
+	}
+	if (!err) {
+		err = write_segment_open(event_lfs.write_seg);
+	}
+
+	k_mutex_unlock(&lfs_lock);
+
+	LOG_DBG("Event segments %u..%u of %u, cursor %u", event_lfs.oldest_seg,
+		event_lfs.write_seg, event_lfs.max_seg_cnt,
+		event_lfs.consumed_id);
+
+	return err;
+}
+
+static int event_storage_littlefs_write(struct event_header *eh)
+{
+	struct segment_record_hdr rec = {
+		.type_id = event_store_type_id_get(eh->type_id),
+		.len = eh->type_id->event_size - sizeof(struct event_header),
+	};
+	size_t rec_size = sizeof(rec) + rec.len;
+	ssize_t len;
+	int err = 0;
+
+	k_mutex_lock(&lfs_lock, K_FOREVER);
+
+	if (event_lfs.write_off + rec_size > SEGMENT_SIZE) {
+		err = write_segment_next();
+		if (err) {
+			goto out;
+		}
+	}
+
+	eh->entry_id = record_id(event_lfs.write_seg, event_lfs.write_off);
+
+	len = fs_write(&event_lfs.write_file, &rec, sizeof(rec));
+	if (len == sizeof(rec)) {
+		len = fs_write(&event_lfs.write_file, eh + 1, rec.len);
+		if (len == rec.len) {
+			len = rec_size;
+		}
+	}
+	if (len != (ssize_t)rec_size) {
+		/* A short write means that the file system is full. */
+		err = (len < 0) ? len : -ENOSPC;
+		write_rollback();
+		goto out;
+	}
+
+	event_lfs.write_off += rec_size;
+	event_lfs.stats.payload_bytes += rec.len;
+	event_lfs.stats.flash_bytes += rec_size;
+	event_lfs.unsynced_cnt++;
+
+	if (event_lfs.unsynced_cnt >=
+	    CONFIG_EVENT_MANAGER_STORAGE_LITTLEFS_SYNC_INTERVAL) {
+		err = write_sync();
+	} else {
+		k_work_schedule(&sync_work,
+			K_MSEC(CONFIG_EVENT_MANAGER_STORAGE_LITTLEFS_SYNC_DELAY_MS));
+		err = 0;
+	}
+
+out:
+	k_mutex_unlock(&lfs_lock);
+
+	if (err) {
+		LOG_ERR("Could not write event to littlefs, err %d", err);
+	}
+
+	return err;
+}
+
+static int event_storage_littlefs_remove(struct event_header *eh)
 {
-	/* TODO */
-	return -ENOTSUP;
+	int err = 0;
+
+	if (eh->entry_id == 0) {
+		return 0;
+	}
+
+	k_mutex_lock(&lfs_lock, K_FOREVER);
+
+	event_lfs.consumed_id = MAX(event_lfs.consumed_id, eh->entry_id);
+	event_lfs.remove_cnt++;
+
+	if (event_lfs.remove_cnt >=
+	    CONFIG_EVENT_MANAGER_STORAGE_LITTLEFS_CURSOR_INTERVAL) {
+		err = cursor_store();
+	}
+
+	k_mutex_unlock(&lfs_lock);
+
+	return err;
 }
 
-int event_storage_littlefs_write(struct event_header *eh)
+static int read_segment_next(void)
 {
-	/* TODO */
-	return -ENOTSUP;
+	if (event_lfs.read_file_open) {
+		fs_close(&event_lfs.read_file);
+		event_lfs.read_file_open = false;
+	}
+
+	if (event_lfs.read_seg >= event_lfs.write_seg) {
+		return -ENOENT;
+	}
+
+	event_lfs.read_seg++;
+	event_lfs.read_off = 0;
+
+	return 0;
 }
 
-int event_storage_littlefs_read(struct event_header **eh, bool from_start)
+static int event_storage_littlefs_read(struct event_header **eh,
+				       bool from_start)
 {
-	/* TODO */
-	return -ENOTSUP;
+	int err;
+
+	k_mutex_lock(&lfs_lock, K_FOREVER);
+
+	if (from_start) {
+		if (event_lfs.read_file_open) {
+			fs_close(&event_lfs.read_file);
+			event_lfs.read_file_open = false;
+		}
+
+		event_lfs.read_seg = event_lfs.oldest_seg;
+		event_lfs.read_off = 0;
+		event_lfs.read_end_id = record_id(event_lfs.write_seg,
+						  event_lfs.write_off);
+	}
+
+	/* Make the events written so far visible for reading. */
+	err = write_sync();
+
+	while (!err) {
+		if (!event_lfs.read_file_open) {
+			err = segment_open(&event_lfs.read_file,
+					   event_lfs.read_seg, FS_O_READ);
+			if (err) {
+				break;
+			}
+
+			event_lfs.read_file_open = true;
+
+			err = fs_seek(&event_lfs.read_file,
+				      event_lfs.read_off, FS_SEEK_SET);
+			if (err) {
+				break;
+			}
+		}
+
+		struct segment_record_hdr rec;
+		uint32_t id = record_id(event_lfs.read_seg, event_lfs.read_off);
+
+		if (id >= event_lfs.read_end_id) {
+			err = -ENOENT;
+			break;
+		}
+
+		ssize_t len = fs_read(&event_lfs.read_file, &rec, sizeof(rec));
+
+		if (len != sizeof(rec)) {
+			err = read_segment_next();
+			continue;
+		}
+
+		const struct event_type *et = event_store_type_find(rec.type_id);
+
+		if ((id <= event_lfs.consumed_id) || !et ||
+		    (rec.len != et->event_size - sizeof(struct event_header))) {
+			if ((id > event_lfs.consumed_id) && !et) {
+				LOG_WRN("Unknown event type 0x%08x in littlefs "
+					"storage", rec.type_id);
+			}
+
+			err = fs_seek(&event_lfs.read_file, rec.len,
+				      FS_SEEK_CUR);
+			event_lfs.read_off += sizeof(rec) + rec.len;
+			continue;
+		}
+
+		struct event_header *header =
+			_EVENT_ALLOC(sizeof(struct event_header) + rec.len);
+
+		if (!header) {
+			LOG_ERR("Could not allocate memory for event");
+			/* Read the event again on next call. */
+			fs_seek(&event_lfs.read_file, event_lfs.read_off,
+				FS_SEEK_SET);
+			err = -ENOMEM;
+			break;
+		}
+
+		len = fs_read(&event_lfs.read_file, header + 1, rec.len);
+		if (len != rec.len) {
+			event_manager_free(header);
+			err = read_segment_next();
+			continue;
+		}
+
+		event_lfs.read_off += sizeof(rec) + rec.len;
+
+		header->type_id = et;
+		header->entry_id = id;
+		*eh = header;
+		break;
+	}
+
+	k_mutex_unlock(&lfs_lock);
+
+	return err;
 }
 
-int event_storage_littlefs_remove(struct event_header *eh)
+static int event_storage_littlefs_clear(void)
 {
-	/* TODO */
-	return -ENOTSUP;
+	int err;
+
+	k_mutex_lock(&lfs_lock, K_FOREVER);
+
+	fs_close(&event_lfs.write_file);
+	event_lfs.write_file_open = false;
+	if (event_lfs.read_file_open) {
+		fs_close(&event_lfs.read_file);
+		event_lfs.read_file_open = false;
+	}
+
+	for (uint32_t seg = event_lfs.oldest_seg; seg <= event_lfs.write_seg;
+	     seg++) {
+		err = segment_delete(seg);
+		if (err && (err != -ENOENT)) {
+			goto out;
+		}
+	}
+
+	err = fs_unlink(CURSOR_PATH);
+	if (err && (err != -ENOENT)) {
+		goto out;
+	}
+
+	event_lfs.consumed_id = 0;
+	event_lfs.remove_cnt = 0;
+	event_lfs.unsynced_cnt = 0;
+	event_lfs.oldest_seg = 1;
+
+	err = write_segment_open(1);
+
+out:
+	k_mutex_unlock(&lfs_lock);
+
+	return err;
 }
 
-int event_storage_littlefs_clear(void)
+static int event_storage_littlefs_stats_get(struct event_storage_stats *stats)
 {
-	/* TODO */
-	return -ENOTSUP;
+	k_mutex_lock(&lfs_lock, K_FOREVER);
+	*stats = event_lfs.stats;
+	k_mutex_unlock(&lfs_lock);
+
+	return 0;
 }
 
 static struct event_storage_api api = {
@@ -41,7 +713,8 @@ static struct event_storage_api api = {
 	.write = event_storage_littlefs_write,
 	.read = event_storage_littlefs_read,
 	.remove = event_storage_littlefs_remove,
-	.clear = event_storage_littlefs_clear
+	.clear = event_storage_littlefs_clear,
+	.stats_get = event_storage_littlefs_stats_get,
 };
 
 struct event_storage_api *event_store_backend_get_api(void)
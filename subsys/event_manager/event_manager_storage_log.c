@@ -0,0 +1,757 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/* Append-only event log.
+ *
+ * The storage partition is used as a ring of flash sectors. Every sector
+ * starts with a header holding a sequence number, followed by records:
+ *
+ * - event records holding the event type identifier and the event payload,
+ * - cursor records holding the ID of the last consumed event,
+ * - commit records closing a batch of records with its CRC.
+ *
+ * Records are collected in a RAM buffer and written to flash in batches.
+ * A batch is valid only if it is closed by a commit record with a matching
+ * CRC. The ID of an event is its position in the log.
+ *
+ * Consumed events are not deleted. Instead, the consumption cursor is kept
+ * in RAM and appended to the log every
+ * CONFIG_EVENT_MANAGER_STORAGE_LOG_CURSOR_INTERVAL consumed events and at the
+ * beginning of every sector. After a reboot, events consumed after the last
+ * persisted cursor are played again.
+ */
+
+#include <event_manager.h>
+#include <storage/flash_map.h>
+#include <sys/crc.h>
+#include <logging/log.h>
+#include "event_manager_storage_priv.h"
+LOG_MODULE_DECLARE(event_manager, CONFIG_EVENT_MANAGER_LOG_LEVEL);
+
+#define LOG_SECTOR_MAGIC	0x474c5645 /* "EVLG" */
+#define LOG_ALIGN_MAX		8
+#define CRC_SEED		0xffff
+
+enum log_record_kind {
+	LOG_RECORD_EVENT	= 0x01,
+	LOG_RECORD_CURSOR	= 0x02,
+	LOG_RECORD_COMMIT	= 0x03,
+};
+
+struct log_sector_hdr {
+	uint32_t magic;
+	uint32_t seq;
+};
+
+struct log_record_hdr {
+	uint8_t kind;
+	uint8_t reserved;
+	/* Length of the payload following the header. */
+	uint16_t len;
+	/* Event type identifier, consumed event ID or batch CRC. */
+	uint32_t value;
+};
+
+BUILD_ASSERT(sizeof(struct log_sector_hdr) == LOG_ALIGN_MAX);
+BUILD_ASSERT(sizeof(struct log_record_hdr) == LOG_ALIGN_MAX);
+BUILD_ASSERT(CONFIG_EVENT_MANAGER_STORAGE_LOG_BUF_SIZE >=
+	     (CONFIG_EVENT_MANAGER_STORAGE_PAYLOAD_MAX_SIZE +
+	      3 * sizeof(struct log_record_hdr) + LOG_ALIGN_MAX),
+	     "Log buffer too small to hold the largest event");
+
+struct event_log {
+	const struct flash_area *fa;
+	size_t sector_size;
+	uint32_t sector_cnt;
+	size_t align;
+	uint8_t erased_val;
+
+	uint32_t oldest_sector;
+	uint32_t oldest_seq;
+
+	uint32_t write_sector;
+	uint32_t write_seq;
+	size_t write_off;
+
+	uint32_t read_sector;
+	uint32_t read_seq;
+	size_t read_off;
+	size_t read_batch_end;
+	/* Records written after the replay started are not played. */
+	uint32_t read_end_id;
+
+	uint32_t consumed_id;
+	uint32_t remove_cnt;
+
+	uint8_t buf[CONFIG_EVENT_MANAGER_STORAGE_LOG_BUF_SIZE]
+		__aligned(LOG_ALIGN_MAX);
+	size_t buf_len;
+
+	struct event_storage_stats stats;
+};
+
+static struct event_log event_log;
+static K_MUTEX_DEFINE(log_lock);
+static struct k_work_delayable commit_work;
+
+
+static size_t record_size(size_t payload_len)
+{
+	return ROUND_UP(sizeof(struct log_record_hdr) + payload_len,
+			event_log.align);
+}
+
+static size_t first_record_off(void)
+{
+	return ROUND_UP(sizeof(struct log_sector_hdr), event_log.align);
+}
+
+static off_t sector_addr(uint32_t sector)
+{
+	return (off_t)sector * event_log.sector_size;
+}
+
+static uint32_t next_sector(uint32_t sector)
+{
+	return (sector + 1) % event_log.sector_cnt;
+}
+
+static uint32_t record_id(uint32_t seq, size_t off)
+{
+	return seq * event_log.sector_size + off;
+}
+
+static int sector_hdr_read(uint32_t sector, struct log_sector_hdr *hdr)
+{
+	int err = flash_area_read(event_log.fa, sector_addr(sector), hdr,
+				  sizeof(*hdr));
+
+	if (err) {
+		return err;
+	}
+
+	return (hdr->magic == LOG_SECTOR_MAGIC) ? 0 : -ENOENT;
+}
+
+static bool record_is_erased(const struct log_record_hdr *rec)
+{
+	const uint8_t *data = (const uint8_t *)rec;
+
+	for (size_t i = 0; i < sizeof(*rec); i++) {
+		if (data[i] != event_log.erased_val) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/* Validate the batch starting at a given offset.
+ *
+ * On success, batch_end is set to the offset directly after the commit
+ * record and cursor to the value of the last cursor record in the batch.
+ */
+static int batch_scan(uint32_t sector, size_t off, size_t *batch_end,
+		      uint32_t *cursor)
+{
+	uint16_t crc = CRC_SEED;
+	bool cursor_found = false;
+	uint32_t cursor_val = 0;
+
+	while (off + sizeof(struct log_record_hdr) <= event_log.sector_size) {
+		struct log_record_hdr rec;
+		int err = flash_area_read(event_log.fa,
+					  sector_addr(sector) + off,
+					  &rec, sizeof(rec));
+
+		if (err) {
+			return err;
+		}
+
+		if (record_is_erased(&rec)) {
+			return -ENOENT;
+		}
+
+		size_t rec_size = record_size(rec.len);
+
+		if (off + rec_size > event_log.sector_size) {
+			return -EBADMSG;
+		}
+
+		switch (rec.kind) {
+		case LOG_RECORD_COMMIT:
+			if (rec.value != crc) {
+				return -EBADMSG;
+			}
+
+			if (cursor && cursor_found) {
+				*cursor = cursor_val;
+			}
+			*batch_end = off + rec_size;
+			return 0;
+
+		case LOG_RECORD_CURSOR:
+			cursor_found = true;
+			cursor_val = rec.value;
+			break;
+
+		case LOG_RECORD_EVENT:
+			break;
+
+		default:
+			return -EBADMSG;
+		}
+
+		/* Include record header, payload and padding in the CRC. */
+		uint8_t chunk[32] __aligned(4);
+
+		for (size_t pos = 0; pos < rec_size; pos += sizeof(chunk)) {
+			size_t len = MIN(sizeof(chunk), rec_size - pos);
+
+			err = flash_area_read(event_log.fa,
+					      sector_addr(sector) + off + pos,
+					      chunk, len);
+			if (err) {
+				return err;
+			}
+
+			crc = crc16_ccitt(crc, chunk, len);
+		}
+
+		off += rec_size;
+	}
+
+	return -ENOENT;
+}
+
+static void buf_append(const struct log_record_hdr *rec, const void *payload)
+{
+	size_t rec_size = record_size(rec->len);
+	uint8_t *dst = &event_log.buf[event_log.buf_len];
+
+	memcpy(dst, rec, sizeof(*rec));
+	if (rec->len > 0) {
+		memcpy(dst + sizeof(*rec), payload, rec->len);
+	}
+	memset(dst + sizeof(*rec) + rec->len, event_log.erased_val,
+	       rec_size - sizeof(*rec) - rec->len);
+
+	event_log.buf_len += rec_size;
+}
+
+static void buf_append_cursor(void)
+{
+	struct log_record_hdr rec = {
+		.kind = LOG_RECORD_CURSOR,
+		.value = event_log.consumed_id,
+	};
+
+	buf_append(&rec, NULL);
+	event_log.remove_cnt = 0;
+}
+
+static int log_flush(void)
+{
+	if (event_log.buf_len == 0) {
+		return 0;
+	}
+
+	struct log_record_hdr commit = {
+		.kind = LOG_RECORD_COMMIT,
+		.value = crc16_ccitt(CRC_SEED, event_log.buf,
+				     event_log.buf_len),
+	};
+
+	buf_append(&commit, NULL);
+
+	int err = flash_area_write(event_log.fa,
+				   sector_addr(event_log.write_sector) +
+				   event_log.write_off,
+				   event_log.buf, event_log.buf_len);
+
+	if (err) {
+		LOG_ERR("Cannot write event log batch, err %d", err);
+		/* Part of the batch may have been written. Continue in
+		 * the next sector.
+		 */
+		event_log.write_off = event_log.sector_size;
+		event_log.buf_len = 0;
+		return err;
+	}
+
+	event_log.stats.flash_bytes += event_log.buf_len;
+	event_log.write_off += event_log.buf_len;
+	event_log.buf_len = 0;
+
+	return 0;
+}
+
+static int sector_open(uint32_t sector, uint32_t seq)
+{
+	int err = flash_area_erase(event_log.fa, sector_addr(sector),
+				   event_log.sector_size);
+
+	if (err) {
+		return err;
+	}
+
+	event_log.stats.erase_cnt++;
+
+	struct log_sector_hdr hdr = {
+		.magic = LOG_SECTOR_MAGIC,
+		.seq = seq,
+	};
+
+	/* Sector header size is a multiple of the supported write block
+	 * sizes, no padding is needed.
+	 */
+	err = flash_area_write(event_log.fa, sector_addr(sector), &hdr,
+			       sizeof(hdr));
+	if (err) {
+		return err;
+	}
+
+	event_log.stats.flash_bytes += sizeof(hdr);
+
+	event_log.write_sector = sector;
+	event_log.write_seq = seq;
+	event_log.write_off = first_record_off();
+
+	/* Start every sector with the cursor, so that it is not lost when
+	 * older sectors are erased.
+	 */
+	buf_append_cursor();
+
+	return 0;
+}
+
+static int sector_open_next(void)
+{
+	uint32_t sector = next_sector(event_log.write_sector);
+
+	if (sector == event_log.oldest_sector) {
+		/* Log is full, drop the oldest sector. */
+		uint32_t sector_end_id = record_id(event_log.oldest_seq + 1,
+						   0);
+
+		if (event_log.consumed_id < sector_end_id) {
+			LOG_WRN("Event log full, dropping unconsumed events");
+			event_log.stats.dropped_cnt++;
+		}
+
+		event_log.oldest_sector = next_sector(event_log.oldest_sector);
+		event_log.oldest_seq++;
+	}
+
+	return sector_open(sector, event_log.write_seq + 1);
+}
+
+/* Make room for a record of a given size in the write buffer. */
+static int log_reserve(size_t rec_size)
+{
+	size_t commit_size = record_size(0);
+	int err;
+
+	if (event_log.buf_len + rec_size + commit_size >
+	    sizeof(event_log.buf)) {
+		err = log_flush();
+		if (err) {
+			return err;
+		}
+	}
+
+	if (event_log.write_off + event_log.buf_len + rec_size +
+	    commit_size > event_log.sector_size) {
+		err = log_flush();
+		if (err) {
+			return err;
+		}
+
+		err = sector_open_next();
+		if (err) {
+			return err;
+		}
+	}
+
+	return 0;
+}
+
+static int log_commit(void)
+{
+	if (CONFIG_EVENT_MANAGER_STORAGE_LOG_COMMIT_DELAY_MS == 0) {
+		return log_flush();
+	}
+
+	k_work_schedule(&commit_work,
+			K_MSEC(CONFIG_EVENT_MANAGER_STORAGE_LOG_COMMIT_DELAY_MS));
+
+	return 0;
+}
+
+static void commit_work_fn(struct k_work *work)
+{
+	k_mutex_lock(&log_lock, K_FOREVER);
+	log_flush();
+	k_mutex_unlock(&log_lock);
+}
+
+static int log_recover(void)
+{
+	struct log_sector_hdr hdr;
+	uint32_t newest = 0;
+	uint32_t newest_seq = 0;
+	bool found = false;
+
+	/* Only the state kept in flash survives a reset. */
+	event_log.buf_len = 0;
+	event_log.consumed_id = 0;
+	event_log.remove_cnt = 0;
+
+	for (uint32_t i = 0; i < event_log.sector_cnt; i++) {
+		int err = sector_hdr_read(i, &hdr);
+
+		if (err == -ENOENT) {
+			continue;
+		} else if (err) {
+			return err;
+		}
+
+		if (!found || (hdr.seq > newest_seq)) {
+			newest = i;
+			newest_seq = hdr.seq;
+			found = true;
+		}
+	}
+
+	if (!found) {
+		LOG_DBG("Event log empty");
+		event_log.oldest_sector = 0;
+		event_log.oldest_seq = 1;
+		return sector_open(0, 1);
+	}
+
+	/* Sectors are written in ring order. Walk back to the oldest one. */
+	event_log.oldest_sector = newest;
+	event_log.oldest_seq = newest_seq;
+
+	for (uint32_t i = 1; i < event_log.sector_cnt; i++) {
+		uint32_t sector = (newest + event_log.sector_cnt - i) %
+				  event_log.sector_cnt;
+
+		if (sector_hdr_read(sector, &hdr) ||
+		    (hdr.seq != newest_seq - i)) {
+			break;
+		}
+
+		event_log.oldest_sector = sector;
+		event_log.oldest_seq = hdr.seq;
+	}
+
+	/* Restore the cursor and find the end of the log. */
+	uint32_t sector = event_log.oldest_sector;
+	size_t off;
+
+	for (uint32_t seq = event_log.oldest_seq; seq <= newest_seq; seq++) {
+		size_t batch_end;
+
+		off = first_record_off();
+		while (!batch_scan(sector, off, &batch_end,
+				   &event_log.consumed_id)) {
+			off = batch_end;
+		}
+
+		if (seq != newest_seq) {
+			sector = next_sector(sector);
+		}
+	}
+
+	LOG_DBG("Event log sectors %u..%u, cursor %u", event_log.oldest_seq,
+		newest_seq, event_log.consumed_id);
+
+	struct log_record_hdr rec;
+	bool tail_erased = false;
+
+	if (off + sizeof(rec) <= event_log.sector_size) {
+		int err = flash_area_read(event_log.fa,
+					  sector_addr(newest) + off,
+					  &rec, sizeof(rec));
+
+		if (err) {
+			return err;
+		}
+
+		tail_erased = record_is_erased(&rec);
+	}
+
+	event_log.write_sector = newest;
+	event_log.write_seq = newest_seq;
+	event_log.write_off = off;
+
+	if (!tail_erased) {
+		/* Interrupted batch or full sector, continue in the next
+		 * sector.
+		 */
+		return sector_open_next();
+	}
+
+	return 0;
+}
+
+static int event_storage_log_init(void)
+{
+	uint32_t sector_cnt = 1;
+	struct flash_sector hw_flash_sector;
+	int err;
+
+	err = flash_area_open(FLASH_AREA_ID(events_storage), &event_log.fa);
+	if (err) {
+		return err;
+	}
+
+	err = flash_area_get_sectors(FLASH_AREA_ID(events_storage), &sector_cnt,
+		&hw_flash_sector);
+	if ((err != 0) && (err != -ENOMEM)) {
+		return err;
+	}
+
+	event_log.sector_size = hw_flash_sector.fs_size;
+	event_log.sector_cnt = event_log.fa->fa_size / event_log.sector_size;
+	event_log.align = flash_area_align(event_log.fa);
+	event_log.erased_val = flash_area_erased_val(event_log.fa);
+
+	if ((event_log.sector_cnt < 2) || (event_log.align > LOG_ALIGN_MAX) ||
+	    (LOG_ALIGN_MAX % event_log.align)) {
+		LOG_ERR("Unsupported event storage partition layout");
+		return -EINVAL;
+	}
+
+	k_work_init_delayable(&commit_work, commit_work_fn);
+
+	k_mutex_lock(&log_lock, K_FOREVER);
+	err = log_recover();
+	if (!err) {
+		err = log_flush();
+	}
+	k_mutex_unlock(&log_lock);
+
+	return err;
+}
+
+static int event_storage_log_write(struct event_header *eh)
+{
+	size_t len = eh->type_id->event_size - sizeof(struct event_header);
+	struct log_record_hdr rec = {
+		.kind = LOG_RECORD_EVENT,
+		.len = len,
+		.value = event_store_type_id_get(eh->type_id),
+	};
+	int err;
+
+	k_mutex_lock(&log_lock, K_FOREVER);
+
+	err = log_reserve(record_size(len));
+	if (err) {
+		goto out;
+	}
+
+	eh->entry_id = record_id(event_log.write_seq,
+				 event_log.write_off + event_log.buf_len);
+	buf_append(&rec, eh + 1);
+	event_log.stats.payload_bytes += len;
+
+	err = log_commit();
+
+out:
+	k_mutex_unlock(&log_lock);
+
+	if (err) {
+		LOG_ERR("Could not write event to log, err %d", err);
+	}
+
+	return err;
+}
+
+static int event_storage_log_remove(struct event_header *eh)
+{
+	int err = 0;
+
+	if (eh->entry_id == 0) {
+		return 0;
+	}
+
+	k_mutex_lock(&log_lock, K_FOREVER);
+
+	event_log.consumed_id = MAX(event_log.consumed_id, eh->entry_id);
+	event_log.remove_cnt++;
+
+	if (event_log.remove_cnt >=
+	    CONFIG_EVENT_MANAGER_STORAGE_LOG_CURSOR_INTERVAL) {
+		err = log_reserve(record_size(0));
+		if (!err) {
+			buf_append_cursor();
+			err = log_commit();
+		}
+	}
+
+	k_mutex_unlock(&log_lock);
+
+	return err;
+}
+
+static int event_storage_log_read(struct event_header **eh, bool from_start)
+{
+	int err;
+
+	k_mutex_lock(&log_lock, K_FOREVER);
+
+	if (from_start) {
+		event_log.read_sector = event_log.oldest_sector;
+		event_log.read_seq = event_log.oldest_seq;
+		event_log.read_off = first_record_off();
+		event_log.read_batch_end = event_log.read_off;
+		event_log.read_end_id =
+			record_id(event_log.write_seq,
+				  event_log.write_off + event_log.buf_len);
+	}
+
+	if (event_log.read_seq < event_log.oldest_seq) {
+		/* The sector being read has been erased to make room for new
+		 * events. Continue with the oldest remaining sector.
+		 */
+		LOG_WRN("Replayed events dropped from the log");
+		event_log.read_sector = event_log.oldest_sector;
+		event_log.read_seq = event_log.oldest_seq;
+		event_log.read_off = first_record_off();
+		event_log.read_batch_end = event_log.read_off;
+	}
+
+	while (true) {
+		if (event_log.read_off >= event_log.read_batch_end) {
+			err = batch_scan(event_log.read_sector,
+					 event_log.read_off,
+					 &event_log.read_batch_end, NULL);
+			if (err) {
+				if (event_log.read_seq >= event_log.write_seq) {
+					err = -ENOENT;
+					break;
+				}
+
+				event_log.read_sector =
+					next_sector(event_log.read_sector);
+				event_log.read_seq++;
+				event_log.read_off = first_record_off();
+				event_log.read_batch_end = event_log.read_off;
+				continue;
+			}
+		}
+
+		struct log_record_hdr rec;
+		off_t addr = sector_addr(event_log.read_sector) +
+			     event_log.read_off;
+		uint32_t id = record_id(event_log.read_seq,
+					event_log.read_off);
+
+		if (id >= event_log.read_end_id) {
+			err = -ENOENT;
+			break;
+		}
+
+		err = flash_area_read(event_log.fa, addr, &rec, sizeof(rec));
+		if (err) {
+			break;
+		}
+
+		event_log.read_off += record_size(rec.len);
+
+		if ((rec.kind != LOG_RECORD_EVENT) ||
+		    (id <= event_log.consumed_id)) {
+			continue;
+		}
+
+		const struct event_type *et = event_store_type_find(rec.value);
+
+		if (!et ||
+		    (rec.len != et->event_size - sizeof(struct event_header))) {
+			LOG_WRN("Unknown event in log, skipping");
+			continue;
+		}
+
+		struct event_header *header =
+			_EVENT_ALLOC(sizeof(struct event_header) + rec.len);
+
+		if (!header) {
+			LOG_ERR("Could not allocate memory for event");
+			/* Read the event again on next call. */
+			event_log.read_off -= record_size(rec.len);
+			err = -ENOMEM;
+			break;
+		}
+
+		err = flash_area_read(event_log.fa, addr + sizeof(rec),
+				      header + 1, rec.len);
+		if (err) {
+			event_manager_free(header);
+			break;
+		}
+
+		header->type_id = et;
+		header->entry_id = id;
+		*eh = header;
+		break;
+	}
+
+	k_mutex_unlock(&log_lock);
+
+	return err;
+}
+
+static int event_storage_log_clear(void)
+{
+	int err;
+
+	k_mutex_lock(&log_lock, K_FOREVER);
+
+	event_log.buf_len = 0;
+	event_log.consumed_id = 0;
+
+	err = flash_area_erase(event_log.fa, 0, event_log.fa->fa_size);
+	if (!err) {
+		event_log.stats.erase_cnt += event_log.sector_cnt;
+		event_log.oldest_sector = 0;
+		event_log.oldest_seq = 1;
+		err = sector_open(0, 1);
+	}
+	if (!err) {
+		err = log_flush();
+	}
+
+	k_mutex_unlock(&log_lock);
+
+	return err;
+}
+
+static int event_storage_log_stats_get(struct event_storage_stats *stats)
+{
+	k_mutex_lock(&log_lock, K_FOREVER);
+	*stats = event_log.stats;
+	k_mutex_unlock(&log_lock);
+
+	return 0;
+}
+
+static struct event_storage_api api = {
+	.init = event_storage_log_init,
+	.write = event_storage_log_write,
+	.read = event_storage_log_read,
+	.remove = event_storage_log_remove,
+	.clear = event_storage_log_clear,
+	.stats_get = event_storage_log_stats_get,
+};
+
+struct event_storage_api *event_store_backend_get_api(void)
+{
+	return &api;
+}
@@ -21,13 +21,19 @@ struct event_nvs {
 	uint16_t last_saved_event;
 	uint16_t last_consumed_event;
 	uint16_t read_cursor;
+	/* Events saved after the replay started are not played. */
+	uint16_t read_end;
 	const char *flash_dev_name;
 };
 
 static struct event_nvs event_nvs_cfg;
+static struct event_storage_stats event_nvs_stats;
+
+/* Every NVS write is followed by an allocation table entry. */
+#define NVS_ATE_SIZE 8
 
 struct event_nvs_entry {
-	struct event_type *type;
+	uint32_t type_id;
 	size_t event_size;
 	uint8_t payload[CONFIG_EVENT_MANAGER_STORAGE_PAYLOAD_MAX_SIZE];
 };
@@ -104,7 +110,7 @@ int event_storage_nvs_write(struct event_header *eh)
 	int err;
 	size_t offset = WB_UP(sizeof(struct event_header));
 	struct event_nvs_entry entry = {
-		.type = (struct event_type *) eh->type_id,
+		.type_id = event_store_type_id_get(eh->type_id),
 		.event_size = eh->type_id->event_size
 	};
 
@@ -112,10 +118,10 @@ int event_storage_nvs_write(struct event_header *eh)
 		entry.event_size - offset);
 	eh->entry_id = event_nvs_cfg.last_saved_event++;
 
-	LOG_DBG("Writing event %s of size %zd, type = %p,"
+	LOG_DBG("Writing event %s of size %zd, type = 0x%08x,"
 		" payload size = %d, offset: %zd",
 		log_strdup(eh->type_id->name), entry.event_size,
-		entry.type, eh->type_id->event_size - offset, offset);
+		entry.type_id, eh->type_id->event_size - offset, offset);
 
 	err = nvs_write(&event_nvs_cfg.cf_nvs, eh->entry_id,
 		&entry, sizeof(entry));
@@ -124,6 +130,9 @@ int event_storage_nvs_write(struct event_header *eh)
 		return err;
 	}
 
+	event_nvs_stats.payload_bytes += entry.event_size - offset;
+	event_nvs_stats.flash_bytes += sizeof(entry) + NVS_ATE_SIZE;
+
 	err = nvs_write(&event_nvs_cfg.cf_nvs, LAST_EVENT_INDEX,
 		&event_nvs_cfg.last_saved_event,
 		sizeof(event_nvs_cfg.last_saved_event));
@@ -132,6 +141,9 @@ int event_storage_nvs_write(struct event_header *eh)
 		return err;
 	}
 
+	event_nvs_stats.flash_bytes += sizeof(event_nvs_cfg.last_saved_event) +
+				       NVS_ATE_SIZE;
+
 	return 0;
 }
 
@@ -150,6 +162,8 @@ int event_storage_nvs_remove(struct event_header *header)
 		return err;
 	}
 
+	event_nvs_stats.flash_bytes += NVS_ATE_SIZE;
+
 	event_nvs_cfg.last_consumed_event = header->entry_id;
 	err = nvs_write(&event_nvs_cfg.cf_nvs, LAST_EVENT_CONSUMED_INDEX,
 		&event_nvs_cfg.last_consumed_event,
@@ -158,6 +172,9 @@ int event_storage_nvs_remove(struct event_header *header)
 		return -EIO;
 	}
 
+	event_nvs_stats.flash_bytes +=
+		sizeof(event_nvs_cfg.last_consumed_event) + NVS_ATE_SIZE;
+
 	return 0;
 }
 
@@ -165,38 +182,59 @@ int event_storage_nvs_read(struct event_header **eh, bool from_start)
 {
 	int err;
 	struct event_nvs_entry entry;
+	const struct event_type *et;
 
 	if (from_start || event_nvs_cfg.read_cursor == 0) {
 		event_nvs_cfg.read_cursor =
 			event_nvs_cfg.last_consumed_event + 1;
+		event_nvs_cfg.read_end = event_nvs_cfg.last_saved_event;
 	}
 
-	LOG_DBG("Reading event %d from nvs storage", event_nvs_cfg.read_cursor);
-
-	err = nvs_read(&event_nvs_cfg.cf_nvs, event_nvs_cfg.read_cursor,
-		&entry, sizeof(entry));
-	if (err < 0) {
-		LOG_DBG("No more event in nvs storage");
-		return err;
-	}
+	do {
+		if (event_nvs_cfg.read_cursor >= event_nvs_cfg.read_end) {
+			LOG_DBG("No more event in nvs storage");
+			return -ENOENT;
+		}
+
+		LOG_DBG("Reading event %d from nvs storage",
+			event_nvs_cfg.read_cursor);
+
+		err = nvs_read(&event_nvs_cfg.cf_nvs,
+			event_nvs_cfg.read_cursor, &entry, sizeof(entry));
+		if (err < 0) {
+			LOG_DBG("No more event in nvs storage");
+			return err;
+		}
+
+		event_nvs_cfg.read_cursor++;
+
+		/* Event types stored by other firmware may not exist. */
+		et = event_store_type_find(entry.type_id);
+		if (!et || (et->event_size != entry.event_size)) {
+			LOG_WRN("Unknown event type 0x%08x in nvs storage",
+				entry.type_id);
+			et = NULL;
+		}
+	} while (!et);
 
 	LOG_DBG("Allocating %zu bytes for event %d", entry.event_size,
-		event_nvs_cfg.read_cursor);
-	event_nvs_cfg.read_cursor++;
+		event_nvs_cfg.read_cursor - 1);
 
 	struct event_header *header =
-		(struct event_header *) k_malloc(entry.event_size);
+		(struct event_header *) _EVENT_ALLOC(entry.event_size);
 	if (!header) {
 		LOG_ERR("Could not allocate memory for event");
+		/* Read the event again on next call. */
+		event_nvs_cfg.read_cursor--;
 		return -ENOMEM;
 	}
 
 	size_t offset = WB_UP(sizeof(struct event_header));
 
-	LOG_DBG("Event entry saved in NVS: type = %p, size= %zu",
-		entry.type, entry.event_size);
+	LOG_DBG("Event entry saved in NVS: type = %s, size= %zu",
+		log_strdup(et->name), entry.event_size);
 	LOG_HEXDUMP_DBG(entry.payload, entry.event_size - offset, "Payload");
-	header->type_id = entry.type;
+	header->type_id = et;
 	header->entry_id = event_nvs_cfg.read_cursor - 1;
 
 	/* We need to compute the address location of the
@@ -215,12 +253,20 @@ static int event_storage_nvs_clear(void)
 	return nvs_clear(&event_nvs_cfg.cf_nvs);
 }
 
+static int event_storage_nvs_stats_get(struct event_storage_stats *stats)
+{
+	*stats = event_nvs_stats;
+
+	return 0;
+}
+
 static struct event_storage_api api = {
 	.init = event_storage_nvs_init,
 	.write = event_storage_nvs_write,
 	.read = event_storage_nvs_read,
 	.remove = event_storage_nvs_remove,
 	.clear = event_storage_nvs_clear,
+	.stats_get = event_storage_nvs_stats_get,
 };
 
 struct event_storage_api *event_store_backend_get_api(void)
@@ -10,6 +10,8 @@
 #include <device.h>
 
 struct event_header;
+struct event_type;
+struct event_storage_stats;
 
 typedef int (*event_storage_init_t)(void);
 
@@ -21,12 +23,15 @@ typedef int (*event_storage_remove_t)(struct event_header *eh);
 
 typedef int (*event_storage_clear_t)(void);
 
+typedef int (*event_storage_stats_get_t)(struct event_storage_stats *stats);
+
 struct event_storage_api {
 	event_storage_init_t init;
 	event_storage_write_t write;
 	event_storage_read_t read;
 	event_storage_remove_t remove;
 	event_storage_clear_t clear;
+	event_storage_stats_get_t stats_get;
 };
 
 int event_store_add(struct event_header *eh);
@@ -37,6 +42,19 @@ int event_store_init(void);
 
 int event_store_clear(void);
 
+int event_store_stats_get(struct event_storage_stats *stats);
+
+/* Get the work queue processing events of the normal dispatch class. */
+struct k_work_q *event_store_work_q_get(void);
+
+/* Get the identifier of an event type that is kept in the storage. */
+uint32_t event_store_type_id_get(const struct event_type *et);
+
+/* Find the event type for a given storage identifier.
+ * Returns NULL if the event type does not exist in the current firmware.
+ */
+const struct event_type *event_store_type_find(uint32_t type_id);
+
 struct event_storage_api *event_store_backend_get_api(void);
 
 #endif /* _EVENT_MANAGER_STORAGE_PRIV_H */
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr.h>
+#include <spinlock.h>
+#include <string.h>
+#include <event_manager.h>
+
+/* Event types are limited by the size of the mask of displayed events. */
+#define EVENT_TYPE_CNT_MAX	32
+#define LISTENER_CNT_MAX	CONFIG_EVENT_MANAGER_TIMING_MAX_LISTENERS
+
+static struct event_histogram latency_hist[EVENT_TYPE_CNT_MAX];
+static struct event_histogram listener_hist[LISTENER_CNT_MAX];
+static struct k_spinlock lock;
+
+
+static size_t bucket_get(uint32_t time_us)
+{
+	size_t bucket = (time_us == 0) ? 0 : (32 - __builtin_clz(time_us));
+
+	return MIN(bucket, EVENT_HISTOGRAM_BUCKET_CNT - 1);
+}
+
+static void histogram_add(struct event_histogram *hist, uint32_t time_us)
+{
+	size_t bucket = bucket_get(time_us);
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	hist->bucket[bucket]++;
+	hist->cnt++;
+	hist->total_us += time_us;
+	hist->max_us = MAX(hist->max_us, time_us);
+
+	k_spin_unlock(&lock, key);
+}
+
+static int histogram_get(const struct event_histogram *hist,
+			 struct event_histogram *out)
+{
+	if (!out) {
+		return -EINVAL;
+	}
+
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	*out = *hist;
+
+	k_spin_unlock(&lock, key);
+
+	return 0;
+}
+
+static size_t event_type_idx(const struct event_type *et)
+{
+	return et - __start_event_types;
+}
+
+static size_t listener_idx(const struct event_listener *el)
+{
+	return el - __start_event_listeners;
+}
+
+void _event_timing_latency_add(const struct event_type *et, uint32_t time_us)
+{
+	size_t idx = event_type_idx(et);
+
+	if (idx < ARRAY_SIZE(latency_hist)) {
+		histogram_add(&latency_hist[idx], time_us);
+	}
+}
+
+void _event_timing_listener_add(const struct event_listener *el,
+				uint32_t time_us)
+{
+	size_t idx = listener_idx(el);
+
+	if (idx < ARRAY_SIZE(listener_hist)) {
+		histogram_add(&listener_hist[idx], time_us);
+	}
+}
+
+int event_manager_latency_histogram_get(const struct event_type *et,
+					struct event_histogram *hist)
+{
+	if (!et || (et < __start_event_types) ||
+	    (event_type_idx(et) >= ARRAY_SIZE(latency_hist))) {
+		return -EINVAL;
+	}
+
+	return histogram_get(&latency_hist[event_type_idx(et)], hist);
+}
+
+int event_manager_listener_histogram_get(const struct event_listener *el,
+					 struct event_histogram *hist)
+{
+	if (!el || (el < __start_event_listeners) ||
+	    (listener_idx(el) >= ARRAY_SIZE(listener_hist))) {
+		return -EINVAL;
+	}
+
+	return histogram_get(&listener_hist[listener_idx(el)], hist);
+}
+
+void event_manager_histograms_reset(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	memset(latency_hist, 0, sizeof(latency_hist));
+	memset(listener_hist, 0, sizeof(listener_hist));
+
+	k_spin_unlock(&lock, key);
+}
@@ -34,6 +34,14 @@ int url_parse_host(const char *url, char *host, size_t len);
 
 int http_parse(struct download_client *client, size_t len);
 int http_get_request_send(struct download_client *client);
+void http_pipeline_reset(struct download_client *client);
+size_t http_recv_len_get(const struct download_client *client);
+size_t http_carry_take(struct download_client *client);
+
+void resume_start(struct download_client *client);
+int resume_verify(struct download_client *client, size_t *skip);
+void resume_save(struct download_client *client, bool force);
+void resume_clear(struct download_client *client);
 
 int coap_block_init(struct download_client *client, size_t from);
 int coap_parse(struct download_client *client, size_t len);
@@ -362,13 +370,14 @@ cleanup:
 	return err;
 }
 
-int socket_send(const struct download_client *client, size_t len)
+int socket_send(const struct download_client *client, const char *buf,
+		size_t len)
 {
 	int sent;
 	size_t off = 0;
 
 	while (len) {
-		sent = send(client->fd, client->buf + off, len, 0);
+		sent = send(client->fd, buf + off, len, 0);
 		if (sent <= 0) {
 			return -errno;
 		}
@@ -396,16 +405,22 @@ static int request_send(struct download_client *dl)
 	return 0;
 }
 
-static int fragment_evt_send(const struct download_client *client)
+/* The first `skip` bytes in the buffer are not sent to the application */
+static int fragment_evt_send(const struct download_client *client,
+			     size_t skip)
 {
 	__ASSERT(client->offset <= CONFIG_DOWNLOAD_CLIENT_BUF_SIZE,
 		 "Buffer overflow!");
 
+	if (client->offset == skip) {
+		return 0;
+	}
+
 	const struct download_client_evt evt = {
 		.id = DOWNLOAD_CLIENT_EVT_FRAGMENT,
 		.fragment = {
-			.buf = client->buf,
-			.len = client->offset,
+			.buf = client->buf + skip,
+			.len = client->offset - skip,
 		}
 	};
 
@@ -440,17 +455,34 @@ static int reconnect(struct download_client *dl)
 		return err;
 	}
 
+	/* Requests in flight on the previous connection are lost */
+	http_pipeline_reset(dl);
+
 	return 0;
 }
 
+static void complete_log(const struct download_client *dl)
+{
+	uint32_t elapsed_ms = k_uptime_get() - dl->start_time;
+	size_t bytes = dl->progress - dl->start_offset;
+
+	LOG_INF("Download complete, %u bytes in %u ms (%u B/s)",
+		bytes, elapsed_ms,
+		elapsed_ms ? (uint32_t)((uint64_t)bytes * 1000 / elapsed_ms) :
+			     bytes);
+}
+
 void download_thread(void *client, void *a, void *b)
 {
 	int rc = 0;
 	int error_cause;
 	size_t len;
+	size_t skip = 0;
+	size_t pending = 0;
 	struct download_client *const dl = client;
 
 restart_and_suspend:
+	pending = 0;
 	k_thread_suspend(dl->tid);
 
 	while (true) {
@@ -463,11 +495,19 @@ restart_and_suspend:
 			break;
 		}
 
+		if (pending > 0) {
+			/* Parse the start of the next pipelined response */
+			LOG_DBG("Parsing %d bytes left in buffer", pending);
+			len = pending;
+			pending = 0;
+			goto parse;
+		}
+
 		LOG_DBG("Receiving up to %d bytes at %p...",
-			(sizeof(dl->buf) - dl->offset), (dl->buf + dl->offset));
+			http_recv_len_get(dl), (dl->buf + dl->offset));
 
 		len = recv(dl->fd, dl->buf + dl->offset,
-			   sizeof(dl->buf) - dl->offset, 0);
+			   http_recv_len_get(dl), 0);
 
 		if ((len == 0) || (len == -1)) {
 			/* We just had an unexpected socket error or closure */
@@ -477,7 +517,13 @@ restart_and_suspend:
 			 * to hand it to the application before discarding it.
 			 */
 			if ((dl->offset > 0) && (dl->http.has_header)) {
-				rc = fragment_evt_send(dl);
+				if (IS_ENABLED(CONFIG_DOWNLOAD_CLIENT_RESUME) &&
+				    resume_verify(dl, &skip)) {
+					error_evt_send(dl, ESTALE);
+					break;
+				}
+
+				rc = fragment_evt_send(dl, skip);
 				if (rc) {
 					/* Restart and suspend */
 					LOG_INF("Fragment refused, download stopped.");
@@ -485,6 +531,13 @@ restart_and_suspend:
 				}
 			}
 
+			/* Save the progress, in case the download cannot
+			 * continue on a new connection.
+			 */
+			if (IS_ENABLED(CONFIG_DOWNLOAD_CLIENT_RESUME)) {
+				resume_save(dl, true);
+			}
+
 			error_cause = ECONNRESET;
 
 			if (len == -1) {
@@ -525,6 +578,7 @@ restart_and_suspend:
 
 		LOG_DBG("Read %d bytes from socket", len);
 
+parse:
 		if (dl->proto == IPPROTO_TCP || dl->proto == IPPROTO_TLS_1_2) {
 			rc = http_parse(client, len);
 			if (rc > 0) {
@@ -551,18 +605,33 @@ restart_and_suspend:
 			LOG_INF("Downloaded %u bytes", dl->progress);
 		}
 
+		/* Verify the bytes downloaded again when resuming */
+		if (IS_ENABLED(CONFIG_DOWNLOAD_CLIENT_RESUME) &&
+		    resume_verify(dl, &skip)) {
+			error_evt_send(dl, ESTALE);
+			break;
+		}
+
 		/* Send fragment to application.
 		 * If the application callback returns non-zero, stop.
 		 */
-		rc = fragment_evt_send(dl);
+		rc = fragment_evt_send(dl, skip);
 		if (rc) {
 			/* Restart and suspend */
 			LOG_INF("Fragment refused, download stopped.");
 			break;
 		}
 
+		if (IS_ENABLED(CONFIG_DOWNLOAD_CLIENT_RESUME)) {
+			resume_save(dl, false);
+		}
+
 		if (dl->progress == dl->file_size) {
-			LOG_INF("Download complete");
+			complete_log(dl);
+			if (IS_ENABLED(CONFIG_DOWNLOAD_CLIENT_RESUME)) {
+				resume_clear(dl);
+			}
+
 			const struct download_client_evt evt = {
 				.id = DOWNLOAD_CLIENT_EVT_DONE,
 			};
@@ -578,6 +647,7 @@ restart_and_suspend:
 		}
 
 send_again:
+		pending = http_carry_take(dl);
 		dl->offset = 0;
 		/* Request next fragment, if necessary (HTTPS/CoAP) */
 		if (dl->proto != IPPROTO_TCP || len == 0
@@ -710,6 +780,15 @@ int download_client_start(struct download_client *client, const char *file,
 	client->file = file;
 	client->file_size = 0;
 	client->progress = from;
+	client->start_offset = from;
+	client->start_time = k_uptime_get();
+
+	if (IS_ENABLED(CONFIG_DOWNLOAD_CLIENT_RESUME)) {
+		/* May move the progress back, to verify the last bytes */
+		resume_start(client);
+	}
+
+	http_pipeline_reset(client);
 
 	client->offset = 0;
 	client->http.has_header = false;
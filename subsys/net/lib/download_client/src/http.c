@@ -42,13 +42,87 @@ LOG_MODULE_DECLARE(download_client, CONFIG_DOWNLOAD_CLIENT_LOG_LEVEL);
 
 int url_parse_host(const char *url, char *host, size_t len);
 int url_parse_file(const char *url, char *file, size_t len);
-int socket_send(const struct download_client *client, size_t len);
+int socket_send(const struct download_client *client, const char *buf,
+		size_t len);
 
-int http_get_request_send(struct download_client *client)
+/* Whether several range requests are kept in flight */
+static bool http_pipelining(const struct download_client *client)
+{
+	return CONFIG_DOWNLOAD_CLIENT_HTTP_PIPELINE_DEPTH > 1 &&
+	       (client->proto == IPPROTO_TLS_1_2 ||
+		(client->proto == IPPROTO_TCP &&
+		 IS_ENABLED(CONFIG_DOWNLOAD_CLIENT_RANGE_REQUESTS)));
+}
+
+/* Reset the pipeline, after the requests in flight have been lost */
+void http_pipeline_reset(struct download_client *client)
+{
+#if CONFIG_DOWNLOAD_CLIENT_HTTP_PIPELINE_DEPTH > 1
+	client->http.in_flight = 0;
+	client->http.requested = client->progress;
+	client->http.carry = 0;
+#endif
+}
+
+/* Size of the next recv(). In pipelined mode, the payload of a response is
+ * not read past its end, so that the next response is not mixed with it.
+ */
+size_t http_recv_len_get(const struct download_client *client)
+{
+	size_t len = CONFIG_DOWNLOAD_CLIENT_BUF_SIZE - client->offset;
+
+#if CONFIG_DOWNLOAD_CLIENT_HTTP_PIPELINE_DEPTH > 1
+	if (http_pipelining(client) && client->http.has_header) {
+		len = MIN(len, client->http.body_len -
+			       client->http.body_received);
+	}
+#endif
+
+	return len;
+}
+
+/* Move the bytes of the next pipelined response, received together with
+ * the last fragment, to the start of the buffer. Returns their number.
+ */
+size_t http_carry_take(struct download_client *client)
+{
+	size_t carry = 0;
+
+#if CONFIG_DOWNLOAD_CLIENT_HTTP_PIPELINE_DEPTH > 1
+	carry = client->http.carry;
+	if (carry) {
+		memmove(client->buf, client->buf + client->offset, carry);
+		client->http.carry = 0;
+	}
+#endif
+
+	return carry;
+}
+
+#if CONFIG_DOWNLOAD_CLIENT_HTTP_PIPELINE_DEPTH > 1
+/* Whether another range request can be sent in pipelined mode */
+static bool pipeline_has_room(const struct download_client *client)
+{
+	/* Until the file size is known, only one request is sent */
+	if (client->http.in_flight == 0) {
+		return client->file_size == 0 ||
+		       client->http.requested < client->file_size;
+	}
+
+	return client->file_size != 0 &&
+	       client->http.in_flight <
+			CONFIG_DOWNLOAD_CLIENT_HTTP_PIPELINE_DEPTH &&
+	       client->http.requested < client->file_size;
+}
+#endif
+
+static int request_send(struct download_client *client, size_t from)
 {
 	int err;
 	int len;
 	size_t off;
+	char *buf = client->buf;
+	size_t size = CONFIG_DOWNLOAD_CLIENT_BUF_SIZE;
 	char host[HOSTNAME_SIZE];
 	char file[FILENAME_SIZE];
 
@@ -65,12 +139,18 @@ int http_get_request_send(struct download_client *client)
 		return err;
 	}
 
+#if CONFIG_DOWNLOAD_CLIENT_HTTP_PIPELINE_DEPTH > 1
+	if (http_pipelining(client)) {
+		buf = client->http.request;
+		size = sizeof(client->http.request);
+	}
+#endif
+
 	/* Offset of last byte in range (Content-Range) */
 	if (client->config.frag_size_override) {
-		off = client->progress + client->config.frag_size_override - 1;
+		off = from + client->config.frag_size_override - 1;
 	} else {
-		off = client->progress +
-			CONFIG_DOWNLOAD_CLIENT_HTTP_FRAG_SIZE - 1;
+		off = from + CONFIG_DOWNLOAD_CLIENT_HTTP_FRAG_SIZE - 1;
 	}
 
 	if (client->file_size != 0) {
@@ -80,34 +160,60 @@ int http_get_request_send(struct download_client *client)
 
 	if (client->proto == IPPROTO_TLS_1_2
 	   || IS_ENABLED(CONFIG_DOWNLOAD_CLIENT_RANGE_REQUESTS)) {
-		len = snprintf(client->buf,
-			CONFIG_DOWNLOAD_CLIENT_BUF_SIZE,
-			HTTP_GET_RANGE, file, host, client->progress, off);
-	} else if (client->progress) {
-		len = snprintf(client->buf,
-			CONFIG_DOWNLOAD_CLIENT_BUF_SIZE,
-			HTTP_GET_OFFSET, file, host, client->progress);
+		len = snprintf(buf, size,
+			HTTP_GET_RANGE, file, host, from, off);
+	} else if (from) {
+		len = snprintf(buf, size,
+			HTTP_GET_OFFSET, file, host, from);
 	} else {
-		len = snprintf(client->buf,
-			CONFIG_DOWNLOAD_CLIENT_BUF_SIZE,
+		len = snprintf(buf, size,
 			HTTP_GET, file, host);
 	}
 
-	if (len < 0 || len > CONFIG_DOWNLOAD_CLIENT_BUF_SIZE) {
+	if (len < 0 || len > size) {
 		LOG_ERR("Cannot create GET request, buffer too small");
 		return -ENOMEM;
 	}
 
 	if (IS_ENABLED(CONFIG_DOWNLOAD_CLIENT_LOG_HEADERS)) {
-		LOG_HEXDUMP_DBG(client->buf, len, "HTTP request");
+		LOG_HEXDUMP_DBG(buf, len, "HTTP request");
 	}
 
-	err = socket_send(client, len);
+	err = socket_send(client, buf, len);
 	if (err) {
 		LOG_ERR("Failed to send HTTP request, errno %d", errno);
 		return err;
 	}
 
+#if CONFIG_DOWNLOAD_CLIENT_HTTP_PIPELINE_DEPTH > 1
+	if (http_pipelining(client)) {
+		client->http.requested = off + 1;
+		client->http.in_flight++;
+	}
+#endif
+
+	return 0;
+}
+
+int http_get_request_send(struct download_client *client)
+{
+	if (!http_pipelining(client)) {
+		return request_send(client, client->progress);
+	}
+
+#if CONFIG_DOWNLOAD_CLIENT_HTTP_PIPELINE_DEPTH > 1
+	/* Keep as many requests in flight as allowed. The server answers
+	 * them in order on the same connection.
+	 */
+	while (pipeline_has_room(client)) {
+		int err = request_send(client, client->http.requested);
+
+		if (err) {
+			return err;
+		}
+	}
+#endif
+
 	return 0;
 }
 
@@ -129,7 +235,7 @@ static int http_header_parse(struct download_client *client, size_t *hdr_len)
 	const unsigned int expected_status = using_range_requests ? 206 : 200;
 
 	p = strstr(client->buf, "\r\n\r\n");
-	if (!p || p > client->buf + client->offset) {
+	if (!p || p + strlen("\r\n\r\n") > client->buf + client->offset) {
 		/* Waiting full HTTP header */
 		LOG_DBG("Waiting full header in response");
 		return 1;
@@ -147,6 +253,12 @@ static int http_header_parse(struct download_client *client, size_t *hdr_len)
 		client->buf[i] = tolower(client->buf[i]);
 	}
 
+	/* The header is discarded once parsed. Terminate it, so that
+	 * it is not searched past its end, where the buffer can hold
+	 * payload or data of a previous response.
+	 */
+	client->buf[*hdr_len - 1] = '\0';
+
 	/* Look for the status code just after "http/1.1 " */
 	p = strstr(client->buf, "http/1.1 ");
 	if (!p) {
@@ -215,6 +327,42 @@ static int http_header_parse(struct download_client *client, size_t *hdr_len)
 		LOG_DBG("File size = %u", client->file_size);
 	}
 
+#if CONFIG_DOWNLOAD_CLIENT_HTTP_PIPELINE_DEPTH > 1
+	if (http_pipelining(client)) {
+		/* Each response carries one fragment */
+		p = strstr(client->buf, "content-length");
+		if (!p || !(p = strstr(p, ":"))) {
+			LOG_ERR("Server did not send "
+				"\"Content-Length\" in response");
+			return -1;
+		}
+
+		client->http.body_len = atoi(p + 1);
+		client->http.body_received = 0;
+	}
+#endif
+
+#if defined(CONFIG_DOWNLOAD_CLIENT_RESUME)
+	/* Keep the entity tag, to detect that the file changed */
+	client->resume.etag[0] = '\0';
+	p = strstr(client->buf, "\r\netag:");
+	if (p) {
+		p += strlen("\r\netag:");
+		while (*p == ' ') {
+			p++;
+		}
+
+		q = p;
+		while ((*q != '\0') && (*q != '\r') &&
+		       ((size_t)(q - p) < sizeof(client->resume.etag) - 1)) {
+			q++;
+		}
+
+		memcpy(client->resume.etag, p, q - p);
+		client->resume.etag[q - p] = '\0';
+	}
+#endif
+
 	p = strstr(client->buf, "connection: close");
 	if (p) {
 		LOG_WRN("Peer closed connection, will re-connect");
@@ -257,7 +405,7 @@ int http_parse(struct download_client *client, size_t len)
 			 */
 			LOG_DBG("Copying %u payload bytes",
 				client->offset - hdr_len);
-			memcpy(client->buf, client->buf + hdr_len,
+			memmove(client->buf, client->buf + hdr_len,
 			       client->offset - hdr_len);
 
 			client->offset -= hdr_len;
@@ -269,6 +417,33 @@ int http_parse(struct download_client *client, size_t len)
 		}
 	}
 
+#if CONFIG_DOWNLOAD_CLIENT_HTTP_PIPELINE_DEPTH > 1
+	if (http_pipelining(client)) {
+		size_t payload = MIN(client->offset, len);
+		size_t remaining = client->http.body_len -
+				   client->http.body_received;
+
+		/* Data past the end of this response belongs to the next
+		 * one. It is left after the fragment in the buffer.
+		 */
+		if (payload > remaining) {
+			client->http.carry = payload - remaining;
+			client->offset -= client->http.carry;
+			payload = remaining;
+		}
+
+		client->http.body_received += payload;
+		client->progress += payload;
+
+		if (client->http.body_received < client->http.body_len) {
+			return 1;
+		}
+
+		client->http.in_flight--;
+		return 0;
+	}
+#endif
+
 	/* Accumulate overall file progress.
 	 * If the last recv() call read an HTTP header,
 	 * `offset` has been moved at the end of any trailing
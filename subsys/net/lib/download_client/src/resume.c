@@ -0,0 +1,293 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <zephyr.h>
+#include <settings/settings.h>
+#include <sys/crc.h>
+#include <logging/log.h>
+#include <net/download_client.h>
+
+LOG_MODULE_DECLARE(download_client, CONFIG_DOWNLOAD_CLIENT_LOG_LEVEL);
+
+#define RESUME_KEY_PREFIX "dl_client/"
+
+/* Progress is saved for HTTP and HTTPS downloads only */
+static bool resume_supported(const struct download_client *client)
+{
+	return client->proto == IPPROTO_TCP ||
+	       client->proto == IPPROTO_TLS_1_2;
+}
+
+/* The key identifies the file by a hash of its host and path, which can be
+ * longer than what the settings backend allows in a key.
+ */
+static void key_set(struct download_client *client, const char *file)
+{
+	uint32_t crc;
+
+	crc = crc32_ieee((const uint8_t *)client->host, strlen(client->host));
+	crc = crc32_ieee_update(crc, (const uint8_t *)file, strlen(file));
+
+	(void)snprintf(client->resume.key, sizeof(client->resume.key),
+		       RESUME_KEY_PREFIX "%08x", crc);
+}
+
+static int record_load_cb(const char *key, size_t len,
+			  settings_read_cb read_cb, void *cb_arg, void *param)
+{
+	struct download_client_resume_record *record = param;
+	ssize_t rc;
+
+	/* Deleted, or saved by another version of the library */
+	if (len != sizeof(*record)) {
+		return 0;
+	}
+
+	rc = read_cb(cb_arg, record, len);
+	if (rc != len) {
+		LOG_WRN("Failed to read saved progress, err %d", (int)rc);
+		memset(record, 0, sizeof(*record));
+		return 0;
+	}
+
+	record->etag[sizeof(record->etag) - 1] = '\0';
+
+	return 0;
+}
+
+static int record_load(struct download_client *client)
+{
+	struct download_client_resume_record *record = &client->resume.record;
+	int err;
+
+	memset(record, 0, sizeof(*record));
+
+	err = settings_load_subtree_direct(client->resume.key, record_load_cb,
+					   record);
+	if (err) {
+		LOG_ERR("Failed to load saved progress, err %d", err);
+		memset(record, 0, sizeof(*record));
+	}
+
+	return err;
+}
+
+/* Called when the download is complete, or the file changed */
+void resume_clear(struct download_client *client)
+{
+	int err;
+
+	if (!resume_supported(client)) {
+		return;
+	}
+
+	memset(&client->resume.record, 0, sizeof(client->resume.record));
+
+	err = settings_delete(client->resume.key);
+	if (err) {
+		LOG_WRN("Failed to delete saved progress, err %d", err);
+	}
+}
+
+static int stale(struct download_client *client, const char *reason)
+{
+	LOG_WRN("File changed on the server (%s), restart the download",
+		reason);
+
+	resume_clear(client);
+
+	return -ESTALE;
+}
+
+int download_client_resume_offset_get(struct download_client *client,
+				      const char *file, size_t *offset)
+{
+	int err;
+
+	if (client == NULL || file == NULL || offset == NULL) {
+		return -EINVAL;
+	}
+
+	if (client->fd < 0 || client->host == NULL) {
+		return -ENOTCONN;
+	}
+
+	*offset = 0;
+
+	if (!resume_supported(client)) {
+		return 0;
+	}
+
+	key_set(client, file);
+
+	err = record_load(client);
+	if (err) {
+		return err;
+	}
+
+	*offset = client->resume.record.offset;
+
+	return 0;
+}
+
+/* Called when a download starts at client->progress. If the progress was
+ * saved at this offset, the bytes before it are downloaded again, so that
+ * they can be compared with the saved ones.
+ */
+void resume_start(struct download_client *client)
+{
+	struct download_client_resume_record *record = &client->resume.record;
+	size_t from = client->progress;
+
+	client->resume.etag[0] = '\0';
+	client->resume.verify_len = 0;
+	client->resume.verify_crc = 0;
+	client->resume.tail_len = 0;
+
+	if (!resume_supported(client)) {
+		memset(record, 0, sizeof(*record));
+		return;
+	}
+
+	key_set(client, client->file);
+
+	if (from == 0 || record_load(client)) {
+		/* New download, nothing is expected from the file */
+		memset(record, 0, sizeof(*record));
+		return;
+	}
+
+	if (record->offset == from && record->tail_len <= from) {
+		client->resume.verify_len = record->tail_len;
+		client->progress -= record->tail_len;
+
+		LOG_INF("Resuming at %u, verifying the last %u bytes",
+			from, record->tail_len);
+		return;
+	}
+
+	/* The application resumes from its own offset. The bytes before it
+	 * cannot be verified, but the file tag and size still can.
+	 */
+	record->offset = from;
+	record->tail_len = 0;
+}
+
+/* Keep the last bytes of the file received so far, which end at the
+ * current progress, to save their CRC32 with it.
+ */
+static void tail_update(struct download_client *client)
+{
+	uint8_t *tail = client->resume.tail;
+	size_t len = MIN(client->offset, sizeof(client->resume.tail));
+
+	if (client->resume.tail_len + len > sizeof(client->resume.tail)) {
+		size_t keep = sizeof(client->resume.tail) - len;
+
+		memmove(tail, tail + client->resume.tail_len - keep, keep);
+		client->resume.tail_len = keep;
+	}
+
+	memcpy(tail + client->resume.tail_len,
+	       client->buf + client->offset - len, len);
+	client->resume.tail_len += len;
+}
+
+/* Called with a fragment in the buffer, before it is sent to the
+ * application. Bytes downloaded again to verify the saved progress must be
+ * skipped when sending the fragment.
+ *
+ * Returns -ESTALE if the file changed since the progress was saved.
+ */
+int resume_verify(struct download_client *client, size_t *skip)
+{
+	struct download_client_resume_record *record = &client->resume.record;
+	size_t len;
+
+	*skip = 0;
+
+	if (!resume_supported(client)) {
+		return 0;
+	}
+
+	/* The tag and size of the file are expected to stay the same over
+	 * the whole download, and over reboots.
+	 */
+	if (client->resume.etag[0] != '\0') {
+		if (record->etag[0] == '\0') {
+			strcpy(record->etag, client->resume.etag);
+		} else if (strcmp(record->etag, client->resume.etag)) {
+			return stale(client, "ETag");
+		}
+	}
+
+	if (client->file_size != 0) {
+		if (record->file_size == 0) {
+			record->file_size = client->file_size;
+		} else if (record->file_size != client->file_size) {
+			return stale(client, "size");
+		}
+	}
+
+	tail_update(client);
+
+	if (client->resume.verify_len == 0) {
+		return 0;
+	}
+
+	len = MIN(client->resume.verify_len, client->offset);
+
+	client->resume.verify_crc = crc32_ieee_update(
+		client->resume.verify_crc, client->buf, len);
+	client->resume.verify_len -= len;
+	*skip = len;
+
+	if (client->resume.verify_len == 0 &&
+	    client->resume.verify_crc != record->tail_crc) {
+		return stale(client, "content");
+	}
+
+	return 0;
+}
+
+/* Called after a fragment has been accepted by the application, or when
+ * the connection is lost. The progress is saved every
+ * CONFIG_DOWNLOAD_CLIENT_RESUME_SAVE_INTERVAL bytes, or right away if
+ * `force` is set.
+ */
+void resume_save(struct download_client *client, bool force)
+{
+	struct download_client_resume_record *record = &client->resume.record;
+	int err;
+
+	if (!resume_supported(client)) {
+		return;
+	}
+
+	if (client->resume.verify_len != 0 ||
+	    client->progress <= record->offset) {
+		return;
+	}
+
+	if (!force && client->progress - record->offset <
+		      CONFIG_DOWNLOAD_CLIENT_RESUME_SAVE_INTERVAL) {
+		return;
+	}
+
+	record->offset = client->progress;
+	record->tail_len = client->resume.tail_len;
+	record->tail_crc = crc32_ieee(client->resume.tail, record->tail_len);
+
+	err = settings_save_one(client->resume.key, record, sizeof(*record));
+	if (err) {
+		LOG_WRN("Failed to save progress, err %d", err);
+		return;
+	}
+
+	LOG_DBG("Progress saved at %u", record->offset);
+}
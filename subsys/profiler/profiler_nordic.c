@@ -10,10 +10,11 @@
 #include <sys/util.h>
 #include <sys/byteorder.h>
 #include <zephyr.h>
-#include <SEGGER_RTT.h>
+#include <spinlock.h>
+#include <sys/ring_buffer.h>
 #include <profiler.h>
 #include <string.h>
-#include <nrfx.h>
+#include "profiler_nordic_backend.h"
 
 
 /* By default, when there is no shell, all events are profiled. */
@@ -47,12 +48,25 @@ static char *arg_types_encodings[] = {
 
 uint8_t profiler_num_events;
 
-static uint8_t buffer_data[CONFIG_PROFILER_NORDIC_DATA_BUFFER_SIZE];
-static uint8_t buffer_info[CONFIG_PROFILER_NORDIC_INFO_BUFFER_SIZE];
-static uint8_t buffer_commands[CONFIG_PROFILER_NORDIC_COMMAND_BUFFER_SIZE];
-
 static k_tid_t protocol_thread_id;
 
+#ifdef CONFIG_PROFILER_NORDIC_BUFFERED
+/* Records are staged in a ring buffer of the CPU that logs them and are sent
+ * to the host by the profiler thread. Records that do not fit in the staging
+ * ring are dropped and reported to the host with the dropped records event.
+ */
+struct staging_ring {
+	struct ring_buf rb;
+	uint8_t buf[CONFIG_PROFILER_NORDIC_STAGING_BUFFER_SIZE];
+	struct k_spinlock lock;
+	uint32_t dropped_cnt;
+};
+
+static struct staging_ring staging_rings[CONFIG_MP_NUM_CPUS];
+static uint16_t dropped_event_id;
+static K_SEM_DEFINE(flush_sem, 0, 1);
+#endif
+
 static K_THREAD_STACK_DEFINE(profiler_nordic_stack,
 			     CONFIG_PROFILER_NORDIC_STACK_SIZE);
 static struct k_thread profiler_nordic_thread;
@@ -64,17 +78,13 @@ static int send_info_data(const char *data, size_t data_len)
 
 	size_t num_bytes_send;
 
-	num_bytes_send = SEGGER_RTT_WriteNoLock(
-				  CONFIG_PROFILER_NORDIC_RTT_CHANNEL_INFO,
-				  data, data_len);
+	num_bytes_send = profiler_backend_info_write(data, data_len);
 
 	while (num_bytes_send == 0) {
 		/* Give host time to read the data and free some space
 		 * in the buffer. */
 		k_sleep(K_MSEC(100));
-		num_bytes_send = SEGGER_RTT_WriteNoLock(
-				  CONFIG_PROFILER_NORDIC_RTT_CHANNEL_INFO,
-				  data, data_len);
+		num_bytes_send = profiler_backend_info_write(data, data_len);
 
 		/* Avoid being blocked in while loop if host does not read
 		 * the RTT data.
@@ -95,7 +105,7 @@ static void send_system_description(void)
 	 */
 	uint8_t ne = profiler_num_events;
 
-	__DMB();
+	__sync_synchronize();
 	char end_line = '\n';
 	int err = 0;
 
@@ -111,15 +121,161 @@ static void send_system_description(void)
 	}
 }
 
+#ifdef CONFIG_PROFILER_NORDIC_BUFFERED
+static bool staging_ring_flush(struct staging_ring *ring)
+{
+	while (true) {
+		uint8_t *data;
+		k_spinlock_key_t key = k_spin_lock(&ring->lock);
+		uint32_t len = ring_buf_get_claim(&ring->rb, &data,
+						  sizeof(ring->buf));
+
+		k_spin_unlock(&ring->lock, key);
+
+		if (len == 0) {
+			return true;
+		}
+
+		/* Only the profiler thread writes to the data channel. */
+		size_t sent = profiler_backend_data_write(data, len);
+
+		key = k_spin_lock(&ring->lock);
+		ring_buf_get_finish(&ring->rb, sent);
+		k_spin_unlock(&ring->lock, key);
+
+		if (sent < len) {
+			/* Host did not read the data yet. */
+			return false;
+		}
+	}
+}
+
+static void dropped_cnt_send(struct staging_ring *ring)
+{
+	k_spinlock_key_t key = k_spin_lock(&ring->lock);
+	uint32_t dropped_cnt = ring->dropped_cnt;
+
+	k_spin_unlock(&ring->lock, key);
+
+	if (dropped_cnt == 0) {
+		return;
+	}
+
+	struct log_event_buf buf;
+
+	profiler_log_start(&buf);
+	profiler_log_encode_uint32(&buf, dropped_cnt);
+	buf.payload_start[0] = dropped_event_id;
+
+	size_t len = buf.payload - buf.payload_start;
+
+	/* The data channel accepts partial writes, so the record is sent
+	 * through the staging ring to never put a truncated record on the wire.
+	 */
+	key = k_spin_lock(&ring->lock);
+	if (ring_buf_space_get(&ring->rb) >= len) {
+		ring_buf_put(&ring->rb, buf.payload_start, len);
+		ring->dropped_cnt -= dropped_cnt;
+	}
+	k_spin_unlock(&ring->lock, key);
+
+	staging_ring_flush(ring);
+}
+
+static void profiler_flush(void)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(staging_rings); i++) {
+		struct staging_ring *ring = &staging_rings[i];
+
+		/* Dropped records are reported after the records that were
+		 * logged before them.
+		 */
+		if (staging_ring_flush(ring)) {
+			dropped_cnt_send(ring);
+		}
+	}
+}
+
+static void staging_init(void)
+{
+	static const char * const labels[] = {"count"};
+	static const enum profiler_arg types[] = {PROFILER_ARG_U32};
+
+	for (size_t i = 0; i < ARRAY_SIZE(staging_rings); i++) {
+		struct staging_ring *ring = &staging_rings[i];
+
+		ring_buf_init(&ring->rb, sizeof(ring->buf), ring->buf);
+		ring->dropped_cnt = 0;
+	}
+
+	dropped_event_id = profiler_register_event_type("profiler_dropped",
+							labels, types,
+							ARRAY_SIZE(types));
+}
+
+static void staging_put(const uint8_t *data, size_t len)
+{
+	/* A thread that migrates to another CPU after reading the CPU ID
+	 * still writes under the lock of the selected ring.
+	 */
+	struct staging_ring *ring = &staging_rings[_current_cpu->id];
+	k_spinlock_key_t key = k_spin_lock(&ring->lock);
+	bool flush = false;
+
+	if (ring_buf_space_get(&ring->rb) < len) {
+		ring->dropped_cnt++;
+	} else {
+		ring_buf_put(&ring->rb, data, len);
+		flush = (ring_buf_space_get(&ring->rb) <
+			 (sizeof(ring->buf) / 2));
+	}
+
+	k_spin_unlock(&ring->lock, key);
+
+	if (flush) {
+		k_sem_give(&flush_sem);
+	}
+}
+
+static void profiler_wait(void)
+{
+	k_sem_take(&flush_sem, K_MSEC(CONFIG_PROFILER_NORDIC_FLUSH_INTERVAL_MS));
+}
+
+static void profiler_wakeup(void)
+{
+	k_sem_give(&flush_sem);
+}
+#else
+static void profiler_flush(void)
+{
+}
+
+static void staging_init(void)
+{
+}
+
+static void profiler_wait(void)
+{
+	k_sleep(K_MSEC(500));
+}
+
+static void profiler_wakeup(void)
+{
+	k_wakeup(protocol_thread_id);
+}
+#endif /* CONFIG_PROFILER_NORDIC_BUFFERED */
+
 static void profiler_nordic_thread_fn(void)
 {
 	while (protocol_running) {
 		uint8_t read_data;
 		enum nordic_command command;
 
-		if (SEGGER_RTT_Read(
-		     CONFIG_PROFILER_NORDIC_RTT_CHANNEL_COMMANDS,
-		     &read_data, sizeof(read_data))) {
+		profiler_flush();
+
+		if (profiler_backend_command_read(&read_data,
+						  sizeof(read_data))) {
 			command = (enum nordic_command)read_data;
 			switch (command) {
 			case NORDIC_COMMAND_START:
@@ -136,8 +292,9 @@ static void profiler_nordic_thread_fn(void)
 				break;
 			}
 		}
-		k_sleep(K_MSEC(500));
+		profiler_wait();
 	}
+	profiler_flush();
 	k_sem_give(&profiler_sem);
 }
 
@@ -149,29 +306,12 @@ int profiler_init(void)
 	}
 	int ret;
 
-	ret = SEGGER_RTT_ConfigUpBuffer(
-		CONFIG_PROFILER_NORDIC_RTT_CHANNEL_DATA,
-		"Nordic profiler data",
-		buffer_data,
-		CONFIG_PROFILER_NORDIC_DATA_BUFFER_SIZE,
-		SEGGER_RTT_MODE_NO_BLOCK_SKIP);
-	__ASSERT_NO_MSG(ret >= 0);
-
-	ret = SEGGER_RTT_ConfigUpBuffer(
-		CONFIG_PROFILER_NORDIC_RTT_CHANNEL_INFO,
-		"Nordic profiler info",
-		buffer_info,
-		CONFIG_PROFILER_NORDIC_INFO_BUFFER_SIZE,
-		SEGGER_RTT_MODE_NO_BLOCK_SKIP);
-	__ASSERT_NO_MSG(ret >= 0);
-
-	ret = SEGGER_RTT_ConfigDownBuffer(
-		CONFIG_PROFILER_NORDIC_RTT_CHANNEL_COMMANDS,
-		"Nordic profiler command",
-		buffer_commands,
-		CONFIG_PROFILER_NORDIC_COMMAND_BUFFER_SIZE,
-		SEGGER_RTT_MODE_NO_BLOCK_SKIP);
-	__ASSERT_NO_MSG(ret >= 0);
+	ret = profiler_backend_init();
+	if (ret) {
+		return ret;
+	}
+
+	staging_init();
 
 	protocol_thread_id =  k_thread_create(&profiler_nordic_thread,
 			profiler_nordic_stack,
@@ -186,7 +326,7 @@ void profiler_term(void)
 {
 	sending_events = false;
 	protocol_running = false;
-	k_wakeup(protocol_thread_id);
+	profiler_wakeup();
 	k_sem_take(&profiler_sem, K_FOREVER);
 }
 
@@ -234,7 +374,7 @@ uint16_t profiler_register_event_type(const char *name, const char * const *args
 	/* Memory barrier to make sure that data is visible
 	 * before being accessed
 	 */
-	__DMB();
+	__sync_synchronize();
 	profiler_num_events++;
 	k_sched_unlock();
 
@@ -320,14 +460,19 @@ void profiler_log_send(struct log_event_buf *buf, uint16_t event_type_id)
 		uint8_t type_id = event_type_id & UCHAR_MAX;
 
 		buf->payload_start[0] = type_id;
+
+#ifdef CONFIG_PROFILER_NORDIC_BUFFERED
+		staging_put(buf->payload_start,
+			    buf->payload - buf->payload_start);
+#else
 		int key = irq_lock();
 
-		uint8_t num_bytes_send = SEGGER_RTT_WriteNoLock(
-				CONFIG_PROFILER_NORDIC_RTT_CHANNEL_DATA,
+		uint8_t num_bytes_send = profiler_backend_data_write(
 				buf->payload_start,
 				buf->payload - buf->payload_start);
 		ARG_UNUSED(num_bytes_send);
 		irq_unlock(key);
 		__ASSERT_NO_MSG(num_bytes_send > 0);
+#endif
 	}
 }
@@ -0,0 +1,28 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _PROFILER_NORDIC_BACKEND_H_
+#define _PROFILER_NORDIC_BACKEND_H_
+
+/* Transport used by the Nordic profiler to exchange data with the host.
+ *
+ * The backend provides a data channel for profiled records, an info channel
+ * for event descriptions and a command channel from the host. Write
+ * functions return the number of bytes that were written and must not
+ * block.
+ */
+
+#include <zephyr/types.h>
+
+int profiler_backend_init(void);
+
+size_t profiler_backend_data_write(const uint8_t *data, size_t len);
+
+size_t profiler_backend_info_write(const uint8_t *data, size_t len);
+
+size_t profiler_backend_command_read(uint8_t *data, size_t len);
+
+#endif /* _PROFILER_NORDIC_BACKEND_H_ */
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr.h>
+#include <spinlock.h>
+#include <sys/ring_buffer.h>
+#include <profiler.h>
+#include "profiler_nordic_backend.h"
+
+RING_BUF_DECLARE(data_ring, CONFIG_PROFILER_NORDIC_DATA_BUFFER_SIZE);
+RING_BUF_DECLARE(info_ring, CONFIG_PROFILER_NORDIC_INFO_BUFFER_SIZE);
+RING_BUF_DECLARE(command_ring, CONFIG_PROFILER_NORDIC_COMMAND_BUFFER_SIZE);
+
+static struct k_spinlock lock;
+
+
+static size_t ring_put(struct ring_buf *ring, const uint8_t *data,
+		       size_t len)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+	size_t written = ring_buf_put(ring, data, len);
+
+	k_spin_unlock(&lock, key);
+
+	return written;
+}
+
+static size_t ring_get(struct ring_buf *ring, uint8_t *data, size_t len)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+	size_t read = ring_buf_get(ring, data, len);
+
+	k_spin_unlock(&lock, key);
+
+	return read;
+}
+
+int profiler_backend_init(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	ring_buf_reset(&data_ring);
+	ring_buf_reset(&info_ring);
+	ring_buf_reset(&command_ring);
+
+	k_spin_unlock(&lock, key);
+
+	return 0;
+}
+
+size_t profiler_backend_data_write(const uint8_t *data, size_t len)
+{
+	return ring_put(&data_ring, data, len);
+}
+
+size_t profiler_backend_info_write(const uint8_t *data, size_t len)
+{
+	return ring_put(&info_ring, data, len);
+}
+
+size_t profiler_backend_command_read(uint8_t *data, size_t len)
+{
+	return ring_get(&command_ring, data, len);
+}
+
+size_t profiler_ram_data_read(uint8_t *data, size_t len)
+{
+	return ring_get(&data_ring, data, len);
+}
+
+size_t profiler_ram_info_read(uint8_t *data, size_t len)
+{
+	return ring_get(&info_ring, data, len);
+}
+
+int profiler_ram_command_write(uint8_t command)
+{
+	return (ring_put(&command_ring, &command, sizeof(command)) ==
+		sizeof(command)) ? 0 : -ENOBUFS;
+}
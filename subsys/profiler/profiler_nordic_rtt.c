@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr.h>
+#include <SEGGER_RTT.h>
+#include "profiler_nordic_backend.h"
+
+/* Buffered records are sent in chunks that may split a record, so partial
+ * writes are allowed. Otherwise every record is written as a whole.
+ */
+#ifdef CONFIG_PROFILER_NORDIC_BUFFERED
+#define DATA_MODE SEGGER_RTT_MODE_NO_BLOCK_TRIM
+#else
+#define DATA_MODE SEGGER_RTT_MODE_NO_BLOCK_SKIP
+#endif
+
+static uint8_t buffer_data[CONFIG_PROFILER_NORDIC_DATA_BUFFER_SIZE];
+static uint8_t buffer_info[CONFIG_PROFILER_NORDIC_INFO_BUFFER_SIZE];
+static uint8_t buffer_commands[CONFIG_PROFILER_NORDIC_COMMAND_BUFFER_SIZE];
+
+int profiler_backend_init(void)
+{
+	int ret;
+
+	ret = SEGGER_RTT_ConfigUpBuffer(
+		CONFIG_PROFILER_NORDIC_RTT_CHANNEL_DATA,
+		"Nordic profiler data",
+		buffer_data,
+		CONFIG_PROFILER_NORDIC_DATA_BUFFER_SIZE,
+		DATA_MODE);
+	__ASSERT_NO_MSG(ret >= 0);
+
+	ret = SEGGER_RTT_ConfigUpBuffer(
+		CONFIG_PROFILER_NORDIC_RTT_CHANNEL_INFO,
+		"Nordic profiler info",
+		buffer_info,
+		CONFIG_PROFILER_NORDIC_INFO_BUFFER_SIZE,
+		SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+	__ASSERT_NO_MSG(ret >= 0);
+
+	ret = SEGGER_RTT_ConfigDownBuffer(
+		CONFIG_PROFILER_NORDIC_RTT_CHANNEL_COMMANDS,
+		"Nordic profiler command",
+		buffer_commands,
+		CONFIG_PROFILER_NORDIC_COMMAND_BUFFER_SIZE,
+		SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+	__ASSERT_NO_MSG(ret >= 0);
+
+	return 0;
+}
+
+size_t profiler_backend_data_write(const uint8_t *data, size_t len)
+{
+	return SEGGER_RTT_WriteNoLock(CONFIG_PROFILER_NORDIC_RTT_CHANNEL_DATA,
+				      data, len);
+}
+
+size_t profiler_backend_info_write(const uint8_t *data, size_t len)
+{
+	return SEGGER_RTT_WriteNoLock(CONFIG_PROFILER_NORDIC_RTT_CHANNEL_INFO,
+				      data, len);
+}
+
+size_t profiler_backend_command_read(uint8_t *data, size_t len)
+{
+	return SEGGER_RTT_Read(CONFIG_PROFILER_NORDIC_RTT_CHANNEL_COMMANDS,
+			       data, len);
+}
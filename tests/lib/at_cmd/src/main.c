@@ -0,0 +1,320 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <ztest.h>
+#include <net/socket.h>
+#include <modem/at_cmd.h>
+#include <modem/nrf_modem_lib.h>
+
+#define SOCK_FD		1
+#define CMD_SIZE	16
+#define RESP_SIZE	32
+#define MAX_SENT_CNT	16
+#define BATCH_CMD_CNT	3
+
+struct modem_resp {
+	char buf[RESP_SIZE];
+};
+
+/* Responses sent by the modem, not yet received by the driver. */
+K_MSGQ_DEFINE(modem_resps, sizeof(struct modem_resp), MAX_SENT_CNT, 4);
+
+/* Responses held back by the modem until released by the test. */
+static bool hold;
+static struct modem_resp held[MAX_SENT_CNT];
+static size_t held_cnt;
+
+/* Commands written to the modem, in order. */
+static char sent[MAX_SENT_CNT][CMD_SIZE];
+static size_t sent_cnt;
+
+static struct at_cmd_batch batch;
+static struct at_cmd_batch_cmd batch_cmds[BATCH_CMD_CNT];
+static char batch_resps[BATCH_CMD_CNT][RESP_SIZE];
+
+/* Calls of the batch handler, and the command it writes, if any. */
+static size_t handler_cnt;
+static const char *handler_cmd;
+static int handler_err;
+
+static K_SEM_DEFINE(cmd_done, 0, 1);
+
+/* Mocks of the socket layer. The modem answers "ERROR" to the commands
+ * containing "ERR", fails to write the commands containing "FAIL", and
+ * echoes the other commands followed by "OK".
+ */
+int z_impl_zsock_socket(int family, int type, int proto)
+{
+	return SOCK_FD;
+}
+
+int z_impl_zsock_close(int sock)
+{
+	return 0;
+}
+
+ssize_t z_impl_zsock_sendto(int sock, const void *buf, size_t len, int flags,
+			    const struct sockaddr *dest_addr, socklen_t addrlen)
+{
+	struct modem_resp resp;
+	const char *cmd = buf;
+
+	zassert_equal(sock, SOCK_FD, "Wrong socket");
+	zassert_true(len < CMD_SIZE, "Command too long");
+
+	if (strstr(cmd, "FAIL") != NULL) {
+		errno = EIO;
+		return -1;
+	}
+
+	zassert_true(sent_cnt < MAX_SENT_CNT, "Too many commands");
+	memcpy(sent[sent_cnt], cmd, len);
+	sent[sent_cnt][len] = '\0';
+	sent_cnt++;
+
+	if (strstr(cmd, "ERR") != NULL) {
+		snprintf(resp.buf, sizeof(resp.buf), "ERROR\r\n");
+	} else {
+		snprintf(resp.buf, sizeof(resp.buf), "%.*s\r\nOK\r\n",
+			 (int)len, cmd);
+	}
+
+	if (hold) {
+		held[held_cnt++] = resp;
+	} else {
+		k_msgq_put(&modem_resps, &resp, K_NO_WAIT);
+	}
+
+	return len;
+}
+
+ssize_t z_impl_zsock_recvfrom(int sock, void *buf, size_t max_len, int flags,
+			      struct sockaddr *src_addr, socklen_t *addrlen)
+{
+	struct modem_resp resp;
+	size_t len;
+
+	k_msgq_get(&modem_resps, &resp, K_FOREVER);
+
+	/* The Modem library includes the terminating null character. */
+	len = strlen(resp.buf) + 1;
+	zassert_true(len <= max_len, "Response too long");
+	memcpy(buf, resp.buf, len);
+
+	return len;
+}
+
+void nrf_modem_lib_shutdown_wait(void)
+{
+}
+
+static void release_held(void)
+{
+	hold = false;
+
+	for (size_t i = 0; i < held_cnt; i++) {
+		k_msgq_put(&modem_resps, &held[i], K_NO_WAIT);
+	}
+	held_cnt = 0;
+}
+
+static void batch_handler(struct at_cmd_batch *completed)
+{
+	zassert_equal_ptr(completed, &batch, "Wrong batch completed");
+	handler_cnt++;
+
+	if (handler_cmd != NULL) {
+		handler_err = at_cmd_write(handler_cmd, NULL, 0, NULL);
+	}
+}
+
+static void cmd_handler(const char *response)
+{
+	k_sem_give(&cmd_done);
+}
+
+static void batch_init(const char *const *cmds, size_t cmd_cnt,
+		       bool stop_on_error)
+{
+	memset(batch_cmds, 0, sizeof(batch_cmds));
+	memset(batch_resps, 0, sizeof(batch_resps));
+
+	for (size_t i = 0; i < cmd_cnt; i++) {
+		batch_cmds[i].cmd = cmds[i];
+		batch_cmds[i].resp = batch_resps[i];
+		batch_cmds[i].resp_size = RESP_SIZE;
+	}
+
+	batch.cmds = batch_cmds;
+	batch.cmd_cnt = cmd_cnt;
+	batch.stop_on_error = stop_on_error;
+	batch.handler = batch_handler;
+}
+
+static void sent_check(size_t i, const char *cmd)
+{
+	zassert_true(i < sent_cnt, "%s not sent", cmd);
+	zassert_equal(strcmp(sent[i], cmd), 0, "Sent %s instead of %s",
+		      sent[i], cmd);
+}
+
+static void batch_cmd_check(size_t i, int code, enum at_cmd_state state)
+{
+	zassert_equal(batch_cmds[i].code, code, "Wrong code %d of %s",
+		      batch_cmds[i].code, batch_cmds[i].cmd);
+	zassert_equal(batch_cmds[i].state, state, "Wrong state %d of %s",
+		      batch_cmds[i].state, batch_cmds[i].cmd);
+}
+
+static void setup(void)
+{
+	hold = false;
+	held_cnt = 0;
+	sent_cnt = 0;
+	handler_cnt = 0;
+	handler_cmd = NULL;
+	handler_err = 0;
+	k_sem_reset(&cmd_done);
+}
+
+static void test_batch_order(void)
+{
+	const char *const cmds[] = { "AT+B0", "AT+B1", "AT+B2" };
+
+	/* Queue the batch and a command while another one is pending. */
+	hold = true;
+	zassert_equal(at_cmd_write_with_callback("AT+X", NULL), 0,
+		      "Cannot write command");
+
+	batch_init(cmds, ARRAY_SIZE(cmds), false);
+	zassert_equal(at_cmd_batch_submit(&batch), 0, "Cannot submit batch");
+	zassert_equal(at_cmd_write_with_callback("AT+Y", cmd_handler), 0,
+		      "Cannot write command");
+
+	release_held();
+	zassert_equal(at_cmd_batch_wait(&batch, K_SECONDS(1)), 0,
+		      "Batch failed");
+	zassert_equal(k_sem_take(&cmd_done, K_SECONDS(1)), 0,
+		      "Command queued after the batch not completed");
+
+	/* The batch commands are written back-to-back, in order. */
+	zassert_equal(sent_cnt, 5, "Wrong number of commands sent");
+	sent_check(0, "AT+X");
+	sent_check(1, "AT+B0");
+	sent_check(2, "AT+B1");
+	sent_check(3, "AT+B2");
+	sent_check(4, "AT+Y");
+
+	for (size_t i = 0; i < ARRAY_SIZE(cmds); i++) {
+		batch_cmd_check(i, 0, AT_CMD_OK);
+		zassert_equal(strncmp(batch_resps[i], cmds[i],
+				      strlen(cmds[i])), 0,
+			      "Wrong response %s to %s", batch_resps[i],
+			      cmds[i]);
+	}
+
+	zassert_equal(handler_cnt, 1, "Batch handler called %zu times",
+		      handler_cnt);
+}
+
+static void test_batch_stop_on_error(void)
+{
+	const char *const cmds[] = { "AT+B0", "AT+ERR", "AT+B2" };
+
+	batch_init(cmds, ARRAY_SIZE(cmds), true);
+	zassert_equal(at_cmd_batch_submit(&batch), 0, "Cannot submit batch");
+	zassert_equal(at_cmd_batch_wait(&batch, K_SECONDS(1)), -ENOEXEC,
+		      "Wrong batch result %d", batch.err);
+
+	/* The commands after the failed one are skipped. */
+	zassert_equal(sent_cnt, 2, "Wrong number of commands sent");
+	batch_cmd_check(0, 0, AT_CMD_OK);
+	batch_cmd_check(1, -ENOEXEC, AT_CMD_ERROR);
+	batch_cmd_check(2, -ECANCELED, AT_CMD_ERROR_QUEUE);
+	zassert_equal(handler_cnt, 1, "Batch handler called %zu times",
+		      handler_cnt);
+}
+
+static void test_batch_continue_on_error(void)
+{
+	const char *const cmds[] = { "AT+B0", "AT+ERR", "AT+B2" };
+
+	batch_init(cmds, ARRAY_SIZE(cmds), false);
+	zassert_equal(at_cmd_batch_submit(&batch), 0, "Cannot submit batch");
+	zassert_equal(at_cmd_batch_wait(&batch, K_SECONDS(1)), -ENOEXEC,
+		      "Wrong batch result %d", batch.err);
+
+	zassert_equal(sent_cnt, 3, "Wrong number of commands sent");
+	batch_cmd_check(0, 0, AT_CMD_OK);
+	batch_cmd_check(1, -ENOEXEC, AT_CMD_ERROR);
+	batch_cmd_check(2, 0, AT_CMD_OK);
+}
+
+static void test_batch_wait_timeout(void)
+{
+	const char *const cmds[] = { "AT+B0", "AT+B1" };
+
+	hold = true;
+	batch_init(cmds, ARRAY_SIZE(cmds), false);
+	zassert_equal(at_cmd_batch_submit(&batch), 0, "Cannot submit batch");
+
+	zassert_equal(at_cmd_batch_wait(&batch, K_MSEC(50)), -EAGAIN,
+		      "Batch completed without responses");
+	zassert_equal(handler_cnt, 0, "Batch handler called too early");
+
+	release_held();
+	zassert_equal(at_cmd_batch_wait(&batch, K_SECONDS(1)), 0,
+		      "Batch failed");
+
+	/* Later waits return immediately. */
+	zassert_equal(at_cmd_batch_wait(&batch, K_NO_WAIT), 0,
+		      "Completed batch not reported");
+	zassert_equal(handler_cnt, 1, "Batch handler called %zu times",
+		      handler_cnt);
+}
+
+static void test_batch_handler_write(void)
+{
+	const char *const cmds[] = { "AT+FAIL" };
+
+	/* The batch fails to be written, so it completes in this thread and
+	 * its handler can wait for the response to another command.
+	 */
+	handler_cmd = "AT+H";
+	batch_init(cmds, ARRAY_SIZE(cmds), false);
+	zassert_equal(at_cmd_batch_submit(&batch), 0, "Cannot submit batch");
+	zassert_equal(at_cmd_batch_wait(&batch, K_SECONDS(1)), -EIO,
+		      "Wrong batch result %d", batch.err);
+
+	batch_cmd_check(0, -EIO, AT_CMD_ERROR_WRITE);
+	zassert_equal(handler_cnt, 1, "Batch handler called %zu times",
+		      handler_cnt);
+	zassert_equal(handler_err, 0, "Command written by the handler failed");
+	zassert_equal(sent_cnt, 1, "Wrong number of commands sent");
+	sent_check(0, "AT+H");
+}
+
+void test_main(void)
+{
+	zassert_equal(at_cmd_init(), 0, "Init failed");
+
+	ztest_test_suite(test_at_cmd,
+		ztest_unit_test_setup_teardown(test_batch_order, setup,
+					       unit_test_noop),
+		ztest_unit_test_setup_teardown(test_batch_stop_on_error, setup,
+					       unit_test_noop),
+		ztest_unit_test_setup_teardown(test_batch_continue_on_error,
+					       setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_batch_wait_timeout, setup,
+					       unit_test_noop),
+		ztest_unit_test_setup_teardown(test_batch_handler_write, setup,
+					       unit_test_noop)
+	);
+
+	ztest_run_test_suite(test_at_cmd);
+}
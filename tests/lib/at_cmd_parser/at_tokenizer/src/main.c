@@ -0,0 +1,273 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <ztest.h>
+#include <string.h>
+#include <kernel.h>
+
+#include <modem/at_cmd_parser.h>
+#include <modem/at_params.h>
+#include <modem/at_tokenizer.h>
+
+#define BENCH_ITERATIONS	1000
+#define MAX_STRING_LEN		64
+#define MAX_ARRAY_LEN		32
+
+/* Responses recorded from the modem. */
+static const char ncellmeas[] =
+	"%NCELLMEAS: 0,\"021D140C\",\"24201\",\"0821\",65535,5300,449,50,15,"
+	"10891,5300,194,46,8,0,1650,292,60,27,24,6400,93,51,12,24,"
+	"300,37,48,10,30,1450,221,44,6,48,6200,442,39,4,72,5300,195,37,3,96"
+	"\r\n";
+static const char xmonitor[] =
+	"%XMONITOR: 5,\"Telia N@\",\"Telia N@\",\"24202\",\"0901\",7,20,"
+	"\"012BEEF\",280,6400,53,23,\"\",\"11100000\",\"11100000\","
+	"\"00001001\"\r\n";
+static const char cgdcont[] =
+	"+CGDCONT: 0,\"IP\",\"telenor.smart\",\"10.81.183.99\",0,0\r\n"
+	"+CGDCONT: 1,\"IPV4V6\",\"ims\",\"10.81.183.100 1.2.3.4\",0,0\r\n";
+static const char cereg[] = "+CEREG: 2,\"76C1\",\"0102DA04\", 7\r\n";
+static const char cpsms[] = "+CPSMS: 1,,,\"10101111\",\"01101100\"\r\n";
+static const char xcband[] = "%XCBAND: (1,2,3,4,12,13)\r\n";
+static const char cmt[] = "+CMT: \"12345678\", 24\r\n"
+	"06917429000171040A91747966543100009160402143708006C8329BFD0601\r\n";
+static const char cgmr[] = "mfw_nrf9160_1.3.0\r\n";
+
+static const char *const responses[] = {
+	ncellmeas, xmonitor, cgdcont, cereg, cpsms, xcband, cmt, cgmr,
+};
+
+static size_t param_count_get(const char *str)
+{
+	/* Every parameter, except the last one, is followed by a comma. */
+	size_t count = 3;
+
+	for (; *str != '\0'; str++) {
+		if (*str == ',') {
+			count++;
+		}
+	}
+
+	return count;
+}
+
+static void token_compare(const struct at_token *token,
+			  const struct at_param_list *list)
+{
+	size_t index = token->index;
+
+	zassert_equal(token->type, at_params_type_get(list, index),
+		      "Wrong type of parameter %zu", index);
+
+	switch (token->type) {
+	case AT_PARAM_TYPE_NUM_INT:
+	{
+		int64_t token_val;
+		int64_t list_val;
+
+		zassert_equal(at_token_int64_get(token, &token_val), 0,
+			      "Cannot get token %zu", index);
+		zassert_equal(at_params_int64_get(list, index, &list_val), 0,
+			      "Cannot get parameter %zu", index);
+		zassert_equal(token_val, list_val,
+			      "Wrong value of parameter %zu", index);
+		break;
+	}
+
+	case AT_PARAM_TYPE_STRING:
+	{
+		char token_str[MAX_STRING_LEN];
+		char list_str[MAX_STRING_LEN];
+		size_t token_len = sizeof(token_str);
+		size_t list_len = sizeof(list_str);
+
+		zassert_equal(at_token_string_get(token, token_str,
+						  &token_len), 0,
+			      "Cannot get token %zu", index);
+		zassert_equal(at_params_string_get(list, index, list_str,
+						   &list_len), 0,
+			      "Cannot get parameter %zu", index);
+		zassert_equal(token_len, list_len,
+			      "Wrong length of parameter %zu", index);
+		zassert_mem_equal(token_str, list_str, token_len,
+				  "Wrong value of parameter %zu", index);
+		break;
+	}
+
+	case AT_PARAM_TYPE_ARRAY:
+	{
+		uint32_t token_array[MAX_ARRAY_LEN];
+		uint32_t list_array[MAX_ARRAY_LEN];
+		size_t token_len = sizeof(token_array);
+		size_t list_len = sizeof(list_array);
+
+		zassert_equal(at_token_array_get(token, token_array,
+						 &token_len), 0,
+			      "Cannot get token %zu", index);
+		zassert_equal(at_params_array_get(list, index, list_array,
+						  &list_len), 0,
+			      "Cannot get parameter %zu", index);
+		zassert_equal(token_len, list_len,
+			      "Wrong length of parameter %zu", index);
+		zassert_mem_equal(token_array, list_array, token_len,
+				  "Wrong value of parameter %zu", index);
+		break;
+	}
+
+	case AT_PARAM_TYPE_EMPTY:
+		break;
+
+	default:
+		zassert_unreachable("Invalid type of parameter %zu", index);
+		break;
+	}
+}
+
+static void test_tokens_match_parser(void)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(responses); i++) {
+		const char *str = responses[i];
+		struct at_param_list list;
+		struct at_tokenizer tokenizer;
+		struct at_token token;
+		size_t count = 0;
+		int err;
+
+		zassert_equal(at_params_list_init(&list, param_count_get(str)),
+			      0, "Cannot init list");
+
+		err = at_parser_params_from_str(str, NULL, &list);
+		zassert_true((err == 0) || (err == -EAGAIN),
+			     "Parser failed on response %zu, err %d", i, err);
+
+		at_tokenizer_init(&tokenizer, str);
+
+		while ((err = at_tokenizer_next(&tokenizer, &token)) == 0) {
+			zassert_equal(token.index, count, "Wrong index");
+			token_compare(&token, &list);
+			count++;
+		}
+
+		zassert_true((err == -ENODATA) || (err == -EAGAIN),
+			     "Tokenizer failed on response %zu, err %d", i,
+			     err);
+		zassert_equal(count, at_params_valid_count_get(&list),
+			      "Wrong parameter count in response %zu", i);
+
+		at_params_list_free(&list);
+	}
+}
+
+static void test_multiline(void)
+{
+	struct at_tokenizer tokenizer;
+	struct at_token token;
+	size_t lines = 0;
+	const char *str = cgdcont;
+	int err;
+
+	do {
+		at_tokenizer_init(&tokenizer, str);
+
+		zassert_equal(at_tokenizer_next(&tokenizer, &token), 0,
+			      "No line name");
+		zassert_true(at_token_string_equals(&token, "+CGDCONT"),
+			     "Wrong line name");
+
+		while ((err = at_tokenizer_next(&tokenizer, &token)) == 0) {
+		}
+
+		lines++;
+		str = at_tokenizer_remaining_get(&tokenizer);
+	} while (err == -EAGAIN);
+
+	zassert_equal(err, -ENODATA, "Unexpected error %d", err);
+	zassert_equal(lines, 2, "Wrong line count");
+}
+
+static void test_trailing_empty(void)
+{
+	struct at_tokenizer tokenizer;
+	struct at_token token;
+
+	at_tokenizer_init(&tokenizer, "+CGEQOSRDP: 0,\r\n");
+
+	zassert_equal(at_tokenizer_next(&tokenizer, &token), 0, "No name");
+	zassert_equal(at_tokenizer_next(&tokenizer, &token), 0, "No number");
+	zassert_equal(token.type, AT_PARAM_TYPE_NUM_INT, "Wrong type");
+	zassert_equal(at_tokenizer_next(&tokenizer, &token), 0, "No empty");
+	zassert_equal(token.type, AT_PARAM_TYPE_EMPTY, "Wrong type");
+	zassert_equal(at_tokenizer_next(&tokenizer, &token), -ENODATA,
+		      "Unexpected parameter");
+}
+
+static uint32_t parser_bench(const char *str)
+{
+	uint32_t start = k_cycle_get_32();
+
+	for (size_t i = 0; i < BENCH_ITERATIONS; i++) {
+		struct at_param_list list;
+		int64_t val;
+
+		zassert_equal(at_params_list_init(&list, param_count_get(str)),
+			      0, "Cannot init list");
+		(void)at_parser_params_from_str(str, NULL, &list);
+
+		for (size_t j = 0; j < at_params_valid_count_get(&list); j++) {
+			if (at_params_type_get(&list, j) ==
+			    AT_PARAM_TYPE_NUM_INT) {
+				(void)at_params_int64_get(&list, j, &val);
+			}
+		}
+
+		at_params_list_free(&list);
+	}
+
+	return (k_cycle_get_32() - start) / BENCH_ITERATIONS;
+}
+
+static uint32_t tokenizer_bench(const char *str)
+{
+	uint32_t start = k_cycle_get_32();
+
+	for (size_t i = 0; i < BENCH_ITERATIONS; i++) {
+		struct at_tokenizer tokenizer;
+		struct at_token token;
+		int64_t val;
+
+		at_tokenizer_init(&tokenizer, str);
+
+		while (at_tokenizer_next(&tokenizer, &token) == 0) {
+			if (token.type == AT_PARAM_TYPE_NUM_INT) {
+				(void)at_token_int64_get(&token, &val);
+			}
+		}
+	}
+
+	return (k_cycle_get_32() - start) / BENCH_ITERATIONS;
+}
+
+static void test_bench(void)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(responses); i++) {
+		const char *str = responses[i];
+
+		printk("%.12s: parser %u cycles, tokenizer %u cycles\n", str,
+		       parser_bench(str), tokenizer_bench(str));
+	}
+}
+
+void test_main(void)
+{
+	ztest_test_suite(at_tokenizer,
+			 ztest_unit_test(test_tokens_match_parser),
+			 ztest_unit_test(test_multiline),
+			 ztest_unit_test(test_trailing_empty),
+			 ztest_unit_test(test_bench)
+			 );
+
+	ztest_run_test_suite(at_tokenizer);
+}
@@ -0,0 +1,252 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <ztest.h>
+#include <nrf_modem_at.h>
+#include <modem/at_monitor.h>
+#include <modem/at_params.h>
+
+#define BENCH_NOTIF_CNT		1000
+#define BENCH_MONITOR_CNT	CONFIG_TEST_AT_MONITOR_BENCH_MONITORS
+
+static nrf_modem_at_notif_handler_t notif_handler;
+
+static size_t cereg_cnt;
+static size_t cereg_short_cnt;
+static size_t cereg_paused_cnt;
+static size_t cscon_cnt;
+static size_t any_cnt;
+
+static bool any_hold;
+static bool any_parse;
+static const char *held_notif;
+static const struct at_param_list *cscon_params;
+static const struct at_param_list *any_params;
+
+static K_SEM_DEFINE(flush_sem, 0, 1);
+
+AT_MONITOR(cereg, "+CEREG", cereg_mon);
+AT_MONITOR(cereg_short, "CEREG", cereg_short_mon);
+AT_MONITOR(cereg_paused, "+CEREG", cereg_paused_mon, PAUSED);
+AT_MONITOR(cscon, "+CSCON", cscon_mon);
+AT_MONITOR(any, ANY, any_mon);
+
+#define BENCH_MONITOR_DEFINE(i, _)					\
+	AT_MONITOR(_CONCAT(bench_, i), "%XBENCH" STRINGIFY(i), bench_mon);
+
+UTIL_LISTIFY(BENCH_MONITOR_CNT, BENCH_MONITOR_DEFINE, _)
+
+
+/* Stub of the Modem library function used by the AT monitor library. */
+int nrf_modem_at_notif_handler_set(nrf_modem_at_notif_handler_t callback)
+{
+	notif_handler = callback;
+
+	return 0;
+}
+
+static void cereg_mon(const char *notif)
+{
+	cereg_cnt++;
+}
+
+static void cereg_short_mon(const char *notif)
+{
+	cereg_short_cnt++;
+}
+
+static void cereg_paused_mon(const char *notif)
+{
+	cereg_paused_cnt++;
+}
+
+static void cscon_mon(const char *notif)
+{
+	cscon_cnt++;
+	cscon_params = at_monitor_notif_params_get(notif);
+}
+
+static void any_mon(const char *notif)
+{
+	any_cnt++;
+
+	if (any_parse) {
+		any_params = at_monitor_notif_params_get(notif);
+	}
+
+	if (any_hold) {
+		held_notif = at_monitor_notif_ref(notif);
+		any_hold = false;
+	}
+}
+
+static void __unused bench_mon(const char *notif)
+{
+	zassert_unreachable("Unexpected notification: %s", notif);
+}
+
+static void flush_work_fn(struct k_work *work)
+{
+	k_sem_give(&flush_sem);
+}
+
+static K_WORK_DEFINE(flush_work, flush_work_fn);
+
+/* Wait until the notifications are dispatched from the system workqueue. */
+static void flush(void)
+{
+	k_work_submit(&flush_work);
+	zassert_equal(k_sem_take(&flush_sem, K_SECONDS(1)), 0,
+		      "Notifications not dispatched");
+}
+
+static void counters_reset(void)
+{
+	cereg_cnt = 0;
+	cereg_short_cnt = 0;
+	cereg_paused_cnt = 0;
+	cscon_cnt = 0;
+	any_cnt = 0;
+}
+
+static void test_init(void)
+{
+	at_monitor_init();
+
+	zassert_not_null(notif_handler, "Notification handler not set");
+}
+
+static void test_filter(void)
+{
+	counters_reset();
+
+	notif_handler("+CEREG: 1,\"002F\",\"0012BEEF\",7\r\n");
+	flush();
+
+	zassert_equal(cereg_cnt, 1, "+CEREG monitor not notified");
+	zassert_equal(cereg_short_cnt, 1, "CEREG monitor not notified");
+	zassert_equal(cereg_paused_cnt, 0, "Paused monitor notified");
+	zassert_equal(cscon_cnt, 0, "+CSCON monitor notified");
+	zassert_equal(any_cnt, 1, "Wildcard monitor not notified");
+
+	notif_handler("+CSCON: 1\r\n");
+	flush();
+
+	zassert_equal(cereg_cnt, 1, "+CEREG monitor notified");
+	zassert_equal(cereg_short_cnt, 1, "CEREG monitor notified");
+	zassert_equal(cscon_cnt, 1, "+CSCON monitor not notified");
+	zassert_equal(any_cnt, 2, "Wildcard monitor not notified");
+}
+
+static void test_pause_resume(void)
+{
+	counters_reset();
+
+	at_monitor_resume(cereg_paused);
+	at_monitor_pause(cereg);
+
+	notif_handler("+CEREG: 5\r\n");
+	flush();
+
+	zassert_equal(cereg_cnt, 0, "Paused monitor notified");
+	zassert_equal(cereg_paused_cnt, 1, "Resumed monitor not notified");
+
+	at_monitor_pause(cereg_paused);
+	at_monitor_resume(cereg);
+}
+
+static void test_notif_ref(void)
+{
+	struct at_monitor_heap_stats stats;
+	const char *notif = "+CEREG: 2\r\n";
+
+	held_notif = NULL;
+	any_hold = true;
+
+	notif_handler(notif);
+	flush();
+
+	zassert_not_null(held_notif, "Notification not referenced");
+	zassert_true(strcmp(held_notif, notif) == 0, "Wrong notification");
+
+	at_monitor_heap_stats_get(&stats);
+	zassert_true(stats.used > strlen(notif), "Notification freed");
+	zassert_true(stats.max_used >= stats.used, "Wrong high-water mark");
+
+	at_monitor_notif_unref(held_notif);
+
+	at_monitor_heap_stats_get(&stats);
+	zassert_equal(stats.used, 0, "Notification not freed");
+	zassert_equal(stats.alloc_fail_cnt, 0, "Notification dropped");
+}
+
+static void test_params_shared(void)
+{
+	int32_t val;
+
+	/* Keep the notification, so that its parameters stay valid. */
+	any_hold = true;
+	any_parse = true;
+	any_params = NULL;
+	cscon_params = NULL;
+
+	notif_handler("+CSCON: 1,7\r\n");
+	flush();
+
+	zassert_not_null(cscon_params, "Notification not parsed");
+	zassert_equal_ptr(cscon_params, any_params,
+			  "Notification parsed twice");
+	zassert_equal(at_params_valid_count_get(cscon_params), 3,
+		      "Wrong parameter count");
+	zassert_equal(at_params_int_get(cscon_params, 2, &val), 0,
+		      "Cannot get parameter");
+	zassert_equal(val, 7, "Wrong parameter value");
+
+	any_parse = false;
+	at_monitor_notif_unref(held_notif);
+}
+
+static void test_dispatch_perf(void)
+{
+	size_t monitor_cnt = 0;
+	uint32_t start_time;
+	uint32_t cycles;
+
+	Z_STRUCT_SECTION_FOREACH(at_monitor_entry, e) {
+		monitor_cnt++;
+	}
+
+	counters_reset();
+	start_time = k_cycle_get_32();
+
+	for (size_t i = 0; i < BENCH_NOTIF_CNT; i++) {
+		notif_handler("%CESQ: 54,2,16,2\r\n");
+		flush();
+	}
+
+	cycles = k_cycle_get_32() - start_time;
+
+	zassert_equal(any_cnt, BENCH_NOTIF_CNT, "Notifications lost");
+
+	printk("Dispatch cost for %zu monitor(s): %u cycles per notification "
+	       "(prefix trie %s)\n",
+	       monitor_cnt, cycles / BENCH_NOTIF_CNT,
+	       IS_ENABLED(CONFIG_AT_MONITOR_TRIE) ? "enabled" : "disabled");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(at_monitor_tests,
+			 ztest_unit_test(test_init),
+			 ztest_unit_test(test_filter),
+			 ztest_unit_test(test_pause_resume),
+			 ztest_unit_test(test_notif_ref),
+			 ztest_unit_test(test_params_shared),
+			 ztest_unit_test(test_dispatch_perf)
+			 );
+
+	ztest_run_test_suite(at_monitor_tests);
+}
@@ -0,0 +1,241 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr.h>
+#include <ztest.h>
+#include <stdio.h>
+#include <string.h>
+#include <modem/at_cmd.h>
+#include <modem/at_notif.h>
+#include <modem/modem_info.h>
+
+#define RESP_BAND	"%XCBAND: 20\r\n"
+#define RESP_FW		"mfw_nrf9160_1.3.0\r\n"
+#define RESP_FW_VERSION	"mfw_nrf9160_1.3.0"
+
+static at_notif_handler_t notif_handler;
+static int band_writes;
+static int fw_writes;
+static int mode_writes;
+static int systemmode_writes;
+/* Responses to AT+CEMODE? and AT%XSYSTEMMODE?, changed by the tests. */
+static char mode_resp[32];
+static char systemmode_resp[32];
+/* Notification received by the mock while an AT command is pending. */
+static const char *pending_notif;
+
+int at_notif_register_handler(void *context, at_notif_handler_t handler)
+{
+	ARG_UNUSED(context);
+
+	/* The first handler registered is the one of the cache. */
+	if (notif_handler == NULL) {
+		notif_handler = handler;
+	}
+
+	return 0;
+}
+
+int at_cmd_write(const char *const cmd, char *buf, size_t buf_len,
+		 enum at_cmd_state *state)
+{
+	const char *resp;
+
+	ARG_UNUSED(state);
+
+	if (strcmp(cmd, "AT%XCBAND") == 0) {
+		resp = RESP_BAND;
+		band_writes++;
+	} else if (strcmp(cmd, "AT+CGMR") == 0) {
+		resp = RESP_FW;
+		fw_writes++;
+	} else if (strcmp(cmd, "AT+CEMODE?") == 0) {
+		resp = mode_resp;
+		mode_writes++;
+	} else if (strcmp(cmd, "AT%XSYSTEMMODE?") == 0) {
+		resp = systemmode_resp;
+		systemmode_writes++;
+	} else {
+		return -EIO;
+	}
+
+	if (pending_notif != NULL) {
+		notif_handler(NULL, pending_notif);
+		pending_notif = NULL;
+	}
+
+	zassert_true(buf_len > strlen(resp), "Buffer too small");
+	strcpy(buf, resp);
+
+	return 0;
+}
+
+static void read_band(void)
+{
+	uint16_t band;
+	int len = modem_info_short_get(MODEM_INFO_CUR_BAND, &band);
+
+	zassert_equal(len, sizeof(band), "Reading the band failed: %d", len);
+	zassert_equal(band, 20, "Wrong band %d", band);
+}
+
+static void read_fw(void)
+{
+	char fw[32];
+	int len = modem_info_string_get(MODEM_INFO_FW_VERSION, fw, sizeof(fw));
+
+	zassert_equal(len, strlen(RESP_FW_VERSION),
+		      "Reading the firmware version failed: %d", len);
+	zassert_equal(strcmp(fw, RESP_FW_VERSION), 0,
+		      "Wrong firmware version %s", fw);
+}
+
+static void read_short_check(enum modem_info info, uint16_t expected)
+{
+	uint16_t val;
+	int len = modem_info_short_get(info, &val);
+
+	zassert_equal(len, sizeof(val), "Reading %d failed: %d", info, len);
+	zassert_equal(val, expected, "Read %d for %d, expected %d", val,
+		      info, expected);
+}
+
+/* Set the modes as lte_lc_system_mode_set() and lte_lc_func_mode_set() do. */
+static void modes_set(int ue_mode, int lte_m, int nb_iot)
+{
+	snprintf(mode_resp, sizeof(mode_resp), "+CEMODE: %d\r\n", ue_mode);
+	snprintf(systemmode_resp, sizeof(systemmode_resp),
+		 "%%XSYSTEMMODE: %d,%d,0,0\r\n", lte_m, nb_iot);
+}
+
+static void setup(void)
+{
+	modem_info_cache_invalidate();
+	band_writes = 0;
+	fw_writes = 0;
+	mode_writes = 0;
+	systemmode_writes = 0;
+	pending_notif = NULL;
+	modes_set(2, 1, 0);
+}
+
+static void test_cache_hit(void)
+{
+	read_band();
+	read_band();
+	read_band();
+	zassert_equal(band_writes, 1, "Band read from the modem %d times",
+		      band_writes);
+
+	read_fw();
+	read_fw();
+	zassert_equal(fw_writes, 1,
+		      "Firmware version read from the modem %d times",
+		      fw_writes);
+}
+
+static void test_cache_ttl(void)
+{
+	read_band();
+	k_sleep(K_MSEC(CONFIG_MODEM_INFO_CACHE_TTL_MS / 2));
+	read_band();
+	zassert_equal(band_writes, 1, "Response expired before the TTL");
+
+	k_sleep(K_MSEC(CONFIG_MODEM_INFO_CACHE_TTL_MS));
+	read_band();
+	zassert_equal(band_writes, 2, "Response not expired after the TTL");
+
+	read_band();
+	zassert_equal(band_writes, 2, "Refreshed response not cached");
+}
+
+static void test_cache_invalidate_notif(void)
+{
+	read_band();
+	read_fw();
+
+	/* Only network information is invalidated by notifications. */
+	notif_handler(NULL, "+CEREG: 5,\"0A0B\",\"01020304\",7\r\n");
+	read_band();
+	read_fw();
+	zassert_equal(band_writes, 2, "Band not invalidated by +CEREG");
+	zassert_equal(fw_writes, 1, "Firmware version invalidated by +CEREG");
+
+	notif_handler(NULL, "%XMODEMSLEEP: 1,3600000\r\n");
+	read_band();
+	zassert_equal(band_writes, 3, "Band not invalidated by %%XMODEMSLEEP");
+
+	/* Other notifications do not invalidate the cache. */
+	notif_handler(NULL, "%CESQ: 54,2,16,2\r\n");
+	read_band();
+	zassert_equal(band_writes, 3, "Band invalidated by %%CESQ");
+}
+
+static void test_cache_invalidate_api(void)
+{
+	read_band();
+	read_fw();
+
+	modem_info_cache_invalidate();
+	read_band();
+	read_fw();
+	zassert_equal(band_writes, 2, "Band not invalidated");
+	zassert_equal(fw_writes, 2, "Firmware version not invalidated");
+}
+
+static void test_cache_invalidate_pending(void)
+{
+	/* A response read before an invalidation must not be cached. */
+	pending_notif = "+CEREG: 1,\"0A0B\",\"01020304\",7\r\n";
+	read_band();
+	read_band();
+	zassert_equal(band_writes, 2, "Outdated response cached");
+
+	read_band();
+	zassert_equal(band_writes, 2, "Response not cached");
+}
+
+static void test_mode_change(void)
+{
+	read_short_check(MODEM_INFO_UE_MODE, 2);
+	read_short_check(MODEM_INFO_LTE_MODE, 1);
+	read_short_check(MODEM_INFO_NBIOT_MODE, 0);
+
+	/* Switching from LTE-M to NB-IoT does not send a notification. */
+	modes_set(0, 0, 1);
+	read_short_check(MODEM_INFO_UE_MODE, 0);
+	read_short_check(MODEM_INFO_LTE_MODE, 0);
+	read_short_check(MODEM_INFO_NBIOT_MODE, 1);
+
+	zassert_equal(mode_writes, 2, "Mode read from the modem %d times",
+		      mode_writes);
+	zassert_equal(systemmode_writes, 4,
+		      "System mode read from the modem %d times",
+		      systemmode_writes);
+}
+
+void test_main(void)
+{
+	zassert_equal(modem_info_init(), 0, "Init failed");
+	zassert_not_null(notif_handler, "Notification handler not registered");
+
+	ztest_test_suite(test_modem_info,
+		ztest_unit_test_setup_teardown(test_cache_hit, setup,
+					       unit_test_noop),
+		ztest_unit_test_setup_teardown(test_cache_ttl, setup,
+					       unit_test_noop),
+		ztest_unit_test_setup_teardown(test_cache_invalidate_notif,
+					       setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_cache_invalidate_api,
+					       setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_cache_invalidate_pending,
+					       setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_mode_change, setup,
+					       unit_test_noop)
+	);
+
+	ztest_run_test_suite(test_modem_info);
+}
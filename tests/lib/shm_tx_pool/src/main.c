@@ -0,0 +1,266 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <ztest.h>
+#include <string.h>
+
+#include "shm_tx_pool.h"
+
+#define REGION_SIZE	8192
+#define TRACE_SLOTS	32
+
+static uint8_t region[REGION_SIZE] __aligned(8);
+static struct shm_tx_pool pool;
+
+static const struct shm_tx_pool_class_config config[] = {
+	{ 64, 8 },
+	{ 256, 4 },
+	{ 1024, 2 },
+};
+
+enum trace_op {
+	OP_ALLOC,
+	OP_ALLOC_FAILED,
+	OP_FREE,
+};
+
+struct trace_entry {
+	enum trace_op op;
+	uint8_t slot;
+	uint16_t size;
+};
+
+#define TRACE_ALLOC(_slot, _size) { OP_ALLOC, _slot, _size },
+#define TRACE_ALLOC_FAILED(_size) { OP_ALLOC_FAILED, 0, _size },
+#define TRACE_FREE(_slot) { OP_FREE, _slot, 0 },
+
+static const struct trace_entry uplink_trace[] = {
+#include "uplink.inc"
+};
+
+struct replay_result {
+	size_t allocs;
+	size_t failures;
+	uint32_t cycles;
+};
+
+typedef void *(*alloc_fn_t)(size_t bytes);
+typedef void (*free_fn_t)(void *mem);
+
+static struct k_heap heap;
+
+static void *pool_alloc(size_t bytes)
+{
+	return shm_tx_pool_alloc(&pool, bytes);
+}
+
+static void pool_free(void *mem)
+{
+	shm_tx_pool_free(&pool, mem);
+}
+
+static void *heap_alloc(size_t bytes)
+{
+	return k_heap_alloc(&heap, bytes, K_NO_WAIT);
+}
+
+static void heap_free(void *mem)
+{
+	k_heap_free(&heap, mem);
+}
+
+/* Replay a trace, filling every buffer with its slot number to detect
+ * overlapping allocations.
+ */
+static void replay(const struct trace_entry *trace, size_t len,
+		   alloc_fn_t alloc_fn, free_fn_t free_fn,
+		   struct replay_result *result)
+{
+	void *slots[TRACE_SLOTS] = { 0 };
+	uint16_t sizes[TRACE_SLOTS] = { 0 };
+	uint32_t start = k_cycle_get_32();
+
+	memset(result, 0, sizeof(*result));
+
+	for (size_t i = 0; i < len; i++) {
+		const struct trace_entry *e = &trace[i];
+		void *mem;
+
+		zassert_true(e->slot < TRACE_SLOTS, "Too many slots in trace");
+
+		switch (e->op) {
+		case OP_ALLOC:
+		case OP_ALLOC_FAILED:
+			result->allocs++;
+			mem = alloc_fn(e->size);
+			if (mem == NULL) {
+				result->failures++;
+				break;
+			}
+
+			if (e->op == OP_ALLOC_FAILED) {
+				free_fn(mem);
+				break;
+			}
+
+			memset(mem, e->slot, e->size);
+			slots[e->slot] = mem;
+			sizes[e->slot] = e->size;
+			break;
+
+		case OP_FREE:
+			mem = slots[e->slot];
+			if (mem == NULL) {
+				/* The allocation failed during the replay. */
+				break;
+			}
+
+			for (size_t j = 0; j < sizes[e->slot]; j++) {
+				zassert_equal(((uint8_t *)mem)[j], e->slot,
+					      "Buffer overwritten at entry %zu",
+					      i);
+			}
+
+			free_fn(mem);
+			slots[e->slot] = NULL;
+			break;
+		}
+	}
+
+	result->cycles = k_cycle_get_32() - start;
+}
+
+static void test_init_invalid(void)
+{
+	const struct shm_tx_pool_class_config unsorted[] = {
+		{ 256, 1 },
+		{ 64, 1 },
+	};
+	const struct shm_tx_pool_class_config unaligned[] = {
+		{ 62, 1 },
+	};
+	const struct shm_tx_pool_class_config too_large[] = {
+		{ 1024, REGION_SIZE / 1024 },
+	};
+
+	zassert_equal(shm_tx_pool_init(&pool, region, sizeof(region),
+				       unsorted, ARRAY_SIZE(unsorted)),
+		      -EINVAL, "Unsorted classes accepted");
+	zassert_equal(shm_tx_pool_init(&pool, region, sizeof(region),
+				       unaligned, ARRAY_SIZE(unaligned)),
+		      -EINVAL, "Unaligned block size accepted");
+	zassert_equal(shm_tx_pool_init(&pool, region, sizeof(region),
+				       too_large, ARRAY_SIZE(too_large)),
+		      -ENOMEM, "Classes without heap accepted");
+}
+
+static void test_class_selection(void)
+{
+	void *small[8];
+	void *mem;
+
+	zassert_equal(shm_tx_pool_init(&pool, region, sizeof(region),
+				       config, ARRAY_SIZE(config)),
+		      0, "Cannot init pool");
+
+	mem = shm_tx_pool_alloc(&pool, 65);
+	zassert_true(mem >= (void *)pool.classes[1].start &&
+		     mem < (void *)pool.classes[1].end, "Wrong class");
+	shm_tx_pool_free(&pool, mem);
+
+	mem = shm_tx_pool_alloc(&pool, 2000);
+	zassert_not_null(mem, "Cannot allocate from heap");
+	zassert_true(mem >= (void *)pool.classes[2].end, "Not in heap");
+	shm_tx_pool_free(&pool, mem);
+
+	for (size_t i = 0; i < ARRAY_SIZE(small); i++) {
+		small[i] = shm_tx_pool_alloc(&pool, 40);
+		zassert_true(small[i] >= (void *)pool.classes[0].start &&
+			     small[i] < (void *)pool.classes[0].end,
+			     "Wrong class");
+	}
+
+	/* The smallest class is empty, the next one is used. */
+	mem = shm_tx_pool_alloc(&pool, 40);
+	zassert_true(mem >= (void *)pool.classes[1].start &&
+		     mem < (void *)pool.classes[1].end, "Wrong class");
+	shm_tx_pool_free(&pool, mem);
+
+	for (size_t i = 0; i < ARRAY_SIZE(small); i++) {
+		shm_tx_pool_free(&pool, small[i]);
+	}
+
+	zassert_equal(atomic_get(&pool.classes[0].hits), 8, "Wrong hits");
+	zassert_equal(atomic_get(&pool.classes[0].misses), 1, "Wrong misses");
+	zassert_equal(atomic_get(&pool.classes[0].max_used), 8,
+		      "Wrong high-water mark");
+	zassert_equal(atomic_get(&pool.classes[1].hits), 2, "Wrong hits");
+	zassert_equal(atomic_get(&pool.heap_allocs), 1, "Wrong heap count");
+	zassert_equal(k_mem_slab_num_used_get(&pool.classes[0].slab), 0,
+		      "Block not freed");
+}
+
+static void test_trace_replay(void)
+{
+	struct replay_result heap_result;
+	struct replay_result pool_result;
+	uint32_t served;
+
+	k_heap_init(&heap, region, sizeof(region));
+	replay(uplink_trace, ARRAY_SIZE(uplink_trace), heap_alloc, heap_free,
+	       &heap_result);
+
+	zassert_equal(shm_tx_pool_init(&pool, region, sizeof(region),
+				       config, ARRAY_SIZE(config)),
+		      0, "Cannot init pool");
+	replay(uplink_trace, ARRAY_SIZE(uplink_trace), pool_alloc, pool_free,
+	       &pool_result);
+
+	served = atomic_get(&pool.heap_allocs) +
+		 atomic_get(&pool.failed_allocs);
+	for (size_t i = 0; i < ARRAY_SIZE(config); i++) {
+		served += atomic_get(&pool.classes[i].hits);
+		zassert_equal(k_mem_slab_num_used_get(&pool.classes[i].slab),
+			      0, "Block leaked in class %zu", i);
+	}
+
+	zassert_equal(served, pool_result.allocs, "Allocations not counted");
+	zassert_equal(atomic_get(&pool.failed_allocs), pool_result.failures,
+		      "Failures not counted");
+
+	printk("Uplink trace, %zu allocations:\n", heap_result.allocs);
+	printk("heap: %zu failed, %u cycles\n", heap_result.failures,
+	       heap_result.cycles);
+	printk("pool: %zu failed, %u cycles\n", pool_result.failures,
+	       pool_result.cycles);
+	shm_tx_pool_print(&pool);
+
+	/* Expected counts for the bundled trace. They only depend on the
+	 * number of blocks in each class, not on the heap.
+	 */
+	zassert_equal(atomic_get(&pool.classes[0].hits), 192, "Wrong hits");
+	zassert_equal(atomic_get(&pool.classes[1].hits), 101, "Wrong hits");
+	zassert_equal(atomic_get(&pool.classes[2].hits), 61, "Wrong hits");
+	for (size_t i = 0; i < ARRAY_SIZE(config); i++) {
+		zassert_equal(atomic_get(&pool.classes[i].misses), 0,
+			      "Misses in class %zu", i);
+		zassert_equal(atomic_get(&pool.classes[i].max_used),
+			      config[i].block_cnt, "Class %zu not filled", i);
+	}
+	zassert_equal(atomic_get(&pool.heap_allocs), 79, "Wrong heap count");
+	zassert_equal(pool_result.failures, 0, "Pool allocations failed");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(shm_tx_pool,
+			 ztest_unit_test(test_init_invalid),
+			 ztest_unit_test(test_class_selection),
+			 ztest_unit_test(test_trace_replay)
+			 );
+
+	ztest_run_test_suite(shm_tx_pool);
+}
@@ -0,0 +1,67 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2021 Nordic Semiconductor ASA
+#
+# SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+
+"""Convert a log of TX region allocations to a trace for the test.
+
+The log is captured with CONFIG_NRF_MODEM_LIB_DEBUG_SHM_TX_ALLOC enabled.
+Each allocation is assigned a slot, which is released when the allocation
+is freed, so that the trace does not depend on the addresses.
+"""
+
+import re
+import sys
+from argparse import ArgumentParser
+
+ALLOC_RE = re.compile(r'shm_tx_alloc\((\d+)\) -> (0x[0-9a-fA-F]+|\(nil\))')
+FREE_RE = re.compile(r'shm_tx_free\((0x[0-9a-fA-F]+)\)')
+
+
+def convert(log, out):
+    slots = {}
+    free_slots = []
+    slot_cnt = 0
+
+    for line in log:
+        match = ALLOC_RE.search(line)
+        if match:
+            size, addr = int(match.group(1)), match.group(2)
+            if addr == '(nil)' or int(addr, 16) == 0:
+                # Failed allocations are not freed, replay them anyway.
+                out.write('TRACE_ALLOC_FAILED({})\n'.format(size))
+                continue
+            if free_slots:
+                slot = free_slots.pop()
+            else:
+                slot = slot_cnt
+                slot_cnt += 1
+            slots[int(addr, 16)] = slot
+            out.write('TRACE_ALLOC({}, {})\n'.format(slot, size))
+            continue
+
+        match = FREE_RE.search(line)
+        if match:
+            slot = slots.pop(int(match.group(1), 16), None)
+            if slot is None:
+                sys.stderr.write('Free without allocation: ' + line)
+                continue
+            free_slots.append(slot)
+            out.write('TRACE_FREE({})\n'.format(slot))
+
+    out.write('/* Slots: {} */\n'.format(slot_cnt))
+
+
+def main():
+    parser = ArgumentParser(description=__doc__)
+    parser.add_argument('log', help='Log file')
+    parser.add_argument('out', help='Output trace file')
+    args = parser.parse_args()
+
+    with open(args.log) as log, open(args.out, 'w') as out:
+        convert(log, out)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,20 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include "dispatch_class_event.h"
+
+
+EVENT_TYPE_DEFINE_DISPATCH_CLASS(realtime_event,
+				 EVENT_DISPATCH_CLASS_REALTIME,
+				 false,
+				 NULL,
+				 NULL);
+
+EVENT_TYPE_DEFINE_DISPATCH_CLASS(background_event,
+				 EVENT_DISPATCH_CLASS_BACKGROUND,
+				 false,
+				 NULL,
+				 NULL);
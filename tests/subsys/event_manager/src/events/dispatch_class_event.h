@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _DISPATCH_CLASS_EVENT_H_
+#define _DISPATCH_CLASS_EVENT_H_
+
+/**
+ * @brief Dispatch Class Events
+ * @defgroup dispatch_class_event Dispatch Class Events
+ * @{
+ */
+
+#include "event_manager.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct realtime_event {
+	struct event_header header;
+
+	int val;
+};
+
+EVENT_TYPE_DECLARE(realtime_event);
+
+struct background_event {
+	struct event_header header;
+
+	int val;
+};
+
+EVENT_TYPE_DECLARE(background_event);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif /* _DISPATCH_CLASS_EVENT_H_ */
@@ -0,0 +1,23 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include "perf_event.h"
+
+
+EVENT_TYPE_DEFINE(perf_event_1,
+		  false,
+		  NULL,
+		  NULL);
+
+EVENT_TYPE_DEFINE(perf_event_8,
+		  false,
+		  NULL,
+		  NULL);
+
+EVENT_TYPE_DEFINE(perf_event_32,
+		  false,
+		  NULL,
+		  NULL);
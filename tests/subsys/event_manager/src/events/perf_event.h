@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _PERF_EVENT_H_
+#define _PERF_EVENT_H_
+
+/**
+ * @brief Dispatch Performance Events
+ * @defgroup perf_event Dispatch Performance Events
+ * @{
+ */
+
+#include "event_manager.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Event with a single listener. */
+struct perf_event_1 {
+	struct event_header header;
+};
+
+EVENT_TYPE_DECLARE(perf_event_1);
+
+/* Event with 8 listeners. */
+struct perf_event_8 {
+	struct event_header header;
+};
+
+EVENT_TYPE_DECLARE(perf_event_8);
+
+/* Event with 32 listeners. */
+struct perf_event_32 {
+	struct event_header header;
+};
+
+EVENT_TYPE_DECLARE(perf_event_32);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif /* _PERF_EVENT_H_ */
@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _STRESS_EVENT_H_
+#define _STRESS_EVENT_H_
+
+/**
+ * @brief Stress Events
+ * @defgroup stress_event Stress Events
+ * @{
+ */
+
+#include "event_manager.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct stress_event {
+	struct event_header header;
+
+	uint8_t source;
+	uint32_t seq;
+};
+
+EVENT_TYPE_DECLARE(stress_event);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif /* _STRESS_EVENT_H_ */
@@ -27,6 +27,10 @@ enum test_id {
 	TEST_SUBSCRIBER_ORDER,
 	TEST_OOM_RESET,
 	TEST_MULTICONTEXT,
+	TEST_DISPATCH_CLASS,
+	TEST_DISPATCH_PERF,
+	TEST_TIMING,
+	TEST_STRESS,
 
 	TEST_CNT
 };
@@ -0,0 +1,38 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _TIMING_EVENT_H_
+#define _TIMING_EVENT_H_
+
+/**
+ * @brief Timing Events
+ * @defgroup timing_event Timing Events
+ * @{
+ */
+
+#include "event_manager.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct timing_event {
+	struct event_header header;
+
+	int val;
+};
+
+EVENT_TYPE_DECLARE(timing_event);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif /* _TIMING_EVENT_H_ */
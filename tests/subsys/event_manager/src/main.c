@@ -39,6 +39,99 @@ static void test_start(enum test_id test_id)
 	zassert_equal(err, 0, "Test execution hanged");
 }
 
+#if defined(CONFIG_EVENT_MANAGER_EVENT_POOL)
+#define POOL_ALIGN	8
+#define SMALL_BLOCK_CNT	CONFIG_EVENT_MANAGER_EVENT_POOL_SMALL_BLOCK_COUNT
+
+static void pool_stats_get(struct event_pool_stats *stats, uint32_t *heap_cnt)
+{
+	int pool_cnt = event_manager_pool_stats_get(stats, EVENT_POOL_CNT,
+						    heap_cnt);
+
+	zassert_equal(pool_cnt, EVENT_POOL_CNT, "Cannot get pool statistics");
+}
+
+static void test_pool(void)
+{
+	struct event_pool_stats start[EVENT_POOL_CNT];
+	struct event_pool_stats stats[EVENT_POOL_CNT];
+	uint32_t start_heap_cnt;
+	uint32_t heap_cnt;
+	void *blocks[SMALL_BLOCK_CNT + 1];
+	void *addr;
+
+	pool_stats_get(start, &start_heap_cnt);
+
+	/* An event is placed in the smallest pool with large enough blocks. */
+	for (size_t i = 0; i < EVENT_POOL_CNT; i++) {
+		size_t size = (i == 0) ? 1 : (start[i - 1].block_size + 1);
+
+		addr = _event_pool_alloc(size);
+		zassert_not_null(addr, "Cannot allocate %zu bytes", size);
+		zassert_equal((uintptr_t)addr % POOL_ALIGN, 0,
+			      "Block not aligned to %d bytes", POOL_ALIGN);
+
+		pool_stats_get(stats, NULL);
+		zassert_equal(stats[i].alloc_cnt, start[i].alloc_cnt + 1,
+			      "%zu bytes not allocated from pool %zu", size, i);
+		zassert_equal(stats[i].used_cnt, start[i].used_cnt + 1,
+			      "Wrong number of used blocks in pool %zu", i);
+
+		event_manager_free(addr);
+		pool_stats_get(stats, NULL);
+		zassert_equal(stats[i].used_cnt, start[i].used_cnt,
+			      "Block not returned to pool %zu", i);
+	}
+
+	/* Events too big for any of the pools are allocated from the heap. */
+	addr = _event_pool_alloc(start[EVENT_POOL_CNT - 1].block_size + 1);
+	zassert_not_null(addr, "Cannot allocate event from the heap");
+	event_manager_free(addr);
+
+	pool_stats_get(stats, &heap_cnt);
+	zassert_equal(heap_cnt, start_heap_cnt + 1, "Heap allocation not counted");
+
+	/* An event that does not fit in the exhausted small pool is allocated
+	 * from the heap, not from a larger pool.
+	 */
+	pool_stats_get(start, &start_heap_cnt);
+	size_t free_cnt = start[0].block_cnt - start[0].used_cnt;
+
+	zassert_true(free_cnt <= SMALL_BLOCK_CNT, "Wrong number of blocks");
+	for (size_t i = 0; i <= free_cnt; i++) {
+		blocks[i] = _event_pool_alloc(1);
+		zassert_not_null(blocks[i], "Cannot allocate block %zu", i);
+	}
+
+	pool_stats_get(stats, &heap_cnt);
+	zassert_equal(stats[0].used_cnt, stats[0].block_cnt,
+		      "Small pool not exhausted");
+	zassert_equal(stats[0].max_used_cnt, stats[0].block_cnt,
+		      "Wrong maximum number of used blocks");
+	zassert_equal(stats[0].alloc_cnt, start[0].alloc_cnt + free_cnt,
+		      "Wrong number of allocations from the small pool");
+	zassert_equal(stats[0].exhausted_cnt, start[0].exhausted_cnt + 1,
+		      "Exhaustion of the small pool not counted");
+	zassert_equal(stats[1].alloc_cnt, start[1].alloc_cnt,
+		      "Block taken from the medium pool");
+	zassert_equal(heap_cnt, start_heap_cnt,
+		      "Exhaustion counted as a too big event");
+
+	for (size_t i = 0; i <= free_cnt; i++) {
+		event_manager_free(blocks[i]);
+	}
+
+	pool_stats_get(stats, NULL);
+	zassert_equal(stats[0].used_cnt, start[0].used_cnt,
+		      "Blocks not returned to the small pool");
+}
+#else
+static void test_pool(void)
+{
+	ztest_test_skip();
+}
+#endif /* CONFIG_EVENT_MANAGER_EVENT_POOL */
+
 static void test_basic(void)
 {
 	test_start(TEST_BASIC);
@@ -69,16 +162,41 @@ static void test_multicontext(void)
 	test_start(TEST_MULTICONTEXT);
 }
 
+static void test_dispatch_class(void)
+{
+	test_start(TEST_DISPATCH_CLASS);
+}
+
+static void test_dispatch_perf(void)
+{
+	test_start(TEST_DISPATCH_PERF);
+}
+
+static void test_timing(void)
+{
+	test_start(TEST_TIMING);
+}
+
+static void test_stress(void)
+{
+	test_start(TEST_STRESS);
+}
+
 void test_main(void)
 {
 	ztest_test_suite(event_manager_tests,
 			 ztest_unit_test(test_init),
+			 ztest_unit_test(test_pool),
 			 ztest_unit_test(test_basic),
 			 ztest_unit_test(test_data),
 			 ztest_unit_test(test_event_order),
 			 ztest_unit_test(test_subs_order),
 			 ztest_unit_test(test_oom_reset),
-			 ztest_unit_test(test_multicontext)
+			 ztest_unit_test(test_multicontext),
+			 ztest_unit_test(test_dispatch_class),
+			 ztest_unit_test(test_dispatch_perf),
+			 ztest_unit_test(test_timing),
+			 ztest_unit_test(test_stress)
 			 );
 
 	ztest_run_test_suite(event_manager_tests);
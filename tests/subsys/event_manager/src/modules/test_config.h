@@ -19,3 +19,23 @@
 
 /* TEST_EVENT_ORDER */
 #define TEST_EVENT_ORDER_CNT 20
+
+
+/* TEST_DISPATCH_CLASS */
+#define TEST_DISPATCH_CLASS_CNT 10
+
+
+/* TEST_DISPATCH_PERF */
+#define TEST_DISPATCH_PERF_EVENT_CNT 20
+
+
+/* TEST_TIMING */
+#define TEST_TIMING_EVENT_CNT 5
+#define TEST_TIMING_BUSY_WAIT_US 1000
+
+
+/* TEST_STRESS */
+#define TEST_STRESS_EVENT_CNT 500
+#define TEST_STRESS_SUBMIT_DELAY_US 20
+#define TEST_STRESS_ISR_PERIOD_US 100
+#define TEST_STRESS_THREAD_PRIORITY K_PRIO_PREEMPT(1)
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr.h>
+#include <ztest.h>
+
+#include <test_events.h>
+#include <dispatch_class_event.h>
+
+#include "test_config.h"
+
+#define MODULE test_dispatch_class
+
+
+static int realtime_cnt;
+static int background_cnt;
+
+static bool event_handler(const struct event_header *eh)
+{
+	if (is_test_start_event(eh)) {
+		struct test_start_event *st = cast_test_start_event(eh);
+
+		if (st->test_id != TEST_DISPATCH_CLASS) {
+			return false;
+		}
+
+		realtime_cnt = 0;
+		background_cnt = 0;
+
+		for (size_t i = 0; i < TEST_DISPATCH_CLASS_CNT; i++) {
+			struct background_event *event =
+				new_background_event();
+
+			zassert_not_null(event, "Failed to allocate event");
+			event->val = i;
+			EVENT_SUBMIT(event);
+		}
+
+		for (size_t i = 0; i < TEST_DISPATCH_CLASS_CNT; i++) {
+			struct realtime_event *event = new_realtime_event();
+
+			zassert_not_null(event, "Failed to allocate event");
+			event->val = i;
+			EVENT_SUBMIT(event);
+		}
+
+		if (IS_ENABLED(CONFIG_EVENT_MANAGER_DISPATCH_CLASSES)) {
+			/* Real-time queue preempts the normal queue. Background
+			 * queue must wait until the normal queue is idle.
+			 */
+			zassert_equal(realtime_cnt, TEST_DISPATCH_CLASS_CNT,
+				      "Real-time events not dispatched");
+			zassert_equal(background_cnt, 0,
+				      "Background events dispatched too early");
+		}
+
+		return false;
+	}
+
+	if (is_realtime_event(eh)) {
+		struct realtime_event *event = cast_realtime_event(eh);
+
+		zassert_equal(event->val, realtime_cnt,
+			      "Incorrect real-time event order");
+		realtime_cnt++;
+
+		return false;
+	}
+
+	if (is_background_event(eh)) {
+		struct background_event *event = cast_background_event(eh);
+
+		zassert_equal(event->val, background_cnt,
+			      "Incorrect background event order");
+		background_cnt++;
+
+		if (background_cnt == TEST_DISPATCH_CLASS_CNT) {
+			struct test_end_event *te = new_test_end_event();
+
+			zassert_not_null(te, "Failed to allocate event");
+			te->test_id = TEST_DISPATCH_CLASS;
+			EVENT_SUBMIT(te);
+		}
+
+		return false;
+	}
+
+	zassert_true(false, "Event unhandled");
+
+	return false;
+}
+
+EVENT_LISTENER(MODULE, event_handler);
+EVENT_SUBSCRIBE(MODULE, test_start_event);
+EVENT_SUBSCRIBE(MODULE, realtime_event);
+EVENT_SUBSCRIBE(MODULE, background_event);
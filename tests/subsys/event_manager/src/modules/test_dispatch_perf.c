@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr.h>
+#include <ztest.h>
+
+#include <test_events.h>
+#include <perf_event.h>
+
+#include "test_config.h"
+
+#define MODULE test_dispatch_perf
+
+enum perf_stage {
+	PERF_STAGE_1,
+	PERF_STAGE_8,
+	PERF_STAGE_32,
+
+	PERF_STAGE_CNT
+};
+
+static const size_t stage_listener_cnt[] = {
+	[PERF_STAGE_1] = 1,
+	[PERF_STAGE_8] = 8,
+	[PERF_STAGE_32] = 32,
+};
+
+static enum perf_stage stage;
+static size_t notification_cnt;
+static uint32_t start_time;
+
+
+static void submit_perf_event(void)
+{
+	switch (stage) {
+	case PERF_STAGE_1:
+	{
+		struct perf_event_1 *event = new_perf_event_1();
+
+		zassert_not_null(event, "Failed to allocate event");
+		EVENT_SUBMIT(event);
+		break;
+	}
+
+	case PERF_STAGE_8:
+	{
+		struct perf_event_8 *event = new_perf_event_8();
+
+		zassert_not_null(event, "Failed to allocate event");
+		EVENT_SUBMIT(event);
+		break;
+	}
+
+	case PERF_STAGE_32:
+	{
+		struct perf_event_32 *event = new_perf_event_32();
+
+		zassert_not_null(event, "Failed to allocate event");
+		EVENT_SUBMIT(event);
+		break;
+	}
+
+	default:
+		zassert_unreachable("Wrong stage");
+		break;
+	}
+}
+
+static void stage_start(void)
+{
+	notification_cnt = 0;
+	start_time = k_cycle_get_32();
+
+	for (size_t i = 0; i < TEST_DISPATCH_PERF_EVENT_CNT; i++) {
+		submit_perf_event();
+	}
+}
+
+static void stage_end(void)
+{
+	uint32_t cycles = k_cycle_get_32() - start_time;
+
+	printk("Dispatch cost for %zu listener(s): %u cycles per event "
+	       "(dispatch table %s)\n",
+	       stage_listener_cnt[stage],
+	       cycles / TEST_DISPATCH_PERF_EVENT_CNT,
+	       IS_ENABLED(CONFIG_EVENT_MANAGER_DISPATCH_TABLE) ?
+	       "enabled" : "disabled");
+
+	stage++;
+
+	if (stage < PERF_STAGE_CNT) {
+		stage_start();
+	} else {
+		struct test_end_event *te = new_test_end_event();
+
+		zassert_not_null(te, "Failed to allocate event");
+		te->test_id = TEST_DISPATCH_PERF;
+		EVENT_SUBMIT(te);
+	}
+}
+
+static bool perf_event_handler(const struct event_header *eh)
+{
+	notification_cnt++;
+
+	if (notification_cnt ==
+	    (stage_listener_cnt[stage] * TEST_DISPATCH_PERF_EVENT_CNT)) {
+		stage_end();
+	}
+
+	return false;
+}
+
+static bool event_handler(const struct event_header *eh)
+{
+	if (is_test_start_event(eh)) {
+		struct test_start_event *st = cast_test_start_event(eh);
+
+		if (st->test_id == TEST_DISPATCH_PERF) {
+			stage = PERF_STAGE_1;
+			stage_start();
+		}
+
+		return false;
+	}
+
+	zassert_true(false, "Event unhandled");
+
+	return false;
+}
+
+EVENT_LISTENER(MODULE, event_handler);
+EVENT_SUBSCRIBE(MODULE, test_start_event);
+
+
+#define PERF_LISTENER(i) _CONCAT(perf_listener_, i)
+
+#define PERF_LISTENER_DEFINE(i, _)					\
+	EVENT_LISTENER(PERF_LISTENER(i), perf_event_handler);		\
+	EVENT_SUBSCRIBE(PERF_LISTENER(i), perf_event_32);
+
+#define PERF_LISTENER_SUBSCRIBE_8(i, _)				\
+	EVENT_SUBSCRIBE(PERF_LISTENER(i), perf_event_8);
+
+UTIL_LISTIFY(32, PERF_LISTENER_DEFINE, _)
+UTIL_LISTIFY(8, PERF_LISTENER_SUBSCRIBE_8, _)
+EVENT_SUBSCRIBE(PERF_LISTENER(0), perf_event_1);
@@ -46,7 +46,7 @@ static bool event_handler(const struct event_header *eh)
 
 			/* Freeing memory to enable further testing. */
 			while (i >= 0) {
-				k_free(event_tab[i]);
+				event_manager_free(event_tab[i]);
 				i--;
 			}
 
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr.h>
+#include <ztest.h>
+#include <string.h>
+
+#include <test_events.h>
+#include <stress_event.h>
+
+#include "test_config.h"
+
+#define MODULE test_stress
+#define THREAD_STACK_SIZE 400
+
+enum stress_source {
+	STRESS_SOURCE_T1,
+	STRESS_SOURCE_T2,
+	STRESS_SOURCE_ISR,
+
+	STRESS_SOURCE_CNT
+};
+
+static K_THREAD_STACK_DEFINE(thread_stack1, THREAD_STACK_SIZE);
+static K_THREAD_STACK_DEFINE(thread_stack2, THREAD_STACK_SIZE);
+
+static struct k_thread thread1;
+static struct k_thread thread2;
+
+static uint32_t submitted_cnt[STRESS_SOURCE_CNT];
+static uint32_t received_cnt[STRESS_SOURCE_CNT];
+static uint32_t received_total;
+
+
+static void submit_stress_event(enum stress_source source)
+{
+	struct stress_event *event = new_stress_event();
+
+	zassert_not_null(event, "Failed to allocate event");
+	event->source = source;
+	event->seq = submitted_cnt[source];
+	submitted_cnt[source]++;
+
+	EVENT_SUBMIT(event);
+}
+
+static void timer_handler(struct k_timer *timer)
+{
+	submit_stress_event(STRESS_SOURCE_ISR);
+
+	if (submitted_cnt[STRESS_SOURCE_ISR] == TEST_STRESS_EVENT_CNT) {
+		k_timer_stop(timer);
+	}
+}
+
+static K_TIMER_DEFINE(stress_timer, timer_handler, NULL);
+
+static void thread_fn(void *p1, void *p2, void *p3)
+{
+	enum stress_source source = (enum stress_source)p1;
+
+	for (size_t i = 0; i < TEST_STRESS_EVENT_CNT; i++) {
+		submit_stress_event(source);
+		k_busy_wait(TEST_STRESS_SUBMIT_DELAY_US);
+	}
+}
+
+static void stress_start(void)
+{
+	memset(submitted_cnt, 0, sizeof(submitted_cnt));
+	memset(received_cnt, 0, sizeof(received_cnt));
+	received_total = 0;
+
+	k_timer_start(&stress_timer, K_USEC(TEST_STRESS_ISR_PERIOD_US),
+		      K_USEC(TEST_STRESS_ISR_PERIOD_US));
+
+	/* Threads of the same priority preempt each other on time slices and
+	 * are preempted by the timer interrupt in the middle of a submission.
+	 */
+	k_thread_create(&thread1, thread_stack1, THREAD_STACK_SIZE,
+			thread_fn, (void *)STRESS_SOURCE_T1, NULL, NULL,
+			TEST_STRESS_THREAD_PRIORITY, 0, K_NO_WAIT);
+	k_thread_create(&thread2, thread_stack2, THREAD_STACK_SIZE,
+			thread_fn, (void *)STRESS_SOURCE_T2, NULL, NULL,
+			TEST_STRESS_THREAD_PRIORITY, 0, K_NO_WAIT);
+}
+
+static bool event_handler(const struct event_header *eh)
+{
+	if (is_test_start_event(eh)) {
+		struct test_start_event *st = cast_test_start_event(eh);
+
+		if (st->test_id == TEST_STRESS) {
+			stress_start();
+		}
+
+		return false;
+	}
+
+	if (is_stress_event(eh)) {
+		struct stress_event *event = cast_stress_event(eh);
+
+		zassert_true(event->source < STRESS_SOURCE_CNT,
+			     "Wrong event source");
+		zassert_equal(event->seq, received_cnt[event->source],
+			      "Events from a single source out of order");
+
+		received_cnt[event->source]++;
+		received_total++;
+
+		if (received_total ==
+		    (STRESS_SOURCE_CNT * TEST_STRESS_EVENT_CNT)) {
+			struct test_end_event *te = new_test_end_event();
+
+			zassert_not_null(te, "Failed to allocate event");
+			te->test_id = TEST_STRESS;
+			EVENT_SUBMIT(te);
+		}
+
+		return false;
+	}
+
+	zassert_true(false, "Event unhandled");
+
+	return false;
+}
+
+EVENT_LISTENER(MODULE, event_handler);
+EVENT_SUBSCRIBE(MODULE, test_start_event);
+EVENT_SUBSCRIBE(MODULE, stress_event);
@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr.h>
+#include <ztest.h>
+#include <string.h>
+
+#include <test_events.h>
+#include <timing_event.h>
+
+#include "test_config.h"
+
+#define MODULE test_timing
+#define SLOW_LISTENER test_timing_slow
+
+
+static int timing_event_cnt;
+
+static void check_histograms(const struct event_type *et)
+{
+#if defined(CONFIG_EVENT_MANAGER_TIMING_HISTOGRAMS)
+	const struct event_listener *slow_listener = NULL;
+	struct event_histogram hist;
+	int err;
+
+	for (const struct event_listener *el = __start_event_listeners;
+	     el != __stop_event_listeners;
+	     el++) {
+		if (!strcmp(el->name, STRINGIFY(SLOW_LISTENER))) {
+			slow_listener = el;
+			break;
+		}
+	}
+
+	zassert_not_null(slow_listener, "Slow listener not found");
+
+	err = event_manager_listener_histogram_get(slow_listener, &hist);
+	zassert_equal(err, 0, "Cannot get listener histogram");
+	zassert_equal(hist.cnt, TEST_TIMING_EVENT_CNT,
+		      "Wrong number of listener samples");
+	zassert_true(hist.max_us >= TEST_TIMING_BUSY_WAIT_US,
+		     "Listener execution time too short");
+
+	uint32_t slow_cnt = 0;
+
+	for (size_t i = 0; i < EVENT_HISTOGRAM_BUCKET_CNT; i++) {
+		if ((i == EVENT_HISTOGRAM_BUCKET_CNT - 1) ||
+		    (EVENT_HISTOGRAM_BUCKET_LIMIT_US(i) >
+		     TEST_TIMING_BUSY_WAIT_US)) {
+			slow_cnt += hist.bucket[i];
+		}
+	}
+
+	zassert_equal(slow_cnt, TEST_TIMING_EVENT_CNT,
+		      "Listener samples in wrong buckets");
+
+	err = event_manager_latency_histogram_get(et, &hist);
+	zassert_equal(err, 0, "Cannot get latency histogram");
+	zassert_equal(hist.cnt, TEST_TIMING_EVENT_CNT,
+		      "Wrong number of latency samples");
+
+	/* Every event waits until the previous events are processed. */
+	zassert_true(hist.max_us >=
+		     (TEST_TIMING_EVENT_CNT - 1) * TEST_TIMING_BUSY_WAIT_US,
+		     "Event latency too short");
+#endif
+}
+
+static bool slow_event_handler(const struct event_header *eh)
+{
+	k_busy_wait(TEST_TIMING_BUSY_WAIT_US);
+
+	return false;
+}
+
+EVENT_LISTENER(SLOW_LISTENER, slow_event_handler);
+EVENT_SUBSCRIBE(SLOW_LISTENER, timing_event);
+
+static bool event_handler(const struct event_header *eh)
+{
+	if (is_test_start_event(eh)) {
+		struct test_start_event *st = cast_test_start_event(eh);
+
+		if (st->test_id != TEST_TIMING) {
+			return false;
+		}
+
+		if (IS_ENABLED(CONFIG_EVENT_MANAGER_TIMING_HISTOGRAMS)) {
+			event_manager_histograms_reset();
+		}
+
+		timing_event_cnt = 0;
+
+		for (size_t i = 0; i < TEST_TIMING_EVENT_CNT; i++) {
+			struct timing_event *event = new_timing_event();
+
+			zassert_not_null(event, "Failed to allocate event");
+			event->val = i;
+			EVENT_SUBMIT(event);
+		}
+
+		return false;
+	}
+
+	if (is_timing_event(eh)) {
+		timing_event_cnt++;
+
+		if (timing_event_cnt == TEST_TIMING_EVENT_CNT) {
+			check_histograms(eh->type_id);
+
+			struct test_end_event *te = new_test_end_event();
+
+			zassert_not_null(te, "Failed to allocate event");
+			te->test_id = TEST_TIMING;
+			EVENT_SUBMIT(te);
+		}
+
+		return false;
+	}
+
+	zassert_true(false, "Event unhandled");
+
+	return false;
+}
+
+EVENT_LISTENER(MODULE, event_handler);
+EVENT_SUBSCRIBE(MODULE, test_start_event);
+EVENT_SUBSCRIBE_FINAL(MODULE, timing_event);
@@ -0,0 +1,338 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <ztest.h>
+#include <event_manager.h>
+#include <event_manager_storage_priv.h>
+#include <native_rtc.h>
+
+#define BATCH_CNT	100
+#define BATCH_SIZE	1000
+#define EVENT_CNT	(BATCH_CNT * BATCH_SIZE)
+
+/* Events kept in the storage across a reinitialization. */
+#define BACKLOG_CNT	4096
+#define CONSUMED_CNT	1000
+
+/* Events that do not fit in the storage partition. */
+#define OVERFLOW_CNT	16384
+
+/* Only synchronized events and stored cursors survive a reset. */
+#define SYNC_INTERVAL	CONFIG_EVENT_MANAGER_STORAGE_LITTLEFS_SYNC_INTERVAL
+#define CURSOR_INTERVAL	CONFIG_EVENT_MANAGER_STORAGE_LITTLEFS_CURSOR_INTERVAL
+
+BUILD_ASSERT((BACKLOG_CNT % SYNC_INTERVAL) == 0);
+BUILD_ASSERT((OVERFLOW_CNT % SYNC_INTERVAL) == 0);
+BUILD_ASSERT((CONSUMED_CNT % CURSOR_INTERVAL) == 0);
+
+struct stored_event {
+	struct event_header header;
+
+	uint32_t val;
+};
+
+EVENT_TYPE_DECLARE(stored_event);
+EVENT_TYPE_DEFINE(stored_event, false, NULL, NULL);
+
+static struct event_storage_api *api;
+
+#if defined(CONFIG_EVENT_MANAGER_STORAGE_REPLAY_INCREMENTAL)
+#include <event_manager_replay_event.h>
+
+#define REPLAY_BATCH_SIZE	CONFIG_EVENT_MANAGER_STORAGE_REPLAY_BATCH_SIZE
+
+/* Events played by the incremental replay, in several batches. */
+#define REPLAY_CNT		(3 * SYNC_INTERVAL)
+#define REPLAY_CONSUMED_CNT	(2 * CURSOR_INTERVAL)
+#define REPLAY_PROGRESS_MAX	(REPLAY_CNT / REPLAY_BATCH_SIZE + 1)
+
+BUILD_ASSERT(REPLAY_CNT > 2 * REPLAY_BATCH_SIZE);
+BUILD_ASSERT(REPLAY_CONSUMED_CNT < REPLAY_CNT);
+
+static K_SEM_DEFINE(replay_done_sem, 0, 1);
+
+/* Events with a lower value are consumed by the listener. */
+static uint32_t replay_consume_below;
+
+static uint32_t replay_vals[REPLAY_CNT];
+static size_t replay_val_cnt;
+
+static struct event_replay_progress_event replay_progress[REPLAY_PROGRESS_MAX];
+static size_t replay_progress_cnt;
+
+static bool event_handler(const struct event_header *eh)
+{
+	if (is_stored_event(eh)) {
+		uint32_t val = cast_stored_event(eh)->val;
+
+		if (replay_val_cnt < ARRAY_SIZE(replay_vals)) {
+			replay_vals[replay_val_cnt] = val;
+		}
+		replay_val_cnt++;
+
+		return (val < replay_consume_below);
+	}
+
+	if (is_event_replay_progress_event(eh)) {
+		const struct event_replay_progress_event *event =
+			cast_event_replay_progress_event(eh);
+
+		if (replay_progress_cnt < ARRAY_SIZE(replay_progress)) {
+			replay_progress[replay_progress_cnt] = *event;
+		}
+		replay_progress_cnt++;
+
+		if (event->done) {
+			k_sem_give(&replay_done_sem);
+		}
+
+		return false;
+	}
+
+	return false;
+}
+
+EVENT_LISTENER(test_storage, event_handler);
+EVENT_SUBSCRIBE(test_storage, stored_event);
+EVENT_SUBSCRIBE(test_storage, event_replay_progress_event);
+#endif /* CONFIG_EVENT_MANAGER_STORAGE_REPLAY_INCREMENTAL */
+
+
+static void test_init(void)
+{
+	zassert_equal(event_manager_init(), 0, "Event manager init failed");
+
+	api = event_store_backend_get_api();
+	zassert_not_null(api, "No storage backend");
+	zassert_equal(api->clear(), 0, "Cannot clear storage");
+}
+
+static void write_events(uint32_t first_val, size_t cnt)
+{
+	for (size_t i = 0; i < cnt; i++) {
+		struct stored_event *event = new_stored_event();
+
+		zassert_not_null(event, "Failed to allocate event");
+		event->val = first_val + i;
+
+		zassert_equal(api->write(&event->header), 0,
+			      "Cannot write event");
+		event_manager_free(event);
+	}
+}
+
+static void read_batch(uint32_t first_val, bool from_start)
+{
+	for (size_t i = 0; i < BATCH_SIZE; i++) {
+		struct event_header *eh;
+
+		zassert_equal(api->read(&eh, from_start && (i == 0)), 0,
+			      "Cannot read event");
+		zassert_true(is_stored_event(eh), "Wrong event type");
+		zassert_equal(cast_stored_event(eh)->val, first_val + i,
+			      "Wrong event order");
+
+		zassert_equal(api->remove(eh), 0, "Cannot remove event");
+		event_manager_free(eh);
+	}
+}
+
+/* Play all stored events without consuming them. Returns the number of
+ * events played, which must end with last_val.
+ */
+static uint32_t replay_check(uint32_t last_val)
+{
+	struct event_header *eh;
+	uint32_t cnt = 0;
+	uint32_t val = 0;
+
+	while (api->read(&eh, (cnt == 0)) == 0) {
+		zassert_true(is_stored_event(eh), "Wrong event type");
+
+		uint32_t read_val = cast_stored_event(eh)->val;
+
+		zassert_true((cnt == 0) || (read_val == val + 1),
+			     "Event %u played after %u", read_val, val);
+		val = read_val;
+		cnt++;
+
+		event_manager_free(eh);
+	}
+
+	zassert_true(cnt > 0, "No event played");
+	zassert_equal(val, last_val, "Last event %u, expected %u", val,
+		      last_val);
+
+	return cnt;
+}
+
+static void test_throughput(void)
+{
+	struct event_storage_stats stats;
+	uint64_t write_us = 0;
+	uint64_t read_us = 0;
+
+	for (size_t i = 0; i < BATCH_CNT; i++) {
+		uint64_t start = native_rtc_gettime_us(RTC_CLOCK_REAL);
+
+		write_events(i * BATCH_SIZE, BATCH_SIZE);
+
+		uint64_t mid = native_rtc_gettime_us(RTC_CLOCK_REAL);
+
+		read_batch(i * BATCH_SIZE, (i == 0));
+
+		uint64_t end = native_rtc_gettime_us(RTC_CLOCK_REAL);
+
+		write_us += mid - start;
+		read_us += end - mid;
+	}
+
+	struct event_header *eh;
+
+	zassert_true(api->read(&eh, false) < 0, "Unexpected event");
+
+	zassert_equal(api->stats_get(&stats), 0, "Cannot get stats");
+	zassert_equal(stats.dropped_cnt, 0, "Events were dropped");
+
+	printk("Wrote %u events in %llu ms (%llu events/s)\n", EVENT_CNT,
+	       write_us / 1000, EVENT_CNT * 1000000ULL / MAX(write_us, 1));
+	printk("Replayed %u events in %llu ms (%llu events/s)\n", EVENT_CNT,
+	       read_us / 1000, EVENT_CNT * 1000000ULL / MAX(read_us, 1));
+	printk("Payload %u bytes, written %u bytes\n", stats.payload_bytes,
+	       stats.flash_bytes);
+}
+
+static void test_replay_after_reinit(void)
+{
+	struct event_storage_stats stats;
+
+	zassert_equal(api->clear(), 0, "Cannot clear storage");
+
+	write_events(0, BACKLOG_CNT);
+
+	for (size_t i = 0; i < CONSUMED_CNT; i++) {
+		struct event_header *eh;
+
+		zassert_equal(api->read(&eh, (i == 0)), 0, "Cannot read event");
+		zassert_equal(cast_stored_event(eh)->val, i,
+			      "Wrong event order");
+		zassert_equal(api->remove(eh), 0, "Cannot remove event");
+		event_manager_free(eh);
+	}
+
+	/* Simulate a reset. */
+	zassert_equal(api->init(), 0, "Cannot reinitialize storage");
+
+	zassert_equal(replay_check(BACKLOG_CNT - 1), BACKLOG_CNT - CONSUMED_CNT,
+		      "Wrong number of events played after reset");
+
+	zassert_equal(api->stats_get(&stats), 0, "Cannot get stats");
+	zassert_equal(stats.dropped_cnt, 0, "Events were dropped");
+}
+
+static void test_overflow(void)
+{
+	struct event_storage_stats stats;
+	uint32_t stored_cnt;
+
+	zassert_equal(api->clear(), 0, "Cannot clear storage");
+
+	/* The oldest events are dropped, writing never fails. */
+	write_events(0, OVERFLOW_CNT);
+
+	zassert_equal(api->stats_get(&stats), 0, "Cannot get stats");
+	zassert_true(stats.dropped_cnt > 0, "No events dropped");
+
+	stored_cnt = replay_check(OVERFLOW_CNT - 1);
+	zassert_true(stored_cnt < OVERFLOW_CNT, "Events not dropped");
+
+	zassert_equal(api->init(), 0, "Cannot reinitialize storage");
+	zassert_equal(replay_check(OVERFLOW_CNT - 1), stored_cnt,
+		      "Wrong number of events played after reset");
+}
+
+#if defined(CONFIG_EVENT_MANAGER_STORAGE_REPLAY_INCREMENTAL)
+/* Play the stored events as after a reboot, and wait until all of them are
+ * played.
+ */
+static void replay_run(uint32_t consume_below)
+{
+	k_sem_reset(&replay_done_sem);
+	replay_consume_below = consume_below;
+	replay_val_cnt = 0;
+	replay_progress_cnt = 0;
+
+	zassert_equal(event_store_init(), 0, "Cannot start replay");
+	zassert_equal(k_sem_take(&replay_done_sem, K_SECONDS(10)), 0,
+		      "Replay not done");
+}
+
+/* Check that the events were played in order, from first_val to the last
+ * stored event, and that a progress event was submitted after every batch.
+ */
+static void replay_run_check(uint32_t first_val)
+{
+	uint32_t cnt = REPLAY_CNT - first_val;
+
+	zassert_equal(replay_val_cnt, cnt, "%zu events played, expected %u",
+		      replay_val_cnt, cnt);
+
+	for (uint32_t i = 0; i < cnt; i++) {
+		zassert_equal(replay_vals[i], first_val + i,
+			      "Event %u played instead of %u", replay_vals[i],
+			      first_val + i);
+	}
+
+	zassert_equal(replay_progress_cnt, cnt / REPLAY_BATCH_SIZE + 1,
+		      "Wrong number of progress events");
+
+	for (size_t i = 0; i < replay_progress_cnt - 1; i++) {
+		zassert_false(replay_progress[i].done, "Replay done early");
+		zassert_equal(replay_progress[i].replayed_cnt,
+			      (i + 1) * REPLAY_BATCH_SIZE,
+			      "Wrong progress after batch %zu", i);
+	}
+
+	zassert_true(replay_progress[replay_progress_cnt - 1].done,
+		     "Replay not done");
+	zassert_equal(replay_progress[replay_progress_cnt - 1].replayed_cnt,
+		      cnt, "Wrong number of events reported");
+}
+
+static void test_replay_incremental(void)
+{
+	zassert_equal(api->clear(), 0, "Cannot clear storage");
+
+	write_events(0, REPLAY_CNT);
+
+	replay_run(REPLAY_CONSUMED_CNT);
+	replay_run_check(0);
+
+	/* The replay resumes after the events consumed before the reboot. */
+	replay_run(0);
+	replay_run_check(REPLAY_CONSUMED_CNT);
+}
+#endif /* CONFIG_EVENT_MANAGER_STORAGE_REPLAY_INCREMENTAL */
+
+void test_main(void)
+{
+	ztest_test_suite(event_manager_storage_tests,
+			 ztest_unit_test(test_init),
+			 ztest_unit_test(test_throughput),
+			 ztest_unit_test(test_replay_after_reinit),
+			 ztest_unit_test(test_overflow)
+			 );
+
+	ztest_run_test_suite(event_manager_storage_tests);
+
+#if defined(CONFIG_EVENT_MANAGER_STORAGE_REPLAY_INCREMENTAL)
+	ztest_test_suite(event_manager_storage_replay_tests,
+			 ztest_unit_test(test_replay_incremental)
+			 );
+
+	ztest_run_test_suite(event_manager_storage_replay_tests);
+#endif
+}
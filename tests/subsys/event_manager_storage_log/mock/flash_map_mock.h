@@ -0,0 +1,24 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef FLASH_MAP_MOCK_H__
+#define FLASH_MAP_MOCK_H__
+
+#include <zephyr.h>
+#include <storage/flash_map.h>
+
+#define FLASH_MOCK_AREA_ID FLASH_AREA_ID(events_storage)
+
+/* Erase the flash area. */
+void flash_mock_init(size_t size, size_t sector_size, uint8_t align);
+
+/* Simulate a power loss after a number of bytes have been written. The
+ * write that crosses the limit is torn, and it and all following writes
+ * fail. A negative value disables the simulation.
+ */
+void flash_mock_power_loss_after(int bytes);
+
+#endif /* FLASH_MAP_MOCK_H__ */
@@ -0,0 +1,293 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <ztest.h>
+#include <event_manager.h>
+#include <event_manager_storage_priv.h>
+
+#include "flash_map_mock.h"
+
+#define SECTOR_SIZE	1024
+#define SECTOR_CNT	8
+#define WRITE_ALIGN	4
+
+#define STORED_EVENT_TYPE_ID	0x5354
+
+/* With a commit after every event, a sector holds about 50 events. */
+#define FILL_CNT	300
+#define WRAP_CNT	200
+
+#define CURSOR_INTERVAL	CONFIG_EVENT_MANAGER_STORAGE_LOG_CURSOR_INTERVAL
+
+struct stored_event {
+	struct event_header header;
+
+	uint32_t val;
+};
+
+/* The backend is tested without the Event Manager, which normally provides
+ * the event types and the identifiers kept in the storage.
+ */
+static const struct event_type stored_event_type = {
+	.name = "stored_event",
+	.event_size = sizeof(struct stored_event),
+};
+
+static struct event_storage_api *api;
+
+
+uint32_t event_store_type_id_get(const struct event_type *et)
+{
+	zassert_equal_ptr(et, &stored_event_type, "Unknown event type");
+
+	return STORED_EVENT_TYPE_ID;
+}
+
+const struct event_type *event_store_type_find(uint32_t type_id)
+{
+	return (type_id == STORED_EVENT_TYPE_ID) ? &stored_event_type : NULL;
+}
+
+void event_manager_free(void *addr)
+{
+	k_free(addr);
+}
+
+static void log_setup(void)
+{
+	flash_mock_init(SECTOR_CNT * SECTOR_SIZE, SECTOR_SIZE, WRITE_ALIGN);
+
+	api = event_store_backend_get_api();
+	zassert_not_null(api, "No storage backend");
+	zassert_equal(api->init(), 0, "Cannot initialize storage");
+}
+
+static void log_reboot(void)
+{
+	flash_mock_power_loss_after(-1);
+	zassert_equal(api->init(), 0, "Cannot initialize storage after reboot");
+}
+
+static int write_event(uint32_t val)
+{
+	struct stored_event *event = k_malloc(sizeof(*event));
+	int err;
+
+	zassert_not_null(event, "Failed to allocate event");
+	event->header.type_id = &stored_event_type;
+	event->header.entry_id = 0;
+	event->val = val;
+
+	err = api->write(&event->header);
+	event_manager_free(event);
+
+	return err;
+}
+
+static void write_events(uint32_t first_val, size_t cnt)
+{
+	for (size_t i = 0; i < cnt; i++) {
+		zassert_equal(write_event(first_val + i), 0,
+			      "Cannot write event");
+	}
+}
+
+/* Read the next event and check that it is the expected one. */
+static void read_check(uint32_t val, bool from_start, bool remove)
+{
+	struct event_header *eh;
+
+	zassert_equal(api->read(&eh, from_start), 0, "Cannot read event %u",
+		      val);
+	zassert_equal_ptr(eh->type_id, &stored_event_type, "Wrong event type");
+	zassert_equal(CONTAINER_OF(eh, struct stored_event, header)->val, val,
+		      "Wrong event order");
+
+	if (remove) {
+		zassert_equal(api->remove(eh), 0, "Cannot remove event");
+	}
+	event_manager_free(eh);
+}
+
+/* Play the remaining events without consuming them and check that their
+ * values increase by one. Returns the number of events played.
+ */
+static uint32_t replay_check(uint32_t first_val, uint32_t last_val,
+			     bool from_start)
+{
+	struct event_header *eh;
+	uint32_t cnt = 0;
+	uint32_t val = first_val - 1;
+
+	while (api->read(&eh, from_start && (cnt == 0)) == 0) {
+		uint32_t read_val =
+			CONTAINER_OF(eh, struct stored_event, header)->val;
+
+		zassert_equal(read_val, val + 1, "Event %u played after %u",
+			      read_val, val);
+		val = read_val;
+		cnt++;
+
+		event_manager_free(eh);
+	}
+
+	zassert_equal(val, last_val, "Last event %u, expected %u", val,
+		      last_val);
+
+	return cnt;
+}
+
+static void test_write_read_remove(void)
+{
+	const uint32_t cnt = 12 * CURSOR_INTERVAL;
+	struct event_storage_stats stats;
+	uint32_t dropped_cnt;
+	struct event_header *eh;
+
+	zassert_equal(api->stats_get(&stats), 0, "Cannot get stats");
+	dropped_cnt = stats.dropped_cnt;
+
+	write_events(0, cnt);
+
+	for (uint32_t i = 0; i < cnt; i++) {
+		read_check(i, (i == 0), true);
+	}
+
+	zassert_equal(api->read(&eh, false), -ENOENT, "Unexpected event");
+
+	/* All consumed events are covered by a stored cursor. */
+	log_reboot();
+	zassert_equal(api->read(&eh, true), -ENOENT,
+		      "Consumed event played after reboot");
+
+	write_events(cnt, 4);
+	zassert_equal(replay_check(cnt, cnt + 3, true), 4,
+		      "Wrong number of events played");
+
+	zassert_equal(api->stats_get(&stats), 0, "Cannot get stats");
+	zassert_equal(stats.dropped_cnt, dropped_cnt, "Events were dropped");
+}
+
+static void test_reboot(void)
+{
+	const uint32_t cnt = 64;
+	const uint32_t consumed_cnt = 2 * CURSOR_INTERVAL + 4;
+	const uint32_t stored_cursor = 2 * CURSOR_INTERVAL;
+
+	write_events(0, cnt);
+
+	for (uint32_t i = 0; i < consumed_cnt; i++) {
+		read_check(i, (i == 0), true);
+	}
+
+	/* Events consumed after the last stored cursor are played again. */
+	log_reboot();
+	zassert_equal(replay_check(stored_cursor, cnt - 1, true),
+		      cnt - stored_cursor, "Wrong number of events played");
+
+	/* New events are appended after the recovered ones. */
+	write_events(cnt, 8);
+	zassert_equal(replay_check(stored_cursor, cnt + 7, true),
+		      cnt + 8 - stored_cursor, "Wrong number of events played");
+}
+
+static void test_torn_record(void)
+{
+	const uint32_t cnt = 10;
+	struct event_header *eh;
+
+	/* An event record takes 12 bytes and is followed by an 8-byte commit
+	 * record. Lose power before the record, in its header, in the commit
+	 * record and just before the end of the batch.
+	 */
+	static const int tear_offsets[] = { 0, 6, 14, 19 };
+
+	for (size_t i = 0; i < ARRAY_SIZE(tear_offsets); i++) {
+		log_setup();
+		write_events(0, cnt);
+
+		flash_mock_power_loss_after(tear_offsets[i]);
+		zassert_not_equal(write_event(cnt), 0, "Torn write succeeded");
+
+		log_reboot();
+		zassert_equal(replay_check(0, cnt - 1, true), cnt,
+			      "Torn event played");
+
+		/* The log continues after the torn record. */
+		write_events(cnt + 1, cnt);
+
+		for (uint32_t val = 0; val < cnt; val++) {
+			read_check(val, (val == 0), false);
+		}
+		for (uint32_t val = cnt + 1; val <= 2 * cnt; val++) {
+			read_check(val, false, false);
+		}
+		zassert_equal(api->read(&eh, false), -ENOENT,
+			      "Unexpected event");
+	}
+}
+
+static void test_wrap_during_replay(void)
+{
+	struct event_storage_stats stats;
+	const uint32_t read_cnt = 10;
+	uint32_t dropped_cnt;
+
+	zassert_equal(api->stats_get(&stats), 0, "Cannot get stats");
+	dropped_cnt = stats.dropped_cnt;
+
+	write_events(0, FILL_CNT);
+
+	for (uint32_t i = 0; i < read_cnt; i++) {
+		read_check(i, (i == 0), false);
+	}
+
+	/* Writing erases the sectors holding the oldest events, including
+	 * the one being played.
+	 */
+	write_events(FILL_CNT, WRAP_CNT);
+
+	zassert_equal(api->stats_get(&stats), 0, "Cannot get stats");
+	zassert_true(stats.dropped_cnt > dropped_cnt, "No events dropped");
+
+	/* The replay continues with the oldest remaining event and stops at
+	 * the events written after it started.
+	 */
+	struct event_header *eh;
+	uint32_t first_val;
+
+	zassert_equal(api->read(&eh, false), 0, "Cannot read event");
+	first_val = CONTAINER_OF(eh, struct stored_event, header)->val;
+	event_manager_free(eh);
+
+	zassert_true(first_val > read_cnt, "Erased event %u played",
+		     first_val);
+	zassert_true(first_val < FILL_CNT, "Replay skipped stored events");
+	replay_check(first_val + 1, FILL_CNT - 1, false);
+
+	/* A new replay plays all remaining events. */
+	zassert_equal(replay_check(first_val, FILL_CNT + WRAP_CNT - 1, true),
+		      FILL_CNT + WRAP_CNT - first_val,
+		      "Wrong number of events played");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(event_manager_storage_log_tests,
+			 ztest_unit_test_setup_teardown(test_write_read_remove,
+							log_setup,
+							unit_test_noop),
+			 ztest_unit_test_setup_teardown(test_reboot,
+							log_setup,
+							unit_test_noop),
+			 ztest_unit_test(test_torn_record),
+			 ztest_unit_test_setup_teardown(test_wrap_during_replay,
+							log_setup,
+							unit_test_noop)
+			 );
+
+	ztest_run_test_suite(event_manager_storage_log_tests);
+}
@@ -0,0 +1,518 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ztest.h>
+#include <net/socket.h>
+#include <settings/settings.h>
+#include <download_client.h>
+
+#define HOST		"example.com"
+#define FILE_NAME	"file.bin"
+#define SEC_TAG		42
+#define SOCK_FD		3
+
+#define FILE_SIZE	5000
+#define FRAG_SIZE	CONFIG_DOWNLOAD_CLIENT_HTTP_FRAG_SIZE
+#define FRAG_CNT	((FILE_SIZE + FRAG_SIZE - 1) / FRAG_SIZE)
+#define STREAM_SIZE	(CONFIG_DOWNLOAD_CLIENT_HTTP_PIPELINE_DEPTH * \
+			 (FRAG_SIZE + 128))
+
+/* Result of a download stopped by the application, to reboot. */
+#define DOWNLOAD_REBOOT	1
+
+static struct download_client client;
+
+static const struct download_client_cfg config = {
+	.sec_tag = SEC_TAG,
+};
+
+/* Result of the download, set when it stops. */
+static int result;
+static K_SEM_DEFINE(download_stopped, 0, 1);
+
+/* Responses sent by the server, not yet received by the client. */
+static char stream[STREAM_SIZE];
+static size_t stream_len;
+static bool connected;
+static size_t connect_cnt;
+static size_t request_cnt;
+static size_t in_flight;
+static size_t max_in_flight;
+/* End of each response in the stream. */
+static size_t response_end[CONFIG_DOWNLOAD_CLIENT_HTTP_PIPELINE_DEPTH + 1];
+
+/* Faults injected while downloading. */
+static size_t drop_at_frag;
+static size_t reboot_at;
+static bool random_faults;
+static bool drop;
+
+/* File as stored by the application, which survives reboots. */
+static uint8_t downloaded[FILE_SIZE];
+static size_t stored;
+static size_t delivered;
+static size_t frag_cnt;
+static uint32_t rand_state;
+
+/* Version of the file on the server, and whether it is tagged. */
+static unsigned int file_version;
+static bool server_etag;
+
+/* Progress saved in the settings, which survives reboots. */
+static struct download_client_resume_record saved_record;
+static char saved_key[32];
+static bool saved;
+
+static uint8_t file_byte(size_t i)
+{
+	return (uint8_t)(i * 7 + (i >> 8) + file_version * 13);
+}
+
+static uint32_t rand_get(void)
+{
+	rand_state = rand_state * 1103515245 + 12345;
+	return rand_state >> 16;
+}
+
+/* Mocks of the socket layer. The server answers each request immediately,
+ * and the responses are received in chunks of random size.
+ */
+int zsock_getaddrinfo(const char *host, const char *service,
+		      const struct zsock_addrinfo *hints,
+		      struct zsock_addrinfo **res)
+{
+	static struct sockaddr addr = {
+		.sa_family = AF_INET,
+	};
+	static struct zsock_addrinfo ai = {
+		.ai_family = AF_INET,
+		.ai_addr = &addr,
+		.ai_addrlen = sizeof(struct sockaddr_in),
+	};
+
+	zassert_equal(strcmp(host, HOST), 0, "Wrong host");
+	*res = &ai;
+
+	return 0;
+}
+
+void zsock_freeaddrinfo(struct zsock_addrinfo *ai)
+{
+}
+
+int z_impl_zsock_socket(int family, int type, int proto)
+{
+	zassert_equal(type, SOCK_STREAM, "Wrong socket type");
+	zassert_equal(proto, IPPROTO_TLS_1_2, "Wrong protocol");
+
+	return SOCK_FD;
+}
+
+int z_impl_zsock_setsockopt(int sock, int level, int optname,
+			    const void *optval, socklen_t optlen)
+{
+	return 0;
+}
+
+int z_impl_zsock_connect(int sock, const struct sockaddr *addr,
+			 socklen_t addrlen)
+{
+	zassert_false(connected, "Already connected");
+
+	connected = true;
+	connect_cnt++;
+
+	return 0;
+}
+
+int z_impl_zsock_close(int sock)
+{
+	zassert_equal(sock, SOCK_FD, "Wrong socket");
+
+	/* The responses in flight are lost. */
+	connected = false;
+	drop = false;
+	stream_len = 0;
+	in_flight = 0;
+
+	return 0;
+}
+
+ssize_t z_impl_zsock_sendto(int sock, const void *buf, size_t len, int flags,
+			    const struct sockaddr *dest_addr, socklen_t addrlen)
+{
+	unsigned int first;
+	unsigned int last;
+	const char *range = strstr(buf, "Range: bytes=");
+	int hdr_len;
+
+	zassert_true(connected, "Not connected");
+	zassert_not_null(range, "Not a range request");
+	zassert_equal(sscanf(range, "Range: bytes=%u-%u", &first, &last), 2,
+		      "Malformed range");
+	zassert_true(first < FILE_SIZE, "Range past end of file");
+
+	/* The size is not known when resuming, the range is truncated */
+	last = MIN(last, FILE_SIZE - 1);
+
+	hdr_len = snprintf(stream + stream_len, sizeof(stream) - stream_len,
+			   "HTTP/1.1 206 Partial Content\r\n"
+			   "Content-Range: bytes %u-%u/%u\r\n"
+			   "Content-Length: %u\r\n"
+			   "%s%u%s"
+			   "\r\n", first, last, FILE_SIZE, last - first + 1,
+			   server_etag ? "ETag: \"v" : "X-Version: ",
+			   file_version, server_etag ? "\"\r\n" : "\r\n");
+	zassert_true(stream_len + hdr_len + (last - first + 1) <=
+		     sizeof(stream), "Too many requests in flight");
+
+	stream_len += hdr_len;
+	for (size_t i = first; i <= last; i++) {
+		stream[stream_len++] = file_byte(i);
+	}
+
+	zassert_true(in_flight < ARRAY_SIZE(response_end),
+		     "Too many requests in flight");
+	response_end[in_flight++] = stream_len;
+	max_in_flight = MAX(max_in_flight, in_flight);
+	request_cnt++;
+
+	return len;
+}
+
+ssize_t z_impl_zsock_recvfrom(int sock, void *buf, size_t max_len, int flags,
+			      struct sockaddr *src_addr, socklen_t *addrlen)
+{
+	size_t len;
+
+	zassert_true(connected, "Not connected");
+
+	if (drop) {
+		/* The server closes the connection. */
+		drop = false;
+		stream_len = 0;
+		in_flight = 0;
+		return 0;
+	}
+
+	if (stream_len == 0) {
+		/* Nothing was requested, the client is stalled. */
+		errno = EAGAIN;
+		return -1;
+	}
+
+	len = MIN(max_len, stream_len);
+	len = MIN(len, 1 + rand_get() % len);
+
+	memcpy(buf, stream, len);
+	memmove(stream, stream + len, stream_len - len);
+	stream_len -= len;
+
+	/* Responses received completely are no longer in flight. */
+	for (size_t i = 0; i < in_flight; i++) {
+		response_end[i] -= MIN(response_end[i], len);
+	}
+
+	while (in_flight > 0 && response_end[0] == 0) {
+		memmove(response_end, response_end + 1,
+			(in_flight - 1) * sizeof(response_end[0]));
+		in_flight--;
+	}
+
+	return len;
+}
+
+/* Stubs of the settings functions, with storage for one record. */
+int settings_save_one(const char *name, const void *value, size_t val_len)
+{
+	zassert_equal(val_len, sizeof(saved_record), "Wrong record size");
+	zassert_true(strlen(name) < sizeof(saved_key), "Key too long");
+
+	strcpy(saved_key, name);
+	memcpy(&saved_record, value, val_len);
+	saved = true;
+
+	return 0;
+}
+
+int settings_delete(const char *name)
+{
+	if (saved && strcmp(name, saved_key) == 0) {
+		saved = false;
+	}
+
+	return 0;
+}
+
+static ssize_t saved_record_read(void *cb_arg, void *data, size_t len)
+{
+	memcpy(data, &saved_record, MIN(len, sizeof(saved_record)));
+
+	return MIN(len, sizeof(saved_record));
+}
+
+int settings_load_subtree_direct(const char *subtree,
+				 settings_load_direct_cb cb, void *param)
+{
+	if (!saved || strcmp(subtree, saved_key) != 0) {
+		return 0;
+	}
+
+	return cb(NULL, sizeof(saved_record), saved_record_read, NULL, param);
+}
+
+static void download_stop(int err)
+{
+	result = err;
+	k_sem_give(&download_stopped);
+}
+
+/* Store the fragments, as the application would. The device reboots,
+ * or the server closes the connection, after some fragments.
+ */
+static int fragment_store(const struct download_client_evt *event)
+{
+	uint32_t fault = random_faults ? rand_get() % 32 : UINT32_MAX;
+
+	if (fault == 0 || (reboot_at && stored >= reboot_at)) {
+		/* The fragment is lost with the content of the RAM. */
+		download_stop(DOWNLOAD_REBOOT);
+		return -1;
+	}
+
+	zassert_true(stored + event->fragment.len <= FILE_SIZE,
+		     "Fragment past end of file");
+	memcpy(downloaded + stored, event->fragment.buf, event->fragment.len);
+	stored += event->fragment.len;
+	delivered += event->fragment.len;
+	frag_cnt++;
+
+	if (fault == 1 || frag_cnt == drop_at_frag) {
+		drop = true;
+	}
+
+	return 0;
+}
+
+static int download_client_callback(const struct download_client_evt *event)
+{
+	switch (event->id) {
+	case DOWNLOAD_CLIENT_EVT_FRAGMENT:
+		return fragment_store(event);
+	case DOWNLOAD_CLIENT_EVT_DONE:
+		download_stop(0);
+		return 0;
+	case DOWNLOAD_CLIENT_EVT_ERROR:
+		if (event->error == -ECONNRESET) {
+			/* Reconnect and continue. */
+			return 0;
+		}
+
+		download_stop(event->error);
+		return -1;
+	default:
+		return 0;
+	}
+}
+
+static void download_start(size_t from)
+{
+	stored = from;
+	request_cnt = 0;
+	max_in_flight = 0;
+
+	zassert_equal(download_client_connect(&client, HOST, &config), 0,
+		      "Connect failed");
+	zassert_equal(download_client_start(&client, FILE_NAME, from), 0,
+		      "Start failed");
+}
+
+/* Wait for the download to stop, then disconnect. */
+static int download_wait(void)
+{
+	zassert_equal(k_sem_take(&download_stopped, K_SECONDS(10)), 0,
+		      "Download timed out");
+
+	/* Let the download thread suspend itself. */
+	k_sleep(K_MSEC(10));
+
+	zassert_equal(download_client_disconnect(&client), 0,
+		      "Disconnect failed");
+
+	return result;
+}
+
+/* Reboot, the progress since it was last saved is lost. Returns the offset
+ * from where the download is resumed.
+ */
+static size_t reboot(void)
+{
+	size_t from;
+
+	memset(&client.resume, 0, sizeof(client.resume));
+
+	zassert_equal(download_client_connect(&client, HOST, &config), 0,
+		      "Connect failed");
+	zassert_equal(download_client_resume_offset_get(&client, FILE_NAME,
+							 &from), 0,
+		      "Cannot get offset");
+	zassert_equal(download_client_disconnect(&client), 0,
+		      "Disconnect failed");
+	zassert_true(from <= stored, "Offset past progress");
+
+	return from;
+}
+
+static void setup(void)
+{
+	memset(downloaded, 0, sizeof(downloaded));
+	stored = 0;
+	delivered = 0;
+	frag_cnt = 0;
+	saved = false;
+	connect_cnt = 0;
+	drop_at_frag = 0;
+	reboot_at = 0;
+	random_faults = false;
+}
+
+static void file_check(void)
+{
+	for (size_t i = 0; i < FILE_SIZE; i++) {
+		zassert_equal(downloaded[i], file_byte(i),
+			      "Wrong data at offset %zu", i);
+	}
+}
+
+static void test_pipelined(void)
+{
+	server_etag = false;
+	file_version = 0;
+
+	for (uint32_t seed = 1; seed < 20; seed++) {
+		setup();
+		rand_state = seed;
+
+		download_start(0);
+		zassert_equal(download_wait(), 0, "Download failed");
+		file_check();
+
+		zassert_equal(connect_cnt, 1, "Reconnected");
+		zassert_equal(request_cnt, FRAG_CNT, "Wrong request count");
+		zassert_equal(max_in_flight,
+			      CONFIG_DOWNLOAD_CLIENT_HTTP_PIPELINE_DEPTH,
+			      "Requests not pipelined");
+	}
+}
+
+static void test_connection_lost(void)
+{
+	server_etag = false;
+	file_version = 0;
+
+	for (size_t frag = 1; frag < FRAG_CNT; frag++) {
+		setup();
+		rand_state = frag;
+		drop_at_frag = frag;
+
+		download_start(0);
+		zassert_equal(download_wait(), 0, "Download failed");
+		file_check();
+
+		zassert_equal(connect_cnt, 2, "Not reconnected");
+		zassert_equal(delivered, FILE_SIZE, "Data delivered twice");
+	}
+}
+
+static void test_resume_random_faults(void)
+{
+	server_etag = true;
+	file_version = 0;
+
+	for (uint32_t seed = 1; seed < 100; seed++) {
+		size_t redelivered = 0;
+		size_t from;
+
+		setup();
+		rand_state = seed;
+		random_faults = true;
+
+		download_start(0);
+		while (download_wait() == DOWNLOAD_REBOOT) {
+			from = reboot();
+			zassert_true(stored - from <
+				     CONFIG_DOWNLOAD_CLIENT_RESUME_SAVE_INTERVAL +
+				     FRAG_SIZE, "Saved progress too old");
+
+			redelivered += stored - from;
+			download_start(from);
+		}
+
+		zassert_equal(result, 0, "Download failed");
+		file_check();
+
+		/* The bytes verified when resuming are not delivered again,
+		 * and no progress is lost when the connection is.
+		 */
+		zassert_equal(delivered, FILE_SIZE + redelivered,
+			      "Data delivered twice");
+		zassert_false(saved, "Progress not deleted");
+	}
+}
+
+static void test_resume_file_changed(void)
+{
+	size_t from;
+
+	for (int tagged = 0; tagged < 2; tagged++) {
+		setup();
+		server_etag = tagged;
+		file_version = 0;
+		rand_state = tagged + 1;
+		reboot_at = FILE_SIZE / 2;
+
+		download_start(0);
+		zassert_equal(download_wait(), DOWNLOAD_REBOOT,
+			      "Download not stopped");
+
+		/* Reboot, while the file is updated on the server */
+		file_version++;
+		reboot_at = 0;
+		from = reboot();
+		zassert_true(from > 0, "Progress not saved");
+
+		download_start(from);
+		zassert_equal(download_wait(), -ESTALE, "Change not detected");
+		zassert_false(saved, "Progress not deleted");
+
+		/* The download can be started again */
+		setup();
+		download_start(0);
+		zassert_equal(download_wait(), 0, "Download failed");
+		file_check();
+	}
+}
+
+void test_main(void)
+{
+	zassert_equal(download_client_init(&client, download_client_callback),
+		      0, "Init failed");
+
+	/* Let the download thread suspend itself, until a download starts. */
+	k_sleep(K_MSEC(10));
+
+	ztest_test_suite(download_client,
+			 ztest_unit_test(test_pipelined),
+			 ztest_unit_test(test_connection_lost),
+			 ztest_unit_test(test_resume_random_faults),
+			 ztest_unit_test(test_resume_file_changed)
+			 );
+
+	ztest_run_test_suite(download_client);
+}
@@ -5,6 +5,8 @@
  */
 
 #include <ztest.h>
+#include <string.h>
+#include <sys/byteorder.h>
 #include <profiler.h>
 
 #define PROFILED_EVENTS_NB 100
@@ -12,6 +14,11 @@
 #define S_VALUE_START -50
 #define EXAMPLE_STRING "example string"
 
+#define BUFFERED_EVENTS_NB 200
+#define DATA_RECORD_LEN 9
+#define DROPPED_RECORD_LEN 9
+#define FLUSH_WAIT_MS 100
+
 static uint16_t no_data_event_id;
 static uint16_t data_event_id;
 static uint16_t big_event_id;
@@ -117,13 +124,103 @@ static void test_performance3(void)
 	       PROFILED_EVENTS_NB, elapsed_time_us);
 }
 
+#if defined(CONFIG_PROFILER_NORDIC_BACKEND_RAM) && \
+	defined(CONFIG_PROFILER_NORDIC_BUFFERED)
+static size_t ram_data_read(uint8_t *buf, size_t len)
+{
+	size_t total = 0;
+	size_t read;
+
+	do {
+		read = profiler_ram_data_read(buf + total, len - total);
+		total += read;
+	} while ((read > 0) && (total < len));
+
+	return total;
+}
+
+static uint16_t dropped_event_id_get(void)
+{
+	static const char name[] = "profiler_dropped,";
+
+	for (size_t i = 0; i < profiler_num_events; i++) {
+		if (!strncmp(profiler_get_event_descr(i), name,
+			     strlen(name))) {
+			return i;
+		}
+	}
+
+	zassert_unreachable("Dropped records event not registered");
+
+	return 0;
+}
+
+static void test_buffered_drops(void)
+{
+	static uint8_t data[CONFIG_PROFILER_NORDIC_DATA_BUFFER_SIZE];
+	uint16_t dropped_event_id = dropped_event_id_get();
+	uint32_t received_cnt = 0;
+	uint32_t dropped_cnt = 0;
+	size_t len;
+
+	/* Discard data of the previous tests. */
+	k_sleep(K_MSEC(FLUSH_WAIT_MS));
+	ram_data_read(data, sizeof(data));
+
+	/* Profiler thread cannot flush until the test thread sleeps, so
+	 * records that do not fit in the staging buffer are dropped.
+	 */
+	for (uint32_t i = 0; i < BUFFERED_EVENTS_NB; i++) {
+		struct log_event_buf buf;
+
+		profiler_log_start(&buf);
+		profiler_log_encode_uint32(&buf, i);
+		profiler_log_send(&buf, data_event_id);
+	}
+
+	k_sleep(K_MSEC(FLUSH_WAIT_MS));
+	len = ram_data_read(data, sizeof(data));
+
+	for (size_t pos = 0; pos < len;) {
+		if (data[pos] == data_event_id) {
+			zassert_true(pos + DATA_RECORD_LEN <= len,
+				     "Truncated record");
+			zassert_equal(sys_get_le32(&data[pos + 5]),
+				      received_cnt, "Records out of order");
+			received_cnt++;
+			pos += DATA_RECORD_LEN;
+		} else if (data[pos] == dropped_event_id) {
+			zassert_true(pos + DROPPED_RECORD_LEN <= len,
+				     "Truncated record");
+			dropped_cnt += sys_get_le32(&data[pos + 5]);
+			pos += DROPPED_RECORD_LEN;
+		} else {
+			zassert_unreachable("Unexpected record");
+			break;
+		}
+	}
+
+	zassert_true(dropped_cnt > 0, "No records dropped");
+	zassert_equal(received_cnt + dropped_cnt, BUFFERED_EVENTS_NB,
+		      "Records lost without drop report");
+	printk("Logged %d events, %u sent, %u dropped\n", BUFFERED_EVENTS_NB,
+	       received_cnt, dropped_cnt);
+}
+#else
+static void test_buffered_drops(void)
+{
+	ztest_test_skip();
+}
+#endif
+
 void test_main(void)
 {
 	ztest_test_suite(profiler_tests,
 			 ztest_unit_test(test_init),
 			 ztest_unit_test(test_performance1),
 			 ztest_unit_test(test_performance2),
-			 ztest_unit_test(test_performance3)
+			 ztest_unit_test(test_performance3),
+			 ztest_unit_test(test_buffered_drops)
 			 );
 
 	ztest_run_test_suite(profiler_tests);